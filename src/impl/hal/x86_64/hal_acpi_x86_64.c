@@ -0,0 +1,159 @@
+#include "hal/hal_acpi.h"
+#include "hal/hal_mmio.h"
+#include "debug/debug.h"
+
+// =============================================================================
+// KOS - HAL ACPI Table Discovery x86_64 Implementation
+// =============================================================================
+
+#define ACPI_EBDA_POINTER       0x40E
+#define ACPI_EBDA_SEARCH_SIZE   1024
+#define ACPI_BIOS_AREA_START    0xE0000
+#define ACPI_BIOS_AREA_END      0x100000
+#define ACPI_RSDP_V1_SIZE       20
+
+// Global ACPI state
+static const hal_acpi_rsdp_t* g_acpi_rsdp = NULL;
+static const hal_acpi_sdt_header_t* g_acpi_root = NULL;
+static bool g_acpi_use_xsdt = false;
+static bool g_acpi_initialized = false;
+
+// Byte-sum checksum, valid when zero
+static uint8_t hal_acpi_checksum(const void* data, uint32_t length) {
+    const uint8_t* bytes = (const uint8_t*)data;
+    uint8_t sum = 0;
+    for (uint32_t i = 0; i < length; i++) {
+        sum += bytes[i];
+    }
+    return sum;
+}
+
+static bool hal_acpi_signature_equals(const char* a, const char* b, uint32_t length) {
+    for (uint32_t i = 0; i < length; i++) {
+        if (a[i] != b[i]) {
+            return false;
+        }
+    }
+    return true;
+}
+
+// Search a physical range for the RSDP on 16-byte boundaries
+static const hal_acpi_rsdp_t* hal_acpi_scan_rsdp(uintptr_t start, uintptr_t end) {
+    for (uintptr_t addr = start; addr + sizeof(hal_acpi_rsdp_t) <= end; addr += 16) {
+        const hal_acpi_rsdp_t* rsdp = (const hal_acpi_rsdp_t*)addr;
+        if (!hal_acpi_signature_equals(rsdp->signature, "RSD PTR ", 8)) {
+            continue;
+        }
+        if (hal_acpi_checksum(rsdp, ACPI_RSDP_V1_SIZE) != 0) {
+            continue;
+        }
+        if (rsdp->revision >= 2 && hal_acpi_checksum(rsdp, rsdp->length) != 0) {
+            continue;
+        }
+        return rsdp;
+    }
+
+    return NULL;
+}
+
+// Map and validate a table at a physical address
+static const hal_acpi_sdt_header_t* hal_acpi_map_table(uint64_t phys_addr) {
+    if (phys_addr == 0) {
+        return NULL;
+    }
+
+    const hal_acpi_sdt_header_t* header =
+        (const hal_acpi_sdt_header_t*)hal_mmio_map(phys_addr, sizeof(hal_acpi_sdt_header_t));
+    if (!header) {
+        return NULL;
+    }
+
+    // Make sure the whole table is reachable before checksumming it
+    if (!hal_mmio_map(phys_addr, header->length)) {
+        return NULL;
+    }
+
+    if (hal_acpi_checksum(header, header->length) != 0) {
+        log_warn("ACPI: bad checksum on table at 0x%x", (uint32_t)phys_addr);
+        return NULL;
+    }
+
+    return header;
+}
+
+// Locate the RSDP and root table
+bool hal_acpi_init(void) {
+    if (g_acpi_initialized) {
+        return g_acpi_root != NULL;
+    }
+    g_acpi_initialized = true;
+
+    // First KiB of the EBDA, then the BIOS read-only area
+    uintptr_t ebda = (uintptr_t)(*(volatile uint16_t*)ACPI_EBDA_POINTER) << 4;
+    if (ebda != 0) {
+        g_acpi_rsdp = hal_acpi_scan_rsdp(ebda, ebda + ACPI_EBDA_SEARCH_SIZE);
+    }
+    if (!g_acpi_rsdp) {
+        g_acpi_rsdp = hal_acpi_scan_rsdp(ACPI_BIOS_AREA_START, ACPI_BIOS_AREA_END);
+    }
+    if (!g_acpi_rsdp) {
+        log_warn("ACPI: RSDP not found");
+        return false;
+    }
+
+    // Prefer the XSDT when present
+    if (g_acpi_rsdp->revision >= 2 && g_acpi_rsdp->xsdt_address != 0) {
+        g_acpi_root = hal_acpi_map_table(g_acpi_rsdp->xsdt_address);
+        g_acpi_use_xsdt = g_acpi_root != NULL;
+    }
+    if (!g_acpi_root) {
+        g_acpi_root = hal_acpi_map_table(g_acpi_rsdp->rsdt_address);
+    }
+    if (!g_acpi_root) {
+        log_warn("ACPI: no valid root table");
+        return false;
+    }
+
+    log_info("ACPI: revision %d, %s at 0x%x", g_acpi_rsdp->revision,
+             g_acpi_use_xsdt ? "XSDT" : "RSDT", (uint32_t)(uintptr_t)g_acpi_root);
+    return true;
+}
+
+// Get the RSDP
+const hal_acpi_rsdp_t* hal_acpi_get_rsdp(void) {
+    if (!g_acpi_initialized) {
+        hal_acpi_init();
+    }
+
+    return g_acpi_rsdp;
+}
+
+// Find the n-th table with the given signature
+const hal_acpi_sdt_header_t* hal_acpi_find_table(const char* signature, uint32_t instance) {
+    if (!signature || (!g_acpi_initialized && !hal_acpi_init()) || !g_acpi_root) {
+        return NULL;
+    }
+
+    uint32_t entry_size = g_acpi_use_xsdt ? 8 : 4;
+    uint32_t entries = (g_acpi_root->length - sizeof(hal_acpi_sdt_header_t)) / entry_size;
+    const uint8_t* entry_base = (const uint8_t*)g_acpi_root + sizeof(hal_acpi_sdt_header_t);
+
+    for (uint32_t i = 0; i < entries; i++) {
+        uint64_t phys_addr;
+        if (g_acpi_use_xsdt) {
+            phys_addr = *(const uint64_t*)(entry_base + i * 8);
+        } else {
+            phys_addr = *(const uint32_t*)(entry_base + i * 4);
+        }
+
+        const hal_acpi_sdt_header_t* table = hal_acpi_map_table(phys_addr);
+        if (!table || !hal_acpi_signature_equals(table->signature, signature, 4)) {
+            continue;
+        }
+        if (instance-- == 0) {
+            return table;
+        }
+    }
+
+    return NULL;
+}
@@ -1,6 +1,7 @@
 #include "hal/hal_interface.h"
 #include "hal/hal_types.h"
 #include "hal/hal_cpu.h"
+#include "hal/hal_tsc.h"
 #include "kos/utils/string.h"
 #include "debug/debug.h"
 
@@ -29,7 +30,6 @@ typedef struct {
     hal_u32_t linear_address_width;
     hal_u32_t cache_hierarchy;
     hal_bool_t hyperthreading_enabled;
-    hal_u64_t msr_platform_info;
     hal_u64_t msr_tsc_aux;
 } hal_x86_64_cpu_info_t;
 
@@ -255,18 +255,8 @@ static void hal_x86_64_get_address_widths(void) {
 
 // Get TSC frequency
 static void hal_x86_64_get_tsc_frequency(void) {
-    // Try to get TSC frequency from MSR
-    g_x86_64_cpu_info.msr_platform_info = hal_x86_64_read_msr(0xCE);
-    
-    // Extract TSC frequency from platform info (if available)
-    hal_u64_t ratio = (g_x86_64_cpu_info.msr_platform_info >> 8) & 0xFF;
-    if (ratio != 0) {
-        // Assume base frequency of 100 MHz (this is a simplification)
-        g_x86_64_cpu_info.tsc_frequency = ratio * 100000000ULL;
-    } else {
-        // Use a reasonable default
-        g_x86_64_cpu_info.tsc_frequency = 2500000000ULL; // 2.5 GHz
-    }
+    // Calibrated against CPUID 0x15/0x16, the hypervisor leaf, the HPET or the PIT
+    g_x86_64_cpu_info.tsc_frequency = hal_tsc_calibrate();
 }
 
 // CPU initialization
@@ -575,7 +565,7 @@ static hal_result_t hal_x86_64_cpu_get_cycle_count(hal_u64_t* count) {
         return HAL_ERROR_INVALID_PARAM;
     }
     
-    asm volatile("rdtsc" : "=A" (*count));
+    *count = hal_tsc_read();
     return HAL_SUCCESS;
 }
 
@@ -585,7 +575,7 @@ static hal_result_t hal_x86_64_cpu_get_timestamp(hal_timestamp_t* timestamp) {
         return HAL_ERROR_INVALID_PARAM;
     }
     
-    asm volatile("rdtsc" : "=A" (*timestamp));
+    *timestamp = hal_tsc_read();
     return HAL_SUCCESS;
 }
 
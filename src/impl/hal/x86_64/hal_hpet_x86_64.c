@@ -0,0 +1,329 @@
+#include "hal/hal_hpet.h"
+#include "hal/hal_acpi.h"
+#include "hal/hal_mmio.h"
+#include "hal/hal_lapic.h"
+#include "kos/interrupts/interrupt.h"
+#include "kos/cpu/irqflags.h"
+#include "kos/time/clock.h"
+#include "debug/debug.h"
+
+// =============================================================================
+// KOS - HAL HPET x86_64 Implementation
+// =============================================================================
+
+#define HPET_MMIO_SIZE          0x400
+#define HPET_MAX_PERIOD_FS      100000000ULL     // 100 ns, per specification
+#define HPET_FS_PER_SEC         1000000000000000ULL
+#define HPET_MIN_EVENT_CYCLES   16
+
+// Global HPET state
+static volatile void* g_hpet_base = NULL;
+static uint64_t g_hpet_frequency = 0;
+static uint32_t g_hpet_timer_count = 0;
+static uint32_t g_hpet_min_tick = HPET_MIN_EVENT_CYCLES;
+static bool g_hpet_counter_64bit = false;
+static bool g_hpet_available = false;
+static bool g_hpet_initialized = false;
+
+// ns -> counter cycles conversion for event programming
+static uint32_t g_hpet_ns_mult = 0;
+static uint32_t g_hpet_ns_shift = 0;
+
+// Comparator event state
+static int32_t g_hpet_event_timer = -1;
+static int32_t g_hpet_event_irq = -1;
+static volatile bool g_hpet_event_armed = false;
+static hal_hpet_event_handler_t g_hpet_event_handler = NULL;
+static void* g_hpet_event_context = NULL;
+
+static void hal_hpet_chip_mask(uint32_t irq);
+static void hal_hpet_chip_unmask(uint32_t irq);
+static void hal_hpet_chip_eoi(uint32_t irq);
+
+// FSB messages land in the local APIC, the comparator enable bit masks them
+static const kos_irq_chip_t g_hpet_event_chip = {
+    .name = "HPET",
+    .mask = hal_hpet_chip_mask,
+    .unmask = hal_hpet_chip_unmask,
+    .eoi = hal_hpet_chip_eoi,
+    .mask_lines = NULL
+};
+
+// HPET clocksource read function
+static uint64_t hal_hpet_clocksource_read(kos_clocksource_t* cs) {
+    (void)cs;
+    return hal_hpet_read_counter();
+}
+
+static kos_clocksource_t g_hpet_clocksource = {
+    .name = "hpet",
+    .read = hal_hpet_clocksource_read,
+    .rating = KOS_CLOCKSOURCE_RATING_GOOD,
+    .flags = KOS_CLOCKSOURCE_FLAG_CONTINUOUS | KOS_CLOCKSOURCE_FLAG_INVARIANT
+};
+
+// Discover, map and start the HPET
+bool hal_hpet_init(void) {
+    if (g_hpet_initialized) {
+        return g_hpet_available;
+    }
+    g_hpet_initialized = true;
+
+    const hal_acpi_hpet_t* table = (const hal_acpi_hpet_t*)hal_acpi_find_table("HPET", 0);
+    if (!table) {
+        log_info("HPET: no ACPI HPET table");
+        return false;
+    }
+
+    if (table->base_address.address_space_id != HAL_ACPI_ADDRESS_SPACE_MEMORY ||
+        table->base_address.address == 0) {
+        log_warn("HPET: unsupported base address");
+        return false;
+    }
+
+    g_hpet_base = hal_mmio_map(table->base_address.address, HPET_MMIO_SIZE);
+    if (!g_hpet_base) {
+        return false;
+    }
+
+    uint64_t caps = hal_mmio_read64(g_hpet_base, HAL_HPET_REG_CAPABILITIES);
+    uint64_t period_fs = caps >> 32;
+    if (period_fs == 0 || period_fs > HPET_MAX_PERIOD_FS) {
+        log_warn("HPET: invalid counter period %d fs", (int)period_fs);
+        return false;
+    }
+
+    g_hpet_frequency = HPET_FS_PER_SEC / period_fs;
+    g_hpet_timer_count = ((caps >> 8) & 0x1F) + 1;
+    g_hpet_counter_64bit = (caps & HAL_HPET_CAP_COUNTER_64BIT) != 0;
+    if (table->minimum_tick > g_hpet_min_tick) {
+        g_hpet_min_tick = table->minimum_tick;
+    }
+
+    // Halt the counter, mask every comparator, then restart from zero
+    uint64_t config = hal_mmio_read64(g_hpet_base, HAL_HPET_REG_CONFIG);
+    config &= ~(HAL_HPET_CONFIG_ENABLE | HAL_HPET_CONFIG_LEGACY_ROUTE);
+    hal_mmio_write64(g_hpet_base, HAL_HPET_REG_CONFIG, config);
+
+    for (uint32_t i = 0; i < g_hpet_timer_count; i++) {
+        uint64_t timer = hal_mmio_read64(g_hpet_base, HAL_HPET_REG_TIMER_CONFIG(i));
+        timer &= ~(HAL_HPET_TIMER_INT_ENABLE | HAL_HPET_TIMER_PERIODIC | HAL_HPET_TIMER_FSB_ENABLE);
+        hal_mmio_write64(g_hpet_base, HAL_HPET_REG_TIMER_CONFIG(i), timer);
+    }
+
+    hal_mmio_write64(g_hpet_base, HAL_HPET_REG_MAIN_COUNTER, 0);
+    hal_mmio_write64(g_hpet_base, HAL_HPET_REG_CONFIG, config | HAL_HPET_CONFIG_ENABLE);
+
+    kos_clocks_calc_mult_shift(&g_hpet_ns_mult, &g_hpet_ns_shift, KOS_NSEC_PER_SEC,
+                               g_hpet_frequency, KOS_CLOCKSOURCE_MAX_DELTA_SEC);
+
+    g_hpet_clocksource.frequency = g_hpet_frequency;
+    g_hpet_clocksource.mask = g_hpet_counter_64bit ? ~0ULL : 0xFFFFFFFFULL;
+    kos_clocksource_register(&g_hpet_clocksource);
+
+    g_hpet_available = true;
+
+    log_info("HPET: %d kHz, %d comparators, %s counter at 0x%x",
+             (int)(g_hpet_frequency / 1000), (int)g_hpet_timer_count,
+             g_hpet_counter_64bit ? "64-bit" : "32-bit",
+             (uint32_t)table->base_address.address);
+
+    return true;
+}
+
+// Check if the HPET is usable
+bool hal_hpet_is_available(void) {
+    return g_hpet_available;
+}
+
+// Read the main counter
+uint64_t hal_hpet_read_counter(void) {
+    if (!g_hpet_available) {
+        return 0;
+    }
+
+    if (g_hpet_counter_64bit) {
+        return hal_mmio_read64(g_hpet_base, HAL_HPET_REG_MAIN_COUNTER);
+    }
+
+    return hal_mmio_read32(g_hpet_base, HAL_HPET_REG_MAIN_COUNTER);
+}
+
+// Get main counter frequency in Hz
+uint64_t hal_hpet_get_frequency(void) {
+    return g_hpet_frequency;
+}
+
+// Get the HPET clocksource
+kos_clocksource_t* hal_hpet_get_clocksource(void) {
+    return g_hpet_available ? &g_hpet_clocksource : NULL;
+}
+
+// Set or clear the comparator's interrupt enable
+static void hal_hpet_event_enable(bool enable) {
+    uint32_t index = (uint32_t)g_hpet_event_timer;
+    uint64_t timer = hal_mmio_read64(g_hpet_base, HAL_HPET_REG_TIMER_CONFIG(index));
+    timer = enable ? (timer | HAL_HPET_TIMER_INT_ENABLE) : (timer & ~HAL_HPET_TIMER_INT_ENABLE);
+    hal_mmio_write64(g_hpet_base, HAL_HPET_REG_TIMER_CONFIG(index), timer);
+}
+
+static void hal_hpet_chip_mask(uint32_t irq) {
+    (void)irq;
+    hal_hpet_event_enable(false);
+}
+
+// Only an armed comparator is let back on, a cancelled one stays quiet
+static void hal_hpet_chip_unmask(uint32_t irq) {
+    (void)irq;
+    if (g_hpet_event_armed) {
+        hal_hpet_event_enable(true);
+    }
+}
+
+static void hal_hpet_chip_eoi(uint32_t irq) {
+    (void)irq;
+    hal_lapic_eoi();
+}
+
+// Comparator interrupt handler. FSB messages are edge-triggered and leave no
+// status bit to clear. One already in flight when the event was cancelled or
+// reported as missed finds the comparator disarmed and is dropped.
+static kos_irq_return_t hal_hpet_irq_handler(uint32_t irq, void* context) {
+    (void)irq;
+    (void)context;
+
+    if (!g_hpet_event_armed) {
+        return KOS_IRQ_HANDLED;
+    }
+
+    g_hpet_event_armed = false;
+    if (g_hpet_event_handler) {
+        g_hpet_event_handler(g_hpet_event_context);
+    }
+    return KOS_IRQ_HANDLED;
+}
+
+// Pick an FSB-capable comparator and give it a vector on the boot CPU
+bool hal_hpet_event_init(hal_hpet_event_handler_t handler, void* context) {
+    if (!g_hpet_available || !handler) {
+        return false;
+    }
+    if (g_hpet_event_timer >= 0) {
+        return false;
+    }
+
+    int32_t index = -1;
+    for (uint32_t i = 0; i < g_hpet_timer_count && index < 0; i++) {
+        if (hal_mmio_read64(g_hpet_base, HAL_HPET_REG_TIMER_CONFIG(i)) & HAL_HPET_TIMER_FSB_CAP) {
+            index = (int32_t)i;
+        }
+    }
+    if (index < 0) {
+        log_info("HPET: no comparator supports FSB delivery, one-shot events unavailable");
+        return false;
+    }
+
+    uint32_t apic_id = hal_lapic_cpu_to_apic_id(0);
+    if (apic_id == HAL_LAPIC_INVALID_ID) {
+        return false;
+    }
+
+    // Timer events preempt device handlers, as the PIT does
+    kos_irq_t irq;
+    if (kos_interrupt_alloc_dynamic(KOS_INTERRUPT_PRIORITY_HIGH, 1, &g_hpet_event_chip, &irq) != KOS_SUCCESS) {
+        return false;
+    }
+
+    // Edge-triggered one-shot delivered as a fixed message, still disabled
+    uint32_t address = HAL_LAPIC_MSI_ADDRESS_BASE | (apic_id << HAL_LAPIC_MSI_DEST_SHIFT);
+    uint32_t data = kos_interrupt_get_vector(irq);
+    hal_mmio_write64(g_hpet_base, HAL_HPET_REG_TIMER_FSB_ROUTE(index), ((uint64_t)address << 32) | data);
+
+    uint64_t timer = hal_mmio_read64(g_hpet_base, HAL_HPET_REG_TIMER_CONFIG(index));
+    timer &= ~(HAL_HPET_TIMER_ROUTE_MASK | HAL_HPET_TIMER_LEVEL_TRIGGER |
+               HAL_HPET_TIMER_PERIODIC | HAL_HPET_TIMER_INT_ENABLE);
+    timer |= HAL_HPET_TIMER_FSB_ENABLE;
+    if (!g_hpet_counter_64bit) {
+        timer |= HAL_HPET_TIMER_FORCE_32BIT;
+    }
+    hal_mmio_write64(g_hpet_base, HAL_HPET_REG_TIMER_CONFIG(index), timer);
+
+    g_hpet_event_timer = index;
+    g_hpet_event_irq = (int32_t)irq;
+    g_hpet_event_handler = handler;
+    g_hpet_event_context = context;
+
+    if (kos_interrupt_register_handler(irq, hal_hpet_irq_handler, NULL, "HPET") != KOS_SUCCESS) {
+        kos_interrupt_free_dynamic(irq, 1);
+        g_hpet_event_timer = -1;
+        g_hpet_event_irq = -1;
+        return false;
+    }
+    kos_interrupt_set_rate_limit(irq, 0);
+
+    log_info("HPET: comparator %d delivers to vector 0x%x (IRQ %d)", (int)index, data, (int)irq);
+    return true;
+}
+
+// Arm the comparator for an absolute counter value, false if already passed
+bool hal_hpet_event_program_counter(uint64_t counter) {
+    if (g_hpet_event_timer < 0) {
+        return false;
+    }
+
+    uint32_t index = (uint32_t)g_hpet_event_timer;
+    uint64_t flags = kos_local_irq_save();
+
+    g_hpet_event_armed = true;
+    hal_mmio_write64(g_hpet_base, HAL_HPET_REG_TIMER_COMPARATOR(index), counter);
+    hal_hpet_event_enable(true);
+
+    // The comparator only fires on an exact match, so detect a missed target
+    uint64_t now = hal_hpet_read_counter();
+    bool pending = g_hpet_counter_64bit ? (int64_t)(counter - now) > 0
+                                        : (int32_t)((uint32_t)counter - (uint32_t)now) > 0;
+
+    if (pending) {
+        // Tell the dispatcher when the interrupt is due so it can measure entry latency
+        uint64_t remaining = (counter - now) & g_hpet_clocksource.mask;
+        uint64_t due_ns = kos_clocksource_cyc2ns(&g_hpet_clocksource, remaining);
+        kos_interrupt_set_expected((kos_irq_t)g_hpet_event_irq, kos_clock_cycles() + kos_clock_ns_to_cycles(due_ns));
+    } else {
+        g_hpet_event_armed = false;
+        hal_hpet_event_enable(false);
+    }
+
+    kos_local_irq_restore(flags);
+    return pending;
+}
+
+// Arm the comparator delta_ns from now
+bool hal_hpet_event_program_ns(uint64_t delta_ns) {
+    if (g_hpet_event_timer < 0) {
+        return false;
+    }
+
+    uint64_t cycles = (delta_ns * g_hpet_ns_mult) >> g_hpet_ns_shift;
+    if (cycles < g_hpet_min_tick) {
+        cycles = g_hpet_min_tick;
+    }
+
+    return hal_hpet_event_program_counter(hal_hpet_read_counter() + cycles);
+}
+
+// Disarm the comparator
+void hal_hpet_event_cancel(void) {
+    if (g_hpet_event_timer < 0) {
+        return;
+    }
+
+    uint64_t flags = kos_local_irq_save();
+    g_hpet_event_armed = false;
+    hal_hpet_event_enable(false);
+    kos_local_irq_restore(flags);
+}
+
+// Get the dynamic IRQ line of comparator events, -1 without one
+int32_t hal_hpet_event_get_irq(void) {
+    return g_hpet_event_irq;
+}
@@ -1,6 +1,7 @@
 #include "hal/hal_interface.h"
 #include "hal/hal_types.h"
 #include "hal/hal_interrupt.h"
+#include "hal/hal_lapic.h"
 #include "kos/utils/string.h"
 #include "debug/debug.h"
 
@@ -53,10 +54,12 @@ static hal_result_t hal_x86_64_interrupt_init(void) {
     g_interrupt_info.total_interrupts = 256;
     g_interrupt_info.available_interrupts = 224; // 0-31 exceptions, 32-255 IRQs
     g_interrupt_info.max_interrupt_priority = 15;
-    g_interrupt_info.has_apic = true;
+    g_interrupt_info.has_apic = hal_lapic_init();
     g_interrupt_info.has_pic = true;
-    g_interrupt_info.has_msi = true;
-    g_interrupt_info.has_msix = true;
+    
+    // Messages are delivered to the local APIC, so MSI needs one
+    g_interrupt_info.has_msi = g_interrupt_info.has_apic;
+    g_interrupt_info.has_msix = g_interrupt_info.has_apic;
     
     g_interrupt_initialized = true;
     
@@ -65,6 +68,7 @@ static hal_result_t hal_x86_64_interrupt_init(void) {
     log_info("Available Interrupts: %u", g_interrupt_info.available_interrupts);
     log_info("APIC: %s", g_interrupt_info.has_apic ? "Yes" : "No");
     log_info("PIC: %s", g_interrupt_info.has_pic ? "Yes" : "No");
+    log_info("MSI/MSI-X: %s", g_interrupt_info.has_msi ? "Yes" : "No");
     
     return HAL_SUCCESS;
 }
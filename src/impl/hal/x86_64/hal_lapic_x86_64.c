@@ -0,0 +1,201 @@
+#include "hal/hal_lapic.h"
+#include "hal/hal_mmio.h"
+#include "hal/hal_acpi.h"
+#include "debug/debug.h"
+
+// =============================================================================
+// KOS - HAL Local APIC x86_64 Implementation
+// =============================================================================
+
+#define LAPIC_MMIO_SIZE         0x1000
+#define LAPIC_CPUID_APIC        (1U << 9)
+#define LAPIC_ICR_SPIN_LIMIT    1000000
+
+// Global local APIC state
+static volatile void* g_lapic_base = NULL;
+static bool g_lapic_available = false;
+static bool g_lapic_initialized = false;
+
+// APIC IDs of the known CPUs, index 0 is the boot CPU
+static uint32_t g_lapic_cpu_ids[HAL_LAPIC_MAX_CPUS];
+static uint32_t g_lapic_cpu_count = 0;
+
+// CPUID wrapper
+static inline void hal_lapic_cpuid(uint32_t leaf, uint32_t subleaf, uint32_t* eax, uint32_t* ebx, uint32_t* ecx, uint32_t* edx) {
+    asm volatile("cpuid"
+                 : "=a" (*eax), "=b" (*ebx), "=c" (*ecx), "=d" (*edx)
+                 : "a" (leaf), "c" (subleaf));
+}
+
+// Read MSR
+static inline uint64_t hal_lapic_read_msr(uint32_t msr) {
+    uint32_t low, high;
+    asm volatile("rdmsr" : "=a" (low), "=d" (high) : "c" (msr));
+    return ((uint64_t)high << 32) | low;
+}
+
+// Write MSR
+static inline void hal_lapic_write_msr(uint32_t msr, uint64_t value) {
+    asm volatile("wrmsr" : : "c" (msr), "a" ((uint32_t)value), "d" ((uint32_t)(value >> 32)));
+}
+
+// Map and software-enable the boot CPU's local APIC. LINT0 is left as the
+// firmware set it up, so the 8259 keeps delivering through virtual wire mode.
+bool hal_lapic_init(void) {
+    if (g_lapic_initialized) {
+        return g_lapic_available;
+    }
+    g_lapic_initialized = true;
+
+    uint32_t eax, ebx, ecx, edx;
+    hal_lapic_cpuid(1, 0, &eax, &ebx, &ecx, &edx);
+    if (!(edx & LAPIC_CPUID_APIC)) {
+        log_info("LAPIC: not present");
+        return false;
+    }
+
+    uint64_t base_msr = hal_lapic_read_msr(HAL_LAPIC_BASE_MSR);
+    if (!(base_msr & HAL_LAPIC_BASE_ENABLE)) {
+        base_msr |= HAL_LAPIC_BASE_ENABLE;
+        hal_lapic_write_msr(HAL_LAPIC_BASE_MSR, base_msr);
+    }
+
+    g_lapic_base = hal_mmio_map(base_msr & HAL_LAPIC_BASE_ADDR_MASK, LAPIC_MMIO_SIZE);
+    if (!g_lapic_base) {
+        log_error("LAPIC: failed to map registers");
+        return false;
+    }
+
+    uint32_t svr = hal_mmio_read32(g_lapic_base, HAL_LAPIC_REG_SVR);
+    svr = (svr & ~0xFFU) | HAL_LAPIC_SVR_ENABLE | HAL_LAPIC_SPURIOUS_VECTOR;
+    hal_mmio_write32(g_lapic_base, HAL_LAPIC_REG_SVR, svr);
+
+    g_lapic_cpu_ids[0] = hal_lapic_get_id();
+    g_lapic_cpu_count = 1;
+    g_lapic_available = true;
+
+    log_info("LAPIC: id %d, version 0x%x", (int)g_lapic_cpu_ids[0],
+             hal_mmio_read32(g_lapic_base, HAL_LAPIC_REG_VERSION) & 0xFF);
+    return true;
+}
+
+// Software-enable an application processor's local APIC, the registers
+// are at the same physical address on every CPU
+bool hal_lapic_init_ap(void) {
+    if (!g_lapic_available) {
+        return false;
+    }
+
+    uint64_t base_msr = hal_lapic_read_msr(HAL_LAPIC_BASE_MSR);
+    if (!(base_msr & HAL_LAPIC_BASE_ENABLE)) {
+        hal_lapic_write_msr(HAL_LAPIC_BASE_MSR, base_msr | HAL_LAPIC_BASE_ENABLE);
+    }
+
+    uint32_t svr = hal_mmio_read32(g_lapic_base, HAL_LAPIC_REG_SVR);
+    svr = (svr & ~0xFFU) | HAL_LAPIC_SVR_ENABLE | HAL_LAPIC_SPURIOUS_VECTOR;
+    hal_mmio_write32(g_lapic_base, HAL_LAPIC_REG_SVR, svr);
+    hal_mmio_write32(g_lapic_base, HAL_LAPIC_REG_TPR, 0);
+    return true;
+}
+
+// Fill the CPU list from the MADT, the boot CPU stays at index 0
+uint32_t hal_lapic_enumerate_cpus(void) {
+    if (!g_lapic_available) {
+        return g_lapic_cpu_count;
+    }
+
+    const hal_acpi_madt_t* madt = (const hal_acpi_madt_t*)hal_acpi_find_table("APIC", 0);
+    if (!madt) {
+        log_info("LAPIC: no MADT, boot CPU only");
+        return g_lapic_cpu_count;
+    }
+
+    const uint8_t* entry = (const uint8_t*)(madt + 1);
+    const uint8_t* end = (const uint8_t*)madt + madt->header.length;
+    while (entry + sizeof(hal_acpi_madt_entry_t) <= end) {
+        const hal_acpi_madt_entry_t* header = (const hal_acpi_madt_entry_t*)entry;
+        if (header->length < sizeof(hal_acpi_madt_entry_t) || entry + header->length > end) {
+            break;
+        }
+
+        if (header->type == HAL_ACPI_MADT_TYPE_LAPIC) {
+            const hal_acpi_madt_lapic_t* lapic = (const hal_acpi_madt_lapic_t*)entry;
+            bool usable = (lapic->flags & (HAL_ACPI_MADT_LAPIC_ENABLED | HAL_ACPI_MADT_LAPIC_ONLINE_CAPABLE)) != 0;
+
+            if (usable && lapic->apic_id != g_lapic_cpu_ids[0]) {
+                if (g_lapic_cpu_count < HAL_LAPIC_MAX_CPUS) {
+                    g_lapic_cpu_ids[g_lapic_cpu_count++] = lapic->apic_id;
+                } else {
+                    log_warn("LAPIC: CPU with APIC id %d over the limit", (int)lapic->apic_id);
+                }
+            }
+        }
+
+        entry += header->length;
+    }
+
+    log_info("LAPIC: %d CPUs in the MADT", (int)g_lapic_cpu_count);
+    return g_lapic_cpu_count;
+}
+
+// Number of known CPUs
+uint32_t hal_lapic_cpu_count(void) {
+    return g_lapic_cpu_count;
+}
+
+// Send an IPI and wait until the APIC has accepted it
+bool hal_lapic_send_ipi(uint32_t apic_id, uint32_t command) {
+    if (!g_lapic_available) {
+        return false;
+    }
+
+    hal_mmio_write32(g_lapic_base, HAL_LAPIC_REG_ICR_HIGH, apic_id << HAL_LAPIC_ICR_DEST_SHIFT);
+    hal_mmio_write32(g_lapic_base, HAL_LAPIC_REG_ICR_LOW, command);
+
+    for (uint32_t spin = 0; spin < LAPIC_ICR_SPIN_LIMIT; spin++) {
+        if (!(hal_mmio_read32(g_lapic_base, HAL_LAPIC_REG_ICR_LOW) & HAL_LAPIC_ICR_PENDING)) {
+            return true;
+        }
+        asm volatile("pause");
+    }
+
+    return false;
+}
+
+// INIT IPI, puts the target into wait-for-SIPI
+bool hal_lapic_send_init(uint32_t apic_id) {
+    return hal_lapic_send_ipi(apic_id, HAL_LAPIC_ICR_INIT | HAL_LAPIC_ICR_ASSERT | HAL_LAPIC_ICR_LEVEL);
+}
+
+// Startup IPI, the target starts in real mode at page << 12
+bool hal_lapic_send_startup(uint32_t apic_id, uint32_t page) {
+    return hal_lapic_send_ipi(apic_id, HAL_LAPIC_ICR_STARTUP | (page & 0xFF));
+}
+
+// Check whether the local APIC is usable
+bool hal_lapic_is_available(void) {
+    return g_lapic_available;
+}
+
+// APIC ID of the calling CPU
+uint32_t hal_lapic_get_id(void) {
+    if (!g_lapic_base) {
+        return 0;
+    }
+
+    return hal_mmio_read32(g_lapic_base, HAL_LAPIC_REG_ID) >> 24;
+}
+
+// Signal end of interrupt for the highest in-service vector
+void hal_lapic_eoi(void) {
+    hal_mmio_write32(g_lapic_base, HAL_LAPIC_REG_EOI, 0);
+}
+
+// CPU index to APIC ID
+uint32_t hal_lapic_cpu_to_apic_id(uint32_t cpu) {
+    if (cpu >= g_lapic_cpu_count) {
+        return HAL_LAPIC_INVALID_ID;
+    }
+
+    return g_lapic_cpu_ids[cpu];
+}
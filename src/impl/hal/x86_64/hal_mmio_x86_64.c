@@ -0,0 +1,112 @@
+#include "hal/hal_mmio.h"
+#include "debug/debug.h"
+
+// =============================================================================
+// KOS - HAL MMIO Mapping x86_64 Implementation
+// =============================================================================
+
+// The boot page tables identity-map only the first 1 GiB. Device windows
+// such as the HPET, LAPIC and IOAPIC live just below 4 GiB, so they get
+// identity-mapped here with uncached 2 MiB pages.
+
+#define MMIO_PAGE_PRESENT       0x001ULL
+#define MMIO_PAGE_WRITABLE      0x002ULL
+#define MMIO_PAGE_WRITE_THROUGH 0x008ULL
+#define MMIO_PAGE_CACHE_DISABLE 0x010ULL
+#define MMIO_PAGE_LARGE         0x080ULL
+#define MMIO_PAGE_ADDR_MASK     0x000FFFFFFFFFF000ULL
+
+#define MMIO_LARGE_PAGE_SIZE    0x200000ULL
+#define MMIO_TABLE_ENTRIES      512
+#define MMIO_TABLE_POOL_SIZE    8
+
+// Page tables for new mappings (identity-mapped kernel .bss)
+static uint64_t g_mmio_table_pool[MMIO_TABLE_POOL_SIZE][MMIO_TABLE_ENTRIES] __attribute__((aligned(4096)));
+static uint32_t g_mmio_tables_used = 0;
+
+static inline uint64_t hal_mmio_read_cr3(void) {
+    uint64_t cr3;
+    asm volatile("mov %%cr3, %0" : "=r" (cr3));
+    return cr3;
+}
+
+static inline void hal_mmio_invlpg(uint64_t addr) {
+    asm volatile("invlpg (%0)" : : "r" (addr) : "memory");
+}
+
+// Take a zeroed page table from the pool
+static uint64_t* hal_mmio_alloc_table(void) {
+    if (g_mmio_tables_used >= MMIO_TABLE_POOL_SIZE) {
+        return NULL;
+    }
+
+    uint64_t* table = g_mmio_table_pool[g_mmio_tables_used++];
+    for (int i = 0; i < MMIO_TABLE_ENTRIES; i++) {
+        table[i] = 0;
+    }
+    return table;
+}
+
+// Get (or create) the next-level table referenced by an entry
+static uint64_t* hal_mmio_next_level(uint64_t* table, uint32_t index) {
+    if (!(table[index] & MMIO_PAGE_PRESENT)) {
+        uint64_t* next = hal_mmio_alloc_table();
+        if (!next) {
+            return NULL;
+        }
+        table[index] = (uint64_t)(uintptr_t)next | MMIO_PAGE_PRESENT | MMIO_PAGE_WRITABLE;
+    }
+
+    return (uint64_t*)(uintptr_t)(table[index] & MMIO_PAGE_ADDR_MASK);
+}
+
+// Identity-map one 2 MiB page, leaving existing mappings untouched
+static bool hal_mmio_map_large_page(uint64_t addr) {
+    uint64_t* l4 = (uint64_t*)(uintptr_t)(hal_mmio_read_cr3() & MMIO_PAGE_ADDR_MASK);
+    uint32_t l4_index = (addr >> 39) & 0x1FF;
+    uint32_t l3_index = (addr >> 30) & 0x1FF;
+    uint32_t l2_index = (addr >> 21) & 0x1FF;
+
+    uint64_t* l3 = hal_mmio_next_level(l4, l4_index);
+    if (!l3) {
+        return false;
+    }
+
+    // Already covered by a 1 GiB page
+    if ((l3[l3_index] & MMIO_PAGE_PRESENT) && (l3[l3_index] & MMIO_PAGE_LARGE)) {
+        return true;
+    }
+
+    uint64_t* l2 = hal_mmio_next_level(l3, l3_index);
+    if (!l2) {
+        return false;
+    }
+
+    if (l2[l2_index] & MMIO_PAGE_PRESENT) {
+        return true;
+    }
+
+    l2[l2_index] = addr | MMIO_PAGE_PRESENT | MMIO_PAGE_WRITABLE |
+                   MMIO_PAGE_WRITE_THROUGH | MMIO_PAGE_CACHE_DISABLE | MMIO_PAGE_LARGE;
+    hal_mmio_invlpg(addr);
+    return true;
+}
+
+// Identity-map a physical MMIO range
+volatile void* hal_mmio_map(uint64_t phys_addr, uint64_t size) {
+    if (size == 0) {
+        return NULL;
+    }
+
+    uint64_t start = phys_addr & ~(MMIO_LARGE_PAGE_SIZE - 1);
+    uint64_t end = phys_addr + size;
+
+    for (uint64_t addr = start; addr < end; addr += MMIO_LARGE_PAGE_SIZE) {
+        if (!hal_mmio_map_large_page(addr)) {
+            log_error("MMIO: out of page tables mapping 0x%x", (uint32_t)addr);
+            return NULL;
+        }
+    }
+
+    return (volatile void*)(uintptr_t)phys_addr;
+}
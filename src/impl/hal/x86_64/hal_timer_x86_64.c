@@ -1,6 +1,10 @@
 #include "hal/hal_interface.h"
 #include "hal/hal_types.h"
 #include "hal/hal_timer_simple.h"
+#include "hal/hal_tsc.h"
+#include "hal/hal_hpet.h"
+#include "kos/time/sleep.h"
+#include "kos/time/clocksource.h"
 #include "kos/utils/string.h"
 #include "debug/debug.h"
 
@@ -58,9 +62,9 @@ static hal_result_t hal_x86_64_timer_init(void) {
     g_timer_info.max_frequency = 10000000; // 10 MHz max
     g_timer_info.has_pit = true;
     g_timer_info.has_apic_timer = true;
-    g_timer_info.has_tsc = true;
-    g_timer_info.has_hpet = false; // TODO: Implement HPET detection
-    g_timer_info.tsc_frequency = 2500000000ULL; // 2.5 GHz default
+    g_timer_info.has_tsc = hal_tsc_is_present();
+    g_timer_info.has_hpet = hal_hpet_init();
+    g_timer_info.tsc_frequency = hal_tsc_get_frequency();
     
     g_timer_initialized = true;
     
@@ -151,7 +155,7 @@ static hal_result_t hal_x86_64_timer_get_timestamp(hal_timestamp_t* timestamp) {
         return HAL_ERROR_INVALID_PARAM;
     }
     
-    asm volatile("rdtsc" : "=A" (*timestamp));
+    *timestamp = hal_tsc_read();
     return HAL_SUCCESS;
 }
 
@@ -161,7 +165,7 @@ static hal_result_t hal_x86_64_timer_get_cycle_count(hal_u64_t* count) {
         return HAL_ERROR_INVALID_PARAM;
     }
     
-    asm volatile("rdtsc" : "=A" (*count));
+    *count = hal_tsc_read();
     return HAL_SUCCESS;
 }
 
@@ -181,23 +185,8 @@ static hal_result_t hal_x86_64_timer_delay(hal_u32_t milliseconds) {
         return HAL_ERROR_INVALID_STATE;
     }
     
-    // Simple delay using busy waiting
-    hal_u64_t start_time;
-    asm volatile("rdtsc" : "=A" (start_time));
-    
-    hal_u64_t delay_cycles = (hal_u64_t)milliseconds * (g_timer_info.tsc_frequency / 1000ULL);
-    
-    while (true) {
-        hal_u64_t current_time;
-        asm volatile("rdtsc" : "=A" (current_time));
-        
-        if ((current_time - start_time) >= delay_cycles) {
-            break;
-        }
-        
-        // Add a small pause to avoid busy waiting too aggressively
-        asm volatile("pause");
-    }
+    // Spins only for the sub-threshold tail, blocks for the rest
+    kos_sleep_ns((hal_u64_t)milliseconds * KOS_NSEC_PER_MSEC);
     
     return HAL_SUCCESS;
 }
@@ -0,0 +1,357 @@
+#include "hal/hal_tsc.h"
+#include "hal/hal_hpet.h"
+#include "kos/cpu/ports.h"
+#include "debug/debug.h"
+
+// =============================================================================
+// KOS - HAL TSC Calibration x86_64 Implementation
+// =============================================================================
+
+// PIT constants for channel 2 calibration
+#define PIT_FREQUENCY           1193182ULL
+#define PIT_CHANNEL2_DATA       0x42
+#define PIT_COMMAND             0x43
+#define PIT_GATE_PORT           0x61
+#define PIT_GATE_ENABLE         0x01
+#define PIT_SPEAKER_ENABLE      0x02
+#define PIT_OUTPUT_HIGH         0x20
+
+// Calibration parameters
+#define TSC_CALIBRATE_MS        10
+#define TSC_CALIBRATE_RUNS      3
+#define TSC_CALIBRATE_MAX_LOOPS 0x10000000ULL
+#define TSC_DEFAULT_FREQUENCY   2500000000ULL
+
+// Global TSC state
+static uint64_t g_tsc_frequency = 0;
+static hal_tsc_calibration_t g_tsc_calibration_source = HAL_TSC_CALIBRATION_NONE;
+static bool g_tsc_present = false;
+static bool g_tsc_invariant = false;
+static bool g_tsc_calibrated = false;
+
+static const char* g_tsc_calibration_names[] = {
+    "none",
+    "CPUID 0x15",
+    "hypervisor",
+    "HPET",
+    "PIT",
+    "CPUID 0x16",
+    "default"
+};
+
+// TSC clocksource read function
+static uint64_t hal_tsc_clocksource_read(kos_clocksource_t* cs) {
+    (void)cs;
+    return hal_tsc_read();
+}
+
+static kos_clocksource_t g_tsc_clocksource = {
+    .name = "tsc",
+    .read = hal_tsc_clocksource_read,
+    .mask = ~0ULL,
+    .rating = KOS_CLOCKSOURCE_RATING_POOR
+};
+
+// CPUID wrapper
+static inline void hal_tsc_cpuid(uint32_t leaf, uint32_t subleaf, uint32_t* eax, uint32_t* ebx, uint32_t* ecx, uint32_t* edx) {
+    asm volatile("cpuid"
+                 : "=a" (*eax), "=b" (*ebx), "=c" (*ecx), "=d" (*edx)
+                 : "a" (leaf), "c" (subleaf));
+}
+
+// Save flags and disable interrupts
+static inline uint64_t hal_tsc_irq_save(void) {
+    uint64_t flags;
+    asm volatile("pushfq; pop %0; cli" : "=r" (flags) : : "memory");
+    return flags;
+}
+
+// Restore saved interrupt state
+static inline void hal_tsc_irq_restore(uint64_t flags) {
+    asm volatile("push %0; popfq" : : "r" (flags) : "memory", "cc");
+}
+
+// Detect TSC presence and invariance
+static void hal_tsc_detect_features(void) {
+    uint32_t eax, ebx, ecx, edx;
+
+    hal_tsc_cpuid(1, 0, &eax, &ebx, &ecx, &edx);
+    g_tsc_present = (edx & (1 << 4)) != 0;
+
+    // Invariant TSC: CPUID 0x80000007 EDX bit 8
+    hal_tsc_cpuid(0x80000000, 0, &eax, &ebx, &ecx, &edx);
+    if (eax >= 0x80000007) {
+        hal_tsc_cpuid(0x80000007, 0, &eax, &ebx, &ecx, &edx);
+        g_tsc_invariant = (edx & (1 << 8)) != 0;
+    }
+}
+
+// Frequency from the crystal clock ratio in CPUID 0x15
+static uint64_t hal_tsc_calibrate_cpuid_15h(void) {
+    uint32_t max_leaf, denominator, numerator, crystal_hz, edx;
+
+    hal_tsc_cpuid(0, 0, &max_leaf, &numerator, &crystal_hz, &edx);
+    if (max_leaf < 0x15) {
+        return 0;
+    }
+
+    hal_tsc_cpuid(0x15, 0, &denominator, &numerator, &crystal_hz, &edx);
+    if (denominator == 0 || numerator == 0) {
+        return 0;
+    }
+
+    // Crystal not enumerated: derive it from the nominal base frequency
+    if (crystal_hz == 0 && max_leaf >= 0x16) {
+        uint32_t base_mhz, ebx, ecx;
+        hal_tsc_cpuid(0x16, 0, &base_mhz, &ebx, &ecx, &edx);
+        crystal_hz = (uint32_t)(((uint64_t)base_mhz * 1000000ULL * denominator) / numerator);
+    }
+
+    if (crystal_hz == 0) {
+        return 0;
+    }
+
+    return ((uint64_t)crystal_hz * numerator) / denominator;
+}
+
+// Frequency reported by the hypervisor timing leaf
+static uint64_t hal_tsc_calibrate_hypervisor(void) {
+    uint32_t eax, ebx, ecx, edx;
+
+    hal_tsc_cpuid(1, 0, &eax, &ebx, &ecx, &edx);
+    if (!(ecx & (1U << 31))) {
+        return 0;
+    }
+
+    hal_tsc_cpuid(0x40000000, 0, &eax, &ebx, &ecx, &edx);
+    if (eax < 0x40000010) {
+        return 0;
+    }
+
+    // EAX holds the TSC frequency in kHz
+    hal_tsc_cpuid(0x40000010, 0, &eax, &ebx, &ecx, &edx);
+    return (uint64_t)eax * 1000ULL;
+}
+
+// One PIT channel 2 measurement, returns TSC ticks or 0 on failure
+static uint64_t hal_tsc_pit_measure(uint32_t ms) {
+    uint32_t latch = (uint32_t)((PIT_FREQUENCY * ms) / 1000);
+
+    // Gate high, speaker off
+    uint8_t gate = kos_port_byte_in(PIT_GATE_PORT);
+    kos_port_byte_out(PIT_GATE_PORT, (gate & ~PIT_SPEAKER_ENABLE) | PIT_GATE_ENABLE);
+
+    // Channel 2, lobyte/hibyte, mode 0 (interrupt on terminal count)
+    kos_port_byte_out(PIT_COMMAND, 0xB0);
+    kos_port_byte_out(PIT_CHANNEL2_DATA, latch & 0xFF);
+    kos_port_byte_out(PIT_CHANNEL2_DATA, (latch >> 8) & 0xFF);
+
+    uint64_t start = hal_tsc_read_ordered();
+    uint64_t loops = 0;
+    while ((kos_port_byte_in(PIT_GATE_PORT) & PIT_OUTPUT_HIGH) == 0) {
+        if (++loops > TSC_CALIBRATE_MAX_LOOPS) {
+            kos_port_byte_out(PIT_GATE_PORT, gate);
+            return 0;
+        }
+    }
+    uint64_t end = hal_tsc_read_ordered();
+
+    kos_port_byte_out(PIT_GATE_PORT, gate);
+    return end - start;
+}
+
+// Frequency measured against PIT channel 2
+static uint64_t hal_tsc_calibrate_pit(void) {
+    uint64_t flags = hal_tsc_irq_save();
+    uint64_t best = 0;
+
+    // Interference only lengthens a run, so keep the shortest
+    for (int run = 0; run < TSC_CALIBRATE_RUNS; run++) {
+        uint64_t delta = hal_tsc_pit_measure(TSC_CALIBRATE_MS);
+        if (delta == 0) {
+            best = 0;
+            break;
+        }
+        if (best == 0 || delta < best) {
+            best = delta;
+        }
+    }
+
+    hal_tsc_irq_restore(flags);
+
+    return best * (1000 / TSC_CALIBRATE_MS);
+}
+
+// One HPET measurement, returns TSC frequency in Hz or 0 on failure
+static uint64_t hal_tsc_hpet_measure(uint32_t ms) {
+    uint64_t hpet_frequency = hal_hpet_get_frequency();
+    uint64_t hpet_cycles = (hpet_frequency * ms) / 1000;
+    uint64_t hpet_mask = hal_hpet_get_clocksource()->mask;
+
+    uint64_t hpet_start = hal_hpet_read_counter();
+    uint64_t tsc_start = hal_tsc_read_ordered();
+    uint64_t hpet_end;
+    uint64_t loops = 0;
+    do {
+        hpet_end = hal_hpet_read_counter();
+        if (++loops > TSC_CALIBRATE_MAX_LOOPS) {
+            return 0;
+        }
+    } while (((hpet_end - hpet_start) & hpet_mask) < hpet_cycles);
+    uint64_t tsc_end = hal_tsc_read_ordered();
+
+    return ((tsc_end - tsc_start) * hpet_frequency) / ((hpet_end - hpet_start) & hpet_mask);
+}
+
+// Frequency measured against the HPET main counter
+static uint64_t hal_tsc_calibrate_hpet(void) {
+    if (!hal_hpet_init()) {
+        return 0;
+    }
+
+    uint64_t flags = hal_tsc_irq_save();
+    uint64_t samples[TSC_CALIBRATE_RUNS];
+
+    for (int run = 0; run < TSC_CALIBRATE_RUNS; run++) {
+        samples[run] = hal_tsc_hpet_measure(TSC_CALIBRATE_MS);
+    }
+
+    hal_tsc_irq_restore(flags);
+
+    // Median of the runs
+    for (int i = 1; i < TSC_CALIBRATE_RUNS; i++) {
+        for (int j = i; j > 0 && samples[j - 1] > samples[j]; j--) {
+            uint64_t tmp = samples[j];
+            samples[j] = samples[j - 1];
+            samples[j - 1] = tmp;
+        }
+    }
+
+    return samples[TSC_CALIBRATE_RUNS / 2];
+}
+
+// Nominal base frequency from CPUID 0x16
+static uint64_t hal_tsc_calibrate_cpuid_16h(void) {
+    uint32_t eax, ebx, ecx, edx;
+
+    hal_tsc_cpuid(0, 0, &eax, &ebx, &ecx, &edx);
+    if (eax < 0x16) {
+        return 0;
+    }
+
+    hal_tsc_cpuid(0x16, 0, &eax, &ebx, &ecx, &edx);
+    return (uint64_t)(eax & 0xFFFF) * 1000000ULL;
+}
+
+// Calibrate the TSC and register it as a clocksource
+uint64_t hal_tsc_calibrate(void) {
+    if (g_tsc_calibrated) {
+        return g_tsc_frequency;
+    }
+
+    hal_tsc_detect_features();
+    if (!g_tsc_present) {
+        log_warn("TSC not present");
+        return 0;
+    }
+
+    // Exact sources first, then measurements, then nominal values
+    uint64_t frequency = hal_tsc_calibrate_cpuid_15h();
+    hal_tsc_calibration_t source = HAL_TSC_CALIBRATION_CPUID_15H;
+
+    if (frequency == 0) {
+        frequency = hal_tsc_calibrate_hypervisor();
+        source = HAL_TSC_CALIBRATION_HYPERVISOR;
+    }
+    if (frequency == 0) {
+        frequency = hal_tsc_calibrate_hpet();
+        source = HAL_TSC_CALIBRATION_HPET;
+    }
+    if (frequency == 0) {
+        frequency = hal_tsc_calibrate_pit();
+        source = HAL_TSC_CALIBRATION_PIT;
+    }
+    if (frequency == 0) {
+        frequency = hal_tsc_calibrate_cpuid_16h();
+        source = HAL_TSC_CALIBRATION_CPUID_16H;
+    }
+    if (frequency == 0) {
+        frequency = TSC_DEFAULT_FREQUENCY;
+        source = HAL_TSC_CALIBRATION_DEFAULT;
+        log_warn("TSC calibration failed, assuming default frequency");
+    }
+
+    g_tsc_frequency = frequency;
+    g_tsc_calibration_source = source;
+    g_tsc_calibrated = true;
+
+    // Only an invariant TSC is a trustworthy system clock
+    g_tsc_clocksource.frequency = frequency;
+    if (g_tsc_invariant) {
+        g_tsc_clocksource.rating = KOS_CLOCKSOURCE_RATING_BEST;
+        g_tsc_clocksource.flags = KOS_CLOCKSOURCE_FLAG_CONTINUOUS |
+                                  KOS_CLOCKSOURCE_FLAG_INVARIANT |
+                                  KOS_CLOCKSOURCE_FLAG_PER_CPU;
+    } else {
+        g_tsc_clocksource.rating = KOS_CLOCKSOURCE_RATING_POOR;
+        g_tsc_clocksource.flags = KOS_CLOCKSOURCE_FLAG_PER_CPU |
+                                  KOS_CLOCKSOURCE_FLAG_UNSTABLE;
+    }
+    kos_clocksource_register(&g_tsc_clocksource);
+
+    log_info("TSC: %d kHz via %s, invariant: %s",
+             (int)(frequency / 1000), hal_tsc_calibration_source_name(source),
+             g_tsc_invariant ? "yes" : "no");
+
+    return frequency;
+}
+
+// Get calibrated TSC frequency in Hz
+uint64_t hal_tsc_get_frequency(void) {
+    if (!g_tsc_calibrated) {
+        return hal_tsc_calibrate();
+    }
+
+    return g_tsc_frequency;
+}
+
+// Check if the CPU has a TSC
+bool hal_tsc_is_present(void) {
+    if (!g_tsc_calibrated) {
+        hal_tsc_detect_features();
+    }
+
+    return g_tsc_present;
+}
+
+// Check if the TSC runs at a constant rate in all P/C-states
+bool hal_tsc_is_invariant(void) {
+    if (!g_tsc_calibrated) {
+        hal_tsc_detect_features();
+    }
+
+    return g_tsc_invariant;
+}
+
+// Get the calibration source used
+hal_tsc_calibration_t hal_tsc_get_calibration_source(void) {
+    return g_tsc_calibration_source;
+}
+
+// Get calibration source name
+const char* hal_tsc_calibration_source_name(hal_tsc_calibration_t source) {
+    if (source > HAL_TSC_CALIBRATION_DEFAULT) {
+        return "unknown";
+    }
+
+    return g_tsc_calibration_names[source];
+}
+
+// Get the TSC clocksource (calibrating on first use)
+kos_clocksource_t* hal_tsc_get_clocksource(void) {
+    if (!g_tsc_calibrated && hal_tsc_calibrate() == 0) {
+        return NULL;
+    }
+
+    return &g_tsc_clocksource;
+}
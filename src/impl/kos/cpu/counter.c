@@ -0,0 +1,89 @@
+#include "kos/cpu/counter.h"
+#include "debug/debug.h"
+
+// =============================================================================
+// KOS - Per-CPU Event Counter Implementation
+// =============================================================================
+
+// Totals at the last reset. Slots are only ever written by their own CPU,
+// so a reset moves the baseline instead of clearing them.
+static uint64_t g_counter_base[KOS_COUNTER_MAX];
+
+// Check the section fits the per-CPU slot array
+kos_result_t kos_counter_init(void) {
+    uint32_t count = (uint32_t)(__stop_kos_counters - __start_kos_counters);
+
+    if (count > KOS_COUNTER_MAX) {
+        log_error("Counters: %u defined, only %u slots per CPU", count, KOS_COUNTER_MAX);
+        return KOS_ERROR_OUT_OF_MEMORY;
+    }
+
+    log_info("Counters: %u registered", count);
+    return KOS_SUCCESS;
+}
+
+// Number of defined counters that have a slot
+uint32_t kos_counter_count(void) {
+    uint32_t count = (uint32_t)(__stop_kos_counters - __start_kos_counters);
+    return count < KOS_COUNTER_MAX ? count : KOS_COUNTER_MAX;
+}
+
+// Counter descriptor by index, for enumeration
+const kos_counter_t* kos_counter_at(uint32_t index) {
+    if (index >= kos_counter_count()) {
+        return NULL;
+    }
+
+    return &__start_kos_counters[index];
+}
+
+// Raw total over all CPUs
+static uint64_t kos_counter_sum(uint32_t index) {
+    uint64_t total = 0;
+
+    for (uint32_t i = 0; i < kos_percpu_count(); i++) {
+        kos_cpu_local_t* cpu = kos_percpu_get(i);
+        if (cpu) {
+            total += *(volatile uint64_t*)&cpu->counters[index];
+        }
+    }
+
+    return total;
+}
+
+// Total since the last reset
+uint64_t kos_counter_read(const kos_counter_t* counter) {
+    if (!counter) {
+        return 0;
+    }
+
+    uint32_t index = kos_counter_index(counter);
+    return kos_counter_sum(index) - g_counter_base[index];
+}
+
+// One CPU's share, not adjusted for resets
+uint64_t kos_counter_read_cpu(const kos_counter_t* counter, uint32_t cpu_id) {
+    kos_cpu_local_t* cpu = kos_percpu_get(cpu_id);
+    if (!counter || !cpu) {
+        return 0;
+    }
+
+    return *(volatile uint64_t*)&cpu->counters[kos_counter_index(counter)];
+}
+
+// Restart a counter from zero
+void kos_counter_reset(const kos_counter_t* counter) {
+    if (!counter) {
+        return;
+    }
+
+    uint32_t index = kos_counter_index(counter);
+    g_counter_base[index] = kos_counter_sum(index);
+}
+
+// Restart every counter from zero
+void kos_counter_reset_all(void) {
+    for (uint32_t i = 0; i < kos_counter_count(); i++) {
+        g_counter_base[i] = kos_counter_sum(i);
+    }
+}
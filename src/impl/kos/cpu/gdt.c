@@ -17,11 +17,13 @@ typedef enum {
 } kos_result_t;
 
 // GDT constants
-#define KOS_GDT_MAX_ENTRIES 5
+#define KOS_GDT_MAX_ENTRIES 7
 #define KOS_GDT_KERNEL_CODE 1
 #define KOS_GDT_KERNEL_DATA 2
-#define KOS_GDT_USER_CODE 3
-#define KOS_GDT_USER_DATA 4
+#define KOS_GDT_USER_DATA 3
+#define KOS_GDT_USER_CODE 4
+#define KOS_GDT_TSS 5
+#define KOS_GDT_TSS_SELECTOR (KOS_GDT_TSS * 8)
 
 // GDT flags
 #define KOS_GDT_FLAG_PRESENT 0x80
@@ -47,6 +49,16 @@ typedef struct {
     kos_gdt_pointer_t pointer;
 } kos_gdt_t;
 
+typedef struct {
+    u32 reserved0;
+    u64 rsp[3];
+    u64 reserved1;
+    u64 ist[7];
+    u64 reserved2;
+    u16 reserved3;
+    u16 iomap_base;
+} __attribute__((packed)) kos_tss_t;
+
 // GDT functions
 kos_result_t kos_gdt_create_entry(kos_gdt_entry_t* entry, u32 base, u32 limit, u8 access, u8 flags) {
     if (!entry) {
@@ -137,6 +149,32 @@ kos_result_t kos_gdt_setup_user_segments(kos_gdt_t* gdt) {
     return KOS_SUCCESS;
 }
 
+kos_result_t kos_gdt_setup_tss(kos_gdt_t* gdt, kos_tss_t* tss) {
+    if (!gdt || !tss) {
+        return KOS_ERROR_INVALID_PARAM;
+    }
+    
+    // Available 64-bit TSS, no I/O permission bitmap
+    tss->iomap_base = sizeof(kos_tss_t);
+    
+    u64 base = (u64)tss;
+    u64 limit = sizeof(kos_tss_t) - 1;
+    u64 low = 0;
+    low |= limit & 0xFFFF;
+    low |= (base & 0xFFFFFF) << 16;
+    low |= (u64)(0x89 | KOS_GDT_FLAG_PRESENT) << 40;
+    low |= ((limit >> 16) & 0xF) << 48;
+    low |= ((base >> 24) & 0xFF) << 56;
+    
+    gdt->entries[KOS_GDT_TSS].raw = low;
+    gdt->entries[KOS_GDT_TSS + 1].raw = base >> 32;
+    return KOS_SUCCESS;
+}
+
+void kos_gdt_load_tss(void) {
+    asm volatile("ltr %w0" : : "r"((u16)KOS_GDT_TSS_SELECTOR));
+}
+
 void kos_gdt_load(const kos_gdt_t* gdt) {
     if (!gdt) {
         return;
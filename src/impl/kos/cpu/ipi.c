@@ -0,0 +1,384 @@
+#include "kos/cpu/ipi.h"
+#include "kos/cpu/irqflags.h"
+#include "kos/sync/spinlock.h"
+#include "kos/time/clock.h"
+#include "kos/utils/string.h"
+#include "hal/hal_lapic.h"
+#include "debug/debug.h"
+
+// =============================================================================
+// KOS - Inter-Processor Interrupt Implementation
+// =============================================================================
+
+// Remote call, one node per target so each CPU can queue it independently
+typedef struct kos_ipi_call_node {
+    struct kos_ipi_call_node* next;
+    struct kos_ipi_call* call;
+} kos_ipi_call_node_t;
+
+typedef struct kos_ipi_call {
+    kos_smp_call_fn_t fn;
+    void* arg;
+    volatile uint32_t remaining;    // Targets that have not run fn yet
+    volatile uint32_t in_use;       // Async pool slot taken
+    bool async;
+    kos_ipi_call_node_t nodes[KOS_CPU_MAX];
+} kos_ipi_call_t;
+
+// Pending shootdowns of one target
+typedef struct {
+    kos_spinlock_t lock;            // Callers have interrupts off
+    uint32_t count;
+    bool full_flush;
+    bool ipi_pending;               // Sent and not yet handled
+    uintptr_t pages[KOS_TLB_BATCH_MAX];
+    volatile uint64_t queued;       // Generation of the last queued request
+    volatile uint64_t done;         // Generation the target has flushed up to
+} kos_tlb_batch_t;
+
+// Per-target queues
+static kos_ipi_call_node_t* volatile g_ipi_call_queue[KOS_CPU_MAX];
+static kos_tlb_batch_t g_tlb_batches[KOS_CPU_MAX];
+
+// Calls whose sender does not wait
+static kos_ipi_call_t g_ipi_async_calls[KOS_IPI_ASYNC_CALLS];
+
+static kos_ipi_stats_t g_ipi_stats;
+
+// Send one IPI, the ICR is a two-register write so keep this CPU out of it
+static void kos_ipi_send(uint32_t cpu, kos_ipi_type_t type) {
+    uint32_t apic_id = hal_lapic_cpu_to_apic_id(cpu);
+    if (apic_id == HAL_LAPIC_INVALID_ID) {
+        return;
+    }
+
+    uint64_t flags = kos_local_irq_save();
+    hal_lapic_send_ipi(apic_id, HAL_LAPIC_ICR_FIXED | (KOS_IPI_VECTOR_BASE + type));
+    kos_local_irq_restore(flags);
+
+    __atomic_fetch_add(&g_ipi_stats.sent[type], 1, __ATOMIC_RELAXED);
+}
+
+// CPUs of the mask that can take an IPI, without the caller
+static kos_cpumask_t kos_ipi_online_targets(kos_cpumask_t mask, uint32_t self) {
+    kos_cpumask_t targets = 0;
+    for (uint32_t cpu = 0; cpu < kos_percpu_count(); cpu++) {
+        kos_cpu_local_t* local = kos_percpu_get(cpu);
+        if (cpu != self && (mask & KOS_CPUMASK_CPU(cpu)) && local && local->online) {
+            targets |= KOS_CPUMASK_CPU(cpu);
+        }
+    }
+    return targets;
+}
+
+// Take a free async slot, NULL when all are in flight
+static kos_ipi_call_t* kos_ipi_get_async_call(void) {
+    for (uint32_t i = 0; i < KOS_IPI_ASYNC_CALLS; i++) {
+        if (__atomic_exchange_n(&g_ipi_async_calls[i].in_use, 1, __ATOMIC_ACQUIRE) == 0) {
+            return &g_ipi_async_calls[i];
+        }
+    }
+    return NULL;
+}
+
+// Run fn on every CPU of the mask, the caller included if it is in it
+kos_result_t kos_smp_call_function(kos_cpumask_t mask, kos_smp_call_fn_t fn, void* arg, bool wait) {
+    if (!fn) {
+        return KOS_ERROR_INVALID_PARAM;
+    }
+
+    uint32_t self = kos_this_cpu()->cpu_id;
+    kos_cpumask_t targets = kos_ipi_online_targets(mask, self);
+
+    if (targets) {
+        // Waiting callers keep the call on their stack
+        kos_ipi_call_t sync_call;
+        kos_ipi_call_t* call = wait ? NULL : kos_ipi_get_async_call();
+        if (!call) {
+            call = &sync_call;
+            wait = true;
+        }
+
+        call->fn = fn;
+        call->arg = arg;
+        call->async = !wait;
+        call->remaining = (uint32_t)__builtin_popcountll(targets);
+
+        for (uint32_t cpu = 0; cpu < KOS_CPU_MAX; cpu++) {
+            if (!(targets & KOS_CPUMASK_CPU(cpu))) {
+                continue;
+            }
+
+            // Lock-free push, the target takes the whole list at once
+            kos_ipi_call_node_t* node = &call->nodes[cpu];
+            node->call = call;
+            kos_ipi_call_node_t* head = g_ipi_call_queue[cpu];
+            do {
+                node->next = head;
+            } while (!__atomic_compare_exchange_n(&g_ipi_call_queue[cpu], &head, node, true,
+                                                  __ATOMIC_RELEASE, __ATOMIC_RELAXED));
+
+            kos_ipi_send(cpu, KOS_IPI_CALL_FUNCTION);
+        }
+
+        if (mask & KOS_CPUMASK_CPU(self)) {
+            uint64_t flags = kos_local_irq_save();
+            fn(arg);
+            kos_local_irq_restore(flags);
+        }
+
+        if (wait) {
+            while (__atomic_load_n(&call->remaining, __ATOMIC_ACQUIRE) != 0) {
+                asm volatile("pause");
+            }
+        }
+    } else if (mask & KOS_CPUMASK_CPU(self)) {
+        uint64_t flags = kos_local_irq_save();
+        fn(arg);
+        kos_local_irq_restore(flags);
+    }
+
+    return KOS_SUCCESS;
+}
+
+// Run fn on one CPU
+kos_result_t kos_smp_call_function_single(uint32_t cpu, kos_smp_call_fn_t fn, void* arg, bool wait) {
+    if (cpu >= KOS_CPU_MAX) {
+        return KOS_ERROR_INVALID_PARAM;
+    }
+
+    return kos_smp_call_function(KOS_CPUMASK_CPU(cpu), fn, arg, wait);
+}
+
+// Run the remote calls queued for this CPU
+static void kos_ipi_run_calls(uint32_t self) {
+    kos_ipi_call_node_t* node = __atomic_exchange_n(&g_ipi_call_queue[self], NULL, __ATOMIC_ACQUIRE);
+
+    while (node) {
+        kos_ipi_call_node_t* next = node->next;
+        kos_ipi_call_t* call = node->call;
+
+        call->fn(call->arg);
+        __atomic_fetch_add(&g_ipi_stats.calls_run, 1, __ATOMIC_RELAXED);
+
+        // The sender may reuse the call once remaining hits zero
+        bool async = call->async;
+        if (__atomic_sub_fetch(&call->remaining, 1, __ATOMIC_RELEASE) == 0 && async) {
+            __atomic_store_n(&call->in_use, 0, __ATOMIC_RELEASE);
+        }
+
+        node = next;
+    }
+}
+
+// Ask a CPU to reschedule
+void kos_smp_send_reschedule(uint32_t cpu) {
+    kos_cpu_local_t* local = kos_percpu_get(cpu);
+    if (!local || !local->online) {
+        return;
+    }
+
+    local->need_resched = true;
+    if (cpu != kos_this_cpu()->cpu_id) {
+        kos_ipi_send(cpu, KOS_IPI_RESCHEDULE);
+    }
+}
+
+// Consume this CPU's reschedule request
+bool kos_smp_test_and_clear_resched(void) {
+    kos_cpu_local_t* local = kos_this_cpu();
+    if (!local->need_resched) {
+        return false;
+    }
+    local->need_resched = false;
+    return true;
+}
+
+static inline void kos_tlb_flush_page(uintptr_t addr) {
+    asm volatile("invlpg (%0)" : : "r" (addr) : "memory");
+}
+
+static inline void kos_tlb_flush_all(void) {
+    uint64_t cr3;
+    asm volatile("mov %%cr3, %0; mov %0, %%cr3" : "=r" (cr3) : : "memory");
+}
+
+// Queue pages on each target; a target with an IPI already in flight
+// picks the new pages up from the same interrupt
+void kos_tlb_invalidate(kos_cpumask_t mask, uintptr_t addr, uint32_t pages) {
+    uint64_t flags = kos_local_irq_save();
+    uint32_t self = kos_this_cpu()->cpu_id;
+
+    if (mask & KOS_CPUMASK_CPU(self)) {
+        if (pages > KOS_TLB_BATCH_MAX) {
+            kos_tlb_flush_all();
+        } else {
+            for (uint32_t i = 0; i < pages; i++) {
+                kos_tlb_flush_page(addr + (uintptr_t)i * KOS_PAGE_SIZE);
+            }
+        }
+    }
+
+    kos_cpumask_t targets = kos_ipi_online_targets(mask, self);
+    for (uint32_t cpu = 0; cpu < KOS_CPU_MAX; cpu++) {
+        if (!(targets & KOS_CPUMASK_CPU(cpu))) {
+            continue;
+        }
+
+        kos_tlb_batch_t* batch = &g_tlb_batches[cpu];
+        kos_spin_lock(&batch->lock);
+
+        if (!batch->full_flush) {
+            if (batch->count + pages > KOS_TLB_BATCH_MAX) {
+                batch->full_flush = true;
+            } else {
+                for (uint32_t i = 0; i < pages; i++) {
+                    batch->pages[batch->count++] = addr + (uintptr_t)i * KOS_PAGE_SIZE;
+                }
+            }
+        }
+        batch->queued++;
+
+        bool send = !batch->ipi_pending;
+        batch->ipi_pending = true;
+        kos_spin_unlock(&batch->lock);
+
+        __atomic_fetch_add(&g_ipi_stats.tlb_pages, pages, __ATOMIC_RELAXED);
+        if (send) {
+            kos_ipi_send(cpu, KOS_IPI_TLB_SHOOTDOWN);
+        } else {
+            __atomic_fetch_add(&g_ipi_stats.tlb_coalesced, 1, __ATOMIC_RELAXED);
+        }
+    }
+
+    kos_local_irq_restore(flags);
+}
+
+// Wait until every target has flushed what was queued before this call
+void kos_tlb_sync(kos_cpumask_t mask) {
+    uint32_t self = kos_this_cpu()->cpu_id;
+    kos_cpumask_t targets = kos_ipi_online_targets(mask, self);
+
+    for (uint32_t cpu = 0; cpu < KOS_CPU_MAX; cpu++) {
+        if (!(targets & KOS_CPUMASK_CPU(cpu))) {
+            continue;
+        }
+
+        kos_tlb_batch_t* batch = &g_tlb_batches[cpu];
+        uint64_t target = __atomic_load_n(&batch->queued, __ATOMIC_ACQUIRE);
+        while (__atomic_load_n(&batch->done, __ATOMIC_ACQUIRE) < target) {
+            asm volatile("pause");
+        }
+    }
+}
+
+// Flush everything queued for this CPU
+static void kos_tlb_run_batch(uint32_t self) {
+    kos_tlb_batch_t* batch = &g_tlb_batches[self];
+    uintptr_t pages[KOS_TLB_BATCH_MAX];
+
+    kos_spin_lock(&batch->lock);
+    bool full_flush = batch->full_flush;
+    uint32_t count = batch->count;
+    uint64_t generation = batch->queued;
+    if (!full_flush) {
+        kos_memcpy(pages, batch->pages, count * sizeof(uintptr_t));
+    }
+    batch->count = 0;
+    batch->full_flush = false;
+    batch->ipi_pending = false;
+    kos_spin_unlock(&batch->lock);
+
+    if (full_flush) {
+        kos_tlb_flush_all();
+        __atomic_fetch_add(&g_ipi_stats.tlb_full_flushes, 1, __ATOMIC_RELAXED);
+    } else {
+        for (uint32_t i = 0; i < count; i++) {
+            kos_tlb_flush_page(pages[i]);
+        }
+    }
+
+    __atomic_store_n(&batch->done, generation, __ATOMIC_RELEASE);
+}
+
+// IPI entry, interrupts are off
+void kos_ipi_handle(uint32_t vector) {
+    uint32_t type = vector - KOS_IPI_VECTOR_BASE;
+    uint32_t self = kos_this_cpu()->cpu_id;
+
+    // Acknowledge first, a new IPI of the same type queued meanwhile is kept
+    hal_lapic_eoi();
+
+    if (type >= KOS_IPI_TYPE_COUNT) {
+        return;
+    }
+    __atomic_fetch_add(&g_ipi_stats.received[type], 1, __ATOMIC_RELAXED);
+
+    switch (type) {
+        case KOS_IPI_CALL_FUNCTION:
+            kos_ipi_run_calls(self);
+            break;
+        case KOS_IPI_RESCHEDULE:
+            // need_resched is already set, the scheduler acts on return
+            break;
+        case KOS_IPI_TLB_SHOOTDOWN:
+            kos_tlb_run_batch(self);
+            break;
+    }
+}
+
+// Get IPI statistics
+void kos_ipi_get_stats(kos_ipi_stats_t* stats) {
+    if (!stats) {
+        return;
+    }
+
+    *stats = g_ipi_stats;
+}
+
+// Reset IPI statistics
+void kos_ipi_reset_stats(void) {
+    kos_memset(&g_ipi_stats, 0, sizeof(kos_ipi_stats_t));
+}
+
+// Dump IPI statistics
+void kos_ipi_dump_stats(void) {
+    static const char* names[KOS_IPI_TYPE_COUNT] = { "call", "resched", "tlb" };
+
+    log_info("=== IPI Statistics ===");
+    for (uint32_t type = 0; type < KOS_IPI_TYPE_COUNT; type++) {
+        log_info("  %s: %u sent, %u received", names[type],
+                 (uint32_t)g_ipi_stats.sent[type], (uint32_t)g_ipi_stats.received[type]);
+    }
+    log_info("  Calls run: %u", (uint32_t)g_ipi_stats.calls_run);
+    log_info("  TLB: %u pages, %u full flushes, %u coalesced", (uint32_t)g_ipi_stats.tlb_pages,
+             (uint32_t)g_ipi_stats.tlb_full_flushes, (uint32_t)g_ipi_stats.tlb_coalesced);
+}
+
+static void kos_ipi_benchmark_nop(void* arg) {
+    (void)arg;
+}
+
+// Round trip of a waited no-op call, in cycles
+kos_result_t kos_ipi_benchmark(uint32_t cpu, uint32_t iterations, kos_histogram_summary_t* summary) {
+    if (!summary || iterations == 0 || cpu == kos_this_cpu()->cpu_id) {
+        return KOS_ERROR_INVALID_PARAM;
+    }
+
+    kos_cpu_local_t* local = kos_percpu_get(cpu);
+    if (!local || !local->online) {
+        return KOS_ERROR_NOT_FOUND;
+    }
+
+    static kos_histogram_t histogram;
+    kos_histogram_reset(&histogram);
+
+    for (uint32_t i = 0; i < iterations; i++) {
+        uint64_t start = kos_clock_cycles();
+        kos_smp_call_function_single(cpu, kos_ipi_benchmark_nop, NULL, true);
+        kos_histogram_record(&histogram, kos_clock_cycles() - start);
+    }
+
+    kos_histogram_summarize(&histogram, summary);
+    return KOS_SUCCESS;
+}
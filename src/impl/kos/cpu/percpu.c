@@ -0,0 +1,126 @@
+#include "kos/cpu/percpu.h"
+#include "kos/utils/string.h"
+#include "hal/hal_lapic.h"
+#include "debug/debug.h"
+
+// =============================================================================
+// KOS - Per-CPU Data Implementation
+// =============================================================================
+
+#define MSR_GS_BASE             0xC0000101
+#define MSR_KERNEL_GS_BASE      0xC0000102
+
+// Global per-CPU state
+static kos_cpu_local_t g_cpu_locals[KOS_CPU_MAX];
+static uint32_t g_cpu_count = 0;
+
+// Default syscall stacks, also the ring 3 interrupt stack through TSS.RSP0,
+// for CPUs running no process with a stack of its own
+static uint8_t g_cpu_syscall_stacks[KOS_CPU_MAX][KOS_CPU_SYSCALL_STACK_SIZE] __attribute__((aligned(16)));
+
+// Write MSR
+static inline void kos_percpu_write_msr(uint32_t msr, uint64_t value) {
+    asm volatile("wrmsr" : : "c" (msr), "a" ((uint32_t)value), "d" ((uint32_t)(value >> 32)));
+}
+
+// Build and load this CPU's GDT and TSS
+static kos_result_t kos_percpu_load_descriptors(kos_cpu_local_t* cpu) {
+    kos_result_t result = kos_gdt_init(&cpu->gdt);
+    if (result != KOS_SUCCESS) {
+        return result;
+    }
+
+    result = kos_gdt_setup_kernel_segments(&cpu->gdt);
+    if (result != KOS_SUCCESS) {
+        return result;
+    }
+
+    result = kos_gdt_setup_user_segments(&cpu->gdt);
+    if (result != KOS_SUCCESS) {
+        return result;
+    }
+
+    cpu->tss.rsp[0] = cpu->kernel_stack;
+    result = kos_gdt_setup_tss(&cpu->gdt, &cpu->tss);
+    if (result != KOS_SUCCESS) {
+        return result;
+    }
+
+    kos_gdt_load(&cpu->gdt);
+    kos_gdt_flush();
+    kos_gdt_load_tss();
+    return KOS_SUCCESS;
+}
+
+// Set up a CPU's block, descriptors and GS, runs on the CPU itself
+kos_result_t kos_percpu_init(uint32_t cpu_id, uint32_t apic_id) {
+    if (cpu_id >= KOS_CPU_MAX) {
+        return KOS_ERROR_INVALID_PARAM;
+    }
+
+    // The boot CPU kept its interrupt state here before it had GS
+    kos_cpu_local_t* cpu = &g_cpu_locals[cpu_id];
+    kos_cpu_irq_t irq = cpu->irq;
+    kos_memset(cpu, 0, sizeof(kos_cpu_local_t));
+    cpu->irq = irq;
+    cpu->self = cpu;
+    cpu->kernel_stack = (uint64_t)(uintptr_t)(g_cpu_syscall_stacks[cpu_id] + KOS_CPU_SYSCALL_STACK_SIZE);
+    cpu->cpu_id = cpu_id;
+    cpu->apic_id = apic_id;
+
+    kos_result_t result = kos_percpu_load_descriptors(cpu);
+    if (result != KOS_SUCCESS) {
+        return result;
+    }
+
+    // Segment reloads clear the hidden base, so this must follow the GDT load
+    kos_percpu_write_msr(MSR_GS_BASE, (uint64_t)(uintptr_t)cpu);
+    kos_percpu_write_msr(MSR_KERNEL_GS_BASE, 0);
+
+    if (cpu_id >= g_cpu_count) {
+        g_cpu_count = cpu_id + 1;
+    }
+
+    cpu->online = true;
+    return KOS_SUCCESS;
+}
+
+// Set up the boot CPU
+kos_result_t kos_percpu_init_boot(void) {
+    return kos_percpu_init(0, hal_lapic_get_id());
+}
+
+// Get a CPU's block by index
+kos_cpu_local_t* kos_percpu_get(uint32_t cpu_id) {
+    if (cpu_id >= g_cpu_count) {
+        return NULL;
+    }
+
+    return &g_cpu_locals[cpu_id];
+}
+
+// Number of CPUs with a block
+uint32_t kos_percpu_count(void) {
+    return g_cpu_count;
+}
+
+// Point SYSCALL entry and ring 3 interrupts of the calling CPU at stack_top,
+// 0 selects the CPU's default stack. Called on every process switch.
+void kos_percpu_set_kernel_stack(uint64_t stack_top) {
+    if (g_cpu_count == 0) {
+        return;
+    }
+
+    kos_cpu_local_t* cpu = kos_this_cpu();
+    if (stack_top == 0) {
+        stack_top = (uint64_t)(uintptr_t)(g_cpu_syscall_stacks[cpu->cpu_id] + KOS_CPU_SYSCALL_STACK_SIZE);
+    }
+
+    cpu->kernel_stack = stack_top;
+    cpu->tss.rsp[0] = stack_top;
+}
+
+// Interrupt state of the calling CPU, CPU 0's block until GS is set up
+kos_cpu_irq_t* kos_percpu_irq(void) {
+    return g_cpu_count ? &kos_this_cpu()->irq : &g_cpu_locals[0].irq;
+}
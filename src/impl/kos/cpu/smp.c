@@ -0,0 +1,201 @@
+#include "kos/cpu/smp.h"
+#include "kos/time/clock.h"
+#include "kos/utils/string.h"
+#include "kos/sync/rcu.h"
+#include "kos/process/workqueue.h"
+#include "hal/hal_lapic.h"
+#include "debug/debug.h"
+
+// =============================================================================
+// KOS - Symmetric Multiprocessing Implementation
+// =============================================================================
+
+#define MSR_EFER                0xC0000080
+
+// Trampoline parameter block, layout matches ap_trampoline.asm
+typedef struct {
+    uint64_t cr3;
+    uint64_t cr4;
+    uint64_t efer;
+    uint64_t stack;
+    uint64_t entry;
+    uint32_t cpu_id;
+    volatile uint32_t started;
+} __attribute__((packed)) kos_smp_trampoline_t;
+
+extern const uint8_t ap_trampoline_start[];
+extern const uint8_t ap_trampoline_params[];
+extern const uint8_t ap_trampoline_end[];
+
+// Architecture entry points
+extern void idt_load_cpu(void);
+extern void syscall_init(void);
+
+// Idle-loop stacks of the application processors
+static uint8_t g_smp_ap_stacks[KOS_CPU_MAX][KOS_SMP_AP_STACK_SIZE] __attribute__((aligned(16)));
+
+// Global SMP state
+static uint32_t g_smp_cpu_count = 1;
+static bool g_smp_initialized = false;
+
+static inline uint64_t kos_smp_read_cr3(void) {
+    uint64_t value;
+    asm volatile("mov %%cr3, %0" : "=r" (value));
+    return value;
+}
+
+static inline uint64_t kos_smp_read_cr4(void) {
+    uint64_t value;
+    asm volatile("mov %%cr4, %0" : "=r" (value));
+    return value;
+}
+
+static inline uint64_t kos_smp_read_msr(uint32_t msr) {
+    uint32_t low, high;
+    asm volatile("rdmsr" : "=a" (low), "=d" (high) : "c" (msr));
+    return ((uint64_t)high << 32) | low;
+}
+
+// Busy-wait, interrupts may still be off this early
+static void kos_smp_delay_ns(uint64_t ns) {
+    uint64_t deadline = kos_clock_monotonic_ns() + ns;
+    while (kos_clock_monotonic_ns() < deadline) {
+        asm volatile("pause");
+    }
+}
+
+// Idle loop of an application processor, woken by IPIs
+static void __attribute__((noreturn)) kos_smp_idle(void) {
+    for (;;) {
+        kos_workqueue_run();
+        kos_rcu_quiescent();
+        kos_rcu_process_callbacks();
+
+        // No timer tick wakes an AP, so check for work and halt atomically
+        asm volatile("cli" : : : "memory");
+        if (kos_workqueue_pending()) {
+            asm volatile("sti" : : : "memory");
+        } else {
+            asm volatile("sti; hlt" : : : "memory");
+        }
+    }
+}
+
+// First C code on an application processor, on its idle stack
+static void __attribute__((noreturn)) kos_smp_ap_main(uint32_t cpu_id) {
+    if (kos_percpu_init(cpu_id, hal_lapic_get_id()) != KOS_SUCCESS) {
+        for (;;) {
+            asm volatile("cli; hlt");
+        }
+    }
+
+    idt_load_cpu();
+    syscall_init();
+    hal_lapic_init_ap();
+
+    kos_smp_idle();
+}
+
+// Start one application processor and wait for it to come online
+static bool kos_smp_start_cpu(uint32_t cpu_id, uint32_t apic_id) {
+    kos_smp_trampoline_t* params = (kos_smp_trampoline_t*)(uintptr_t)
+        (KOS_SMP_TRAMPOLINE_BASE + (ap_trampoline_params - ap_trampoline_start));
+
+    params->cr3 = kos_smp_read_cr3();
+    params->cr4 = kos_smp_read_cr4();
+    params->efer = kos_smp_read_msr(MSR_EFER);
+    params->stack = (uint64_t)(uintptr_t)(g_smp_ap_stacks[cpu_id] + KOS_SMP_AP_STACK_SIZE);
+    params->entry = (uint64_t)(uintptr_t)kos_smp_ap_main;
+    params->cpu_id = cpu_id;
+    params->started = 0;
+
+    // INIT-SIPI-SIPI, the second SIPI only if the first was missed
+    uint32_t page = KOS_SMP_TRAMPOLINE_BASE >> 12;
+    if (!hal_lapic_send_init(apic_id)) {
+        return false;
+    }
+    kos_smp_delay_ns(KOS_SMP_INIT_DELAY_NS);
+
+    hal_lapic_send_startup(apic_id, page);
+    kos_smp_delay_ns(KOS_SMP_SIPI_DELAY_NS);
+    if (!params->started) {
+        hal_lapic_send_startup(apic_id, page);
+    }
+
+    uint64_t deadline = kos_clock_monotonic_ns() + KOS_SMP_START_TIMEOUT_NS;
+    while (kos_clock_monotonic_ns() < deadline) {
+        kos_cpu_local_t* cpu = kos_percpu_get(cpu_id);
+        if (cpu && cpu->online) {
+            return true;
+        }
+        asm volatile("pause");
+    }
+
+    return false;
+}
+
+// Bring up every CPU the firmware lists
+kos_result_t kos_smp_init(void) {
+    if (g_smp_initialized) {
+        return KOS_SUCCESS;
+    }
+    g_smp_initialized = true;
+
+    if (!hal_lapic_is_available()) {
+        log_info("SMP: no local APIC, boot CPU only");
+        return KOS_ERROR_NOT_FOUND;
+    }
+
+    uint32_t count = hal_lapic_enumerate_cpus();
+    if (count > KOS_CPU_MAX) {
+        count = KOS_CPU_MAX;
+    }
+
+    // APs start in real mode, so the trampoline must sit below 1 MB
+    kos_memcpy((void*)(uintptr_t)KOS_SMP_TRAMPOLINE_BASE, ap_trampoline_start,
+               (size_t)(ap_trampoline_end - ap_trampoline_start));
+
+    // One at a time, they share the trampoline parameter block
+    g_smp_cpu_count = count;
+    for (uint32_t cpu_id = 1; cpu_id < count; cpu_id++) {
+        uint32_t apic_id = hal_lapic_cpu_to_apic_id(cpu_id);
+        if (!kos_smp_start_cpu(cpu_id, apic_id)) {
+            log_warn("SMP: CPU %d (APIC id %d) did not start", (int)cpu_id, (int)apic_id);
+        }
+    }
+
+    log_info("SMP: %d of %d CPUs online", (int)kos_smp_online_count(), (int)count);
+    return KOS_SUCCESS;
+}
+
+// Number of CPUs found
+uint32_t kos_smp_cpu_count(void) {
+    return g_smp_cpu_count;
+}
+
+// Number of CPUs that came up
+uint32_t kos_smp_online_count(void) {
+    uint32_t online = 0;
+    for (uint32_t cpu_id = 0; cpu_id < kos_percpu_count(); cpu_id++) {
+        kos_cpu_local_t* cpu = kos_percpu_get(cpu_id);
+        if (cpu && cpu->online) {
+            online++;
+        }
+    }
+    return online;
+}
+
+// Index of the calling CPU
+uint32_t kos_smp_this_cpu_id(void) {
+    return kos_this_cpu()->cpu_id;
+}
+
+// Dump CPU states
+void kos_smp_dump(void) {
+    log_info("=== SMP CPUs ===");
+    for (uint32_t cpu_id = 0; cpu_id < g_smp_cpu_count; cpu_id++) {
+        kos_cpu_local_t* cpu = kos_percpu_get(cpu_id);
+        log_info("  CPU %d: APIC id %d, %s", (int)cpu_id, (int)hal_lapic_cpu_to_apic_id(cpu_id),
+                 (cpu && cpu->online) ? "online" : "offline");
+    }
+}
@@ -1,6 +1,7 @@
 #include "kos/drivers/driver_framework.h"
 #include "kos/utils/log_stubs.h"
 #include "kos/utils/hal_utils.h"
+#include "kos/interrupts/interrupt.h"
 
 // =============================================================================
 // KOS - Driver Manager Implementation
@@ -16,6 +17,19 @@
 // Global driver manager instance
 static kos_driver_manager_t g_driver_manager = {0};
 
+// Look up a driver by name, caller holds driver_lock or is in a read section
+static kos_driver_t* driver_find_by_name_locked(const char* name) {
+    kos_driver_t* driver = kos_rcu_dereference(g_driver_manager.drivers);
+    while (driver) {
+        if (hal_strcmp(driver->name, name) == 0) {
+            return driver;
+        }
+        driver = kos_rcu_dereference(driver->next);
+    }
+    
+    return NULL;
+}
+
 // =============================================================================
 // Driver Manager Core Operations
 // =============================================================================
@@ -30,19 +44,9 @@ hal_result_t kos_driver_manager_init(void) {
     // Initialize manager structure
     hal_memset(&g_driver_manager, 0, sizeof(kos_driver_manager_t));
     
-    // Initialize mutexes (simplified - no real mutex implementation yet)
-    // hal_result_t result = hal_mutex_init(&g_driver_manager.driver_lock);
-    // if (result != HAL_SUCCESS) {
-    //     log_error("Failed to initialize driver mutex");
-    //     return result;
-    // }
-    
-    // result = hal_mutex_init(&g_driver_manager.device_lock);
-    // if (result != HAL_SUCCESS) {
-    //     log_error("Failed to initialize device mutex");
-    //     hal_mutex_destroy(&g_driver_manager.driver_lock);
-    //     return result;
-    // }
+    // Initialize list locks
+    kos_spin_init(&g_driver_manager.driver_lock);
+    kos_spin_init(&g_driver_manager.device_lock);
     
     g_driver_manager.initialized = true;
     
@@ -65,10 +69,6 @@ hal_result_t kos_driver_manager_shutdown(void) {
         driver = driver->next;
     }
     
-    // Destroy mutexes (simplified)
-    // hal_mutex_destroy(&g_driver_manager.device_lock);
-    // hal_mutex_destroy(&g_driver_manager.driver_lock);
-    
     // Clear manager structure
     hal_memset(&g_driver_manager, 0, sizeof(kos_driver_manager_t));
     
@@ -85,22 +85,17 @@ hal_result_t kos_driver_manager_register_driver(kos_driver_t* driver) {
         return HAL_ERROR_NOT_INITIALIZED;
     }
     
-    // hal_mutex_lock(&g_driver_manager.driver_lock);
-    
     // Check if driver already exists
-    kos_driver_t* existing = kos_driver_find_by_name(driver->name);
-    if (existing) {
-        // // hal_mutex_unlock(&g_driver_manager.driver_lock);
+    if (kos_driver_find_by_name(driver->name)) {
         log_error("Driver %s already registered", driver->name);
         return HAL_ERROR_ALREADY_EXISTS;
     }
     
-    // Initialize driver if needed
+    // Initialize driver if needed, outside the lock since init may be slow
     if (driver->state == KOS_DRIVER_STATE_UNINITIALIZED) {
         if (driver->ops->init) {
             hal_result_t result = driver->ops->init(driver);
             if (result != HAL_SUCCESS) {
-                // hal_mutex_unlock(&g_driver_manager.driver_lock);
                 log_error("Failed to initialize driver %s", driver->name);
                 return result;
             }
@@ -108,13 +103,22 @@ hal_result_t kos_driver_manager_register_driver(kos_driver_t* driver) {
         driver->state = KOS_DRIVER_STATE_INITIALIZED;
     }
     
-    // Add to driver list
+    uint64_t flags = kos_spin_lock_irqsave(&g_driver_manager.driver_lock);
+    
+    // Re-check, another CPU may have registered the name meanwhile
+    if (driver_find_by_name_locked(driver->name)) {
+        kos_spin_unlock_irqrestore(&g_driver_manager.driver_lock, flags);
+        log_error("Driver %s already registered", driver->name);
+        return HAL_ERROR_ALREADY_EXISTS;
+    }
+    
+    // Add to driver list, publishing it only once it is linked
     driver->next = g_driver_manager.drivers;
-    g_driver_manager.drivers = driver;
+    kos_rcu_assign_pointer(g_driver_manager.drivers, driver);
     g_driver_manager.driver_count++;
     g_driver_manager.total_drivers++;
     
-    // hal_mutex_unlock(&g_driver_manager.driver_lock);
+    kos_spin_unlock_irqrestore(&g_driver_manager.driver_lock, flags);
     
     log_info("Driver %s registered successfully", driver->name);
     return HAL_SUCCESS;
@@ -129,25 +133,28 @@ hal_result_t kos_driver_manager_unregister_driver(kos_driver_t* driver) {
         return HAL_ERROR_NOT_INITIALIZED;
     }
     
-    // hal_mutex_lock(&g_driver_manager.driver_lock);
+    uint64_t flags = kos_spin_lock_irqsave(&g_driver_manager.driver_lock);
     
     // Find and remove from list
     kos_driver_t** current = &g_driver_manager.drivers;
     while (*current) {
         if (*current == driver) {
-            *current = driver->next;
+            kos_rcu_assign_pointer(*current, driver->next);
             g_driver_manager.driver_count--;
             break;
         }
         current = &(*current)->next;
     }
     
-    // Stop and shutdown driver
+    kos_spin_unlock_irqrestore(&g_driver_manager.driver_lock, flags);
+    
+    // Let lookups that may still see the driver finish
+    kos_synchronize_rcu();
+    
+    // Stop and shutdown driver once it is no longer reachable
     kos_driver_stop(driver);
     kos_driver_shutdown(driver);
     
-    // hal_mutex_unlock(&g_driver_manager.driver_lock);
-    
     log_info("Driver %s unregistered successfully", driver->name);
     return HAL_SUCCESS;
 }
@@ -161,15 +168,15 @@ hal_result_t kos_driver_manager_register_device(kos_device_t* device) {
         return HAL_ERROR_NOT_INITIALIZED;
     }
     
-    // hal_mutex_lock(&g_driver_manager.device_lock);
+    uint64_t flags = kos_spin_lock_irqsave(&g_driver_manager.device_lock);
     
-    // Add to device list
+    // Add to device list, publishing it only once it is linked
     device->next = g_driver_manager.devices;
-    g_driver_manager.devices = device;
+    kos_rcu_assign_pointer(g_driver_manager.devices, device);
     g_driver_manager.device_count++;
     g_driver_manager.total_devices++;
     
-    // hal_mutex_unlock(&g_driver_manager.device_lock);
+    kos_spin_unlock_irqrestore(&g_driver_manager.device_lock, flags);
     
     log_info("Device %s registered successfully", device->info.name);
     return HAL_SUCCESS;
@@ -184,20 +191,23 @@ hal_result_t kos_driver_manager_unregister_device(kos_device_t* device) {
         return HAL_ERROR_NOT_INITIALIZED;
     }
     
-    // hal_mutex_lock(&g_driver_manager.device_lock);
+    uint64_t flags = kos_spin_lock_irqsave(&g_driver_manager.device_lock);
     
     // Find and remove from list
     kos_device_t** current = &g_driver_manager.devices;
     while (*current) {
         if (*current == device) {
-            *current = device->next;
+            kos_rcu_assign_pointer(*current, device->next);
             g_driver_manager.device_count--;
             break;
         }
         current = &(*current)->next;
     }
     
-    // hal_mutex_unlock(&g_driver_manager.device_lock);
+    kos_spin_unlock_irqrestore(&g_driver_manager.device_lock, flags);
+    
+    // The caller may reuse the device once no lookup can still see it
+    kos_synchronize_rcu();
     
     log_info("Device %s unregistered successfully", device->info.name);
     return HAL_SUCCESS;
@@ -351,6 +361,14 @@ hal_result_t kos_driver_add_device(kos_driver_t* driver, kos_device_t* device) {
         }
     }
     
+    // Interrupt-driven devices get their line as soon as they are bound
+    if (device->info.flags & KOS_DRIVER_FLAG_INTERRUPT_DRIVEN) {
+        hal_result_t result = kos_device_request_irq(device);
+        if (result != HAL_SUCCESS) {
+            log_error("Device %s could not get IRQ %u", device->info.name, device->info.irq_line);
+        }
+    }
+    
     log_info("Device %s added to driver %s", device->info.name, driver->name);
     return HAL_SUCCESS;
 }
@@ -371,6 +389,10 @@ hal_result_t kos_driver_remove_device(kos_driver_t* driver, kos_device_t* device
         current = &(*current)->next;
     }
     
+    if (device->info.flags & KOS_DRIVER_FLAG_INTERRUPT_DRIVEN) {
+        kos_device_free_irq(device);
+    }
+    
     // Remove device
     if (driver->ops->remove) {
         driver->ops->remove(driver, device);
@@ -398,12 +420,8 @@ hal_result_t kos_device_init(kos_device_t* device, const kos_device_info_t* info
     device->reference_count = 0;
     device->is_open = false;
     
-    // Initialize device lock (simplified)
-    // hal_result_t result = hal_mutex_init(&device->lock);
-    // if (result != HAL_SUCCESS) {
-    //     log_error("Failed to initialize device lock for %s", info->name);
-    //     return result;
-    // }
+    // Initialize device lock
+    kos_spin_init(&device->lock);
     
     log_info("Device %s initialized successfully", info->name);
     return HAL_SUCCESS;
@@ -419,9 +437,6 @@ hal_result_t kos_device_shutdown(kos_device_t* device) {
         kos_device_close(device);
     }
     
-    // Destroy device lock (simplified)
-    // hal_mutex_destroy(&device->lock);
-    
     device->state = KOS_DRIVER_STATE_UNINITIALIZED;
     
     log_info("Device %s shutdown completed", device->info.name);
@@ -433,17 +448,17 @@ hal_result_t kos_device_open(kos_device_t* device) {
         return HAL_ERROR_INVALID_PARAM;
     }
     
-    // hal_mutex_lock(&device->lock);
+    uint64_t flags = kos_spin_lock_irqsave(&device->lock);
     
     if (device->is_open) {
-        // hal_mutex_unlock(&device->lock);
+        kos_spin_unlock_irqrestore(&device->lock, flags);
         return HAL_ERROR_ALREADY_OPEN;
     }
     
     device->is_open = true;
     device->reference_count++;
     
-    // hal_mutex_unlock(&device->lock);
+    kos_spin_unlock_irqrestore(&device->lock, flags);
     
     log_debug("Device %s opened", device->info.name);
     return HAL_SUCCESS;
@@ -454,10 +469,10 @@ hal_result_t kos_device_close(kos_device_t* device) {
         return HAL_ERROR_INVALID_PARAM;
     }
     
-    // hal_mutex_lock(&device->lock);
+    uint64_t flags = kos_spin_lock_irqsave(&device->lock);
     
     if (!device->is_open) {
-        // hal_mutex_unlock(&device->lock);
+        kos_spin_unlock_irqrestore(&device->lock, flags);
         return HAL_ERROR_NOT_OPEN;
     }
     
@@ -466,7 +481,7 @@ hal_result_t kos_device_close(kos_device_t* device) {
         device->reference_count--;
     }
     
-    // hal_mutex_unlock(&device->lock);
+    kos_spin_unlock_irqrestore(&device->lock, flags);
     
     log_debug("Device %s closed", device->info.name);
     return HAL_SUCCESS;
@@ -535,6 +550,43 @@ hal_result_t kos_device_ioctl(kos_device_t* device, uint32_t request, void* arg)
     return result;
 }
 
+// IRQ dispatch straight into the bound driver's interrupt_handler op
+static kos_irq_return_t kos_device_irq_dispatch(uint32_t irq, void* context) {
+    kos_device_t* device = (kos_device_t*)context;
+    
+    if (device->driver->ops->interrupt_handler(device, irq, device->private_data) == HAL_SUCCESS) {
+        return KOS_IRQ_HANDLED;
+    }
+    return KOS_IRQ_NONE;
+}
+
+hal_result_t kos_device_request_irq(kos_device_t* device) {
+    if (!device || !device->driver || !device->driver->ops->interrupt_handler) {
+        return HAL_ERROR_INVALID_PARAM;
+    }
+    
+    uint32_t flags = (device->info.flags & KOS_DRIVER_FLAG_SHARED) ? KOS_IRQF_SHARED : 0;
+    kos_result_t result = kos_interrupt_request((kos_irq_t)device->info.irq_line, kos_device_irq_dispatch,
+                                                device, flags, device->info.name);
+    if (result != KOS_SUCCESS) {
+        return HAL_ERROR_INVALID_STATE;
+    }
+    
+    return HAL_SUCCESS;
+}
+
+hal_result_t kos_device_free_irq(kos_device_t* device) {
+    if (!device) {
+        return HAL_ERROR_INVALID_PARAM;
+    }
+    
+    if (kos_interrupt_free((kos_irq_t)device->info.irq_line, device) != KOS_SUCCESS) {
+        return HAL_ERROR_INVALID_STATE;
+    }
+    
+    return HAL_SUCCESS;
+}
+
 // =============================================================================
 // Utility Functions
 // =============================================================================
@@ -544,15 +596,11 @@ kos_driver_t* kos_driver_find_by_name(const char* name) {
         return NULL;
     }
     
-    kos_driver_t* driver = g_driver_manager.drivers;
-    while (driver) {
-        if (hal_strcmp(driver->name, name) == 0) {
-            return driver;
-        }
-        driver = driver->next;
-    }
+    kos_rcu_read_lock();
+    kos_driver_t* driver = driver_find_by_name_locked(name);
+    kos_rcu_read_unlock();
     
-    return NULL;
+    return driver;
 }
 
 kos_device_t* kos_device_find_by_name(const char* name) {
@@ -560,15 +608,18 @@ kos_device_t* kos_device_find_by_name(const char* name) {
         return NULL;
     }
     
-    kos_device_t* device = g_driver_manager.devices;
+    kos_rcu_read_lock();
+    
+    kos_device_t* device = kos_rcu_dereference(g_driver_manager.devices);
     while (device) {
         if (hal_strcmp(device->info.name, name) == 0) {
-            return device;
+            break;
         }
-        device = device->next;
+        device = kos_rcu_dereference(device->next);
     }
     
-    return NULL;
+    kos_rcu_read_unlock();
+    return device;
 }
 
 kos_device_t* kos_device_find_by_id(uint32_t device_id) {
@@ -576,15 +627,18 @@ kos_device_t* kos_device_find_by_id(uint32_t device_id) {
         return NULL;
     }
     
-    kos_device_t* device = g_driver_manager.devices;
+    kos_rcu_read_lock();
+    
+    kos_device_t* device = kos_rcu_dereference(g_driver_manager.devices);
     while (device) {
         if (device->info.device_id == device_id) {
-            return device;
+            break;
         }
-        device = device->next;
+        device = kos_rcu_dereference(device->next);
     }
     
-    return NULL;
+    kos_rcu_read_unlock();
+    return device;
 }
 
 hal_result_t kos_driver_manager_dump_stats(void) {
@@ -0,0 +1,231 @@
+#include "kos/drivers/pci.h"
+#include "kos/cpu/ports.h"
+#include "kos/cpu/irqflags.h"
+#include "debug/debug.h"
+
+// =============================================================================
+// KOS - PCI Configuration Space Implementation
+// =============================================================================
+
+#define PCI_MAX_BUS             256
+#define PCI_MAX_SLOT            32
+#define PCI_MAX_FUNCTION        8
+#define PCI_HEADER_MULTIFUNC    0x80
+#define PCI_HEADER_TYPE_MASK    0x7F
+#define PCI_CAP_WALK_LIMIT      48
+
+// Global PCI state
+static kos_pci_device_t g_pci_devices[KOS_PCI_MAX_DEVICES];
+static uint32_t g_pci_device_count = 0;
+static bool g_pci_initialized = false;
+
+// Build a mechanism #1 address
+static inline uint32_t kos_pci_address(uint8_t bus, uint8_t slot, uint8_t function, uint8_t offset) {
+    return (1U << 31) | ((uint32_t)bus << 16) | ((uint32_t)slot << 11) |
+           ((uint32_t)function << 8) | (offset & 0xFC);
+}
+
+// Read a dword by location, the address/data pair must not be interleaved
+static uint32_t kos_pci_config_read(uint8_t bus, uint8_t slot, uint8_t function, uint8_t offset) {
+    uint64_t flags = kos_local_irq_save();
+    kos_port_dword_out(KOS_PCI_CONFIG_ADDRESS, kos_pci_address(bus, slot, function, offset));
+    uint32_t value = kos_port_dword_in(KOS_PCI_CONFIG_DATA);
+    kos_local_irq_restore(flags);
+    return value;
+}
+
+// Write a dword by location
+static void kos_pci_config_write(uint8_t bus, uint8_t slot, uint8_t function, uint8_t offset, uint32_t value) {
+    uint64_t flags = kos_local_irq_save();
+    kos_port_dword_out(KOS_PCI_CONFIG_ADDRESS, kos_pci_address(bus, slot, function, offset));
+    kos_port_dword_out(KOS_PCI_CONFIG_DATA, value);
+    kos_local_irq_restore(flags);
+}
+
+uint32_t kos_pci_read32(const kos_pci_device_t* dev, uint8_t offset) {
+    return kos_pci_config_read(dev->bus, dev->slot, dev->function, offset);
+}
+
+uint16_t kos_pci_read16(const kos_pci_device_t* dev, uint8_t offset) {
+    return (uint16_t)(kos_pci_read32(dev, offset) >> ((offset & 2) * 8));
+}
+
+uint8_t kos_pci_read8(const kos_pci_device_t* dev, uint8_t offset) {
+    return (uint8_t)(kos_pci_read32(dev, offset) >> ((offset & 3) * 8));
+}
+
+void kos_pci_write32(const kos_pci_device_t* dev, uint8_t offset, uint32_t value) {
+    kos_pci_config_write(dev->bus, dev->slot, dev->function, offset, value);
+}
+
+// 16-bit write as read-modify-write of the containing dword
+void kos_pci_write16(const kos_pci_device_t* dev, uint8_t offset, uint16_t value) {
+    uint32_t shift = (offset & 2) * 8;
+    uint32_t dword = kos_pci_read32(dev, offset);
+    dword = (dword & ~(0xFFFFU << shift)) | ((uint32_t)value << shift);
+    kos_pci_write32(dev, offset, dword);
+}
+
+// Walk the capability list, returns the config offset or 0
+uint8_t kos_pci_find_capability(const kos_pci_device_t* dev, uint8_t cap_id) {
+    if (!dev || !(kos_pci_read16(dev, KOS_PCI_STATUS) & KOS_PCI_STATUS_CAP_LIST)) {
+        return 0;
+    }
+
+    uint8_t offset = kos_pci_read8(dev, KOS_PCI_CAPABILITY_LIST) & 0xFC;
+
+    // Bounded walk so a looping list cannot hang enumeration
+    for (int i = 0; i < PCI_CAP_WALK_LIMIT && offset != 0; i++) {
+        uint16_t header = kos_pci_read16(dev, offset);
+        if ((header & 0xFF) == cap_id) {
+            return offset;
+        }
+        offset = (uint8_t)(header >> 8) & 0xFC;
+    }
+
+    return 0;
+}
+
+// Physical address of a memory BAR, 64-bit BARs span two slots
+uint64_t kos_pci_get_bar(const kos_pci_device_t* dev, uint32_t bar) {
+    if (!dev || bar >= KOS_PCI_BAR_COUNT) {
+        return 0;
+    }
+
+    uint32_t low = kos_pci_read32(dev, KOS_PCI_BAR0 + bar * 4);
+    if (low & KOS_PCI_BAR_IO) {
+        return low & ~0x3U;
+    }
+
+    uint64_t address = low & ~0xFU;
+    if ((low & KOS_PCI_BAR_TYPE_MASK) == KOS_PCI_BAR_TYPE_64 && bar + 1 < KOS_PCI_BAR_COUNT) {
+        address |= (uint64_t)kos_pci_read32(dev, KOS_PCI_BAR0 + (bar + 1) * 4) << 32;
+    }
+
+    return address;
+}
+
+// Let the device issue DMA and MSI writes
+void kos_pci_enable_bus_master(const kos_pci_device_t* dev) {
+    uint16_t command = kos_pci_read16(dev, KOS_PCI_COMMAND);
+    kos_pci_write16(dev, KOS_PCI_COMMAND, command | KOS_PCI_COMMAND_MASTER | KOS_PCI_COMMAND_MEMORY);
+}
+
+// Enable or disable legacy INTx assertion
+void kos_pci_set_intx(const kos_pci_device_t* dev, bool enable) {
+    uint16_t command = kos_pci_read16(dev, KOS_PCI_COMMAND);
+    if (enable) {
+        command &= ~KOS_PCI_COMMAND_INTX_OFF;
+    } else {
+        command |= KOS_PCI_COMMAND_INTX_OFF;
+    }
+    kos_pci_write16(dev, KOS_PCI_COMMAND, command);
+}
+
+// Record one function
+static void kos_pci_add_function(uint8_t bus, uint8_t slot, uint8_t function, uint32_t id) {
+    if (g_pci_device_count >= KOS_PCI_MAX_DEVICES) {
+        return;
+    }
+
+    kos_pci_device_t* dev = &g_pci_devices[g_pci_device_count++];
+    uint32_t class_reg = kos_pci_config_read(bus, slot, function, KOS_PCI_REVISION);
+    uint32_t misc_reg = kos_pci_config_read(bus, slot, function, 0x0C);
+    uint32_t irq_reg = kos_pci_config_read(bus, slot, function, KOS_PCI_INTERRUPT_LINE);
+
+    dev->bus = bus;
+    dev->slot = slot;
+    dev->function = function;
+    dev->vendor_id = (uint16_t)id;
+    dev->device_id = (uint16_t)(id >> 16);
+    dev->prog_if = (uint8_t)(class_reg >> 8);
+    dev->subclass = (uint8_t)(class_reg >> 16);
+    dev->class_code = (uint8_t)(class_reg >> 24);
+    dev->header_type = (uint8_t)(misc_reg >> 16);
+    dev->irq_line = (uint8_t)irq_reg;
+    dev->irq_pin = (uint8_t)(irq_reg >> 8);
+    dev->msi_cap = kos_pci_find_capability(dev, KOS_PCI_CAP_ID_MSI);
+    dev->msix_cap = kos_pci_find_capability(dev, KOS_PCI_CAP_ID_MSIX);
+}
+
+// Brute-force scan of every bus/slot/function
+kos_result_t kos_pci_init(void) {
+    if (g_pci_initialized) {
+        return KOS_SUCCESS;
+    }
+
+    g_pci_device_count = 0;
+
+    for (uint32_t bus = 0; bus < PCI_MAX_BUS; bus++) {
+        for (uint8_t slot = 0; slot < PCI_MAX_SLOT; slot++) {
+            uint32_t id = kos_pci_config_read((uint8_t)bus, slot, 0, KOS_PCI_VENDOR_ID);
+            if ((id & 0xFFFF) == 0xFFFF) {
+                continue;
+            }
+
+            kos_pci_add_function((uint8_t)bus, slot, 0, id);
+
+            uint8_t header = (uint8_t)(kos_pci_config_read((uint8_t)bus, slot, 0, 0x0C) >> 16);
+            if (!(header & PCI_HEADER_MULTIFUNC)) {
+                continue;
+            }
+
+            for (uint8_t function = 1; function < PCI_MAX_FUNCTION; function++) {
+                id = kos_pci_config_read((uint8_t)bus, slot, function, KOS_PCI_VENDOR_ID);
+                if ((id & 0xFFFF) != 0xFFFF) {
+                    kos_pci_add_function((uint8_t)bus, slot, function, id);
+                }
+            }
+        }
+    }
+
+    g_pci_initialized = true;
+    log_info("PCI: %d functions found", (int)g_pci_device_count);
+    return KOS_SUCCESS;
+}
+
+uint32_t kos_pci_get_device_count(void) {
+    return g_pci_device_count;
+}
+
+kos_pci_device_t* kos_pci_get_device(uint32_t index) {
+    if (index >= g_pci_device_count) {
+        return NULL;
+    }
+
+    return &g_pci_devices[index];
+}
+
+// Find the first function with a vendor/device ID pair
+kos_pci_device_t* kos_pci_find_device(uint16_t vendor_id, uint16_t device_id) {
+    for (uint32_t i = 0; i < g_pci_device_count; i++) {
+        if (g_pci_devices[i].vendor_id == vendor_id && g_pci_devices[i].device_id == device_id) {
+            return &g_pci_devices[i];
+        }
+    }
+
+    return NULL;
+}
+
+// Find the first function of a class/subclass
+kos_pci_device_t* kos_pci_find_class(uint8_t class_code, uint8_t subclass) {
+    for (uint32_t i = 0; i < g_pci_device_count; i++) {
+        if (g_pci_devices[i].class_code == class_code && g_pci_devices[i].subclass == subclass) {
+            return &g_pci_devices[i];
+        }
+    }
+
+    return NULL;
+}
+
+// Dump enumerated functions
+void kos_pci_dump_devices(void) {
+    log_info("=== PCI Devices ===");
+    for (uint32_t i = 0; i < g_pci_device_count; i++) {
+        kos_pci_device_t* dev = &g_pci_devices[i];
+        log_info("%d:%d.%d %x:%x class %x/%x irq %d%s%s",
+                 dev->bus, dev->slot, dev->function, dev->vendor_id, dev->device_id,
+                 dev->class_code, dev->subclass, dev->irq_line,
+                 dev->msi_cap ? " MSI" : "", dev->msix_cap ? " MSI-X" : "");
+    }
+}
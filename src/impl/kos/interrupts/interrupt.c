@@ -1,6 +1,12 @@
 #include "kos/interrupts/interrupt.h"
 #include "kos/utils/string.h"
 #include "kos/memory/memory.h"
+#include "kos/time/clock.h"
+#include "kos/cpu/irqflags.h"
+#include "kos/interrupts/softirq.h"
+#include "kos/sync/seqlock.h"
+#include "kos/cpu/counter.h"
+#include "kos/cpu/percpu.h"
 #include "debug/debug.h"
 
 // =============================================================================
@@ -11,14 +17,55 @@
 extern memory_manager_t g_memory_manager;
 extern uint64_t kos_get_timestamp(void);
 
-// Global interrupt state
-static kos_interrupt_config_t g_interrupt_config = {0};
+// Global interrupt state, nesting by priority is on until kos_interrupt_init says otherwise
+static kos_interrupt_config_t g_interrupt_config = {
+    .enable_nesting = true,
+    .enable_priority = true,
+    .enable_statistics = true,
+    .max_nesting_level = KOS_INTERRUPT_PRIORITY_COUNT
+};
 static kos_interrupt_stats_t g_interrupt_stats = {0};
-static kos_interrupt_descriptor_t g_interrupt_descriptors[KOS_IRQ_COUNT] = {0};
+static kos_seqlock_t g_interrupt_stats_lock = KOS_SEQLOCK_INIT;    // Writers run with interrupts off
+
+KOS_COUNTER_DEFINE(irq, interrupts);
+KOS_COUNTER_DEFINE(irq, unhandled_interrupts);
+static kos_interrupt_descriptor_t g_interrupt_descriptors[KOS_IRQ_LINES] = {0};
 static kos_interrupt_stack_t g_interrupt_stack = {0};
 static bool g_interrupt_initialized = false;
 static kos_interrupt_state_t g_interrupt_state = KOS_INTERRUPT_ENABLED;
 
+// Handler pool, lines link actions out of it
+static kos_irq_action_t g_irq_actions[KOS_IRQ_MAX_ACTIONS];
+static kos_irq_action_t* g_irq_free_actions = NULL;
+static bool g_irq_table_ready = false;
+
+// Dynamic lines handed out for MSI/MSI-X
+static bool g_irq_dynamic_used[KOS_IRQ_DYNAMIC_COUNT];
+
+// Priority nesting state, the running priority and depth are per CPU
+static const kos_irq_chip_t* g_irq_chip = NULL;                    // Legacy line controller
+static uint32_t g_priority_lines[KOS_INTERRUPT_PRIORITY_COUNT];   // Lines at or below each priority
+
+// Default priority per line: the clock preempts everything, slow block devices nothing
+static const kos_interrupt_priority_t g_irq_default_priorities[KOS_IRQ_COUNT] = {
+    KOS_INTERRUPT_PRIORITY_HIGH,      // Timer
+    KOS_INTERRUPT_PRIORITY_NORMAL,    // Keyboard
+    KOS_INTERRUPT_PRIORITY_NORMAL,    // Cascade
+    KOS_INTERRUPT_PRIORITY_NORMAL,    // COM2
+    KOS_INTERRUPT_PRIORITY_NORMAL,    // COM1
+    KOS_INTERRUPT_PRIORITY_LOW,       // LPT2
+    KOS_INTERRUPT_PRIORITY_LOW,       // Floppy
+    KOS_INTERRUPT_PRIORITY_LOW,       // LPT1
+    KOS_INTERRUPT_PRIORITY_HIGH,      // CMOS RTC
+    KOS_INTERRUPT_PRIORITY_NORMAL,    // Free1
+    KOS_INTERRUPT_PRIORITY_NORMAL,    // Free2
+    KOS_INTERRUPT_PRIORITY_NORMAL,    // Free3
+    KOS_INTERRUPT_PRIORITY_NORMAL,    // Mouse
+    KOS_INTERRUPT_PRIORITY_NORMAL,    // Math Coprocessor
+    KOS_INTERRUPT_PRIORITY_LOW,       // Primary ATA
+    KOS_INTERRUPT_PRIORITY_LOW        // Secondary ATA
+};
+
 // IRQ names and descriptions
 static const char* g_irq_names[KOS_IRQ_COUNT] = {
     "Timer",
@@ -63,6 +110,83 @@ static uint32_t g_irq_vectors[KOS_IRQ_COUNT] = {
     32, 33, 34, 35, 36, 37, 38, 39, 40, 41, 42, 43, 44, 45, 46, 47
 };
 
+static void kos_interrupt_storm_poll(void* context);
+static void kos_interrupt_storm_report(void* data);
+
+// Throttled lines are reported from the worker, not from the handler
+static kos_work_t g_irq_storm_work = KOS_WORK_INIT(kos_interrupt_storm_report, NULL);
+
+// Recompute which lines each priority level holds off
+static void kos_interrupt_update_priority_lines(void) {
+    for (int p = 0; p < KOS_INTERRUPT_PRIORITY_COUNT; p++) {
+        uint32_t lines = 0;
+        for (int i = 0; i < KOS_IRQ_COUNT; i++) {
+            if ((int)g_interrupt_descriptors[i].priority <= p) {
+                lines |= 1U << i;
+            }
+        }
+        g_priority_lines[p] = lines;
+    }
+}
+
+// Hold off everything at or below a priority, -1 releases all. The legacy
+// lines only reach the boot CPU, so only it touches their mask.
+static void kos_interrupt_hold_off(int priority) {
+    if (g_irq_chip && g_irq_chip->mask_lines && kos_this_cpu_id() == 0) {
+        g_irq_chip->mask_lines(priority < 0 ? 0 : g_priority_lines[priority]);
+    }
+    kos_write_cr8(priority < 0 ? 0 : kos_interrupt_priority_to_tpr((kos_interrupt_priority_t)priority));
+}
+
+// Acknowledge a line at its controller
+static void kos_interrupt_eoi(uint32_t irq) {
+    const kos_irq_chip_t* chip = g_interrupt_descriptors[irq].chip;
+    if (chip && chip->eoi) {
+        chip->eoi(irq);
+    }
+}
+
+// Set up the descriptor table and handler pool
+static void kos_interrupt_table_init(void) {
+    if (g_irq_table_ready) {
+        return;
+    }
+    
+    for (int i = 0; i < KOS_IRQ_LINES; i++) {
+        kos_memset(&g_interrupt_descriptors[i], 0, sizeof(kos_interrupt_descriptor_t));
+        g_interrupt_descriptors[i].irq = i;
+        if (i < KOS_IRQ_COUNT) {
+            g_interrupt_descriptors[i].vector = g_irq_vectors[i];
+            g_interrupt_descriptors[i].priority = g_irq_default_priorities[i];
+        } else {
+            // A dynamic line's priority is the class of its vector
+            g_interrupt_descriptors[i].vector = KOS_IRQ_DYNAMIC_VECTOR_BASE + (i - KOS_IRQ_COUNT);
+            g_interrupt_descriptors[i].priority =
+                (kos_interrupt_priority_t)((g_interrupt_descriptors[i].vector >> 4) - KOS_INTERRUPT_TPR_BASE);
+        }
+        g_interrupt_descriptors[i].enabled = false;
+        g_interrupt_descriptors[i].min_time = UINT64_MAX;
+        
+        // The clock line drives the poll timers, so it is never throttled
+        g_interrupt_descriptors[i].rate_limit = (i == KOS_IRQ_TIMER) ? 0 : KOS_IRQ_STORM_DEFAULT_RATE;
+        g_interrupt_descriptors[i].backoff_ns = KOS_IRQ_STORM_BACKOFF_MIN_NS;
+        kos_timer_init(&g_interrupt_descriptors[i].poll_timer, kos_interrupt_storm_poll, &g_interrupt_descriptors[i]);
+    }
+    
+    g_irq_free_actions = NULL;
+    for (int i = KOS_IRQ_MAX_ACTIONS - 1; i >= 0; i--) {
+        g_irq_actions[i].next = g_irq_free_actions;
+        g_irq_free_actions = &g_irq_actions[i];
+    }
+    
+    kos_interrupt_update_priority_lines();
+    
+    uint64_t flags = kos_write_seqlock_irqsave(&g_interrupt_stats_lock);
+    g_interrupt_stats.min_interrupt_time = UINT64_MAX;
+    kos_write_sequnlock_irqrestore(&g_interrupt_stats_lock, flags);
+    g_irq_table_ready = true;
+}
+
 // Interrupt initialization
 kos_result_t kos_interrupt_init(const kos_interrupt_config_t* config) {
     if (!config) {
@@ -72,17 +196,16 @@ kos_result_t kos_interrupt_init(const kos_interrupt_config_t* config) {
     // Copy configuration
     g_interrupt_config = *config;
     
-    // Initialize statistics
-    kos_memset(&g_interrupt_stats, 0, sizeof(kos_interrupt_stats_t));
+    // Handlers may already be installed by early boot code
+    kos_interrupt_table_init();
     
-    // Initialize interrupt descriptors
-    for (int i = 0; i < KOS_IRQ_COUNT; i++) {
-        kos_memset(&g_interrupt_descriptors[i], 0, sizeof(kos_interrupt_descriptor_t));
-        g_interrupt_descriptors[i].irq = i;
-        g_interrupt_descriptors[i].vector = g_irq_vectors[i];
-        g_interrupt_descriptors[i].priority = KOS_INTERRUPT_PRIORITY_NORMAL;
-        g_interrupt_descriptors[i].enabled = false;
-        g_interrupt_descriptors[i].min_time = UINT64_MAX;
+    // A configured budget replaces the default on every rate-limited line
+    if (config->storm_rate_limit > 0) {
+        for (int i = 0; i < KOS_IRQ_LINES; i++) {
+            if (g_interrupt_descriptors[i].rate_limit > 0) {
+                g_interrupt_descriptors[i].rate_limit = config->storm_rate_limit;
+            }
+        }
     }
     
     // Initialize interrupt stack
@@ -103,14 +226,103 @@ kos_result_t kos_interrupt_init(const kos_interrupt_config_t* config) {
     return KOS_SUCCESS;
 }
 
-// Register interrupt handler
-kos_result_t kos_interrupt_register_handler(kos_irq_t irq, kos_interrupt_handler_t handler, void* context, const char* name) {
-    if (!g_interrupt_initialized) {
-        log_error("Interrupt system not initialized");
-        return KOS_ERROR_INVALID_STATE;
+// Install the controller that masks and acknowledges the legacy lines
+kos_result_t kos_interrupt_set_chip(const kos_irq_chip_t* chip) {
+    if (!chip || !chip->eoi) {
+        return KOS_ERROR_INVALID_PARAM;
     }
     
-    if (irq >= KOS_IRQ_COUNT) {
+    kos_interrupt_table_init();
+    g_irq_chip = chip;
+    for (int i = 0; i < KOS_IRQ_COUNT; i++) {
+        g_interrupt_descriptors[i].chip = chip;
+    }
+    
+    log_debug("Interrupt controller: %s", chip->name);
+    return KOS_SUCCESS;
+}
+
+// Allocate count lines (a power of two) whose vectors are contiguous and
+// aligned, as multi-message MSI requires, in the vector class of a priority
+kos_result_t kos_interrupt_alloc_dynamic(kos_interrupt_priority_t priority, uint32_t count, const kos_irq_chip_t* chip, kos_irq_t* first_irq) {
+    if (priority >= KOS_INTERRUPT_PRIORITY_COUNT || count == 0 || count > KOS_IRQ_VECTORS_PER_CLASS ||
+        (count & (count - 1)) != 0 || !chip || !chip->eoi || !first_irq) {
+        return KOS_ERROR_INVALID_PARAM;
+    }
+    
+    kos_interrupt_table_init();
+    
+    uint32_t class_slot = ((uint32_t)kos_interrupt_priority_to_tpr(priority) << 4) - KOS_IRQ_DYNAMIC_VECTOR_BASE;
+    uint64_t flags = kos_local_irq_save();
+    
+    for (uint32_t slot = class_slot; slot < class_slot + KOS_IRQ_VECTORS_PER_CLASS; slot += count) {
+        bool free = true;
+        for (uint32_t k = 0; k < count; k++) {
+            if (g_irq_dynamic_used[slot + k]) {
+                free = false;
+                break;
+            }
+        }
+        if (!free) {
+            continue;
+        }
+        
+        for (uint32_t k = 0; k < count; k++) {
+            g_irq_dynamic_used[slot + k] = true;
+            g_interrupt_descriptors[KOS_IRQ_COUNT + slot + k].chip = chip;
+        }
+        kos_local_irq_restore(flags);
+        
+        *first_irq = (kos_irq_t)(KOS_IRQ_COUNT + slot);
+        log_debug("Allocated IRQ %d-%d (vectors 0x%x-0x%x) for %s", *first_irq, *first_irq + count - 1,
+                  KOS_IRQ_DYNAMIC_VECTOR_BASE + slot, KOS_IRQ_DYNAMIC_VECTOR_BASE + slot + count - 1, chip->name);
+        return KOS_SUCCESS;
+    }
+    
+    kos_local_irq_restore(flags);
+    log_error("No free vectors for %d lines at priority %d", count, priority);
+    return KOS_ERROR_OUT_OF_MEMORY;
+}
+
+// Release dynamic lines, removing any handlers left on them
+void kos_interrupt_free_dynamic(kos_irq_t first_irq, uint32_t count) {
+    for (uint32_t k = 0; k < count; k++) {
+        kos_irq_t irq = (kos_irq_t)(first_irq + k);
+        if (!kos_interrupt_is_dynamic(irq)) {
+            continue;
+        }
+        
+        kos_interrupt_descriptor_t* desc = &g_interrupt_descriptors[irq];
+        kos_interrupt_unregister_handler(irq);
+        kos_timer_cancel(&desc->poll_timer);
+        
+        uint64_t flags = kos_local_irq_save();
+        desc->throttled = false;
+        desc->chip = NULL;
+        g_irq_dynamic_used[irq - KOS_IRQ_COUNT] = false;
+        kos_local_irq_restore(flags);
+    }
+}
+
+// Check whether a line was allocated dynamically
+bool kos_interrupt_is_dynamic(kos_irq_t irq) {
+    return irq >= KOS_IRQ_COUNT && irq < KOS_IRQ_LINES && g_irq_dynamic_used[irq - KOS_IRQ_COUNT];
+}
+
+// Map an IDT vector to its line, KOS_IRQ_LINES if none
+uint32_t kos_interrupt_vector_to_irq(uint32_t vector) {
+    if (vector >= 32 && vector < 32 + KOS_IRQ_COUNT) {
+        return vector - 32;
+    }
+    if (vector >= KOS_IRQ_DYNAMIC_VECTOR_BASE && vector < KOS_IRQ_DYNAMIC_VECTOR_BASE + KOS_IRQ_DYNAMIC_COUNT) {
+        return KOS_IRQ_COUNT + (vector - KOS_IRQ_DYNAMIC_VECTOR_BASE);
+    }
+    return KOS_IRQ_LINES;
+}
+
+// Add a handler to an IRQ line
+kos_result_t kos_interrupt_request(kos_irq_t irq, kos_interrupt_handler_t handler, void* context, uint32_t flags, const char* name) {
+    if (irq >= KOS_IRQ_LINES) {
         log_error("Invalid IRQ number: %d", irq);
         return KOS_ERROR_INVALID_PARAM;
     }
@@ -120,77 +332,138 @@ kos_result_t kos_interrupt_register_handler(kos_irq_t irq, kos_interrupt_handler
         return KOS_ERROR_INVALID_PARAM;
     }
     
+    kos_interrupt_table_init();
+    
+    uint64_t irq_flags = kos_local_irq_save();
+    
     kos_interrupt_descriptor_t* desc = &g_interrupt_descriptors[irq];
     
-    // Check if handler is already registered
-    if (desc->handler != NULL) {
-        log_warn("Handler already registered for IRQ %d, replacing", irq);
+    // Every handler on a busy line must agree to share it
+    if (desc->actions && !(desc->flags & flags & KOS_IRQF_SHARED)) {
+        kos_local_irq_restore(irq_flags);
+        log_error("IRQ %d (%s) is busy and not shared", irq, kos_interrupt_get_name(irq));
+        return KOS_ERROR_INVALID_STATE;
     }
     
-    // Set up descriptor
-    desc->handler = handler;
-    desc->device_context = context;
-    desc->enabled = true;
-    desc->count = 0;
-    desc->last_time = 0;
+    kos_irq_action_t* action = g_irq_free_actions;
+    if (!action) {
+        kos_local_irq_restore(irq_flags);
+        log_error("Out of IRQ handler slots");
+        return KOS_ERROR_OUT_OF_MEMORY;
+    }
+    g_irq_free_actions = action->next;
     
+    action->handler = handler;
+    action->context = context;
+    action->flags = flags;
+    action->handled = 0;
+    action->next = NULL;
     if (name) {
-        kos_strncpy(desc->name, name, sizeof(desc->name) - 1);
-        desc->name[sizeof(desc->name) - 1] = '\0';
+        kos_strncpy(action->name, name, sizeof(action->name) - 1);
+        action->name[sizeof(action->name) - 1] = '\0';
     } else {
-        kos_strcpy(desc->name, "Unknown");
+        kos_strcpy(action->name, "Unknown");
+    }
+    
+    // Append so earlier handlers keep their priority on shared lines
+    kos_irq_action_t** tail = &desc->actions;
+    while (*tail) {
+        tail = &(*tail)->next;
     }
+    *tail = action;
     
-    log_debug("Registered handler for IRQ %d (%s): %s", irq, kos_interrupt_get_name(irq), desc->name);
+    desc->flags = flags;
+    desc->action_count++;
+    desc->enabled = true;
+    
+    // The first handler opens the line at its controller
+    if (desc->action_count == 1 && !desc->throttled) {
+        kos_interrupt_unmask(irq);
+    }
+    
+    kos_local_irq_restore(irq_flags);
+    
+    log_debug("Registered handler for IRQ %d (%s): %s", irq, kos_interrupt_get_name(irq), action->name);
     return KOS_SUCCESS;
 }
 
-// Unregister interrupt handler
-kos_result_t kos_interrupt_unregister_handler(kos_irq_t irq) {
-    if (!g_interrupt_initialized) {
-        log_error("Interrupt system not initialized");
-        return KOS_ERROR_INVALID_STATE;
-    }
-    
-    if (irq >= KOS_IRQ_COUNT) {
-        log_error("Invalid IRQ number: %d", irq);
+// Remove the handler registered with context from an IRQ line
+kos_result_t kos_interrupt_free(kos_irq_t irq, void* context) {
+    if (irq >= KOS_IRQ_LINES || !g_irq_table_ready) {
         return KOS_ERROR_INVALID_PARAM;
     }
     
+    uint64_t irq_flags = kos_local_irq_save();
+    
     kos_interrupt_descriptor_t* desc = &g_interrupt_descriptors[irq];
+    kos_irq_action_t** link = &desc->actions;
+    while (*link && (*link)->context != context) {
+        link = &(*link)->next;
+    }
     
-    // Clear descriptor
-    desc->handler = NULL;
-    desc->device_context = NULL;
-    desc->enabled = false;
-    kos_strcpy(desc->name, "Unregistered");
+    kos_irq_action_t* action = *link;
+    if (!action) {
+        kos_local_irq_restore(irq_flags);
+        return KOS_ERROR_NOT_FOUND;
+    }
+    
+    *link = action->next;
+    action->next = g_irq_free_actions;
+    g_irq_free_actions = action;
+    
+    desc->action_count--;
+    if (!desc->actions) {
+        desc->flags = 0;
+        desc->enabled = false;
+        kos_interrupt_mask(irq);
+    }
+    
+    kos_local_irq_restore(irq_flags);
     
     log_debug("Unregistered handler for IRQ %d (%s)", irq, kos_interrupt_get_name(irq));
     return KOS_SUCCESS;
 }
 
-// Enable interrupt
-kos_result_t kos_interrupt_enable(kos_irq_t irq) {
-    if (!g_interrupt_initialized) {
-        return KOS_ERROR_INVALID_STATE;
+// Register an exclusive interrupt handler
+kos_result_t kos_interrupt_register_handler(kos_irq_t irq, kos_interrupt_handler_t handler, void* context, const char* name) {
+    return kos_interrupt_request(irq, handler, context, 0, name);
+}
+
+// Unregister every handler on an IRQ line
+kos_result_t kos_interrupt_unregister_handler(kos_irq_t irq) {
+    if (irq >= KOS_IRQ_LINES) {
+        log_error("Invalid IRQ number: %d", irq);
+        return KOS_ERROR_INVALID_PARAM;
     }
     
-    if (irq >= KOS_IRQ_COUNT) {
+    while (g_irq_table_ready && g_interrupt_descriptors[irq].actions) {
+        kos_interrupt_free(irq, g_interrupt_descriptors[irq].actions->context);
+    }
+    
+    return KOS_SUCCESS;
+}
+
+// Enable interrupt
+kos_result_t kos_interrupt_enable(kos_irq_t irq) {
+    if (irq >= KOS_IRQ_LINES) {
         return KOS_ERROR_INVALID_PARAM;
     }
     
+    kos_interrupt_table_init();
+    
     kos_interrupt_descriptor_t* desc = &g_interrupt_descriptors[irq];
     
-    if (!desc->handler) {
+    if (!desc->actions) {
         log_warn("Attempting to enable IRQ %d with no handler", irq);
         return KOS_ERROR_INVALID_STATE;
     }
     
     desc->enabled = true;
     
-    // Enable interrupt in hardware (PIC)
-    // This would involve writing to the PIC registers
-    // For now, we just mark it as enabled
+    // A throttled line is unmasked by its poll timer once the backoff expires
+    if (!desc->throttled) {
+        kos_interrupt_unmask(irq);
+    }
     
     log_debug("Enabled IRQ %d (%s)", irq, kos_interrupt_get_name(irq));
     return KOS_SUCCESS;
@@ -198,25 +471,50 @@ kos_result_t kos_interrupt_enable(kos_irq_t irq) {
 
 // Disable interrupt
 kos_result_t kos_interrupt_disable(kos_irq_t irq) {
-    if (!g_interrupt_initialized) {
-        return KOS_ERROR_INVALID_STATE;
-    }
-    
-    if (irq >= KOS_IRQ_COUNT) {
+    if (irq >= KOS_IRQ_LINES) {
         return KOS_ERROR_INVALID_PARAM;
     }
     
+    kos_interrupt_table_init();
+    
     kos_interrupt_descriptor_t* desc = &g_interrupt_descriptors[irq];
     desc->enabled = false;
-    
-    // Disable interrupt in hardware (PIC)
-    // This would involve writing to the PIC registers
-    // For now, we just mark it as disabled
+    kos_interrupt_mask(irq);
     
     log_debug("Disabled IRQ %d (%s)", irq, kos_interrupt_get_name(irq));
     return KOS_SUCCESS;
 }
 
+// Mask a line at the controller
+kos_result_t kos_interrupt_mask(kos_irq_t irq) {
+    if (irq >= KOS_IRQ_LINES) {
+        return KOS_ERROR_INVALID_PARAM;
+    }
+    
+    const kos_irq_chip_t* chip = g_interrupt_descriptors[irq].chip;
+    if (!chip || !chip->mask) {
+        return KOS_ERROR_NOT_IMPLEMENTED;
+    }
+    
+    chip->mask(irq);
+    return KOS_SUCCESS;
+}
+
+// Unmask a line at the controller
+kos_result_t kos_interrupt_unmask(kos_irq_t irq) {
+    if (irq >= KOS_IRQ_LINES) {
+        return KOS_ERROR_INVALID_PARAM;
+    }
+    
+    const kos_irq_chip_t* chip = g_interrupt_descriptors[irq].chip;
+    if (!chip || !chip->unmask) {
+        return KOS_ERROR_NOT_IMPLEMENTED;
+    }
+    
+    chip->unmask(irq);
+    return KOS_SUCCESS;
+}
+
 // Get interrupt state
 kos_interrupt_state_t kos_interrupt_get_state(void) {
     return g_interrupt_state;
@@ -270,222 +568,562 @@ kos_result_t kos_interrupt_restore_enable(kos_interrupt_state_t state) {
     return kos_interrupt_set_state(state);
 }
 
-// Enter nested interrupt
+// Account for a handler entry, called with interrupts off
 kos_result_t kos_interrupt_enter_nest(kos_irq_t irq) {
-    if (!g_interrupt_initialized) {
-        return KOS_ERROR_INVALID_STATE;
+    if (irq >= KOS_IRQ_LINES) {
+        return KOS_ERROR_INVALID_PARAM;
     }
     
-    if (!g_interrupt_config.enable_nesting) {
-        return KOS_ERROR_NOT_IMPLEMENTED;
-    }
+    kos_interrupt_priority_stats_t* stats = &g_interrupt_stats.priority[g_interrupt_descriptors[irq].priority];
+    kos_cpu_irq_t* cpu = kos_percpu_irq();
+    uintptr_t sp = (uintptr_t)__builtin_frame_address(0);
     
-    if (g_interrupt_stack.nesting_level >= g_interrupt_config.max_nesting_level) {
-        log_error("Interrupt nesting level too deep: %d", g_interrupt_stack.nesting_level);
-        return KOS_ERROR_INVALID_STATE;
+    kos_write_seqlock(&g_interrupt_stats_lock);
+    
+    if (cpu->dispatch_nesting == 0) {
+        cpu->stack_base = sp;
+    } else {
+        g_interrupt_stats.nested_interrupts++;
+        stats->preemptions++;
     }
     
-    g_interrupt_stack.nesting_level++;
-    g_interrupt_stats.nested_interrupts++;
+    cpu->dispatch_nesting++;
     
-    log_debug("Entered nested interrupt %d, level: %d", irq, g_interrupt_stack.nesting_level);
+    stats->entries++;
+    if (cpu->dispatch_nesting > stats->max_depth) {
+        stats->max_depth = cpu->dispatch_nesting;
+    }
+    if (cpu->stack_base > sp && cpu->stack_base - sp > stats->max_stack_bytes) {
+        stats->max_stack_bytes = cpu->stack_base - sp;
+    }
+    
+    kos_write_sequnlock(&g_interrupt_stats_lock);
     return KOS_SUCCESS;
 }
 
-// Exit nested interrupt
+// Account for a handler exit, called with interrupts off
 kos_result_t kos_interrupt_exit_nest(kos_irq_t irq) {
-    if (!g_interrupt_initialized) {
-        return KOS_ERROR_INVALID_STATE;
-    }
+    (void)irq;
     
-    if (g_interrupt_stack.nesting_level == 0) {
-        log_error("Attempting to exit nested interrupt with level 0");
+    kos_cpu_irq_t* cpu = kos_percpu_irq();
+    if (cpu->dispatch_nesting == 0) {
         return KOS_ERROR_INVALID_STATE;
     }
     
-    g_interrupt_stack.nesting_level--;
-    
-    log_debug("Exited nested interrupt %d, level: %d", irq, g_interrupt_stack.nesting_level);
+    cpu->dispatch_nesting--;
     return KOS_SUCCESS;
 }
 
-// Get nesting level
+// Get the calling CPU's nesting level
 uint32_t kos_interrupt_get_nesting_level(void) {
-    return g_interrupt_stack.nesting_level;
+    return kos_percpu_irq()->dispatch_nesting;
 }
 
-// Check if nested
+// Check if the calling CPU is inside a handler
 bool kos_interrupt_is_nested(void) {
-    return g_interrupt_stack.nesting_level > 0;
+    return kos_percpu_irq()->dispatch_nesting > 0;
 }
 
-// Handle interrupt
-void kos_interrupt_handle(uint32_t irq) {
-    if (!g_interrupt_initialized) {
-        log_error("Interrupt system not initialized");
-        return;
+// Bound how many handlers may be stacked on top of each other
+kos_result_t kos_interrupt_set_max_nesting(uint32_t max_level) {
+    if (max_level == 0 || max_level > KOS_INTERRUPT_PRIORITY_COUNT) {
+        return KOS_ERROR_INVALID_PARAM;
+    }
+    
+    g_interrupt_config.max_nesting_level = max_level;
+    return KOS_SUCCESS;
+}
+
+// Get the priority of an IRQ line
+kos_interrupt_priority_t kos_interrupt_get_priority(kos_irq_t irq) {
+    if (irq >= KOS_IRQ_LINES) {
+        return KOS_INTERRUPT_PRIORITY_LOW;
     }
     
+    kos_interrupt_table_init();
+    return g_interrupt_descriptors[irq].priority;
+}
+
+// Set the priority of an IRQ line
+kos_result_t kos_interrupt_set_priority(kos_irq_t irq, kos_interrupt_priority_t priority) {
+    if (irq >= KOS_IRQ_LINES || priority >= KOS_INTERRUPT_PRIORITY_COUNT) {
+        return KOS_ERROR_INVALID_PARAM;
+    }
+    
+    // Dynamic lines take their priority from the vector class they were given
     if (irq >= KOS_IRQ_COUNT) {
-        log_error("Invalid IRQ number: %d", irq);
-        return;
+        return KOS_ERROR_INVALID_STATE;
     }
     
-    kos_interrupt_descriptor_t* desc = &g_interrupt_descriptors[irq];
+    kos_interrupt_table_init();
     
-    // Check if handler is registered and enabled
-    if (!desc->handler || !desc->enabled) {
-        log_warn("No handler or disabled for IRQ %d", irq);
-        g_interrupt_stats.failed_interrupts++;
+    uint64_t flags = kos_local_irq_save();
+    g_interrupt_descriptors[irq].priority = priority;
+    kos_interrupt_update_priority_lines();
+    kos_local_irq_restore(flags);
+    
+    log_debug("IRQ %d (%s) priority %d", irq, kos_interrupt_get_name(irq), priority);
+    return KOS_SUCCESS;
+}
+
+// Mask a line that exceeds its budget and hand its handlers to the poll timer
+static void kos_interrupt_throttle(kos_interrupt_descriptor_t* desc) {
+    uint64_t now = kos_clock_monotonic_ns();
+    
+    // Storming again soon after the last retry doubles the backoff
+    if (desc->storms > 0 && now - desc->calm_since_ns < KOS_IRQ_STORM_CALM_NS) {
+        desc->backoff_ns *= 2;
+        if (desc->backoff_ns > KOS_IRQ_STORM_BACKOFF_MAX_NS) {
+            desc->backoff_ns = KOS_IRQ_STORM_BACKOFF_MAX_NS;
+        }
+    } else {
+        desc->backoff_ns = KOS_IRQ_STORM_BACKOFF_MIN_NS;
+    }
+    
+    desc->throttled = true;
+    desc->storms++;
+    desc->unthrottle_ns = now + desc->backoff_ns;
+    kos_write_seqlock(&g_interrupt_stats_lock);
+    g_interrupt_stats.storms++;
+    kos_write_sequnlock(&g_interrupt_stats_lock);
+    
+    kos_interrupt_mask(desc->irq);
+    kos_timer_add_relative(&desc->poll_timer, KOS_IRQ_STORM_POLL_NS);
+    kos_work_queue(&g_irq_storm_work);
+}
+
+// Fold the interrupt into the line's rate estimate, called with interrupts off
+static void kos_interrupt_account_rate(kos_interrupt_descriptor_t* desc, uint64_t now_cycles) {
+    desc->window_count++;
+    
+    uint64_t elapsed = kos_clock_cycles_to_ns(now_cycles - desc->window_start);
+    if (elapsed < KOS_IRQ_STORM_WINDOW_NS) {
         return;
     }
     
-    // Update statistics
-    g_interrupt_stats.total_interrupts++;
-    g_interrupt_stats.interrupt_counts[irq]++;
-    desc->count++;
+    uint32_t sample = (uint32_t)((uint64_t)desc->window_count * KOS_NSEC_PER_SEC / elapsed);
+    
+    // After a long quiet spell the old average says nothing
+    if (elapsed >= (KOS_IRQ_STORM_WINDOW_NS << KOS_IRQ_STORM_EWMA_SHIFT)) {
+        desc->rate = sample;
+    } else {
+        desc->rate = desc->rate - (desc->rate >> KOS_IRQ_STORM_EWMA_SHIFT) + (sample >> KOS_IRQ_STORM_EWMA_SHIFT);
+    }
+    
+    desc->window_start = now_cycles;
+    desc->window_count = 0;
     
-    uint64_t start_time = kos_get_timestamp();
-    
-    // Create interrupt context
-    kos_interrupt_context_t context = {
-        .irq = irq,
-        .vector = desc->vector,
-        .type = KOS_INTERRUPT_HARDWARE,
-        .priority = desc->priority,
-        .state = KOS_INTERRUPT_ACTIVE,
-        .timestamp = start_time,
-        .device_context = desc->device_context,
-        .nesting_level = g_interrupt_stack.nesting_level,
-        .is_nested = g_interrupt_stack.nesting_level > 0
-    };
-    
-    // Handle nesting if enabled
-    if (g_interrupt_config.enable_nesting && g_interrupt_stack.nesting_level > 0) {
-        kos_interrupt_handle_nested(irq);
+    if (desc->rate_limit > 0 && desc->rate > desc->rate_limit && !desc->throttled) {
+        kos_interrupt_throttle(desc);
+    }
+}
+
+// Poll a throttled line's handlers, retry the line once the backoff expires
+static void kos_interrupt_storm_poll(void* context) {
+    kos_interrupt_descriptor_t* desc = (kos_interrupt_descriptor_t*)context;
+    
+    uint64_t flags = kos_local_irq_save();
+    
+    if (!desc->throttled) {
+        kos_local_irq_restore(flags);
         return;
     }
     
-    // Call the handler
-    desc->handler(irq, desc->device_context);
+    // Handlers see the same call as from the line, just at a bounded rate
+    for (kos_irq_action_t* action = desc->actions; action; action = action->next) {
+        if (action->handler(desc->irq, action->context) == KOS_IRQ_HANDLED) {
+            action->handled++;
+        }
+    }
+    desc->polls++;
     
-    uint64_t end_time = kos_get_timestamp();
-    uint64_t elapsed = end_time - start_time;
+    uint64_t now = kos_clock_monotonic_ns();
+    if (now >= desc->unthrottle_ns) {
+        // Start the estimate over at the budget so a still-stuck line trips at once
+        desc->throttled = false;
+        desc->calm_since_ns = now;
+        desc->rate = desc->rate_limit;
+        desc->window_start = kos_clock_cycles();
+        desc->window_count = 0;
+        if (desc->enabled) {
+            kos_interrupt_unmask(desc->irq);
+        }
+    } else {
+        kos_timer_add_relative(&desc->poll_timer, KOS_IRQ_STORM_POLL_NS);
+    }
     
-    // Update timing statistics
-    g_interrupt_stats.total_time += elapsed;
-    desc->total_time += elapsed;
-    desc->last_time = elapsed;
+    kos_local_irq_restore(flags);
+}
+
+// Report throttled lines from the worker
+static void kos_interrupt_storm_report(void* data) {
+    (void)data;
     
-    if (elapsed > desc->max_time) {
-        desc->max_time = elapsed;
+    for (int i = 0; i < KOS_IRQ_LINES; i++) {
+        kos_interrupt_descriptor_t* desc = &g_interrupt_descriptors[i];
+        if (desc->throttled) {
+            log_warn("IRQ %d (%s) storm: %u/s over budget %u/s, polled for %d ms",
+                     i, kos_interrupt_get_name((kos_irq_t)i), desc->rate, desc->rate_limit,
+                     (int)(desc->backoff_ns / KOS_NSEC_PER_MSEC));
+        }
     }
-    if (elapsed < desc->min_time) {
-        desc->min_time = elapsed;
+}
+
+// Set a line's storm budget in interrupts per second, 0 disables throttling
+kos_result_t kos_interrupt_set_rate_limit(kos_irq_t irq, uint32_t per_second) {
+    if (irq >= KOS_IRQ_LINES) {
+        return KOS_ERROR_INVALID_PARAM;
+    }
+    
+    kos_interrupt_table_init();
+    g_interrupt_descriptors[irq].rate_limit = per_second;
+    return KOS_SUCCESS;
+}
+
+// Get a line's averaged interrupt rate per second
+uint32_t kos_interrupt_get_rate(kos_irq_t irq) {
+    if (irq >= KOS_IRQ_LINES) {
+        return 0;
+    }
+    
+    return g_interrupt_descriptors[irq].rate;
+}
+
+// Check whether a line is masked for storming
+bool kos_interrupt_is_throttled(kos_irq_t irq) {
+    if (irq >= KOS_IRQ_LINES) {
+        return false;
+    }
+    
+    return g_interrupt_descriptors[irq].throttled;
+}
+
+// Number of lines currently throttled
+uint32_t kos_interrupt_throttled_count(void) {
+    uint32_t count = 0;
+    
+    for (int i = 0; i < KOS_IRQ_LINES; i++) {
+        if (g_interrupt_descriptors[i].throttled) {
+            count++;
+        }
+    }
+    
+    return count;
+}
+
+// Run every handler on an IRQ line, called from the low-level IRQ entry
+kos_result_t kos_interrupt_dispatch(uint32_t irq) {
+    if (irq >= KOS_IRQ_LINES) {
+        kos_write_seqlock(&g_interrupt_stats_lock);
+        g_interrupt_stats.failed_interrupts++;
+        kos_write_sequnlock(&g_interrupt_stats_lock);
+        return KOS_ERROR_INVALID_PARAM;
+    }
+    
+    kos_interrupt_descriptor_t* desc = &g_interrupt_descriptors[irq];
+    
+    if (!desc->enabled) {
+        kos_interrupt_eoi(irq);
+        kos_write_seqlock(&g_interrupt_stats_lock);
+        g_interrupt_stats.masked_interrupts++;
+        kos_write_sequnlock(&g_interrupt_stats_lock);
+        return KOS_ERROR_INVALID_STATE;
+    }
+    
+    uint64_t start_cycles = kos_clock_cycles();
+    kos_irq_return_t result = KOS_IRQ_NONE;
+    kos_counter_inc(interrupts);
+    
+    // Entry latency against the deadline the timer source announced
+    if (desc->expected_cycles) {
+        if (start_cycles > desc->expected_cycles) {
+            kos_histogram_record(&desc->latency, kos_clock_cycles_to_ns(start_cycles - desc->expected_cycles));
+        } else {
+            kos_histogram_record(&desc->latency, 0);
+        }
+        desc->expected_cycles = 0;
+    }
+    
+    // Higher priorities may preempt the handler, up to the nesting bound
+    kos_cpu_irq_t* cpu = kos_percpu_irq();
+    int previous = cpu->dispatch_nesting ? cpu->running_priority : -1;
+    bool preemptible = g_interrupt_config.enable_nesting && g_interrupt_config.enable_priority &&
+                       cpu->dispatch_nesting < g_interrupt_config.max_nesting_level;
+    
+    kos_interrupt_enter_nest(irq);
+    cpu->running_priority = desc->priority;
+    
+    // Early EOI: the priority mask, not the in-service bit, keeps the line quiet
+    if (preemptible) {
+        kos_interrupt_hold_off(desc->priority);
+    }
+    kos_interrupt_eoi(irq);
+    if (preemptible) {
+        kos_local_irq_enable();
+    }
+    
+    // Shared lines ask every device, each one reports whether it was the source
+    for (kos_irq_action_t* action = desc->actions; action; action = action->next) {
+        if (action->handler(irq, action->context) == KOS_IRQ_HANDLED) {
+            action->handled++;
+            result = KOS_IRQ_HANDLED;
+        }
+    }
+    
+    if (preemptible) {
+        kos_local_irq_disable();
+        kos_interrupt_hold_off(previous);
     }
     
+    cpu->running_priority = previous;
+    kos_interrupt_exit_nest(irq);
+    
+    kos_interrupt_account_rate(desc, start_cycles);
+    
+    uint64_t elapsed = kos_clock_cycles_to_ns(kos_clock_cycles() - start_cycles);
+    uint64_t end_ns = kos_get_timestamp();
+    
+    // Update statistics, one write section so snapshots see a whole interrupt
+    kos_write_seqlock(&g_interrupt_stats_lock);
+    g_interrupt_stats.total_interrupts++;
+    g_interrupt_stats.interrupt_counts[irq]++;
+    g_interrupt_stats.total_time += elapsed;
+    g_interrupt_stats.last_interrupt_time = end_ns;
+    g_interrupt_stats.last_irq = irq;
     if (elapsed > g_interrupt_stats.max_interrupt_time) {
         g_interrupt_stats.max_interrupt_time = elapsed;
     }
     if (elapsed < g_interrupt_stats.min_interrupt_time) {
         g_interrupt_stats.min_interrupt_time = elapsed;
     }
+    if (result == KOS_IRQ_NONE) {
+        g_interrupt_stats.failed_interrupts++;
+    }
+    kos_write_sequnlock(&g_interrupt_stats_lock);
     
-    g_interrupt_stats.last_interrupt_time = end_time;
-    g_interrupt_stats.last_irq = irq;
+    desc->count++;
+    desc->total_time += elapsed;
+    desc->last_time = elapsed;
+    kos_histogram_record(&desc->duration, elapsed);
+    if (elapsed > desc->max_time) {
+        desc->max_time = elapsed;
+    }
+    if (elapsed < desc->min_time) {
+        desc->min_time = elapsed;
+    }
+    
+    if (result == KOS_IRQ_NONE) {
+        desc->unhandled++;
+        kos_counter_inc(unhandled_interrupts);
+        return KOS_ERROR_NOT_FOUND;
+    }
     
-    log_debug("Handled IRQ %d (%s) in %llu cycles", irq, kos_interrupt_get_name(irq), elapsed);
+    return KOS_SUCCESS;
 }
 
-// Handle nested interrupt
-void kos_interrupt_handle_nested(uint32_t irq) {
-    if (!g_interrupt_config.enable_nesting) {
-        log_error("Nested interrupts not enabled");
+// Announce when a timer-driven IRQ is due, in kos_clock_cycles() units
+void kos_interrupt_set_expected(kos_irq_t irq, uint64_t deadline_cycles) {
+    if (irq >= KOS_IRQ_LINES) {
         return;
     }
     
-    kos_interrupt_enter_nest(irq);
-    
-    // Handle the interrupt
-    kos_interrupt_handle(irq);
-    
-    kos_interrupt_exit_nest(irq);
+    g_interrupt_descriptors[irq].expected_cycles = deadline_cycles;
 }
 
-// Get interrupt statistics
-const kos_interrupt_stats_t* kos_interrupt_get_stats(void) {
-    return &g_interrupt_stats;
+// Handle interrupt
+void kos_interrupt_handle(uint32_t irq) {
+    kos_interrupt_dispatch(irq);
+}
+
+// Handle nested interrupt, dispatch already opens the priority window
+void kos_interrupt_handle_nested(uint32_t irq) {
+    kos_interrupt_dispatch(irq);
+}
+
+// Copy a consistent snapshot of the interrupt statistics, retries while a
+// handler is updating them instead of holding interrupts off
+void kos_interrupt_get_stats(kos_interrupt_stats_t* stats) {
+    if (!stats) {
+        return;
+    }
+    
+    uint32_t seq;
+    do {
+        seq = kos_read_seqbegin(&g_interrupt_stats_lock);
+        kos_memcpy(stats, &g_interrupt_stats, sizeof(kos_interrupt_stats_t));
+    } while (kos_read_seqretry(&g_interrupt_stats_lock, seq));
 }
 
 // Reset interrupt statistics
 void kos_interrupt_reset_stats(void) {
+    uint64_t flags = kos_write_seqlock_irqsave(&g_interrupt_stats_lock);
     kos_memset(&g_interrupt_stats, 0, sizeof(kos_interrupt_stats_t));
     g_interrupt_stats.min_interrupt_time = UINT64_MAX;
+    kos_write_sequnlock_irqrestore(&g_interrupt_stats_lock, flags);
     
     // Reset per-IRQ statistics
-    for (int i = 0; i < KOS_IRQ_COUNT; i++) {
+    for (int i = 0; i < KOS_IRQ_LINES; i++) {
         kos_interrupt_descriptor_t* desc = &g_interrupt_descriptors[i];
         desc->count = 0;
         desc->total_time = 0;
         desc->last_time = 0;
         desc->max_time = 0;
         desc->min_time = UINT64_MAX;
+        desc->unhandled = 0;
+        desc->storms = 0;
+        desc->polls = 0;
+        kos_histogram_reset(&desc->latency);
+        kos_histogram_reset(&desc->duration);
+        for (kos_irq_action_t* action = desc->actions; action; action = action->next) {
+            action->handled = 0;
+        }
     }
 }
 
 // Dump interrupt statistics
 kos_result_t kos_interrupt_dump_stats(void) {
+    kos_interrupt_stats_t snapshot;
+    kos_interrupt_get_stats(&snapshot);
+    
     log_info("=== Interrupt Statistics ===");
-    log_info("Total interrupts: %u", g_interrupt_stats.total_interrupts);
-    log_info("Nested interrupts: %u", g_interrupt_stats.nested_interrupts);
-    log_info("Failed interrupts: %u", g_interrupt_stats.failed_interrupts);
-    log_info("Total time: %llu cycles", g_interrupt_stats.total_time);
-    log_info("Max time: %llu cycles", g_interrupt_stats.max_interrupt_time);
-    log_info("Min time: %llu cycles", g_interrupt_stats.min_interrupt_time);
-    
-    if (g_interrupt_stats.total_interrupts > 0) {
+    log_info("Total interrupts: %u", snapshot.total_interrupts);
+    log_info("Nested interrupts: %u", snapshot.nested_interrupts);
+    log_info("Failed interrupts: %u", snapshot.failed_interrupts);
+    log_info("Interrupt storms: %u", snapshot.storms);
+    log_info("Total time: %llu ns", snapshot.total_time);
+    log_info("Max time: %llu ns", snapshot.max_interrupt_time);
+    log_info("Min time: %llu ns", snapshot.min_interrupt_time);
+    
+    if (snapshot.total_interrupts > 0) {
         log_info("Interrupt counts:");
-        for (int i = 0; i < KOS_IRQ_COUNT; i++) {
-            if (g_interrupt_stats.interrupt_counts[i] > 0) {
+        for (int i = 0; i < KOS_IRQ_LINES; i++) {
+            if (snapshot.interrupt_counts[i] > 0) {
                 kos_interrupt_descriptor_t* desc = &g_interrupt_descriptors[i];
-                log_info("  %s (%s): %u calls, %llu cycles avg", 
-                         kos_interrupt_get_name((kos_irq_t)i), 
-                         desc->name,
-                         g_interrupt_stats.interrupt_counts[i],
-                         desc->count > 0 ? desc->total_time / desc->count : 0);
+                kos_histogram_summary_t duration;
+                kos_histogram_summarize(&desc->duration, &duration);
+                log_info("  %s (vector %d): %u calls, %u unhandled, %d ns avg", 
+                         kos_interrupt_get_name((kos_irq_t)i), desc->vector,
+                         snapshot.interrupt_counts[i],
+                         desc->unhandled,
+                         (int)(desc->count > 0 ? desc->total_time / desc->count : 0));
+                log_info("    rate %u/s (budget %u/s), %u storms, %u polls%s",
+                         desc->rate, desc->rate_limit, desc->storms, desc->polls,
+                         desc->throttled ? ", THROTTLED" : "");
+                log_info("    duration p50 %d p99 %d p999 %d max %d ns",
+                         (int)duration.p50, (int)duration.p99, (int)duration.p999, (int)duration.max);
+                if (desc->latency.count > 0) {
+                    kos_histogram_summary_t latency;
+                    kos_histogram_summarize(&desc->latency, &latency);
+                    log_info("    latency  p50 %d p99 %d p999 %d max %d ns",
+                             (int)latency.p50, (int)latency.p99, (int)latency.p999, (int)latency.max);
+                }
+                for (kos_irq_action_t* action = desc->actions; action; action = action->next) {
+                    log_info("    %s: %u handled", action->name, (uint32_t)action->handled);
+                }
             }
         }
     }
     
+    log_info("Nesting by priority (limit %d):", g_interrupt_config.max_nesting_level);
+    for (int p = 0; p < KOS_INTERRUPT_PRIORITY_COUNT; p++) {
+        kos_interrupt_priority_stats_t* stats = &snapshot.priority[p];
+        if (stats->entries == 0) {
+            continue;
+        }
+        log_info("  priority %d: %u entries, %u preempting, max depth %d, max stack %d bytes",
+                 p, (uint32_t)stats->entries, (uint32_t)stats->preemptions,
+                 stats->max_depth, (int)stats->max_stack_bytes);
+    }
+    
     return KOS_SUCCESS;
 }
 
-// Get IRQ name
+// Get percentile summaries for one IRQ line
+kos_result_t kos_interrupt_get_latency(kos_irq_t irq, kos_histogram_summary_t* latency, kos_histogram_summary_t* duration) {
+    if (irq >= KOS_IRQ_LINES) {
+        return KOS_ERROR_INVALID_PARAM;
+    }
+    
+    kos_interrupt_descriptor_t* desc = &g_interrupt_descriptors[irq];
+    
+    // Copy with interrupts off, summarize with them on
+    static kos_histogram_t latency_copy;
+    static kos_histogram_t duration_copy;
+    uint64_t flags = kos_local_irq_save();
+    latency_copy = desc->latency;
+    duration_copy = desc->duration;
+    kos_local_irq_restore(flags);
+    
+    if (latency) {
+        kos_histogram_summarize(&latency_copy, latency);
+    }
+    if (duration) {
+        kos_histogram_summarize(&duration_copy, duration);
+    }
+    
+    return KOS_SUCCESS;
+}
+
+// Dump p50/p99/p999/max for every active line
+void kos_interrupt_dump_latency(void) {
+    log_info("=== Interrupt Latency (ns) ===");
+    log_info("Columns: count p50 p99 p999 max");
+    
+    for (int i = 0; i < KOS_IRQ_LINES; i++) {
+        kos_histogram_summary_t latency;
+        kos_histogram_summary_t duration;
+        kos_interrupt_get_latency((kos_irq_t)i, &latency, &duration);
+        if (duration.count == 0) {
+            continue;
+        }
+        
+        log_info("IRQ %d %s handler: %u %d %d %d %d", i, kos_interrupt_get_name((kos_irq_t)i),
+                 (uint32_t)duration.count, (int)duration.p50, (int)duration.p99,
+                 (int)duration.p999, (int)duration.max);
+        if (latency.count > 0) {
+            log_info("IRQ %d %s entry: %u %d %d %d %d", i, kos_interrupt_get_name((kos_irq_t)i),
+                     (uint32_t)latency.count, (int)latency.p50, (int)latency.p99,
+                     (int)latency.p999, (int)latency.max);
+        }
+    }
+}
+
+// Get IRQ name, dynamic lines are named after their first handler
 const char* kos_interrupt_get_name(kos_irq_t irq) {
-    if (irq >= KOS_IRQ_COUNT) {
+    if (irq >= KOS_IRQ_LINES) {
         return "Unknown IRQ";
     }
+    if (irq >= KOS_IRQ_COUNT) {
+        kos_irq_action_t* action = g_interrupt_descriptors[irq].actions;
+        return action ? action->name : "MSI";
+    }
     return g_irq_names[irq];
 }
 
 // Get IRQ description
 const char* kos_interrupt_get_description(kos_irq_t irq) {
-    if (irq >= KOS_IRQ_COUNT) {
+    if (irq >= KOS_IRQ_LINES) {
         return "Unknown IRQ";
     }
+    if (irq >= KOS_IRQ_COUNT) {
+        return "Message-signalled interrupt";
+    }
     return g_irq_descriptions[irq];
 }
 
 // Check if IRQ is valid
 bool kos_interrupt_is_valid(kos_irq_t irq) {
-    return irq < KOS_IRQ_COUNT;
+    return irq < KOS_IRQ_LINES;
 }
 
 // Get vector for IRQ
 uint32_t kos_interrupt_get_vector(kos_irq_t irq) {
-    if (irq >= KOS_IRQ_COUNT) {
+    if (irq >= KOS_IRQ_LINES) {
         return 0;
     }
+    if (irq >= KOS_IRQ_COUNT) {
+        return KOS_IRQ_DYNAMIC_VECTOR_BASE + (irq - KOS_IRQ_COUNT);
+    }
     return g_irq_vectors[irq];
 }
 
@@ -504,8 +1142,6 @@ kos_result_t kos_interrupt_stack_init(size_t stack_size) {
     g_interrupt_stack.stack_top = (void*)((uintptr_t)g_interrupt_stack.stack_base + stack_size);
     g_interrupt_stack.stack_size = stack_size;
     g_interrupt_stack.current_sp = g_interrupt_stack.stack_top;
-    g_interrupt_stack.nesting_level = 0;
-    g_interrupt_stack.in_interrupt = false;
     
     log_info("Interrupt stack initialized: %zu bytes", stack_size);
     return KOS_SUCCESS;
@@ -516,23 +1152,25 @@ kos_interrupt_stack_t* kos_interrupt_stack_get(void) {
     return &g_interrupt_stack;
 }
 
-// Get timestamp (placeholder)
+// Get timestamp in ns
 uint64_t kos_get_timestamp(void) {
-    uint64_t timestamp;
-    asm volatile("rdtsc" : "=A" (timestamp));
-    return timestamp;
+    return kos_clock_monotonic_ns();
 }
 
 // Dump interrupt descriptors
 void kos_interrupt_dump_descriptors(void) {
     log_info("=== Interrupt Descriptors ===");
-    for (int i = 0; i < KOS_IRQ_COUNT; i++) {
+    for (int i = 0; i < KOS_IRQ_LINES; i++) {
         kos_interrupt_descriptor_t* desc = &g_interrupt_descriptors[i];
-        if (desc->handler) {
-            log_info("IRQ %d (%s): %s - %s (vector %d, priority %d, count %u)",
-                     i, kos_interrupt_get_name((kos_irq_t)i), desc->name,
+        if (desc->actions) {
+            log_info("IRQ %d (%s): %d handler(s)%s - %s (vector %d, priority %d, count %u)",
+                     i, kos_interrupt_get_name((kos_irq_t)i), desc->action_count,
+                     (desc->flags & KOS_IRQF_SHARED) ? " shared" : "",
                      desc->enabled ? "ENABLED" : "DISABLED",
                      desc->vector, desc->priority, desc->count);
+            for (kos_irq_action_t* action = desc->actions; action; action = action->next) {
+                log_info("  %s", action->name);
+            }
         }
     }
 }
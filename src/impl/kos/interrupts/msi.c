@@ -0,0 +1,329 @@
+#include "kos/interrupts/msi.h"
+#include "kos/cpu/irqflags.h"
+#include "kos/cpu/percpu.h"
+#include "hal/hal_lapic.h"
+#include "hal/hal_mmio.h"
+#include "debug/debug.h"
+
+// =============================================================================
+// KOS - MSI/MSI-X Implementation
+// =============================================================================
+
+// Per-line message state, indexed by dynamic line
+typedef struct {
+    kos_pci_device_t* device;
+    volatile void* entry;       // MSI-X table entry, NULL for MSI
+    uint8_t cap;
+    uint16_t index;             // MSI-X entry or MSI message number
+    uint32_t cpu;
+    bool msix;
+    bool in_use;
+} kos_msi_line_t;
+
+static kos_msi_line_t g_msi_lines[KOS_IRQ_DYNAMIC_COUNT];
+
+static void kos_msi_chip_mask(uint32_t irq);
+static void kos_msi_chip_unmask(uint32_t irq);
+static void kos_msi_chip_eoi(uint32_t irq);
+
+// Messages land in the local APIC, so the LAPIC acknowledges them
+static const kos_irq_chip_t g_msi_chip = {
+    .name = "MSI",
+    .mask = kos_msi_chip_mask,
+    .unmask = kos_msi_chip_unmask,
+    .eoi = kos_msi_chip_eoi,
+    .mask_lines = NULL
+};
+
+static kos_msi_line_t* kos_msi_line(uint32_t irq) {
+    if (irq < KOS_IRQ_COUNT || irq >= KOS_IRQ_LINES || !g_msi_lines[irq - KOS_IRQ_COUNT].in_use) {
+        return NULL;
+    }
+
+    return &g_msi_lines[irq - KOS_IRQ_COUNT];
+}
+
+// Config offset of the MSI per-vector mask register
+static uint8_t kos_msi_mask_offset(const kos_msi_line_t* line, uint16_t control) {
+    return line->cap + ((control & KOS_MSI_CONTROL_64BIT) ? KOS_MSI_MASK_64 : KOS_MSI_MASK_32);
+}
+
+// Set or clear the mask for one line. Plain MSI without per-vector masking
+// cannot be held off at the device, the storm poller then only rate limits.
+static void kos_msi_set_masked(uint32_t irq, bool masked) {
+    kos_msi_line_t* line = kos_msi_line(irq);
+    if (!line) {
+        return;
+    }
+
+    if (line->msix) {
+        uint32_t control = hal_mmio_read32(line->entry, KOS_MSIX_ENTRY_CONTROL);
+        control = masked ? (control | KOS_MSIX_ENTRY_MASKED) : (control & ~KOS_MSIX_ENTRY_MASKED);
+        hal_mmio_write32(line->entry, KOS_MSIX_ENTRY_CONTROL, control);
+        return;
+    }
+
+    uint16_t control = kos_pci_read16(line->device, line->cap + KOS_MSI_CONTROL);
+    if (!(control & KOS_MSI_CONTROL_MASKABLE)) {
+        return;
+    }
+
+    uint8_t offset = kos_msi_mask_offset(line, control);
+    uint32_t bits = kos_pci_read32(line->device, offset);
+    bits = masked ? (bits | (1U << line->index)) : (bits & ~(1U << line->index));
+    kos_pci_write32(line->device, offset, bits);
+}
+
+static void kos_msi_chip_mask(uint32_t irq) {
+    kos_msi_set_masked(irq, true);
+}
+
+static void kos_msi_chip_unmask(uint32_t irq) {
+    kos_msi_set_masked(irq, false);
+}
+
+static void kos_msi_chip_eoi(uint32_t irq) {
+    (void)irq;
+    hal_lapic_eoi();
+}
+
+// Destination address for a CPU, 0 if the CPU is unknown or not yet online.
+// The boot CPU takes interrupts before its per-CPU block exists.
+static uint32_t kos_msi_address(uint32_t cpu) {
+    if (cpu != 0) {
+        kos_cpu_local_t* local = kos_percpu_get(cpu);
+        if (!local || !local->online) {
+            return 0;
+        }
+    }
+
+    uint32_t apic_id = hal_lapic_cpu_to_apic_id(cpu);
+    if (apic_id == HAL_LAPIC_INVALID_ID) {
+        return 0;
+    }
+
+    return HAL_LAPIC_MSI_ADDRESS_BASE | (apic_id << HAL_LAPIC_MSI_DEST_SHIFT);
+}
+
+// Write address and data of the MSI capability
+static void kos_msi_write_message(kos_pci_device_t* dev, uint8_t cap, uint32_t address, uint32_t data) {
+    uint16_t control = kos_pci_read16(dev, cap + KOS_MSI_CONTROL);
+
+    kos_pci_write32(dev, cap + KOS_MSI_ADDRESS_LOW, address);
+    if (control & KOS_MSI_CONTROL_64BIT) {
+        kos_pci_write32(dev, cap + KOS_MSI_ADDRESS_HIGH, 0);
+        kos_pci_write16(dev, cap + KOS_MSI_DATA_64, (uint16_t)data);
+    } else {
+        kos_pci_write16(dev, cap + KOS_MSI_DATA_32, (uint16_t)data);
+    }
+}
+
+// Write one MSI-X table entry, left masked
+static void kos_msix_write_entry(volatile void* entry, uint32_t address, uint32_t data) {
+    hal_mmio_write32(entry, KOS_MSIX_ENTRY_CONTROL,
+                     hal_mmio_read32(entry, KOS_MSIX_ENTRY_CONTROL) | KOS_MSIX_ENTRY_MASKED);
+    hal_mmio_write32(entry, KOS_MSIX_ENTRY_ADDR_LOW, address);
+    hal_mmio_write32(entry, KOS_MSIX_ENTRY_ADDR_HIGH, 0);
+    hal_mmio_write32(entry, KOS_MSIX_ENTRY_DATA, data);
+}
+
+// MSI needs the local APIC to receive the messages
+bool kos_msi_is_supported(void) {
+    return hal_lapic_is_available();
+}
+
+// Enable MSI with count vectors (a power of two), all aimed at one CPU
+kos_result_t kos_msi_enable(kos_pci_device_t* dev, uint32_t count, kos_interrupt_priority_t priority,
+                            uint32_t cpu, kos_irq_t* first_irq) {
+    if (!dev || !first_irq || count == 0 || (count & (count - 1)) != 0) {
+        return KOS_ERROR_INVALID_PARAM;
+    }
+
+    if (!dev->msi_cap || !kos_msi_is_supported()) {
+        return KOS_ERROR_NOT_IMPLEMENTED;
+    }
+
+    uint32_t address = kos_msi_address(cpu);
+    if (!address) {
+        return KOS_ERROR_INVALID_PARAM;
+    }
+
+    uint16_t control = kos_pci_read16(dev, dev->msi_cap + KOS_MSI_CONTROL);
+    uint32_t capable = 1U << ((control >> KOS_MSI_CONTROL_MMC_SHIFT) & 7);
+    if (count > capable || count > KOS_MSI_MAX_VECTORS) {
+        return KOS_ERROR_INVALID_PARAM;
+    }
+
+    kos_irq_t irq;
+    kos_result_t result = kos_interrupt_alloc_dynamic(priority, count, &g_msi_chip, &irq);
+    if (result != KOS_SUCCESS) {
+        return result;
+    }
+
+    for (uint32_t i = 0; i < count; i++) {
+        kos_msi_line_t* line = &g_msi_lines[irq + i - KOS_IRQ_COUNT];
+        line->device = dev;
+        line->entry = NULL;
+        line->cap = dev->msi_cap;
+        line->index = (uint16_t)i;
+        line->cpu = cpu;
+        line->msix = false;
+        line->in_use = true;
+    }
+
+    // Multi-message MSI ORs the message number into the low data bits,
+    // which is why the vector block is aligned to its size
+    kos_msi_write_message(dev, dev->msi_cap, address, kos_interrupt_get_vector(irq));
+
+    uint32_t log2_count = (uint32_t)__builtin_ctz(count);
+    control = (uint16_t)((control & ~KOS_MSI_CONTROL_MME_MASK) | (log2_count << KOS_MSI_CONTROL_MME_SHIFT));
+    kos_pci_write16(dev, dev->msi_cap + KOS_MSI_CONTROL, control | KOS_MSI_CONTROL_ENABLE);
+
+    kos_pci_set_intx(dev, false);
+    kos_pci_enable_bus_master(dev);
+
+    *first_irq = irq;
+    log_info("MSI: %x:%x uses %d vector(s) from IRQ %d on CPU %d",
+             dev->vendor_id, dev->device_id, (int)count, irq, (int)cpu);
+    return KOS_SUCCESS;
+}
+
+// Enable MSI-X with one vector per queue, queue i aimed at cpus[i] (NULL: CPU 0)
+kos_result_t kos_msix_enable(kos_pci_device_t* dev, uint32_t count, kos_interrupt_priority_t priority,
+                             const uint32_t* cpus, kos_irq_t* irqs) {
+    if (!dev || !irqs || count == 0) {
+        return KOS_ERROR_INVALID_PARAM;
+    }
+
+    if (!dev->msix_cap || !kos_msi_is_supported()) {
+        return KOS_ERROR_NOT_IMPLEMENTED;
+    }
+
+    uint16_t control = kos_pci_read16(dev, dev->msix_cap + KOS_MSIX_CONTROL);
+    uint32_t table_size = (control & KOS_MSIX_CONTROL_SIZE_MASK) + 1;
+    if (count > table_size) {
+        return KOS_ERROR_INVALID_PARAM;
+    }
+
+    uint32_t table = kos_pci_read32(dev, dev->msix_cap + KOS_MSIX_TABLE);
+    uint64_t bar = kos_pci_get_bar(dev, table & KOS_MSIX_BIR_MASK);
+    if (!bar) {
+        return KOS_ERROR_IO_ERROR;
+    }
+
+    volatile void* base = hal_mmio_map(bar + (table & ~KOS_MSIX_BIR_MASK), table_size * KOS_MSIX_ENTRY_SIZE);
+    if (!base) {
+        return KOS_ERROR_OUT_OF_MEMORY;
+    }
+
+    // Mask the whole function while the table is being filled
+    kos_pci_write16(dev, dev->msix_cap + KOS_MSIX_CONTROL,
+                    control | KOS_MSIX_CONTROL_ENABLE | KOS_MSIX_CONTROL_MASKALL);
+
+    for (uint32_t i = 0; i < count; i++) {
+        uint32_t cpu = cpus ? cpus[i] : 0;
+        uint32_t address = kos_msi_address(cpu);
+        kos_result_t result = address ? kos_interrupt_alloc_dynamic(priority, 1, &g_msi_chip, &irqs[i])
+                                      : KOS_ERROR_INVALID_PARAM;
+        if (result != KOS_SUCCESS) {
+            kos_msi_disable(dev);
+            return result;
+        }
+
+        kos_msi_line_t* line = &g_msi_lines[irqs[i] - KOS_IRQ_COUNT];
+        line->device = dev;
+        line->entry = (volatile void*)((uintptr_t)base + i * KOS_MSIX_ENTRY_SIZE);
+        line->cap = dev->msix_cap;
+        line->index = (uint16_t)i;
+        line->cpu = cpu;
+        line->msix = true;
+        line->in_use = true;
+
+        // Entries stay masked until a handler enables the line
+        kos_msix_write_entry(line->entry, address, kos_interrupt_get_vector(irqs[i]));
+    }
+
+    kos_pci_write16(dev, dev->msix_cap + KOS_MSIX_CONTROL,
+                    (control | KOS_MSIX_CONTROL_ENABLE) & ~KOS_MSIX_CONTROL_MASKALL);
+    kos_pci_set_intx(dev, false);
+    kos_pci_enable_bus_master(dev);
+
+    log_info("MSI-X: %x:%x uses %d of %d vectors from IRQ %d",
+             dev->vendor_id, dev->device_id, (int)count, (int)table_size, irqs[0]);
+    return KOS_SUCCESS;
+}
+
+// Turn off MSI and MSI-X on a device and release its lines
+void kos_msi_disable(kos_pci_device_t* dev) {
+    if (!dev) {
+        return;
+    }
+
+    if (dev->msi_cap) {
+        uint16_t control = kos_pci_read16(dev, dev->msi_cap + KOS_MSI_CONTROL);
+        kos_pci_write16(dev, dev->msi_cap + KOS_MSI_CONTROL, control & ~KOS_MSI_CONTROL_ENABLE);
+    }
+    if (dev->msix_cap) {
+        uint16_t control = kos_pci_read16(dev, dev->msix_cap + KOS_MSIX_CONTROL);
+        kos_pci_write16(dev, dev->msix_cap + KOS_MSIX_CONTROL, control & ~KOS_MSIX_CONTROL_ENABLE);
+    }
+
+    for (uint32_t i = 0; i < KOS_IRQ_DYNAMIC_COUNT; i++) {
+        if (g_msi_lines[i].in_use && g_msi_lines[i].device == dev) {
+            kos_interrupt_free_dynamic((kos_irq_t)(KOS_IRQ_COUNT + i), 1);
+            g_msi_lines[i].in_use = false;
+        }
+    }
+
+    kos_pci_set_intx(dev, true);
+}
+
+// Steer a line to another CPU
+kos_result_t kos_msi_set_affinity(kos_irq_t irq, uint32_t cpu) {
+    kos_msi_line_t* line = kos_msi_line(irq);
+    if (!line) {
+        return KOS_ERROR_INVALID_PARAM;
+    }
+
+    uint32_t address = kos_msi_address(cpu);
+    if (!address) {
+        return KOS_ERROR_INVALID_PARAM;
+    }
+
+    uint64_t flags = kos_local_irq_save();
+
+    if (line->msix) {
+        uint32_t control = hal_mmio_read32(line->entry, KOS_MSIX_ENTRY_CONTROL);
+        kos_msix_write_entry(line->entry, address, kos_interrupt_get_vector(irq));
+        hal_mmio_write32(line->entry, KOS_MSIX_ENTRY_CONTROL, control);
+    } else {
+        // All messages of an MSI function share one address
+        kos_irq_t first = (kos_irq_t)(irq - line->index);
+        kos_msi_write_message(line->device, line->cap, address, kos_interrupt_get_vector(first));
+        for (uint32_t i = 0; i < KOS_IRQ_DYNAMIC_COUNT; i++) {
+            if (g_msi_lines[i].in_use && g_msi_lines[i].device == line->device && !g_msi_lines[i].msix) {
+                g_msi_lines[i].cpu = cpu;
+            }
+        }
+    }
+
+    line->cpu = cpu;
+    kos_local_irq_restore(flags);
+    return KOS_SUCCESS;
+}
+
+// Dump message-signalled lines
+void kos_msi_dump(void) {
+    log_info("=== MSI Lines ===");
+    for (uint32_t i = 0; i < KOS_IRQ_DYNAMIC_COUNT; i++) {
+        kos_msi_line_t* line = &g_msi_lines[i];
+        if (!line->in_use) {
+            continue;
+        }
+
+        kos_irq_t irq = (kos_irq_t)(KOS_IRQ_COUNT + i);
+        log_info("IRQ %d vector 0x%x: %x:%x %s #%d -> CPU %d (%s)", irq, kos_interrupt_get_vector(irq),
+                 line->device->vendor_id, line->device->device_id, line->msix ? "MSI-X" : "MSI",
+                 line->index, (int)line->cpu, kos_interrupt_get_name(irq));
+    }
+}
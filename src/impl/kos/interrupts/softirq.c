@@ -0,0 +1,420 @@
+#include "kos/interrupts/softirq.h"
+#include "kos/time/clock.h"
+#include "kos/time/timer.h"
+#include "kos/cpu/irqflags.h"
+#include "kos/cpu/percpu.h"
+#include "kos/sync/spinlock.h"
+#include "kos/utils/string.h"
+#include "debug/debug.h"
+
+// =============================================================================
+// KOS - Deferred Work Implementation
+// =============================================================================
+
+// Built-in softirq actions
+static void kos_softirq_timer_action(void);
+static void kos_softirq_hi_tasklet_action(void);
+static void kos_softirq_tasklet_action(void);
+
+// Softirq actions, pending bits and tasklet queues live in each CPU's block
+static kos_softirq_action_t g_softirq_actions[KOS_SOFTIRQ_COUNT] = {
+    [KOS_SOFTIRQ_HI_TASKLET] = kos_softirq_hi_tasklet_action,
+    [KOS_SOFTIRQ_TIMER]      = kos_softirq_timer_action,
+    [KOS_SOFTIRQ_TASKLET]    = kos_softirq_tasklet_action,
+};
+static const char* g_softirq_names[KOS_SOFTIRQ_COUNT] = {
+    "HI_TASKLET", "TIMER", "TASKLET"
+};
+static bool g_softirq_initialized = false;
+
+// Worker queue, shared because only the boot CPU runs the worker
+static kos_spinlock_t g_work_lock = KOS_SPINLOCK_INIT;
+static kos_work_t* g_work_head = NULL;
+static kos_work_t** g_work_tail = &g_work_head;
+
+// Statistics
+static kos_softirq_stats_t g_softirq_stats;
+
+// Nanoseconds elapsed since a kos_clock_cycles() reading
+static inline uint64_t kos_softirq_elapsed_ns(uint64_t start) {
+    return kos_clock_cycles_to_ns(kos_clock_cycles() - start);
+}
+
+// Initialize deferred work
+kos_result_t kos_softirq_init(void) {
+    if (g_softirq_initialized) {
+        return KOS_SUCCESS;
+    }
+
+    kos_memset(&g_softirq_stats, 0, sizeof(kos_softirq_stats_t));
+    g_softirq_initialized = true;
+
+    log_info("Deferred work initialized: %d softirqs, budget %d us",
+             KOS_SOFTIRQ_COUNT, (int)(KOS_SOFTIRQ_BUDGET_NS / KOS_NSEC_PER_USEC));
+    return KOS_SUCCESS;
+}
+
+// Install a softirq action
+kos_result_t kos_softirq_open(kos_softirq_t nr, kos_softirq_action_t action) {
+    if (nr >= KOS_SOFTIRQ_COUNT || !action) {
+        return KOS_ERROR_INVALID_PARAM;
+    }
+
+    g_softirq_actions[nr] = action;
+    return KOS_SUCCESS;
+}
+
+// Mark a softirq pending, safe from any context
+void kos_softirq_raise(kos_softirq_t nr) {
+    if (nr >= KOS_SOFTIRQ_COUNT) {
+        return;
+    }
+
+    uint64_t flags = kos_local_irq_save();
+    kos_percpu_irq()->softirq_pending |= 1U << nr;
+    g_softirq_stats.vectors[nr].raised++;
+    kos_local_irq_restore(flags);
+}
+
+// Check for softirqs pending on the calling CPU
+bool kos_softirq_pending(void) {
+    return kos_percpu_irq()->softirq_pending != 0;
+}
+
+// Run pending softirqs with interrupts enabled, called with interrupts disabled
+static void kos_softirq_do_pass(kos_cpu_irq_t* cpu) {
+    uint64_t pass_start = kos_clock_cycles();
+    uint64_t budget = kos_clock_ns_to_cycles(KOS_SOFTIRQ_BUDGET_NS);
+    uint32_t restart = KOS_SOFTIRQ_MAX_RESTART;
+    uint32_t pending;
+
+    cpu->in_softirq = true;
+
+    while ((pending = cpu->softirq_pending) != 0) {
+        cpu->softirq_pending = 0;
+        kos_local_irq_enable();
+
+        for (uint32_t nr = 0; nr < KOS_SOFTIRQ_COUNT; nr++) {
+            if (!(pending & (1U << nr)) || !g_softirq_actions[nr]) {
+                continue;
+            }
+
+            uint64_t start = kos_clock_cycles();
+            g_softirq_actions[nr]();
+            uint64_t elapsed = kos_softirq_elapsed_ns(start);
+
+            kos_softirq_vector_stats_t* vs = &g_softirq_stats.vectors[nr];
+            vs->runs++;
+            vs->total_ns += elapsed;
+            if (elapsed > vs->max_ns) {
+                vs->max_ns = elapsed;
+            }
+        }
+
+        kos_local_irq_disable();
+
+        // Out of budget: leave the rest to the worker context
+        if (--restart == 0 || (budget && kos_clock_cycles() - pass_start >= budget)) {
+            if (cpu->softirq_pending) {
+                g_softirq_stats.softirq_deferred++;
+            }
+            break;
+        }
+    }
+
+    cpu->in_softirq = false;
+
+    uint64_t elapsed = kos_softirq_elapsed_ns(pass_start);
+    g_softirq_stats.softirq_passes++;
+    g_softirq_stats.softirq_ns += elapsed;
+    if (elapsed > g_softirq_stats.softirq_max_pass_ns) {
+        g_softirq_stats.softirq_max_pass_ns = elapsed;
+    }
+}
+
+// Run pending softirqs from process context
+void kos_softirq_run(void) {
+    uint64_t flags = kos_local_irq_save();
+    kos_cpu_irq_t* cpu = kos_percpu_irq();
+
+    if (cpu->hardirq_nesting == 0 && !cpu->in_softirq && cpu->softirq_pending) {
+        kos_softirq_do_pass(cpu);
+    }
+
+    kos_local_irq_restore(flags);
+}
+
+// Enter hard interrupt context, interrupts are disabled
+void kos_irq_enter(void) {
+    kos_cpu_irq_t* cpu = kos_percpu_irq();
+
+    if (cpu->hardirq_nesting++ == 0) {
+        cpu->hardirq_start = kos_clock_cycles();
+    }
+}
+
+// Leave hard interrupt context, runs bottom halves once the outermost IRQ is acknowledged
+void kos_irq_exit(void) {
+    kos_cpu_irq_t* cpu = kos_percpu_irq();
+
+    if (cpu->hardirq_nesting == 0 || --cpu->hardirq_nesting != 0) {
+        return;
+    }
+
+    uint64_t elapsed = kos_softirq_elapsed_ns(cpu->hardirq_start);
+    g_softirq_stats.hardirq_count++;
+    g_softirq_stats.hardirq_ns += elapsed;
+    if (elapsed > g_softirq_stats.hardirq_max_ns) {
+        g_softirq_stats.hardirq_max_ns = elapsed;
+    }
+
+    // An IRQ arriving during a pass leaves its work to that pass
+    if (cpu->softirq_pending && !cpu->in_softirq) {
+        kos_softirq_do_pass(cpu);
+    }
+}
+
+// Check whether the calling CPU is in a hard interrupt handler
+bool kos_in_interrupt(void) {
+    return kos_percpu_irq()->hardirq_nesting != 0;
+}
+
+// Check whether the calling CPU is running bottom halves
+bool kos_in_softirq(void) {
+    return kos_percpu_irq()->in_softirq;
+}
+
+// =============================================================================
+// Tasklets
+// =============================================================================
+
+// Initialize a tasklet
+void kos_tasklet_init(kos_tasklet_t* tasklet, kos_deferred_fn_t func, void* data) {
+    if (!tasklet) {
+        return;
+    }
+
+    tasklet->next = NULL;
+    tasklet->scheduled = false;
+    tasklet->running = false;
+    tasklet->func = func;
+    tasklet->data = data;
+}
+
+// Append a scheduled tasklet to the calling CPU's list and raise its softirq
+static void kos_tasklet_append(kos_tasklet_t* tasklet, kos_softirq_t nr) {
+    uint64_t flags = kos_local_irq_save();
+    kos_cpu_irq_t* cpu = kos_percpu_irq();
+    kos_tasklet_list_t* list = nr == KOS_SOFTIRQ_HI_TASKLET ? &cpu->tasklet_hi : &cpu->tasklet_normal;
+
+    tasklet->next = NULL;
+    if (list->head) {
+        list->tail->next = tasklet;
+    } else {
+        list->head = tasklet;
+    }
+    list->tail = tasklet;
+    kos_softirq_raise(nr);
+
+    kos_local_irq_restore(flags);
+}
+
+// Queue a tasklet on the calling CPU, returns false if it was already
+// scheduled. The flag is claimed atomically since any CPU may schedule it.
+static bool kos_tasklet_enqueue(kos_tasklet_t* tasklet, kos_softirq_t nr) {
+    if (!tasklet || !tasklet->func) {
+        return false;
+    }
+
+    if (__atomic_exchange_n(&tasklet->scheduled, true, __ATOMIC_ACQ_REL)) {
+        return false;
+    }
+
+    kos_tasklet_append(tasklet, nr);
+    return true;
+}
+
+// Schedule a tasklet
+bool kos_tasklet_schedule(kos_tasklet_t* tasklet) {
+    return kos_tasklet_enqueue(tasklet, KOS_SOFTIRQ_TASKLET);
+}
+
+// Schedule a tasklet ahead of timers and normal tasklets
+bool kos_tasklet_hi_schedule(kos_tasklet_t* tasklet) {
+    return kos_tasklet_enqueue(tasklet, KOS_SOFTIRQ_HI_TASKLET);
+}
+
+// Run every tasklet queued on a list of the calling CPU
+static void kos_tasklet_run_list(kos_tasklet_list_t* list, kos_softirq_t nr) {
+    uint64_t flags = kos_local_irq_save();
+    kos_tasklet_t* tasklet = list->head;
+    list->head = NULL;
+    list->tail = NULL;
+    kos_local_irq_restore(flags);
+
+    while (tasklet) {
+        kos_tasklet_t* next = tasklet->next;
+
+        // Still running on another CPU, retry on a later pass
+        if (__atomic_exchange_n(&tasklet->running, true, __ATOMIC_ACQUIRE)) {
+            kos_tasklet_append(tasklet, nr);
+            tasklet = next;
+            continue;
+        }
+
+        // Cleared first so the tasklet may reschedule itself
+        tasklet->next = NULL;
+        __atomic_store_n(&tasklet->scheduled, false, __ATOMIC_RELEASE);
+        tasklet->func(tasklet->data);
+        __atomic_store_n(&tasklet->running, false, __ATOMIC_RELEASE);
+        g_softirq_stats.tasklet_runs++;
+
+        tasklet = next;
+    }
+}
+
+static void kos_softirq_hi_tasklet_action(void) {
+    kos_tasklet_run_list(&kos_percpu_irq()->tasklet_hi, KOS_SOFTIRQ_HI_TASKLET);
+}
+
+static void kos_softirq_tasklet_action(void) {
+    kos_tasklet_run_list(&kos_percpu_irq()->tasklet_normal, KOS_SOFTIRQ_TASKLET);
+}
+
+static void kos_softirq_timer_action(void) {
+    kos_timer_run();
+}
+
+// =============================================================================
+// Worker
+// =============================================================================
+
+// Initialize a work item
+void kos_work_init(kos_work_t* work, kos_deferred_fn_t func, void* data) {
+    if (!work) {
+        return;
+    }
+
+    work->next = NULL;
+    work->pending = false;
+    work->func = func;
+    work->data = data;
+}
+
+// Queue a work item for the worker, returns false if it was already queued
+bool kos_work_queue(kos_work_t* work) {
+    if (!work || !work->func) {
+        return false;
+    }
+
+    uint64_t flags = kos_spin_lock_irqsave(&g_work_lock);
+
+    if (work->pending) {
+        kos_spin_unlock_irqrestore(&g_work_lock, flags);
+        return false;
+    }
+
+    work->pending = true;
+    work->next = NULL;
+    *g_work_tail = work;
+    g_work_tail = &work->next;
+    g_softirq_stats.work_queued++;
+
+    kos_spin_unlock_irqrestore(&g_work_lock, flags);
+    return true;
+}
+
+// Check whether the worker has anything to do
+bool kos_worker_pending(void) {
+    return __atomic_load_n(&g_work_head, __ATOMIC_RELAXED) != NULL || kos_softirq_pending();
+}
+
+// Run deferred softirqs and queued work, process context only
+void kos_worker_run(void) {
+    if (kos_in_interrupt() || kos_in_softirq()) {
+        return;
+    }
+
+    // Softirqs that overran their IRQ-exit budget
+    kos_softirq_run();
+
+    while (true) {
+        uint64_t flags = kos_spin_lock_irqsave(&g_work_lock);
+        kos_work_t* work = g_work_head;
+        if (work) {
+            g_work_head = work->next;
+            if (!g_work_head) {
+                g_work_tail = &g_work_head;
+            }
+            work->next = NULL;
+            work->pending = false;
+        }
+        kos_spin_unlock_irqrestore(&g_work_lock, flags);
+
+        if (!work) {
+            break;
+        }
+
+        uint64_t start = kos_clock_cycles();
+        work->func(work->data);
+        uint64_t elapsed = kos_softirq_elapsed_ns(start);
+
+        g_softirq_stats.work_runs++;
+        g_softirq_stats.worker_ns += elapsed;
+        if (elapsed > g_softirq_stats.worker_max_ns) {
+            g_softirq_stats.worker_max_ns = elapsed;
+        }
+    }
+}
+
+// =============================================================================
+// Statistics
+// =============================================================================
+
+// Get deferred work statistics
+void kos_softirq_get_stats(kos_softirq_stats_t* stats) {
+    if (!stats) {
+        return;
+    }
+
+    uint64_t flags = kos_local_irq_save();
+    *stats = g_softirq_stats;
+    kos_local_irq_restore(flags);
+}
+
+// Reset deferred work statistics
+void kos_softirq_reset_stats(void) {
+    uint64_t flags = kos_local_irq_save();
+    kos_memset(&g_softirq_stats, 0, sizeof(kos_softirq_stats_t));
+    kos_local_irq_restore(flags);
+}
+
+// Dump deferred work statistics
+void kos_softirq_dump_stats(void) {
+    kos_softirq_stats_t stats;
+    kos_softirq_get_stats(&stats);
+
+    log_info("=== Deferred Work Statistics ===");
+    log_info("Hard IRQs: %u, Total: %d us, Max: %d ns",
+             (uint32_t)stats.hardirq_count,
+             (int)(stats.hardirq_ns / KOS_NSEC_PER_USEC), (int)stats.hardirq_max_ns);
+    log_info("Softirq passes: %u, Total: %d us, Max pass: %d ns, Deferred: %u",
+             (uint32_t)stats.softirq_passes,
+             (int)(stats.softirq_ns / KOS_NSEC_PER_USEC), (int)stats.softirq_max_pass_ns,
+             (uint32_t)stats.softirq_deferred);
+
+    for (uint32_t nr = 0; nr < KOS_SOFTIRQ_COUNT; nr++) {
+        const kos_softirq_vector_stats_t* vs = &stats.vectors[nr];
+        if (vs->raised == 0) {
+            continue;
+        }
+        log_info("  %s: raised %u, runs %u, total %d us, max %d ns",
+                 g_softirq_names[nr], (uint32_t)vs->raised, (uint32_t)vs->runs,
+                 (int)(vs->total_ns / KOS_NSEC_PER_USEC), (int)vs->max_ns);
+    }
+
+    log_info("Tasklets run: %u", (uint32_t)stats.tasklet_runs);
+    log_info("Work queued: %u, Run: %u, Total: %d us, Max: %d ns",
+             (uint32_t)stats.work_queued, (uint32_t)stats.work_runs,
+             (int)(stats.worker_ns / KOS_NSEC_PER_USEC), (int)stats.worker_max_ns);
+}
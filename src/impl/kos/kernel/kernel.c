@@ -58,20 +58,9 @@ const kos_kernel_config_t g_default_kernel_config = {
     .enable_timer = true
 };
 
-// GDT functions (simplified)
-typedef struct {
-    u64 entries[5];
-    struct {
-        u16 limit;
-        u64 base;
-    } pointer;
-} kos_gdt_t;
-
-extern kos_result_t kos_gdt_init(kos_gdt_t* gdt);
-extern void kos_gdt_load(const kos_gdt_t* gdt);
-extern kos_result_t kos_gdt_setup_kernel_segments(kos_gdt_t* gdt);
-extern kos_result_t kos_gdt_setup_user_segments(kos_gdt_t* gdt);
-extern void kos_gdt_flush(void);
+// Per-CPU GDT, TSS and GS block
+extern kos_result_t kos_percpu_init_boot(void);
+extern kos_result_t kos_counter_init(void);
 
 // Memory functions (simplified)
 typedef struct {
@@ -110,6 +99,14 @@ extern kos_driver_t g_keyboard_driver;
 extern kos_result_t kos_keyboard_init(kos_driver_t* driver);
 extern void kos_keyboard_handle_interrupt(kos_driver_t* driver);
 
+// Interrupt bring-up
+extern void init_idt(void);
+extern void irq_remap(void);
+extern void timer_phase(int hz);
+extern void timer_install(void);
+extern void keyboard_install(void);
+extern void syscall_init(void);
+
 // Kernel functions
 kos_result_t kos_kernel_init(const kos_kernel_config_t* config) {
     if (!config) {
@@ -119,25 +116,20 @@ kos_result_t kos_kernel_init(const kos_kernel_config_t* config) {
     // Initialize kernel state
     kos_memset(&g_kernel_state, 0, sizeof(kos_kernel_state_t));
     
-    // Initialize GDT
-    kos_gdt_t gdt;
-    kos_result_t result = kos_gdt_init(&gdt);
-    if (result != KOS_SUCCESS) {
-        return result;
-    }
-    
-    result = kos_gdt_setup_kernel_segments(&gdt);
+    // Initialize the boot CPU's GDT and TSS, they live in its per-CPU block
+    kos_result_t result = kos_percpu_init_boot();
     if (result != KOS_SUCCESS) {
         return result;
     }
     
-    result = kos_gdt_setup_user_segments(&gdt);
+    // Event counters live in the per-CPU block
+    result = kos_counter_init();
     if (result != KOS_SUCCESS) {
         return result;
     }
     
-    kos_gdt_load(&gdt);
-    kos_gdt_flush();
+    // SYSCALL MSRs, the entry stub reaches its stack through GS
+    syscall_init();
     
     // Disable interrupts during setup using HAL
     hal_interrupt_disable();
@@ -174,15 +166,48 @@ kos_result_t kos_kernel_init(const kos_kernel_config_t* config) {
         return result;
     }
     
+    // Load the IDT, remap the PIC and attach the interrupt sources
+    init_idt();
+    irq_remap();
+    timer_phase(1000);
+    timer_install();
+    if (config->enable_keyboard) {
+        keyboard_install();
+    }
+    
     // Enable interrupts using HAL
     hal_interrupt_enable();
     
     return KOS_SUCCESS;
 }
 
+// Deferred work
+extern void kos_worker_run(void);
+extern bool kos_workqueue_run(void);
+
+// Ready processes run whenever the boot CPU is idle
+extern hal_result_t kos_process_schedule(void);
+
+// RCU grace periods advance from the idle loop
+extern void kos_rcu_quiescent(void);
+extern void kos_rcu_process_callbacks(void);
+
 kos_result_t kos_kernel_start(void) {
     // Main kernel loop
     while (true) {
+        // Run queued work and softirqs that overran their IRQ-exit budget
+        kos_worker_run();
+        
+        // This CPU's share of the work queues
+        kos_workqueue_run();
+        
+        // Switch to processes woken since the last pass
+        kos_process_schedule();
+        
+        // Nothing is held here, report it and run RCU callbacks that are due
+        kos_rcu_quiescent();
+        kos_rcu_process_callbacks();
+        
         // Save power when idle using HAL
         hal_halt();
     }
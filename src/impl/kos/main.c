@@ -9,21 +9,22 @@
 #include "hal/hal_memory_simple.h"
 #include "hal/hal_timer_simple.h"
 #include "hal/hal_platform_simple.h"
+#include "kos/process/workqueue.h"
 
 // =============================================================================
 // KOS - Main Entry Point (Fixed)
 // =============================================================================
 
-// Basic types
-typedef enum {
-    KOS_SUCCESS = 0,
-    KOS_ERROR_INVALID_PARAM = -1
-} kos_result_t;
-
 // External test functions
 extern void test_memory_system(void);
 extern void test_logging_system(void);
 extern void test_integration_system(void);
+extern void test_timer_system(void);
+extern void test_ring_system(void);
+extern void test_workqueue_system(void);
+extern void test_wait_system(void);
+extern void test_switch_system(void);
+extern void test_hpet_system(void);
 
 // Run validation tests
 void run_validation_tests(void) {
@@ -44,11 +45,37 @@ void run_validation_tests(void) {
     log_info("Running Integration Tests...");
     test_integration_system();
     
+    log_info("Running Timer Wheel Tests...");
+    test_timer_system();
+    
+    log_info("Running Lock-Free Ring Tests...");
+    test_ring_system();
+    
+    log_info("Running Work Queue Tests...");
+    test_workqueue_system();
+    
+    log_info("Running Wait Queue Tests...");
+    test_wait_system();
+    
+    log_info("Running Context Switch Tests...");
+    test_switch_system();
+    
+    log_info("Running HPET Comparator Tests...");
+    test_hpet_system();
+    
     log_info("========================================");
     log_info("  Validation Tests Completed");
     log_info("========================================");
 }
 
+// Validation runs in worker context, boot goes on to the idle loop meanwhile
+static void run_validation_work(void* data) {
+    (void)data;
+    run_validation_tests();
+}
+
+static kos_work_item_t g_validation_work = KOS_WORK_ITEM_INIT(run_validation_work, NULL);
+
 // Legacy entry point - delegates to new kernel system
 void kernel_main(void) {
     // Initialize HAL first - this is the most important step
@@ -83,6 +110,40 @@ void kernel_main(void) {
         }
     }
     
+    // Bring up the HPET and calibrate the TSC before anything takes timestamps
+    extern bool hal_hpet_init(void);
+    extern uint64_t hal_tsc_calibrate(void);
+    hal_hpet_init();
+    hal_tsc_calibrate();
+    
+    // Start the monotonic clock on the best clocksource
+    extern kos_result_t kos_clock_init(void);
+    kos_clock_init();
+    
+    // Calibrate the sleep spin threshold against the running clock
+    extern kos_result_t kos_sleep_init(void);
+    kos_sleep_init();
+    
+    // Deferred work must be ready before the first interrupt
+    extern kos_result_t kos_softirq_init(void);
+    kos_softirq_init();
+    
+    // Work queues, their workers are the idle loops of each CPU
+    kos_workqueue_init();
+    
+    // Processes run on this CPU, the boot flow becomes the idle process
+    extern hal_result_t kos_process_init(void* manager);
+    extern hal_result_t kos_process_scheduler_start(void);
+    if (kos_process_init(NULL) == HAL_SUCCESS) {
+        kos_process_scheduler_start();
+    }
+    
+    // Local APIC receives message-signalled interrupts, PCI devices may use them
+    extern bool hal_lapic_init(void);
+    extern kos_result_t kos_pci_init(void);
+    hal_lapic_init();
+    kos_pci_init();
+    
     // Initialize performance monitoring first
     perf_init();
     perf_shell_init();
@@ -92,10 +153,6 @@ void kernel_main(void) {
     log_info("KOS Kernel Starting...");
     log_info("Performance Monitor Active");
     
-    // Run validation tests first
-    log_info("Starting Fase 0 Validation...");
-    run_validation_tests();
-    
     // Call the standalone kernel initialization
     extern void kos_kernel_start(void);
     
@@ -111,6 +168,14 @@ void kernel_main(void) {
         }
     }
     
+    // Start the application processors, each needs the IDT loaded above
+    extern kos_result_t kos_smp_init(void);
+    kos_smp_init();
+    
+    // Hand the validation suites to the system work queue
+    log_info("Starting Fase 0 Validation...");
+    kos_queue_work(kos_system_wq(), &g_validation_work);
+    
     // Show initial performance stats
     perf_print_stats();
     
@@ -2,11 +2,20 @@
 #include "kos/utils/log_stubs.h"
 #include "kos/utils/hal_utils.h"
 #include "hal/hal_interface_clean.h"
+#include "kos/time/clock.h"
+#include "kos/time/vdso.h"
+#include "kos/sync/rcu.h"
+#include "kos/cpu/counter.h"
+#include "kos/cpu/percpu.h"
+#include "kos/cpu/irqflags.h"
+#include "kos/interrupts/softirq.h"
 
 // =============================================================================
 // KOS - Process Manager Implementation (HAL-based)
 // =============================================================================
 
+KOS_COUNTER_DEFINE(sched, context_switches);
+
 // Global process manager instance
 static kos_process_manager_t g_process_manager;
 static hal_bool_t g_process_manager_initialized = false;
@@ -18,6 +27,7 @@ static kos_process_t* g_process_table[KOS_CONFIG_MAX_PROCESSES];
 // Process Manager Internal Functions
 // =============================================================================
 
+// PID and table helpers below expect the caller to hold table.lock
 static uint32_t allocate_pid(void) {
     uint32_t pid = g_process_manager.table.next_pid;
     
@@ -46,7 +56,7 @@ static hal_result_t add_process_to_table(kos_process_t* process) {
         return HAL_ERROR_INVALID_PARAM;
     }
     
-    g_process_table[process->pid] = process;
+    kos_rcu_assign_pointer(g_process_table[process->pid], process);
     g_process_manager.table.count++;
     
     return HAL_SUCCESS;
@@ -57,35 +67,45 @@ static hal_result_t remove_process_from_table(kos_process_t* process) {
         return HAL_ERROR_INVALID_PARAM;
     }
     
-    g_process_table[process->pid] = NULL;
+    kos_rcu_assign_pointer(g_process_table[process->pid], NULL);
     g_process_manager.table.count--;
     
     return HAL_SUCCESS;
 }
 
-static void initialize_process_context(kos_process_t* process, void* entry_point, void* stack_top) {
+// kos_context_start calls entry(arg) on the process's own stack, a process
+// without an entry point exits as soon as it first runs
+static void initialize_process_context(kos_process_t* process, kos_process_entry_t entry, void* arg) {
     hal_memset(&process->context, 0, sizeof(kos_cpu_context_t));
     
-    // Set up stack pointer
-    process->context.rsp = (uint64_t)stack_top;
-    process->context.rbp = (uint64_t)stack_top;
-    
-    // Set up instruction pointer
-    process->context.rip = (uint64_t)entry_point;
+    // The ABI wants a 16-byte aligned stack at the call in kos_context_start
+    process->context.rsp = (uint64_t)(process->memory.stack_end & ~(uintptr_t)0xF);
+    process->context.rip = (uint64_t)(uintptr_t)kos_context_start;
+    process->context.rbx = (uint64_t)(uintptr_t)entry;
+    process->context.r12 = (uint64_t)(uintptr_t)arg;
     
-    // Set up segment registers
-    process->context.cs = 0x08;  // Kernel code segment
-    process->context.ds = 0x10;  // Kernel data segment
-    process->context.es = 0x10;
-    process->context.fs = 0x10;
-    process->context.gs = 0x10;
-    process->context.ss = 0x10;  // Kernel stack segment
+    // Kernel processes keep whichever address space is loaded
+    process->context.cr3 = (uint64_t)(uintptr_t)process->page_directory;
+}
+
+// Processes only run on the boot CPU and never from interrupt context, the
+// process table tracks a single current process
+static bool kos_process_can_switch(void) {
+    if (kos_in_interrupt() || kos_in_softirq()) {
+        return false;
+    }
     
-    // Set up flags
-    process->context.rflags = 0x202; // Interrupts enabled
+    return kos_this_cpu_id() == 0;
+}
+
+// Free a destroyed process once no PID lookup can still see it
+static void free_process_rcu(kos_rcu_head_t* head) {
+    kos_process_t* process = (kos_process_t*)((char*)head - offsetof(kos_process_t, rcu));
     
-    // Set up page directory
-    process->context.cr3 = (uint64_t)process->page_directory;
+    if (process->memory.stack_start) {
+        hal_free((void*)process->memory.stack_start);
+    }
+    hal_free(process);
 }
 
 static kos_process_t* create_idle_process(void) {
@@ -95,12 +115,17 @@ static kos_process_t* create_idle_process(void) {
         return NULL;
     }
     
+    // The idle process is the boot flow, its context is filled in by the
+    // first switch away from it. Move it from the PID it was handed to 0.
+    uint64_t lock_flags = kos_spin_lock_irqsave(&g_process_manager.table.lock);
+    remove_process_from_table(idle_process);
     idle_process->pid = KOS_IDLE_PROCESS_PID;
+    add_process_to_table(idle_process);
+    kos_spin_unlock_irqrestore(&g_process_manager.table.lock, lock_flags);
+    
     idle_process->state = KOS_PROCESS_STATE_RUNNING;
     idle_process->time_slice = KOS_MIN_TIME_SLICE;
-    
-    // Add to process table
-    add_process_to_table(idle_process);
+    idle_process->stats.last_run_time = kos_clock_monotonic_ns();
     
     return idle_process;
 }
@@ -119,6 +144,7 @@ hal_result_t kos_process_init(kos_process_manager_t* manager) {
     // Initialize process manager structure
     hal_memset(&g_process_manager, 0, sizeof(kos_process_manager_t));
     hal_memset(g_process_table, 0, sizeof(g_process_table));
+    kos_spin_init(&g_process_manager.table.lock);
     
     g_process_manager.table.next_pid = 1;
     g_process_manager.scheduler_enabled = false;
@@ -185,8 +211,15 @@ hal_result_t kos_process_create(kos_process_t** process, const char* name,
     // Initialize process structure
     hal_memset(new_process, 0, sizeof(kos_process_t));
     
-    // Set basic information
+    // Set basic information, the slot is claimed in the same critical
+    // section so two CPUs can never be handed the same PID
+    uint64_t lock_flags = kos_spin_lock_irqsave(&g_process_manager.table.lock);
     new_process->pid = allocate_pid();
+    if (new_process->pid != 0) {
+        add_process_to_table(new_process);
+    }
+    kos_spin_unlock_irqrestore(&g_process_manager.table.lock, lock_flags);
+    
     if (new_process->pid == 0) {
         hal_free(new_process);
         return HAL_ERROR_OUT_OF_MEMORY; // No available PIDs
@@ -222,15 +255,19 @@ hal_result_t kos_process_create(kos_process_t** process, const char* name,
     new_process->memory.stack_end = new_process->memory.stack_start + stack_size;
     new_process->memory.total_size = stack_size;
     new_process->memory.used_size = 0;
+    new_process->memory.vdso_base = (uintptr_t)kos_vdso_get_page();
     
     if (!new_process->memory.stack_start) {
+        lock_flags = kos_spin_lock_irqsave(&g_process_manager.table.lock);
+        remove_process_from_table(new_process);
+        kos_spin_unlock_irqrestore(&g_process_manager.table.lock, lock_flags);
         hal_free(new_process);
         return HAL_ERROR_OUT_OF_MEMORY;
     }
     
     // Initialize statistics
     hal_memset(&new_process->stats, 0, sizeof(kos_process_stats_t));
-    new_process->stats.creation_time = hal_get_timestamp();
+    new_process->stats.creation_time = kos_clock_monotonic_ns();
     
     // Set up parent-child relationships
     new_process->parent = g_process_manager.table.current_process;
@@ -242,22 +279,13 @@ hal_result_t kos_process_create(kos_process_t** process, const char* name,
         new_process->parent->first_child = new_process;
     }
     
-    // Initialize context (will be set properly when starting)
-    initialize_process_context(new_process, (void*)0x100000, // Default entry point
-                              (void*)(new_process->memory.stack_end - 8));
+    // Initialize context, kos_process_set_entry supplies the entry point
+    initialize_process_context(new_process, NULL, NULL);
     
     // Set magic number and initialized flag
     new_process->magic = KOS_PROCESS_MAGIC;
     new_process->initialized = true;
     
-    // Add to process table
-    hal_result_t result = add_process_to_table(new_process);
-    if (result != HAL_SUCCESS) {
-        hal_free((void*)new_process->memory.stack_start);
-        hal_free(new_process);
-        return result;
-    }
-    
     *process = new_process;
     
     log_info("Created process '%s' with PID %u", name, new_process->pid);
@@ -292,20 +320,17 @@ hal_result_t kos_process_destroy(kos_process_t* process) {
         child = next_child;
     }
     
-    // Free process memory
-    if (process->memory.stack_start) {
-        hal_free((void*)process->memory.stack_start);
-    }
-    
     // Remove from process table
+    uint64_t lock_flags = kos_spin_lock_irqsave(&g_process_manager.table.lock);
     remove_process_from_table(process);
+    kos_spin_unlock_irqrestore(&g_process_manager.table.lock, lock_flags);
     
     // Clear magic and initialized flag
     process->magic = 0;
     process->initialized = false;
     
-    // Free process structure
-    hal_free(process);
+    // Free process memory and structure after a grace period
+    kos_call_rcu(&process->rcu, free_process_rcu);
     
     return HAL_SUCCESS;
 }
@@ -322,8 +347,46 @@ hal_result_t kos_process_start(kos_process_t* process) {
     log_info("Starting process '%s' (PID %u)", process->name, process->pid);
     
     process->state = KOS_PROCESS_STATE_READY;
-    process->stats.start_time = hal_get_timestamp();
+    process->stats.start_time = kos_clock_monotonic_ns();
+    
+    return HAL_SUCCESS;
+}
+
+// Point a process that has not started yet at its entry function
+hal_result_t kos_process_set_entry(kos_process_t* process, kos_process_entry_t entry, void* arg) {
+    if (!process || !process->initialized || process->magic != KOS_PROCESS_MAGIC || !entry) {
+        return HAL_ERROR_INVALID_PARAM;
+    }
+    
+    if (process->state != KOS_PROCESS_STATE_CREATED) {
+        return HAL_ERROR_INVALID_STATE;
+    }
+    
+    initialize_process_context(process, entry, arg);
+    return HAL_SUCCESS;
+}
+
+// Create a kernel process running entry(arg) and make it ready
+hal_result_t kos_process_spawn(kos_process_t** process, const char* name, kos_process_entry_t entry,
+                               void* arg, kos_process_priority_t priority) {
+    if (!process || !entry) {
+        return HAL_ERROR_INVALID_PARAM;
+    }
+    
+    kos_process_t* new_process = NULL;
+    hal_result_t result = kos_process_create(&new_process, name, priority, KOS_PROCESS_FLAG_KERNEL);
+    if (result != HAL_SUCCESS) {
+        return result;
+    }
+    
+    kos_process_set_entry(new_process, entry, arg);
+    result = kos_process_start(new_process);
+    if (result != HAL_SUCCESS) {
+        kos_process_destroy(new_process);
+        return result;
+    }
     
+    *process = new_process;
     return HAL_SUCCESS;
 }
 
@@ -342,7 +405,7 @@ hal_result_t kos_process_terminate(kos_process_t* process, int32_t exit_code) {
     
     process->state = KOS_PROCESS_STATE_TERMINATED;
     process->exit_code = exit_code;
-    process->stats.total_run_time = hal_get_timestamp() - process->stats.start_time;
+    process->stats.total_run_time = kos_clock_monotonic_ns() - process->stats.start_time;
     
     // If this is the current process, schedule next one
     if (process == g_process_manager.table.current_process) {
@@ -352,11 +415,54 @@ hal_result_t kos_process_terminate(kos_process_t* process, int32_t exit_code) {
     return HAL_SUCCESS;
 }
 
+// Let processes be switched to, the calling flow becomes the idle process
+hal_result_t kos_process_scheduler_start(void) {
+    if (!g_process_manager_initialized) {
+        return HAL_ERROR_NOT_INITIALIZED;
+    }
+    
+    g_process_manager.scheduler_enabled = true;
+    log_info("Scheduler started");
+    return HAL_SUCCESS;
+}
+
+// End the current process, the caller's stack is never resumed
+void kos_process_exit(int32_t exit_code) {
+    kos_process_t* current = g_process_manager.table.current_process;
+    
+    if (current && current != g_process_manager.table.idle_process) {
+        kos_process_terminate(current, exit_code);
+    }
+    
+    // Only reached without a scheduler to switch away
+    while (true) {
+        asm volatile("hlt");
+    }
+}
+
+// First code a process runs, entered from kos_context_start. The switch
+// into it left the table locked with interrupts off.
+void kos_process_bootstrap(kos_process_entry_t entry, void* arg) {
+    kos_spin_unlock(&g_process_manager.table.lock);
+    kos_local_irq_enable();
+    
+    kos_process_exit(entry ? entry(arg) : 0);
+}
+
 hal_result_t kos_process_schedule(void) {
     if (!g_process_manager_initialized || !g_process_manager.scheduler_enabled) {
         return HAL_ERROR_NOT_INITIALIZED;
     }
     
+    if (!kos_process_can_switch()) {
+        return HAL_ERROR_INVALID_STATE;
+    }
+    
+    // The lock is held across the switch and released by whichever flow
+    // resumes, the interrupt flag is restored from each flow's own stack
+    uint64_t irq_flags = kos_local_irq_save();
+    kos_spin_lock(&g_process_manager.table.lock);
+    
     kos_process_t* current = g_process_manager.table.current_process;
     kos_process_t* next = NULL;
     
@@ -381,17 +487,23 @@ hal_result_t kos_process_schedule(void) {
     
     // If we're already running the selected process, nothing to do
     if (next == current) {
+        if (current->state == KOS_PROCESS_STATE_READY) {
+            current->state = KOS_PROCESS_STATE_RUNNING;
+        }
+        kos_spin_unlock(&g_process_manager.table.lock);
+        kos_local_irq_restore(irq_flags);
         return HAL_SUCCESS;
     }
     
     // Update scheduler statistics
     g_process_manager.scheduler_ticks++;
-    g_process_manager.scheduler_time = hal_get_timestamp();
+    g_process_manager.scheduler_time = kos_clock_monotonic_ns();
     
-    // Update current process statistics
+    // Charge the outgoing process for the time it actually ran (ns)
     if (current) {
-        current->stats.last_run_time = g_process_manager.scheduler_time;
-        current->stats.cpu_time += current->time_slice;
+        uint64_t ran = g_process_manager.scheduler_time - current->stats.last_run_time;
+        current->stats.cpu_time += ran;
+        current->stats.kernel_time += ran;
         current->stats.context_switches++;
         
         if (current->state == KOS_PROCESS_STATE_RUNNING) {
@@ -401,15 +513,24 @@ hal_result_t kos_process_schedule(void) {
     
     // Switch to next process
     next->state = KOS_PROCESS_STATE_RUNNING;
+    next->stats.last_run_time = g_process_manager.scheduler_time;
     next->stats.context_switches++;
     next->remaining_time = next->quantum;
     
     g_process_manager.table.current_process = next;
+    kos_counter_inc(context_switches);
     
-    // Perform context switch (this would call assembly function)
-    // kos_context_switch(&current->context, &next->context);
+    // Kernel entries from ring 3 land on the incoming process's own stack
+    kos_percpu_set_kernel_stack(next->memory.stack_end & ~(uintptr_t)0xF);
+    
+    // Returns once something switches back to us, a new process starts in
+    // kos_process_bootstrap instead
+    if (current) {
+        kos_context_switch(&current->context, &next->context);
+    }
     
-    log_debug("Scheduled process '%s' (PID %u)", next->name, next->pid);
+    kos_spin_unlock(&g_process_manager.table.lock);
+    kos_local_irq_restore(irq_flags);
     
     return HAL_SUCCESS;
 }
@@ -419,12 +540,81 @@ hal_result_t kos_process_yield(void) {
         return HAL_ERROR_NOT_INITIALIZED;
     }
     
+    uint64_t lock_flags = kos_spin_lock_irqsave(&g_process_manager.table.lock);
     kos_process_t* current = g_process_manager.table.current_process;
-    if (current && current->state == KOS_PROCESS_STATE_RUNNING) {
+    bool yielded = current && current->state == KOS_PROCESS_STATE_RUNNING;
+    if (yielded) {
         current->state = KOS_PROCESS_STATE_READY;
-        return kos_process_schedule();
+    }
+    kos_spin_unlock_irqrestore(&g_process_manager.table.lock, lock_flags);
+    
+    if (!yielded) {
+        return HAL_SUCCESS;
+    }
+    
+    // Carry on as the running process if the switch was refused
+    hal_result_t result = kos_process_schedule();
+    if (result != HAL_SUCCESS) {
+        lock_flags = kos_spin_lock_irqsave(&g_process_manager.table.lock);
+        if (current->state == KOS_PROCESS_STATE_READY) {
+            current->state = KOS_PROCESS_STATE_RUNNING;
+        }
+        kos_spin_unlock_irqrestore(&g_process_manager.table.lock, lock_flags);
     }
     
+    return result;
+}
+
+// Block the current process until kos_process_wake(). A wake that arrived
+// while it was still running makes this return at once, so callers must
+// re-check what they wait for.
+hal_result_t kos_process_block(void) {
+    if (!g_process_manager_initialized || !g_process_manager.scheduler_enabled) {
+        return HAL_ERROR_NOT_INITIALIZED;
+    }
+    
+    if (!kos_process_can_switch()) {
+        return HAL_ERROR_INVALID_STATE;
+    }
+    
+    uint64_t lock_flags = kos_spin_lock_irqsave(&g_process_manager.table.lock);
+    kos_process_t* current = g_process_manager.table.current_process;
+    if (!current || current == g_process_manager.table.idle_process) {
+        kos_spin_unlock_irqrestore(&g_process_manager.table.lock, lock_flags);
+        return HAL_ERROR_INVALID_STATE;
+    }
+    
+    if (current->wake_pending) {
+        current->wake_pending = false;
+        kos_spin_unlock_irqrestore(&g_process_manager.table.lock, lock_flags);
+        return HAL_SUCCESS;
+    }
+    
+    current->state = KOS_PROCESS_STATE_BLOCKED;
+    kos_spin_unlock_irqrestore(&g_process_manager.table.lock, lock_flags);
+    
+    return kos_process_schedule();
+}
+
+// Make a blocked process runnable again, safe from timer callbacks
+hal_result_t kos_process_wake(kos_process_t* process) {
+    if (!process || !process->initialized || process->magic != KOS_PROCESS_MAGIC) {
+        return HAL_ERROR_INVALID_PARAM;
+    }
+    
+    uint64_t lock_flags = kos_spin_lock_irqsave(&g_process_manager.table.lock);
+    if (process->state != KOS_PROCESS_STATE_BLOCKED) {
+        // Not asleep yet, keep the wake for its next block
+        if (process->state == KOS_PROCESS_STATE_RUNNING) {
+            process->wake_pending = true;
+        }
+        kos_spin_unlock_irqrestore(&g_process_manager.table.lock, lock_flags);
+        return HAL_ERROR_INVALID_STATE;
+    }
+    
+    process->state = KOS_PROCESS_STATE_READY;
+    process->stats.wakeups++;
+    kos_spin_unlock_irqrestore(&g_process_manager.table.lock, lock_flags);
     return HAL_SUCCESS;
 }
 
@@ -457,7 +647,9 @@ hal_result_t kos_process_get_by_pid(uint32_t pid, kos_process_t** process) {
         return HAL_ERROR_INVALID_PARAM;
     }
     
-    *process = g_process_table[pid];
+    kos_rcu_read_lock();
+    *process = kos_rcu_dereference(g_process_table[pid]);
+    kos_rcu_read_unlock();
     return *process ? HAL_SUCCESS : HAL_ERROR_INVALID_PARAM;
 }
 
@@ -477,7 +669,7 @@ hal_result_t kos_process_get_stats(kos_process_t* process, kos_process_stats_t*
     
     // Update current statistics
     if (process->state == KOS_PROCESS_STATE_RUNNING) {
-        uint64_t current_time = hal_get_timestamp();
+        uint64_t current_time = kos_clock_monotonic_ns();
         process->stats.total_run_time = current_time - process->stats.start_time;
     }
     
@@ -0,0 +1,535 @@
+#include "kos/process/workqueue.h"
+#include "kos/cpu/ipi.h"
+#include "kos/time/clock.h"
+#include "kos/utils/string.h"
+#include "debug/debug.h"
+
+// =============================================================================
+// KOS - Work Queue Implementation
+// =============================================================================
+
+// Queues are handed out of a fixed pool, workers walk the used part
+static kos_workqueue_t g_workqueues[KOS_WORKQUEUE_MAX];
+static volatile uint32_t g_workqueue_count = 0;
+static kos_spinlock_t g_workqueue_lock = KOS_SPINLOCK_INIT;
+
+// Built-in queues
+static kos_workqueue_t* g_system_wq = NULL;
+static kos_workqueue_t* g_parallel_wq = NULL;
+
+// Check a CPU can run work
+static bool kos_workqueue_cpu_online(uint32_t cpu) {
+    if (cpu == 0 && kos_percpu_count() == 0) {
+        return true;
+    }
+
+    kos_cpu_local_t* local = kos_percpu_get(cpu);
+    return local && local->online;
+}
+
+// Pick the pool for an unpinned item
+static uint32_t kos_workqueue_pick_cpu(kos_workqueue_t* wq) {
+    uint32_t self = kos_this_cpu_id();
+    if (!(wq->flags & KOS_WQ_UNBOUND) || kos_percpu_count() <= 1) {
+        return self;
+    }
+
+    // Round robin over online CPUs
+    for (uint32_t tries = 0; tries < kos_percpu_count(); tries++) {
+        uint32_t cpu = __atomic_fetch_add(&wq->next_cpu, 1, __ATOMIC_RELAXED) % kos_percpu_count();
+        if (kos_workqueue_cpu_online(cpu)) {
+            return cpu;
+        }
+    }
+
+    return self;
+}
+
+// Append a claimed item to a CPU's pool and wake that CPU
+static void kos_workqueue_insert(kos_workqueue_t* wq, uint32_t cpu, kos_work_item_t* work) {
+    kos_worker_pool_t* pool = &wq->pools[cpu];
+
+    work->cpu = cpu;
+    work->next = NULL;
+
+    uint64_t flags = kos_spin_lock_irqsave(&pool->lock);
+    if (pool->tail) {
+        pool->tail->next = work;
+    } else {
+        pool->head = work;
+    }
+    pool->tail = work;
+    pool->queued++;
+    kos_spin_unlock_irqrestore(&pool->lock, flags);
+
+    // The idle loop of that CPU is its worker, get it out of HLT
+    if (kos_percpu_count() && cpu != kos_this_cpu_id()) {
+        kos_smp_send_reschedule(cpu);
+    }
+}
+
+// Run everything queued on one pool, returns true if anything ran
+static bool kos_workqueue_run_pool(kos_worker_pool_t* pool) {
+    bool ran = false;
+
+    while (true) {
+        uint64_t flags = kos_spin_lock_irqsave(&pool->lock);
+        kos_work_item_t* work = pool->head;
+        if (!work) {
+            kos_spin_unlock_irqrestore(&pool->lock, flags);
+            break;
+        }
+
+        pool->head = work->next;
+        if (!pool->head) {
+            pool->tail = NULL;
+        }
+        work->next = NULL;
+
+        // The item may be queued again or freed once its function starts
+        kos_work_item_t* outer = pool->running;
+        kos_deferred_fn_t func = work->func;
+        void* data = work->data;
+        pool->running = work;
+        pool->depth++;
+        __atomic_store_n(&work->pending, false, __ATOMIC_RELEASE);
+        kos_spin_unlock_irqrestore(&pool->lock, flags);
+
+        uint64_t start = kos_clock_cycles();
+        func(data);
+        uint64_t elapsed = kos_clock_cycles_to_ns(kos_clock_cycles() - start);
+
+        flags = kos_spin_lock_irqsave(&pool->lock);
+        pool->running = outer;
+        pool->depth--;
+        pool->done++;
+        pool->busy_ns += elapsed;
+        if (elapsed > pool->max_ns) {
+            pool->max_ns = elapsed;
+        }
+        kos_spin_unlock_irqrestore(&pool->lock, flags);
+
+        __atomic_thread_fence(__ATOMIC_SEQ_CST);
+        if (kos_wait_queue_active(&pool->flush_wait)) {
+            kos_wake_up_all(&pool->flush_wait);
+        }
+
+        ran = true;
+    }
+
+    return ran;
+}
+
+// Wait for a pool to pass a done count, running it if it is ours. Items our
+// own pool is executing are our callers and only finish once we return.
+static void kos_workqueue_wait_pool(kos_workqueue_t* wq, uint32_t cpu, uint64_t target) {
+    kos_worker_pool_t* pool = &wq->pools[cpu];
+
+    if (cpu != kos_this_cpu_id()) {
+        kos_wait_event(&pool->flush_wait, pool->done >= target);
+        return;
+    }
+
+    target = target > pool->depth ? target - pool->depth : 0;
+    while (pool->done < target) {
+        kos_workqueue_run_pool(pool);
+    }
+}
+
+// Check whether another CPU is executing an item. One running on the calling
+// CPU is up our own stack, waiting for it would never end.
+static bool kos_workqueue_is_running(const kos_work_item_t* work) {
+    uint32_t self = kos_this_cpu_id();
+
+    for (uint32_t i = 0; i < g_workqueue_count; i++) {
+        for (uint32_t cpu = 0; cpu < KOS_CPU_MAX; cpu++) {
+            if (cpu == self) {
+                continue;
+            }
+            if (*(kos_work_item_t* volatile*)&g_workqueues[i].pools[cpu].running == work) {
+                return true;
+            }
+        }
+    }
+
+    return false;
+}
+
+// Create the built-in queues
+kos_result_t kos_workqueue_init(void) {
+    if (g_system_wq) {
+        return KOS_SUCCESS;
+    }
+
+    g_system_wq = kos_workqueue_create("system", 0);
+    g_parallel_wq = kos_workqueue_create("parallel", 0);
+    if (!g_system_wq || !g_parallel_wq) {
+        return KOS_ERROR_OUT_OF_MEMORY;
+    }
+
+    log_info("Work queues initialized: %d max, workers on every CPU", KOS_WORKQUEUE_MAX);
+    return KOS_SUCCESS;
+}
+
+// Create a work queue, NULL when the pool is exhausted
+kos_workqueue_t* kos_workqueue_create(const char* name, uint32_t flags) {
+    uint64_t lock_flags = kos_spin_lock_irqsave(&g_workqueue_lock);
+
+    if (g_workqueue_count >= KOS_WORKQUEUE_MAX) {
+        kos_spin_unlock_irqrestore(&g_workqueue_lock, lock_flags);
+        log_error("Work queue '%s': all %d queues in use", name ? name : "unnamed", KOS_WORKQUEUE_MAX);
+        return NULL;
+    }
+
+    kos_workqueue_t* wq = &g_workqueues[g_workqueue_count];
+    kos_memset(wq, 0, sizeof(kos_workqueue_t));
+    wq->name = name ? name : "unnamed";
+    wq->flags = flags;
+    for (uint32_t cpu = 0; cpu < KOS_CPU_MAX; cpu++) {
+        kos_spin_init_named(&wq->pools[cpu].lock, wq->name);
+        kos_wait_queue_init_named(&wq->pools[cpu].flush_wait, wq->name);
+    }
+
+    // Publish only once the queue is set up, workers read the count unlocked
+    __atomic_store_n(&g_workqueue_count, g_workqueue_count + 1, __ATOMIC_RELEASE);
+    kos_spin_unlock_irqrestore(&g_workqueue_lock, lock_flags);
+
+    return wq;
+}
+
+// Queue shared by everything without its own
+kos_workqueue_t* kos_system_wq(void) {
+    return g_system_wq;
+}
+
+// Worker body, called from every CPU's idle loop, returns true if anything ran
+bool kos_workqueue_run(void) {
+    if (kos_in_interrupt() || kos_in_softirq()) {
+        return false;
+    }
+
+    uint32_t cpu = kos_this_cpu_id();
+    uint32_t count = __atomic_load_n(&g_workqueue_count, __ATOMIC_ACQUIRE);
+    bool ran = false;
+
+    for (uint32_t i = 0; i < count; i++) {
+        ran |= kos_workqueue_run_pool(&g_workqueues[i].pools[cpu]);
+    }
+
+    return ran;
+}
+
+// Check whether this CPU has queued work, call with interrupts off before HLT
+bool kos_workqueue_pending(void) {
+    uint32_t cpu = kos_this_cpu_id();
+    uint32_t count = __atomic_load_n(&g_workqueue_count, __ATOMIC_ACQUIRE);
+
+    for (uint32_t i = 0; i < count; i++) {
+        if (*(kos_work_item_t* volatile*)&g_workqueues[i].pools[cpu].head) {
+            return true;
+        }
+    }
+
+    return false;
+}
+
+// Initialize a work item
+void kos_work_item_init(kos_work_item_t* work, kos_deferred_fn_t func, void* data) {
+    if (!work) {
+        return;
+    }
+
+    work->next = NULL;
+    work->pending = false;
+    work->cpu = 0;
+    work->func = func;
+    work->data = data;
+}
+
+// Queue on the calling CPU, or spread for unbound queues, false if already pending
+bool kos_queue_work(kos_workqueue_t* wq, kos_work_item_t* work) {
+    return kos_queue_work_on(KOS_WORK_CPU_ANY, wq, work);
+}
+
+// Queue on a given CPU, false if already pending
+bool kos_queue_work_on(uint32_t cpu, kos_workqueue_t* wq, kos_work_item_t* work) {
+    if (!wq) {
+        wq = g_system_wq;
+    }
+    if (!wq || !work || !work->func) {
+        return false;
+    }
+    if (cpu != KOS_WORK_CPU_ANY && (cpu >= KOS_CPU_MAX || !kos_workqueue_cpu_online(cpu))) {
+        return false;
+    }
+
+    if (__atomic_exchange_n(&work->pending, true, __ATOMIC_ACQ_REL)) {
+        return false;
+    }
+
+    kos_workqueue_insert(wq, cpu == KOS_WORK_CPU_ANY ? kos_workqueue_pick_cpu(wq) : cpu, work);
+    return true;
+}
+
+// Remove a pending item and wait out one running on another CPU, true if it
+// was pending
+bool kos_cancel_work(kos_work_item_t* work) {
+    if (!work) {
+        return false;
+    }
+
+    bool cancelled = false;
+
+    // A pending item may not be linked yet, the queuer is between claim and insert
+    while (__atomic_load_n(&work->pending, __ATOMIC_ACQUIRE) && !cancelled) {
+        for (uint32_t i = 0; i < g_workqueue_count && !cancelled; i++) {
+            kos_worker_pool_t* pool = &g_workqueues[i].pools[work->cpu];
+            uint64_t flags = kos_spin_lock_irqsave(&pool->lock);
+
+            kos_work_item_t* prev = NULL;
+            for (kos_work_item_t* it = pool->head; it; prev = it, it = it->next) {
+                if (it != work) {
+                    continue;
+                }
+                if (prev) {
+                    prev->next = it->next;
+                } else {
+                    pool->head = it->next;
+                }
+                if (pool->tail == it) {
+                    pool->tail = prev;
+                }
+                it->next = NULL;
+
+                // Counts as done so flushes do not wait for it
+                pool->done++;
+                __atomic_store_n(&work->pending, false, __ATOMIC_RELEASE);
+                cancelled = true;
+                break;
+            }
+
+            kos_spin_unlock_irqrestore(&pool->lock, flags);
+        }
+        if (!cancelled) {
+            kos_cpu_relax();
+        }
+    }
+
+    while (kos_workqueue_is_running(work)) {
+        kos_cpu_relax();
+    }
+
+    return cancelled;
+}
+
+// Wait until an item is neither pending nor running on another CPU
+void kos_flush_work(kos_work_item_t* work) {
+    if (!work) {
+        return;
+    }
+
+    uint32_t self = kos_this_cpu_id();
+    while (__atomic_load_n(&work->pending, __ATOMIC_ACQUIRE) || kos_workqueue_is_running(work)) {
+        if (work->cpu == self) {
+            kos_workqueue_run();
+        } else {
+            kos_cpu_relax();
+        }
+    }
+}
+
+// Wait for everything queued on a queue before the call
+void kos_flush_workqueue(kos_workqueue_t* wq) {
+    if (!wq) {
+        wq = g_system_wq;
+    }
+    if (!wq) {
+        return;
+    }
+
+    uint64_t targets[KOS_CPU_MAX];
+    for (uint32_t cpu = 0; cpu < KOS_CPU_MAX; cpu++) {
+        targets[cpu] = wq->pools[cpu].queued;
+    }
+
+    for (uint32_t cpu = 0; cpu < KOS_CPU_MAX; cpu++) {
+        kos_workqueue_wait_pool(wq, cpu, targets[cpu]);
+    }
+}
+
+// =============================================================================
+// Delayed work
+// =============================================================================
+
+// Timer expired, hand the already claimed item to its queue
+static void kos_delayed_work_timer(void* context) {
+    kos_delayed_work_t* dwork = (kos_delayed_work_t*)context;
+    uint32_t cpu = dwork->cpu;
+
+    if (cpu == KOS_WORK_CPU_ANY || !kos_workqueue_cpu_online(cpu)) {
+        cpu = kos_workqueue_pick_cpu(dwork->wq);
+    }
+    kos_workqueue_insert(dwork->wq, cpu, &dwork->work);
+}
+
+// Initialize a delayed work item
+void kos_delayed_work_init(kos_delayed_work_t* dwork, kos_deferred_fn_t func, void* data) {
+    if (!dwork) {
+        return;
+    }
+
+    kos_work_item_init(&dwork->work, func, data);
+    kos_timer_init(&dwork->timer, kos_delayed_work_timer, dwork);
+    dwork->wq = NULL;
+    dwork->cpu = KOS_WORK_CPU_ANY;
+}
+
+// Queue after a delay, false if already pending
+bool kos_queue_delayed_work(kos_workqueue_t* wq, kos_delayed_work_t* dwork, uint64_t delay_ns) {
+    return kos_queue_delayed_work_on(KOS_WORK_CPU_ANY, wq, dwork, delay_ns);
+}
+
+// Queue on a given CPU after a delay, false if already pending
+bool kos_queue_delayed_work_on(uint32_t cpu, kos_workqueue_t* wq, kos_delayed_work_t* dwork, uint64_t delay_ns) {
+    if (!dwork) {
+        return false;
+    }
+    if (delay_ns == 0) {
+        return kos_queue_work_on(cpu, wq, &dwork->work);
+    }
+    if (!wq) {
+        wq = g_system_wq;
+    }
+    if (!wq || !dwork->work.func) {
+        return false;
+    }
+
+    if (__atomic_exchange_n(&dwork->work.pending, true, __ATOMIC_ACQ_REL)) {
+        return false;
+    }
+
+    dwork->wq = wq;
+    dwork->cpu = cpu;
+    if (kos_timer_add_relative(&dwork->timer, delay_ns) != KOS_SUCCESS) {
+        __atomic_store_n(&dwork->work.pending, false, __ATOMIC_RELEASE);
+        return false;
+    }
+
+    return true;
+}
+
+// Stop the timer or dequeue the item, true if it was pending
+bool kos_cancel_delayed_work(kos_delayed_work_t* dwork) {
+    if (!dwork) {
+        return false;
+    }
+
+    if (kos_timer_cancel(&dwork->timer)) {
+        __atomic_store_n(&dwork->work.pending, false, __ATOMIC_RELEASE);
+        return true;
+    }
+
+    return kos_cancel_work(&dwork->work);
+}
+
+// =============================================================================
+// Parallel for
+// =============================================================================
+
+// Shared state of one kos_parallel_for call, lives on the caller's stack
+typedef struct {
+    kos_parallel_fn_t fn;
+    void* arg;
+    uint64_t end;
+    uint64_t chunk;
+    volatile uint64_t next;
+    volatile kos_result_t result;
+} kos_parallel_job_t;
+
+// Claim chunks until the range is used up or a chunk failed
+static void kos_parallel_worker(void* data) {
+    kos_parallel_job_t* job = (kos_parallel_job_t*)data;
+
+    while (job->result == KOS_SUCCESS) {
+        uint64_t start = __atomic_fetch_add(&job->next, job->chunk, __ATOMIC_RELAXED);
+        if (start >= job->end) {
+            break;
+        }
+
+        uint64_t end = job->end - start > job->chunk ? start + job->chunk : job->end;
+        kos_result_t result = job->fn(start, end, job->arg);
+        if (result != KOS_SUCCESS) {
+            kos_result_t expected = KOS_SUCCESS;
+            __atomic_compare_exchange_n(&job->result, &expected, result, false,
+                                        __ATOMIC_RELAXED, __ATOMIC_RELAXED);
+        }
+    }
+}
+
+// Split [start, end) into chunks run on every online CPU
+kos_result_t kos_parallel_for(uint64_t start, uint64_t end, uint64_t chunk, kos_parallel_fn_t fn, void* arg) {
+    if (!fn || chunk == 0) {
+        return KOS_ERROR_INVALID_PARAM;
+    }
+    if (start >= end) {
+        return KOS_SUCCESS;
+    }
+
+    kos_parallel_job_t job = {
+        .fn = fn, .arg = arg, .end = end, .chunk = chunk, .next = start, .result = KOS_SUCCESS
+    };
+
+    // One helper per other online CPU, no more than there are chunks
+    kos_work_item_t helpers[KOS_CPU_MAX];
+    bool queued[KOS_CPU_MAX] = { false };
+    uint64_t chunks = (end - start + chunk - 1) / chunk;
+    uint32_t self = kos_this_cpu_id();
+
+    if (g_parallel_wq && !kos_in_interrupt()) {
+        for (uint32_t cpu = 0; cpu < kos_percpu_count() && chunks > 1; cpu++) {
+            if (cpu == self || !kos_workqueue_cpu_online(cpu)) {
+                continue;
+            }
+            kos_work_item_init(&helpers[cpu], kos_parallel_worker, &job);
+            queued[cpu] = kos_queue_work_on(cpu, g_parallel_wq, &helpers[cpu]);
+            chunks--;
+        }
+    }
+
+    // The caller works too, so the job finishes even if no helper starts
+    kos_parallel_worker(&job);
+
+    // Helpers that never started are dropped, running ones are waited for
+    for (uint32_t cpu = 0; cpu < KOS_CPU_MAX; cpu++) {
+        if (queued[cpu]) {
+            kos_cancel_work(&helpers[cpu]);
+        }
+    }
+
+    return job.result;
+}
+
+// =============================================================================
+// Statistics
+// =============================================================================
+
+// Dump per-CPU work queue statistics
+void kos_workqueue_dump_stats(void) {
+    log_info("=== Work Queues ===");
+
+    for (uint32_t i = 0; i < g_workqueue_count; i++) {
+        kos_workqueue_t* wq = &g_workqueues[i];
+        log_info("%s%s:", wq->name, (wq->flags & KOS_WQ_UNBOUND) ? " (unbound)" : "");
+
+        for (uint32_t cpu = 0; cpu < KOS_CPU_MAX; cpu++) {
+            kos_worker_pool_t* pool = &wq->pools[cpu];
+            if (pool->queued == 0) {
+                continue;
+            }
+            log_info("  cpu %u: %u queued, %u done, %u us busy, max %u us",
+                     cpu, (uint32_t)pool->queued, (uint32_t)pool->done,
+                     (uint32_t)(pool->busy_ns / KOS_NSEC_PER_USEC),
+                     (uint32_t)(pool->max_ns / KOS_NSEC_PER_USEC));
+        }
+    }
+}
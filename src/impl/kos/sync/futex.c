@@ -0,0 +1,95 @@
+#include "kos/sync/futex.h"
+#include "kos/syscall/syscall.h"
+
+// =============================================================================
+// KOS - Futex Implementation
+// =============================================================================
+
+// Zeroed queues are valid: an unlocked ticket lock and no waiters
+static kos_wait_queue_t g_futex_buckets[KOS_FUTEX_BUCKETS];
+
+// Bucket for an address in an address space
+static kos_wait_queue_t* kos_futex_bucket(uintptr_t space, uintptr_t key) {
+    uint64_t hash = ((uint64_t)(key >> 2) ^ (uint64_t)space) * 0x9E3779B97F4A7C15ULL;
+    return &g_futex_buckets[hash >> (64 - 6)];
+}
+
+_Static_assert(KOS_FUTEX_BUCKETS == 64, "kos_futex_bucket takes the top 6 hash bits");
+
+// Address space of the calling process, its page table root
+static uintptr_t kos_futex_user_space(void) {
+    uint64_t cr3;
+    asm volatile("mov %%cr3, %0" : "=r" (cr3));
+    return (uintptr_t)(cr3 & ~0xFFFULL);
+}
+
+// Sleep while *addr == expected, keyed by (space, addr)
+static kos_result_t kos_futex_wait_space(uintptr_t space, volatile uint32_t* addr,
+                                         uint32_t expected, uint64_t timeout_ns) {
+    uintptr_t key = (uintptr_t)addr;
+    kos_wait_queue_t* bucket = kos_futex_bucket(space, key);
+    uint64_t deadline = timeout_ns ? kos_wait_deadline(timeout_ns) : 0;
+    kos_wait_entry_t entry;
+    kos_result_t result;
+
+    kos_wait_entry_init(&entry, KOS_WAIT_EXCLUSIVE, key);
+    entry.space = space;
+    kos_wait_prepare(bucket, &entry);
+
+    // Queued before the check, a wake after the waker's store finds us
+    if (__atomic_load_n(addr, __ATOMIC_ACQUIRE) != expected) {
+        result = KOS_ERROR_INVALID_STATE;
+    } else {
+        result = kos_wait_schedule(&entry, deadline);
+    }
+
+    kos_wait_finish(bucket, &entry);
+    return result;
+}
+
+// Wake up to nr waiters on (space, addr)
+static uint32_t kos_futex_wake_space(uintptr_t space, volatile uint32_t* addr, uint32_t nr) {
+    // No lockless empty check: the waiter's queueing and our caller's store
+    // could pass each other, the bucket lock orders them
+    uintptr_t key = (uintptr_t)addr;
+    return kos_wake_up_space(kos_futex_bucket(space, key), space, key, nr);
+}
+
+// Sleep while *addr == expected, on a kernel word
+kos_result_t kos_futex_wait(volatile uint32_t* addr, uint32_t expected, uint64_t timeout_ns) {
+    if (!addr || ((uintptr_t)addr & (sizeof(uint32_t) - 1))) {
+        return KOS_ERROR_INVALID_PARAM;
+    }
+
+    return kos_futex_wait_space(0, addr, expected, timeout_ns);
+}
+
+// Wake up to nr waiters on a kernel word
+uint32_t kos_futex_wake(volatile uint32_t* addr, uint32_t nr) {
+    if (!addr || nr == 0) {
+        return 0;
+    }
+
+    return kos_futex_wake_space(0, addr, nr);
+}
+
+// futex(addr, op, val, timeout_ns), addr is a word in the caller's address space
+int64_t kos_sys_futex(uint64_t a0, uint64_t a1, uint64_t a2, uint64_t a3, uint64_t a4, uint64_t a5) {
+    (void)a4; (void)a5;
+
+    if (a0 == 0 || !kos_user_access_ok(a0, sizeof(uint32_t), sizeof(uint32_t))) {
+        return KOS_ERROR_INVALID_PARAM;
+    }
+
+    volatile uint32_t* addr = (volatile uint32_t*)(uintptr_t)a0;
+    uintptr_t space = kos_futex_user_space();
+
+    switch (a1) {
+        case KOS_FUTEX_WAIT:
+            return kos_futex_wait_space(space, addr, (uint32_t)a2, a3);
+        case KOS_FUTEX_WAKE:
+            return a2 ? kos_futex_wake_space(space, addr, (uint32_t)a2) : 0;
+        default:
+            return KOS_ERROR_INVALID_PARAM;
+    }
+}
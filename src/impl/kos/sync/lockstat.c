@@ -0,0 +1,185 @@
+#include "kos/sync/lockstat.h"
+#include "kos/utils/string.h"
+#include "debug/debug.h"
+
+// =============================================================================
+// KOS - Lock Statistics Implementation
+// =============================================================================
+
+#define KOS_LOCKSTAT_EMPTY      0
+#define KOS_LOCKSTAT_CLAIMING   1
+#define KOS_LOCKSTAT_READY      2
+
+// Classes shown by the dump, busiest first
+#define KOS_LOCKSTAT_DUMP_MAX   16
+
+volatile bool g_lockstat_enabled = KOS_FEATURE_LOCKSTAT;
+
+// Open-addressed, classes are never removed so lookups need no lock
+static kos_lockstat_class_t g_lockstat_classes[KOS_LOCKSTAT_CLASSES];
+static volatile uint64_t g_lockstat_overflow;
+
+// Raise *max to value
+static inline void kos_lockstat_update_max(volatile uint64_t* max, uint64_t value) {
+    uint64_t old = __atomic_load_n(max, __ATOMIC_RELAXED);
+    while (value > old &&
+           !__atomic_compare_exchange_n(max, &old, value, true, __ATOMIC_RELAXED, __ATOMIC_RELAXED)) {
+    }
+}
+
+static inline uint32_t kos_lockstat_hash(const char* name, const char* file, uint32_t line) {
+    uint64_t key = (uint64_t)(uintptr_t)name * 0x9E3779B97F4A7C15ULL;
+    key ^= (uint64_t)(uintptr_t)file + line;
+    key *= 0xBF58476D1CE4E5B9ULL;
+    return (uint32_t)(key >> 32) & (KOS_LOCKSTAT_CLASSES - 1);
+}
+
+// Find or create the class of a lock name at a site, NULL once the table is full
+static kos_lockstat_class_t* kos_lockstat_lookup(const char* name, const char* file, uint32_t line) {
+    uint32_t index = kos_lockstat_hash(name, file, line);
+
+    for (uint32_t probe = 0; probe < KOS_LOCKSTAT_CLASSES; probe++) {
+        kos_lockstat_class_t* class = &g_lockstat_classes[(index + probe) & (KOS_LOCKSTAT_CLASSES - 1)];
+        uint32_t state = __atomic_load_n(&class->state, __ATOMIC_ACQUIRE);
+
+        if (state == KOS_LOCKSTAT_EMPTY) {
+            if (__atomic_compare_exchange_n(&class->state, &state, KOS_LOCKSTAT_CLAIMING, false,
+                                            __ATOMIC_ACQUIRE, __ATOMIC_ACQUIRE)) {
+                class->name = name;
+                class->file = file;
+                class->line = line;
+                __atomic_store_n(&class->state, KOS_LOCKSTAT_READY, __ATOMIC_RELEASE);
+                return class;
+            }
+        }
+
+        // Another CPU is filling this slot in
+        while (state == KOS_LOCKSTAT_CLAIMING) {
+            asm volatile("pause");
+            state = __atomic_load_n(&class->state, __ATOMIC_ACQUIRE);
+        }
+
+        if (class->name == name && class->file == file && class->line == line) {
+            return class;
+        }
+    }
+
+    __atomic_fetch_add(&g_lockstat_overflow, 1, __ATOMIC_RELAXED);
+    return NULL;
+}
+
+// Account one acquisition, exclusive holds are timed until release
+void kos_lockstat_acquired(kos_lockstat_map_t* map, const char* file, uint32_t line,
+                           uint64_t wait_cycles, bool contended, bool exclusive) {
+    kos_lockstat_class_t* class = map->last;
+    if (!class || class->file != file || class->line != line || class->name != map->name) {
+        class = kos_lockstat_lookup(map->name, file, line);
+        if (!class) {
+            return;
+        }
+        map->last = class;
+    }
+
+    __atomic_fetch_add(&class->acquisitions, 1, __ATOMIC_RELAXED);
+    if (contended) {
+        __atomic_fetch_add(&class->contended, 1, __ATOMIC_RELAXED);
+        __atomic_fetch_add(&class->wait_cycles, wait_cycles, __ATOMIC_RELAXED);
+        kos_lockstat_update_max(&class->max_wait_cycles, wait_cycles);
+    }
+
+    if (exclusive) {
+        map->holder = class;
+        map->acquired_at = kos_lockstat_cycles();
+    }
+}
+
+// Account the hold time, called while the lock is still held
+void kos_lockstat_released(kos_lockstat_map_t* map) {
+    kos_lockstat_class_t* class = map->holder;
+    if (!class) {
+        return;
+    }
+
+    uint64_t held = kos_lockstat_cycles() - map->acquired_at;
+    map->holder = NULL;
+
+    __atomic_fetch_add(&class->hold_cycles, held, __ATOMIC_RELAXED);
+    kos_lockstat_update_max(&class->max_hold_cycles, held);
+}
+
+// Turn recording on or off, a no-op when compiled out
+void kos_lockstat_enable(bool enable) {
+    g_lockstat_enabled = KOS_FEATURE_LOCKSTAT && enable;
+}
+
+bool kos_lockstat_is_compiled(void) {
+    return KOS_FEATURE_LOCKSTAT;
+}
+
+// Zero the counters, classes stay registered
+void kos_lockstat_reset(void) {
+    for (uint32_t i = 0; i < KOS_LOCKSTAT_CLASSES; i++) {
+        kos_lockstat_class_t* class = &g_lockstat_classes[i];
+        class->acquisitions = 0;
+        class->contended = 0;
+        class->wait_cycles = 0;
+        class->max_wait_cycles = 0;
+        class->hold_cycles = 0;
+        class->max_hold_cycles = 0;
+    }
+    g_lockstat_overflow = 0;
+}
+
+// Copy out the used classes, most total wait first
+uint32_t kos_lockstat_snapshot(kos_lockstat_class_t* out, uint32_t max) {
+    if (!out || max == 0) {
+        return 0;
+    }
+
+    uint32_t count = 0;
+    for (uint32_t i = 0; i < KOS_LOCKSTAT_CLASSES; i++) {
+        const kos_lockstat_class_t* class = &g_lockstat_classes[i];
+        if (__atomic_load_n(&class->state, __ATOMIC_ACQUIRE) != KOS_LOCKSTAT_READY ||
+            class->acquisitions == 0) {
+            continue;
+        }
+
+        // Insertion sort, keeping the max busiest
+        uint32_t pos = count < max ? count++ : max;
+        while (pos > 0 && out[pos - 1].wait_cycles < class->wait_cycles) {
+            if (pos < max) {
+                out[pos] = out[pos - 1];
+            }
+            pos--;
+        }
+        if (pos < max) {
+            kos_memcpy(&out[pos], class, sizeof(kos_lockstat_class_t));
+        }
+    }
+
+    return count;
+}
+
+void kos_lockstat_dump(void) {
+    if (!KOS_FEATURE_LOCKSTAT) {
+        log_info("Lock statistics not compiled in (KOS_FEATURE_LOCKSTAT)");
+        return;
+    }
+
+    kos_lockstat_class_t classes[KOS_LOCKSTAT_DUMP_MAX];
+    uint32_t count = kos_lockstat_snapshot(classes, KOS_LOCKSTAT_DUMP_MAX);
+
+    log_info("=== Lock Statistics (%s) ===", g_lockstat_enabled ? "on" : "off");
+    for (uint32_t i = 0; i < count; i++) {
+        const kos_lockstat_class_t* class = &classes[i];
+        log_info("  %s at %s:%u", class->name ? class->name : "(unnamed)", class->file, class->line);
+        log_info("    acquired %u, contended %u", (uint32_t)class->acquisitions, (uint32_t)class->contended);
+        log_info("    wait %u kcycles, max %u cycles", (uint32_t)(class->wait_cycles / 1000),
+                 (uint32_t)class->max_wait_cycles);
+        log_info("    hold %u kcycles, max %u cycles", (uint32_t)(class->hold_cycles / 1000),
+                 (uint32_t)class->max_hold_cycles);
+    }
+    if (g_lockstat_overflow) {
+        log_info("  %u acquisitions not recorded, class table full", (uint32_t)g_lockstat_overflow);
+    }
+}
@@ -0,0 +1,148 @@
+#include "kos/sync/rcu.h"
+#include "kos/sync/spinlock.h"
+#include "kos/cpu/percpu.h"
+#include "kos/cpu/ipi.h"
+#include "kos/time/clock.h"
+#include "kos/utils/string.h"
+#include "debug/debug.h"
+
+// =============================================================================
+// KOS - Read-Copy-Update Implementation
+// =============================================================================
+
+// Number of the newest grace period, every CPU copies it on a quiescent state
+static volatile uint64_t g_rcu_gp_seq;
+
+// call_rcu pushes here from any context
+static kos_rcu_head_t* volatile g_rcu_pending;
+
+// Callbacks waiting for g_rcu_waiting_seq to end, owned by g_rcu_cb_lock
+static kos_spinlock_t g_rcu_cb_lock = KOS_SPINLOCK_INIT;
+static kos_rcu_head_t* g_rcu_waiting;
+static uint64_t g_rcu_waiting_seq;
+
+static kos_rcu_stats_t g_rcu_stats;
+
+// Start a grace period and wake idle CPUs so they report promptly
+static uint64_t kos_rcu_gp_start(void) {
+    uint64_t seq = __atomic_add_fetch(&g_rcu_gp_seq, 1, __ATOMIC_ACQ_REL);
+    uint32_t self = kos_this_cpu()->cpu_id;
+
+    for (uint32_t cpu = 0; cpu < kos_percpu_count(); cpu++) {
+        kos_cpu_local_t* local = kos_percpu_get(cpu);
+        if (cpu != self && local->online &&
+            __atomic_load_n(&local->rcu_qs_seq, __ATOMIC_ACQUIRE) < seq) {
+            kos_smp_send_reschedule(cpu);
+        }
+    }
+
+    __atomic_fetch_add(&g_rcu_stats.grace_periods, 1, __ATOMIC_RELAXED);
+    return seq;
+}
+
+// Whether every online CPU has passed a quiescent state since seq began
+static bool kos_rcu_gp_done(uint64_t seq) {
+    for (uint32_t cpu = 0; cpu < kos_percpu_count(); cpu++) {
+        kos_cpu_local_t* local = kos_percpu_get(cpu);
+        if (local->online && __atomic_load_n(&local->rcu_qs_seq, __ATOMIC_ACQUIRE) < seq) {
+            return false;
+        }
+    }
+    return true;
+}
+
+// Report a quiescent state, the caller holds no RCU references
+void kos_rcu_quiescent(void) {
+    kos_cpu_local_t* cpu = kos_this_cpu();
+    uint64_t seq = __atomic_load_n(&g_rcu_gp_seq, __ATOMIC_ACQUIRE);
+
+    // Only write our line when a grace period is waiting on it
+    if (cpu->rcu_qs_seq != seq) {
+        __atomic_store_n(&cpu->rcu_qs_seq, seq, __ATOMIC_RELEASE);
+    }
+}
+
+// Wait until every reader that might see removed data has finished.
+// Needs interrupts enabled and must not be called inside a read section.
+void kos_synchronize_rcu(void) {
+    // Before per-CPU setup there is only the boot CPU and no readers
+    if (kos_percpu_count() == 0) {
+        return;
+    }
+
+    uint64_t start = kos_clock_monotonic_ns();
+    uint64_t seq = kos_rcu_gp_start();
+
+    kos_rcu_quiescent();
+    while (!kos_rcu_gp_done(seq)) {
+        asm volatile("pause");
+    }
+
+    uint64_t waited = kos_clock_monotonic_ns() - start;
+    __atomic_fetch_add(&g_rcu_stats.synchronize_calls, 1, __ATOMIC_RELAXED);
+    if (waited > g_rcu_stats.max_gp_ns) {
+        g_rcu_stats.max_gp_ns = waited;
+    }
+}
+
+// Run func(head) after a grace period, safe from any context
+void kos_call_rcu(kos_rcu_head_t* head, kos_rcu_fn_t func) {
+    if (!head || !func) {
+        return;
+    }
+
+    head->func = func;
+    head->next = __atomic_load_n(&g_rcu_pending, __ATOMIC_RELAXED);
+    while (!__atomic_compare_exchange_n(&g_rcu_pending, &head->next, head, true,
+                                        __ATOMIC_RELEASE, __ATOMIC_RELAXED)) {
+    }
+    __atomic_fetch_add(&g_rcu_stats.callbacks_queued, 1, __ATOMIC_RELAXED);
+}
+
+// Advance deferred frees, called from the idle loop after kos_rcu_quiescent
+void kos_rcu_process_callbacks(void) {
+    if (!__atomic_load_n(&g_rcu_pending, __ATOMIC_RELAXED) && !g_rcu_waiting) {
+        return;
+    }
+
+    // One CPU at a time, the others just keep reporting quiescent states
+    if (!kos_spin_trylock(&g_rcu_cb_lock)) {
+        return;
+    }
+
+    kos_rcu_head_t* ready = NULL;
+    if (g_rcu_waiting && kos_rcu_gp_done(g_rcu_waiting_seq)) {
+        ready = g_rcu_waiting;
+        g_rcu_waiting = NULL;
+    }
+    if (!g_rcu_waiting && __atomic_load_n(&g_rcu_pending, __ATOMIC_RELAXED)) {
+        g_rcu_waiting = __atomic_exchange_n(&g_rcu_pending, NULL, __ATOMIC_ACQUIRE);
+        g_rcu_waiting_seq = kos_rcu_gp_start();
+    }
+
+    kos_spin_unlock(&g_rcu_cb_lock);
+
+    while (ready) {
+        kos_rcu_head_t* next = ready->next;
+        ready->func(ready);
+        ready = next;
+        __atomic_fetch_add(&g_rcu_stats.callbacks_run, 1, __ATOMIC_RELAXED);
+    }
+}
+
+void kos_rcu_get_stats(kos_rcu_stats_t* stats) {
+    if (!stats) {
+        return;
+    }
+
+    kos_memcpy(stats, &g_rcu_stats, sizeof(kos_rcu_stats_t));
+}
+
+void kos_rcu_dump_stats(void) {
+    log_info("=== RCU Statistics ===");
+    log_info("  Grace periods: %u (now %u)", (uint32_t)g_rcu_stats.grace_periods, (uint32_t)g_rcu_gp_seq);
+    log_info("  Synchronize calls: %u, max wait %u us", (uint32_t)g_rcu_stats.synchronize_calls,
+             (uint32_t)(g_rcu_stats.max_gp_ns / 1000));
+    log_info("  Callbacks: %u queued, %u run", (uint32_t)g_rcu_stats.callbacks_queued,
+             (uint32_t)g_rcu_stats.callbacks_run);
+}
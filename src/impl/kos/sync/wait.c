@@ -0,0 +1,308 @@
+#include "kos/sync/wait.h"
+#include "kos/cpu/percpu.h"
+#include "kos/cpu/ipi.h"
+#include "kos/cpu/irqflags.h"
+#include "kos/interrupts/softirq.h"
+#include "kos/process/process.h"
+#include "kos/time/clock.h"
+#include "kos/time/timer.h"
+#include "debug/debug.h"
+
+// =============================================================================
+// KOS - Wait Queue Implementation
+// =============================================================================
+
+static kos_wait_stats_t g_wait_stats;
+
+// Make a waiter's process runnable and get its CPU out of HLT
+static void kos_wait_kick(kos_process_t* process, uint32_t cpu) {
+    if (process) {
+        kos_process_wake(process);
+    }
+
+    if (kos_percpu_count() && cpu != kos_this_cpu_id()) {
+        kos_smp_send_reschedule(cpu);
+    }
+}
+
+// Unlink an entry, queue lock held
+static void kos_wait_unlink(kos_wait_queue_t* wq, kos_wait_entry_t* entry) {
+    if (entry->prev) {
+        entry->prev->next = entry->next;
+    } else {
+        wq->head = entry->next;
+    }
+
+    if (entry->next) {
+        entry->next->prev = entry->prev;
+    } else {
+        wq->tail = entry->prev;
+    }
+
+    entry->next = NULL;
+    entry->prev = NULL;
+    entry->queued = false;
+}
+
+// Timer callback, ends a timed wait
+static void kos_wait_timeout(void* context) {
+    kos_wait_entry_t* entry = (kos_wait_entry_t*)context;
+
+    __atomic_store_n(&entry->timed_out, true, __ATOMIC_RELEASE);
+    __atomic_thread_fence(__ATOMIC_SEQ_CST);
+    kos_wait_kick(__atomic_load_n(&entry->process, __ATOMIC_RELAXED), entry->cpu);
+}
+
+// Halt until the next interrupt. CPU 0 runs due timers on the way, the
+// system wheel is not run from APs and their timeouts arrive as an IPI.
+static void kos_wait_halt(kos_wait_entry_t* entry) {
+    kos_local_irq_disable();
+
+    if (entry->cpu == 0 && kos_timer_work_pending()) {
+        kos_local_irq_enable();
+        kos_timer_run();
+        return;
+    }
+
+    if (entry->woken || entry->timed_out) {
+        kos_local_irq_enable();
+        return;
+    }
+
+    // sti delays interrupts by one instruction, so no wakeup is lost
+    asm volatile("sti; hlt" : : : "memory");
+}
+
+// Initialize a queue
+void kos_wait_queue_init_named(kos_wait_queue_t* wq, const char* name) {
+    if (!wq) {
+        return;
+    }
+
+    kos_spin_init_named(&wq->lock, name);
+    wq->head = NULL;
+    wq->tail = NULL;
+}
+
+// Check for waiters without taking the lock, a hint only
+bool kos_wait_queue_active(kos_wait_queue_t* wq) {
+    return wq && __atomic_load_n(&wq->head, __ATOMIC_RELAXED) != NULL;
+}
+
+// Initialize an entry before its first kos_wait_prepare
+void kos_wait_entry_init(kos_wait_entry_t* entry, uint32_t flags, uintptr_t key) {
+    entry->next = NULL;
+    entry->prev = NULL;
+    entry->process = NULL;
+    entry->cpu = 0;
+    entry->flags = flags;
+    entry->key = key;
+    entry->space = 0;
+    entry->wake_ns = 0;
+    entry->queued = false;
+    entry->woken = false;
+    entry->timed_out = false;
+}
+
+// Queue an entry if a wakeup took it off, the caller checks its condition next
+void kos_wait_prepare(kos_wait_queue_t* wq, kos_wait_entry_t* entry) {
+    uint64_t flags = kos_spin_lock_irqsave(&wq->lock);
+
+    entry->woken = false;
+    if (!entry->queued) {
+        if (entry->flags & KOS_WAIT_EXCLUSIVE) {
+            entry->next = NULL;
+            entry->prev = wq->tail;
+            if (wq->tail) {
+                wq->tail->next = entry;
+            } else {
+                wq->head = entry;
+            }
+            wq->tail = entry;
+        } else {
+            entry->prev = NULL;
+            entry->next = wq->head;
+            if (wq->head) {
+                wq->head->prev = entry;
+            } else {
+                wq->tail = entry;
+            }
+            wq->head = entry;
+        }
+        entry->queued = true;
+    }
+
+    kos_spin_unlock_irqrestore(&wq->lock, flags);
+
+    // Order the queueing before the condition check, unlock is only a store
+    __atomic_thread_fence(__ATOMIC_SEQ_CST);
+}
+
+// Block until the entry is woken or the deadline passes, 0 means no deadline.
+// Returns KOS_ERROR_INVALID_STATE where sleeping is not allowed, the caller
+// then just re-checks its condition.
+kos_result_t kos_wait_schedule(kos_wait_entry_t* entry, uint64_t deadline_ns) {
+    // Checked first so callers that can only poll still time out
+    if (deadline_ns && kos_clock_monotonic_ns() >= deadline_ns) {
+        __atomic_fetch_add(&g_wait_stats.timeouts, 1, __ATOMIC_RELAXED);
+        return KOS_ERROR_TIMEOUT;
+    }
+
+    if (kos_in_interrupt() || !kos_local_irq_enabled()) {
+        return KOS_ERROR_INVALID_STATE;
+    }
+
+    if (entry->woken) {
+        return KOS_SUCCESS;
+    }
+
+    kos_timer_t timer;
+    kos_process_t* current = NULL;
+
+    entry->timed_out = false;
+    entry->cpu = kos_this_cpu_id();
+    kos_process_get_current(&current);
+
+    if (deadline_ns) {
+        kos_timer_init(&timer, kos_wait_timeout, entry);
+        if (kos_timer_add(&timer, deadline_ns) != KOS_SUCCESS) {
+            entry->timed_out = true;
+        }
+    }
+
+    __atomic_fetch_add(&g_wait_stats.waits, 1, __ATOMIC_RELAXED);
+
+    // Block the process so others run, or halt where there is none to block.
+    // A stale wake can end a block early, so block again until woken.
+    bool can_block = current != NULL;
+    while (!entry->woken && !entry->timed_out) {
+        if (can_block) {
+            uint64_t flags = kos_local_irq_save();
+
+            // Checked with interrupts off, a wake before the block is kept
+            // by the process manager and ends the block at once
+            if (!entry->woken && !entry->timed_out && current->state == KOS_PROCESS_STATE_RUNNING) {
+                // Publish the process, then check again. Wakers store their
+                // flag before loading the process, so with a full fence on
+                // both sides either they see the process or we see the flag.
+                __atomic_store_n(&entry->process, current, __ATOMIC_RELAXED);
+                __atomic_thread_fence(__ATOMIC_SEQ_CST);
+                if (!entry->woken && !entry->timed_out) {
+                    can_block = kos_process_block() == HAL_SUCCESS;
+                    if (!can_block) {
+                        __atomic_store_n(&entry->process, NULL, __ATOMIC_RELEASE);
+                    }
+                }
+            }
+
+            kos_local_irq_restore(flags);
+            if (can_block) {
+                continue;
+            }
+        }
+
+        kos_wait_halt(entry);
+    }
+
+    // The timer lives on this stack, a callback still running must finish first
+    if (deadline_ns) {
+        kos_timer_cancel_sync(&timer);
+    }
+
+    if (__atomic_load_n(&entry->woken, __ATOMIC_ACQUIRE)) {
+        uint64_t latency = kos_clock_monotonic_ns() - entry->wake_ns;
+        if (latency > g_wait_stats.max_wake_ns) {
+            g_wait_stats.max_wake_ns = latency;
+        }
+        return KOS_SUCCESS;
+    }
+
+    __atomic_fetch_add(&g_wait_stats.timeouts, 1, __ATOMIC_RELAXED);
+    return KOS_ERROR_TIMEOUT;
+}
+
+// Take the entry off the queue for good. Always locks, a waker may still be
+// writing to an entry it has just unlinked.
+void kos_wait_finish(kos_wait_queue_t* wq, kos_wait_entry_t* entry) {
+    uint64_t flags = kos_spin_lock_irqsave(&wq->lock);
+
+    if (entry->queued) {
+        kos_wait_unlink(wq, entry);
+    }
+
+    kos_spin_unlock_irqrestore(&wq->lock, flags);
+}
+
+// Absolute deadline for a relative timeout, never 0
+uint64_t kos_wait_deadline(uint64_t timeout_ns) {
+    uint64_t deadline = kos_clock_monotonic_ns() + timeout_ns;
+    return deadline ? deadline : 1;
+}
+
+// Wake every plain waiter and up to nr_exclusive exclusive ones whose space
+// and key match, KOS_WAIT_KEY_ANY matches all
+uint32_t kos_wake_up_space(kos_wait_queue_t* wq, uintptr_t space, uintptr_t key, uint32_t nr_exclusive) {
+    if (!wq) {
+        return 0;
+    }
+
+    uint32_t woken = 0;
+    uint64_t now = kos_clock_monotonic_ns();
+    uint64_t flags = kos_spin_lock_irqsave(&wq->lock);
+
+    kos_wait_entry_t* entry = wq->head;
+    while (entry) {
+        kos_wait_entry_t* next = entry->next;
+
+        if (key != KOS_WAIT_KEY_ANY && (entry->key != key || entry->space != space)) {
+            entry = next;
+            continue;
+        }
+
+        // Exclusive waiters are all behind the plain ones
+        if (entry->flags & KOS_WAIT_EXCLUSIVE) {
+            if (nr_exclusive == 0) {
+                break;
+            }
+            if (nr_exclusive != KOS_WAKE_ALL) {
+                nr_exclusive--;
+            }
+        }
+
+        kos_wait_unlink(wq, entry);
+        entry->wake_ns = now;
+
+        // Flag first and process second, pairs with the fence in kos_wait_schedule
+        __atomic_store_n(&entry->woken, true, __ATOMIC_RELEASE);
+        __atomic_thread_fence(__ATOMIC_SEQ_CST);
+        kos_wait_kick(__atomic_load_n(&entry->process, __ATOMIC_RELAXED), entry->cpu);
+
+        woken++;
+        entry = next;
+    }
+
+    kos_spin_unlock_irqrestore(&wq->lock, flags);
+
+    if (woken) {
+        __atomic_fetch_add(&g_wait_stats.wakeups, woken, __ATOMIC_RELAXED);
+    }
+    return woken;
+}
+
+// Get wait statistics
+void kos_wait_get_stats(kos_wait_stats_t* stats) {
+    if (!stats) {
+        return;
+    }
+
+    *stats = g_wait_stats;
+}
+
+// Dump wait statistics
+void kos_wait_dump_stats(void) {
+    log_info("=== Wait Queue Statistics ===");
+    log_info("Waits: %u, Wakeups: %u, Timeouts: %u",
+             (uint32_t)g_wait_stats.waits, (uint32_t)g_wait_stats.wakeups,
+             (uint32_t)g_wait_stats.timeouts);
+    log_info("Max wake latency: %d ns", (int)g_wait_stats.max_wake_ns);
+}
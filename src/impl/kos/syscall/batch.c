@@ -0,0 +1,192 @@
+#include "kos/syscall/batch.h"
+#include "kos/syscall/syscall.h"
+#include "kos/drivers/driver_framework.h"
+#include "kos/utils/string.h"
+
+// =============================================================================
+// KOS - Batched System Call Implementation
+// =============================================================================
+
+static kos_syscall_batch_stats_t g_batch_stats;
+
+// Driver results come back as HAL codes, the syscall ABI speaks kos_result_t
+static int64_t kos_syscall_from_hal(hal_result_t result) {
+    switch (result) {
+        case HAL_SUCCESS:
+            return KOS_SUCCESS;
+        case HAL_ERROR_INVALID_PARAM:
+            return KOS_ERROR_INVALID_PARAM;
+        case HAL_ERROR_NOT_SUPPORTED:
+            return KOS_ERROR_NOT_IMPLEMENTED;
+        case HAL_ERROR_OUT_OF_MEMORY:
+            return KOS_ERROR_OUT_OF_MEMORY;
+        case HAL_ERROR_HARDWARE:
+            return KOS_ERROR_IO_ERROR;
+        case HAL_ERROR_TIMEOUT:
+            return KOS_ERROR_TIMEOUT;
+        default:
+            return KOS_ERROR_INVALID_STATE;
+    }
+}
+
+// Run one device operation, shared by the single calls and the batch.
+// The last device looked up is cached for the length of one kernel entry,
+// so a batch aimed at one device walks the device list once.
+static int64_t kos_syscall_device_op(kos_batch_op_t* op, kos_device_t** cache) {
+    if (op->opcode == KOS_BATCH_OP_NOP) {
+        return KOS_SUCCESS;
+    }
+
+    kos_device_t* device = *cache;
+    if (!device || device->info.device_id != op->device_id) {
+        device = kos_device_find_by_id(op->device_id);
+        if (!device) {
+            return KOS_ERROR_NOT_FOUND;
+        }
+        *cache = device;
+    }
+
+    size_t transferred = 0;
+    hal_result_t result;
+    switch (op->opcode) {
+        case KOS_BATCH_OP_READ:
+            result = kos_device_read(device, (void*)(uintptr_t)op->buffer, (size_t)op->size, &transferred);
+            break;
+        case KOS_BATCH_OP_WRITE:
+            result = kos_device_write(device, (const void*)(uintptr_t)op->buffer, (size_t)op->size, &transferred);
+            break;
+        case KOS_BATCH_OP_IOCTL:
+            result = kos_device_ioctl(device, op->request, (void*)(uintptr_t)op->buffer);
+            break;
+        default:
+            return KOS_ERROR_INVALID_PARAM;
+    }
+
+    if (result != HAL_SUCCESS) {
+        return kos_syscall_from_hal(result);
+    }
+    return (int64_t)transferred;
+}
+
+// Check the buffer of an op that came from user space
+static bool kos_syscall_user_op_ok(const kos_batch_op_t* op) {
+    switch (op->opcode) {
+        case KOS_BATCH_OP_READ:
+        case KOS_BATCH_OP_WRITE:
+            return kos_user_access_ok(op->buffer, op->size, 1);
+        case KOS_BATCH_OP_IOCTL:
+            // The argument may be a plain value, only its address is checked
+            return kos_user_access_ok(op->buffer, 0, 1);
+        default:
+            return true;
+    }
+}
+
+// Run a batch held in kernel memory, user buffers are checked op by op
+static int64_t kos_syscall_batch_run(kos_batch_op_t* ops, uint32_t count, bool user) {
+    g_batch_stats.batches++;
+
+    kos_device_t* cache = NULL;
+    int64_t executed = 0;
+    bool cancel = false;
+    for (uint32_t i = 0; i < count; i++) {
+        kos_batch_op_t* op = &ops[i];
+        bool linked = (op->flags & KOS_BATCH_F_LINK) != 0;
+
+        if (cancel) {
+            op->result = KOS_SYSCALL_BATCH_CANCELLED;
+            g_batch_stats.cancelled++;
+            cancel = linked;
+            continue;
+        }
+
+        if (user && !kos_syscall_user_op_ok(op)) {
+            op->result = KOS_ERROR_INVALID_PARAM;
+        } else {
+            op->result = kos_syscall_device_op(op, &cache);
+        }
+        executed++;
+
+        if (op->result < 0) {
+            g_batch_stats.failed++;
+            cancel = linked;
+        }
+    }
+
+    g_batch_stats.ops += (uint64_t)executed;
+    return executed;
+}
+
+// Run a batch of kernel ops, returns the number of ops that ran (failed ones included)
+int64_t kos_syscall_batch_submit(kos_batch_op_t* ops, uint32_t count) {
+    if (!ops || count == 0 || count > KOS_SYSCALL_BATCH_MAX) {
+        return KOS_ERROR_INVALID_PARAM;
+    }
+
+    return kos_syscall_batch_run(ops, count, false);
+}
+
+// Get batch statistics
+void kos_syscall_batch_get_stats(kos_syscall_batch_stats_t* stats) {
+    if (!stats) {
+        return;
+    }
+
+    *stats = g_batch_stats;
+}
+
+// read(device_id, buffer, size)
+int64_t kos_sys_device_read(uint64_t a0, uint64_t a1, uint64_t a2, uint64_t a3, uint64_t a4, uint64_t a5) {
+    (void)a3; (void)a4; (void)a5;
+    kos_batch_op_t op = { .opcode = KOS_BATCH_OP_READ, .device_id = (uint32_t)a0, .buffer = a1, .size = a2 };
+    kos_device_t* cache = NULL;
+    if (!kos_syscall_user_op_ok(&op)) {
+        return KOS_ERROR_INVALID_PARAM;
+    }
+    return kos_syscall_device_op(&op, &cache);
+}
+
+// write(device_id, buffer, size)
+int64_t kos_sys_device_write(uint64_t a0, uint64_t a1, uint64_t a2, uint64_t a3, uint64_t a4, uint64_t a5) {
+    (void)a3; (void)a4; (void)a5;
+    kos_batch_op_t op = { .opcode = KOS_BATCH_OP_WRITE, .device_id = (uint32_t)a0, .buffer = a1, .size = a2 };
+    kos_device_t* cache = NULL;
+    if (!kos_syscall_user_op_ok(&op)) {
+        return KOS_ERROR_INVALID_PARAM;
+    }
+    return kos_syscall_device_op(&op, &cache);
+}
+
+// ioctl(device_id, request, arg)
+int64_t kos_sys_device_ioctl(uint64_t a0, uint64_t a1, uint64_t a2, uint64_t a3, uint64_t a4, uint64_t a5) {
+    (void)a3; (void)a4; (void)a5;
+    kos_batch_op_t op = { .opcode = KOS_BATCH_OP_IOCTL, .device_id = (uint32_t)a0, .request = (uint32_t)a1, .buffer = a2 };
+    kos_device_t* cache = NULL;
+    if (!kos_syscall_user_op_ok(&op)) {
+        return KOS_ERROR_INVALID_PARAM;
+    }
+    return kos_syscall_device_op(&op, &cache);
+}
+
+// batch(ops, count). The ops are copied in before anything runs, so the
+// caller cannot change them under the checks, and the results go back at the end.
+int64_t kos_sys_batch(uint64_t a0, uint64_t a1, uint64_t a2, uint64_t a3, uint64_t a4, uint64_t a5) {
+    (void)a2; (void)a3; (void)a4; (void)a5;
+    uint32_t count = (uint32_t)a1;
+
+    if (a0 == 0 || count == 0 || count > KOS_SYSCALL_BATCH_MAX ||
+        !kos_user_access_ok(a0, (uint64_t)count * sizeof(kos_batch_op_t), sizeof(uint64_t))) {
+        return KOS_ERROR_INVALID_PARAM;
+    }
+
+    kos_batch_op_t* user_ops = (kos_batch_op_t*)(uintptr_t)a0;
+    kos_batch_op_t ops[KOS_SYSCALL_BATCH_MAX];
+    kos_memcpy(ops, user_ops, count * sizeof(kos_batch_op_t));
+
+    int64_t executed = kos_syscall_batch_run(ops, count, true);
+
+    for (uint32_t i = 0; i < count; i++) {
+        user_ops[i].result = ops[i].result;
+    }
+    return executed;
+}
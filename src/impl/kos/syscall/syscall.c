@@ -0,0 +1,177 @@
+#include "kos/syscall/syscall.h"
+#include "kos/syscall/batch.h"
+#include "kos/sync/futex.h"
+#include "kos/process/process.h"
+#include "kos/time/clock.h"
+#include "kos/time/sleep.h"
+#include "kos/time/vdso.h"
+#include "kos/utils/string.h"
+#include "kos/cpu/counter.h"
+#include "debug/debug.h"
+
+// =============================================================================
+// KOS - System Call Implementation
+// =============================================================================
+
+typedef struct {
+    kos_syscall_fn_t handler;
+    const char* name;
+} kos_syscall_entry_t;
+
+static int64_t kos_sys_nop(uint64_t a0, uint64_t a1, uint64_t a2, uint64_t a3, uint64_t a4, uint64_t a5);
+static int64_t kos_sys_getpid(uint64_t a0, uint64_t a1, uint64_t a2, uint64_t a3, uint64_t a4, uint64_t a5);
+static int64_t kos_sys_clock_ns(uint64_t a0, uint64_t a1, uint64_t a2, uint64_t a3, uint64_t a4, uint64_t a5);
+static int64_t kos_sys_sleep_ns(uint64_t a0, uint64_t a1, uint64_t a2, uint64_t a3, uint64_t a4, uint64_t a5);
+static int64_t kos_sys_yield(uint64_t a0, uint64_t a1, uint64_t a2, uint64_t a3, uint64_t a4, uint64_t a5);
+static int64_t kos_sys_vdso_base(uint64_t a0, uint64_t a1, uint64_t a2, uint64_t a3, uint64_t a4, uint64_t a5);
+static int64_t kos_sys_exit(uint64_t a0, uint64_t a1, uint64_t a2, uint64_t a3, uint64_t a4, uint64_t a5);
+
+// Dispatch table, indexed by number
+static kos_syscall_entry_t g_syscall_table[KOS_SYSCALL_MAX] = {
+    [KOS_SYS_NOP]      = { kos_sys_nop,      "nop" },
+    [KOS_SYS_GETPID]   = { kos_sys_getpid,   "getpid" },
+    [KOS_SYS_CLOCK_NS] = { kos_sys_clock_ns, "clock_ns" },
+    [KOS_SYS_SLEEP_NS] = { kos_sys_sleep_ns, "sleep_ns" },
+    [KOS_SYS_YIELD]    = { kos_sys_yield,    "yield" },
+    [KOS_SYS_VDSO_BASE] = { kos_sys_vdso_base, "vdso_base" },
+    [KOS_SYS_DEVICE_READ]  = { kos_sys_device_read,  "device_read" },
+    [KOS_SYS_DEVICE_WRITE] = { kos_sys_device_write, "device_write" },
+    [KOS_SYS_DEVICE_IOCTL] = { kos_sys_device_ioctl, "device_ioctl" },
+    [KOS_SYS_BATCH]        = { kos_sys_batch,        "batch" },
+    [KOS_SYS_FUTEX]        = { kos_sys_futex,        "futex" },
+    [KOS_SYS_EXIT]         = { kos_sys_exit,         "exit" },
+};
+
+static kos_syscall_stats_t g_syscall_stats;
+
+KOS_COUNTER_DEFINE(syscall, syscalls);
+
+static int64_t kos_sys_nop(uint64_t a0, uint64_t a1, uint64_t a2, uint64_t a3, uint64_t a4, uint64_t a5) {
+    (void)a0; (void)a1; (void)a2; (void)a3; (void)a4; (void)a5;
+    return 0;
+}
+
+static int64_t kos_sys_getpid(uint64_t a0, uint64_t a1, uint64_t a2, uint64_t a3, uint64_t a4, uint64_t a5) {
+    (void)a0; (void)a1; (void)a2; (void)a3; (void)a4; (void)a5;
+    kos_process_t* current = NULL;
+    if (kos_process_get_current(&current) != HAL_SUCCESS || !current) {
+        return 0;
+    }
+    return current->pid;
+}
+
+static int64_t kos_sys_clock_ns(uint64_t a0, uint64_t a1, uint64_t a2, uint64_t a3, uint64_t a4, uint64_t a5) {
+    (void)a0; (void)a1; (void)a2; (void)a3; (void)a4; (void)a5;
+    return (int64_t)kos_clock_monotonic_ns();
+}
+
+static int64_t kos_sys_sleep_ns(uint64_t a0, uint64_t a1, uint64_t a2, uint64_t a3, uint64_t a4, uint64_t a5) {
+    (void)a1; (void)a2; (void)a3; (void)a4; (void)a5;
+    return kos_sleep_ns(a0);
+}
+
+static int64_t kos_sys_yield(uint64_t a0, uint64_t a1, uint64_t a2, uint64_t a3, uint64_t a4, uint64_t a5) {
+    (void)a0; (void)a1; (void)a2; (void)a3; (void)a4; (void)a5;
+    return kos_process_yield() == HAL_SUCCESS ? 0 : KOS_ERROR_INVALID_STATE;
+}
+
+static int64_t kos_sys_vdso_base(uint64_t a0, uint64_t a1, uint64_t a2, uint64_t a3, uint64_t a4, uint64_t a5) {
+    (void)a0; (void)a1; (void)a2; (void)a3; (void)a4; (void)a5;
+    kos_process_t* current = NULL;
+    if (kos_process_get_current(&current) == HAL_SUCCESS && current && current->memory.vdso_base) {
+        return (int64_t)current->memory.vdso_base;
+    }
+    return (int64_t)(uintptr_t)kos_vdso_get_page();
+}
+
+// exit(code), the frame on the process's kernel stack is never returned to
+static int64_t kos_sys_exit(uint64_t a0, uint64_t a1, uint64_t a2, uint64_t a3, uint64_t a4, uint64_t a5) {
+    (void)a1; (void)a2; (void)a3; (void)a4; (void)a5;
+    kos_process_exit((int32_t)a0);
+}
+
+// Install a handler for a free number
+kos_result_t kos_syscall_register(uint32_t nr, kos_syscall_fn_t handler, const char* name) {
+    if (nr >= KOS_SYSCALL_MAX || !handler) {
+        return KOS_ERROR_INVALID_PARAM;
+    }
+
+    if (g_syscall_table[nr].handler) {
+        return KOS_ERROR_INVALID_STATE;
+    }
+
+    g_syscall_table[nr].name = name ? name : "unnamed";
+    g_syscall_table[nr].handler = handler;
+    return KOS_SUCCESS;
+}
+
+// Common entry for SYSCALL and int 0x80, the return value goes back in RAX
+int64_t kos_syscall_dispatch(kos_syscall_frame_t* frame) {
+    uint64_t nr = frame->number;
+
+    if (nr >= KOS_SYSCALL_MAX || !g_syscall_table[nr].handler) {
+        g_syscall_stats.invalid++;
+        return KOS_ERROR_NOT_IMPLEMENTED;
+    }
+
+    kos_process_t* current = NULL;
+    if (kos_process_get_current(&current) == HAL_SUCCESS && current) {
+        current->stats.system_calls++;
+    }
+
+    uint64_t start = kos_clock_cycles();
+    int64_t result = g_syscall_table[nr].handler(frame->args[0], frame->args[1], frame->args[2],
+                                                 frame->args[3], frame->args[4], frame->args[5]);
+
+    g_syscall_stats.calls[nr]++;
+    g_syscall_stats.cycles[nr] += kos_clock_cycles() - start;
+    g_syscall_stats.total++;
+    kos_counter_inc(syscalls);
+    return result;
+}
+
+// Get a syscall's name
+const char* kos_syscall_get_name(uint32_t nr) {
+    if (nr >= KOS_SYSCALL_MAX || !g_syscall_table[nr].handler) {
+        return "invalid";
+    }
+    return g_syscall_table[nr].name;
+}
+
+// Get syscall statistics
+void kos_syscall_get_stats(kos_syscall_stats_t* stats) {
+    if (!stats) {
+        return;
+    }
+
+    *stats = g_syscall_stats;
+}
+
+// Reset syscall statistics
+void kos_syscall_reset_stats(void) {
+    kos_memset(&g_syscall_stats, 0, sizeof(kos_syscall_stats_t));
+}
+
+// Dump syscall statistics
+void kos_syscall_dump_stats(void) {
+    log_info("=== System Call Statistics ===");
+    log_info("Total: %u, Invalid: %u", (uint32_t)g_syscall_stats.total, (uint32_t)g_syscall_stats.invalid);
+    for (uint32_t nr = 0; nr < KOS_SYSCALL_MAX; nr++) {
+        if (g_syscall_stats.calls[nr] == 0) {
+            continue;
+        }
+        log_info("  %d %s: %u calls, %d ns avg in handler", nr, g_syscall_table[nr].name,
+                 (uint32_t)g_syscall_stats.calls[nr],
+                 (int)(kos_clock_cycles_to_ns(g_syscall_stats.cycles[nr]) / g_syscall_stats.calls[nr]));
+    }
+}
+
+// SYSCALL entry refused to return to a non-canonical RIP
+void kos_syscall_bad_return(kos_syscall_frame_t* frame) {
+    log_error("syscall %d: non-canonical return address %x:%x", (int)frame->number,
+              (uint32_t)(frame->rip >> 32), (uint32_t)frame->rip);
+    asm volatile("cli");
+    for (;;) {
+        asm volatile("hlt");
+    }
+}
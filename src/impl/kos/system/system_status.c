@@ -329,7 +329,7 @@ hal_result_t kos_system_status_show_system_info(void) {
     vga_write_string("│ Uptime: ");
     vga_set_color(KOS_VGA_COLOR_LIGHT_GRAY, KOS_VGA_COLOR_BLACK);
     
-    uint64_t uptime = hal_get_timestamp() - g_system_info.boot_time;
+    uint64_t uptime = (hal_get_timestamp() - g_system_info.boot_time) / 1000000; // ms
     if (uptime < 1000) {
         char uptime_str[32];
         hal_snprintf(uptime_str, sizeof(uptime_str), "%llu ms", uptime);
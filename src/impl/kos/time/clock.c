@@ -0,0 +1,263 @@
+#include "kos/time/clock.h"
+#include "kos/sync/seqlock.h"
+#include "kos/time/vdso.h"
+#include "kos/time/rtc.h"
+#include "hal/hal_tsc.h"
+#include "debug/debug.h"
+
+// =============================================================================
+// KOS - Monotonic Clock Implementation
+// =============================================================================
+
+// Timekeeping state, written under the sequence lock so that writers on
+// different CPUs serialize while readers only retry
+typedef struct {
+    kos_seqlock_t lock;
+    kos_clocksource_t* cs;
+    uint64_t mask;
+    uint32_t mult;
+    uint32_t shift;
+    uint64_t cycle_last;
+    uint64_t base_ns;
+    uint64_t base_frac;       // Sub-nanosecond remainder, scaled by 2^shift
+    uint64_t updates;
+} kos_clock_state_t;
+
+// Global clock state
+static kos_clock_state_t g_clock = { .lock = KOS_SEQLOCK_INIT };
+static bool g_clock_initialized = false;
+
+// Time page shared with processes, republished on every clock write
+static kos_vdso_time_t g_vdso_time = { .version = KOS_VDSO_VERSION, .mode = KOS_VDSO_MODE_NONE };
+
+// TSC cycle conversion for kos_clock_cycles() deltas
+static kos_clocksource_t* g_clock_tsc = NULL;
+static uint64_t g_clock_tsc_max_fast = 0;
+static uint32_t g_clock_ns_to_cycles_mult = 0;
+static uint32_t g_clock_ns_to_cycles_shift = 0;
+
+// Fold elapsed cycles into the base, caller holds the write side
+static void kos_clock_accumulate(void) {
+    uint64_t now = kos_clocksource_read(g_clock.cs);
+    uint64_t delta = (now - g_clock.cycle_last) & g_clock.mask;
+    uint64_t scaled = g_clock.base_frac + delta * g_clock.mult;
+
+    g_clock.base_ns += scaled >> g_clock.shift;
+    g_clock.base_frac = scaled & ((1ULL << g_clock.shift) - 1);
+    g_clock.cycle_last = now;
+    g_clock.updates++;
+}
+
+// Copy the clock state into the time page, caller holds the write side
+static void kos_clock_publish(void) {
+    g_vdso_time.sequence++;
+    kos_seq_barrier();
+
+    g_vdso_time.mode = (g_clock.cs == g_clock_tsc) ? KOS_VDSO_MODE_TSC : KOS_VDSO_MODE_SYSCALL;
+    g_vdso_time.mult = g_clock.mult;
+    g_vdso_time.shift = g_clock.shift;
+    g_vdso_time.mask = g_clock.mask;
+    g_vdso_time.cycle_last = g_clock.cycle_last;
+    g_vdso_time.base_ns = g_clock.base_ns;
+    g_vdso_time.base_frac = g_clock.base_frac;
+    g_vdso_time.tick_ns = g_clock.base_ns;
+
+    kos_seq_barrier();
+    g_vdso_time.sequence++;
+}
+
+// Initialize the monotonic clock on the best clocksource
+kos_result_t kos_clock_init(void) {
+    if (g_clock_initialized) {
+        return KOS_SUCCESS;
+    }
+
+    // Registers the TSC clocksource on first use
+    g_clock_tsc = hal_tsc_get_clocksource();
+    if (g_clock_tsc) {
+        g_clock_tsc_max_fast = g_clock_tsc->frequency * KOS_CLOCKSOURCE_MAX_DELTA_SEC;
+        kos_clocks_calc_mult_shift(&g_clock_ns_to_cycles_mult, &g_clock_ns_to_cycles_shift,
+                                   KOS_NSEC_PER_SEC, g_clock_tsc->frequency,
+                                   KOS_CLOCKSOURCE_MAX_DELTA_SEC);
+    }
+
+    kos_clocksource_t* cs = kos_clocksource_get_best();
+    if (!cs) {
+        log_error("Clock: no clocksource available");
+        return KOS_ERROR_NOT_FOUND;
+    }
+
+    g_clock_initialized = true;
+    kos_result_t result = kos_clock_select(cs);
+    if (result != KOS_SUCCESS) {
+        return result;
+    }
+
+    // Wall time starts from the CMOS clock, stays at the epoch without one
+    kos_rtc_time_t rtc;
+    if (kos_rtc_read(&rtc) == KOS_SUCCESS) {
+        kos_clock_set_realtime(kos_rtc_to_unix_ns(&rtc));
+    } else {
+        log_warn("Clock: RTC unreadable, wall time starts at the epoch");
+    }
+
+    return KOS_SUCCESS;
+}
+
+// Switch the clock to another clocksource without a time step
+kos_result_t kos_clock_select(kos_clocksource_t* cs) {
+    if (!cs || !cs->read || cs->mult == 0) {
+        return KOS_ERROR_INVALID_PARAM;
+    }
+
+    uint64_t flags = kos_write_seqlock_irqsave(&g_clock.lock);
+
+    if (g_clock.cs) {
+        kos_clock_accumulate();
+    }
+
+    g_clock.cs = cs;
+    g_clock.mask = cs->mask;
+    g_clock.mult = cs->mult;
+    g_clock.shift = cs->shift;
+    g_clock.base_frac = 0;
+    g_clock.cycle_last = kos_clocksource_read(cs);
+    kos_clock_publish();
+
+    kos_write_sequnlock_irqrestore(&g_clock.lock, flags);
+
+    log_info("Clock: using %s clocksource", cs->name);
+    return KOS_SUCCESS;
+}
+
+// Periodic accumulation, must run at least every KOS_CLOCKSOURCE_MAX_DELTA_SEC
+void kos_clock_update(void) {
+    if (!g_clock_initialized) {
+        return;
+    }
+
+    // Runs from the timer interrupt, which leaves interrupts on while it
+    // nests. An IPI landing inside the write section would spin on it.
+    uint64_t flags = kos_write_seqlock_irqsave(&g_clock.lock);
+    kos_clock_accumulate();
+    g_vdso_time.ticks++;
+    kos_clock_publish();
+    kos_write_sequnlock_irqrestore(&g_clock.lock, flags);
+}
+
+// Nanoseconds since the clock was initialized
+uint64_t kos_clock_monotonic_ns(void) {
+    if (!g_clock_initialized && kos_clock_init() != KOS_SUCCESS) {
+        return 0;
+    }
+
+    uint32_t seq;
+    uint64_t ns;
+    do {
+        seq = kos_read_seqbegin(&g_clock.lock);
+
+        uint64_t now = kos_clocksource_read(g_clock.cs);
+        uint64_t delta = (now - g_clock.cycle_last) & g_clock.mask;
+        ns = g_clock.base_ns + ((g_clock.base_frac + delta * g_clock.mult) >> g_clock.shift);
+    } while (kos_read_seqretry(&g_clock.lock, seq));
+
+    return ns;
+}
+
+// Nanoseconds since 1970-01-01 UTC
+uint64_t kos_clock_realtime_ns(void) {
+    if (!g_clock_initialized && kos_clock_init() != KOS_SUCCESS) {
+        return 0;
+    }
+
+    // Wall offset and monotonic base from the same update, a concurrent
+    // kos_clock_set_realtime cannot pair an old base with a new offset
+    uint32_t seq;
+    uint64_t ns;
+    do {
+        seq = kos_read_seqbegin(&g_clock.lock);
+
+        uint64_t now = kos_clocksource_read(g_clock.cs);
+        uint64_t delta = (now - g_clock.cycle_last) & g_clock.mask;
+        ns = g_vdso_time.wall_base_ns + g_clock.base_ns +
+             ((g_clock.base_frac + delta * g_clock.mult) >> g_clock.shift);
+    } while (kos_read_seqretry(&g_clock.lock, seq));
+
+    return ns;
+}
+
+// Step wall time, monotonic time is unaffected
+void kos_clock_set_realtime(uint64_t unix_ns) {
+    uint64_t now = kos_clock_monotonic_ns();
+
+    uint64_t flags = kos_write_seqlock_irqsave(&g_clock.lock);
+    g_vdso_time.sequence++;
+    kos_seq_barrier();
+    g_vdso_time.wall_base_ns = unix_ns - now;
+    kos_seq_barrier();
+    g_vdso_time.sequence++;
+    kos_write_sequnlock_irqrestore(&g_clock.lock, flags);
+}
+
+// Time page of this boot
+const kos_vdso_time_t* kos_vdso_get_page(void) {
+    return &g_vdso_time;
+}
+
+// Raw TSC cycles
+uint64_t kos_clock_cycles(void) {
+    return hal_tsc_read();
+}
+
+// Convert a cycle delta to nanoseconds
+uint64_t kos_clock_cycles_to_ns(uint64_t cycles) {
+    if (!g_clock_tsc) {
+        return 0;
+    }
+
+    if (cycles < g_clock_tsc_max_fast) {
+        return kos_clocksource_cyc2ns(g_clock_tsc, cycles);
+    }
+
+    return kos_clocksource_cycles_to_ns(g_clock_tsc, cycles);
+}
+
+// Convert nanoseconds to a cycle delta
+uint64_t kos_clock_ns_to_cycles(uint64_t ns) {
+    if (!g_clock_tsc) {
+        return 0;
+    }
+
+    if (ns < KOS_CLOCKSOURCE_MAX_DELTA_SEC * KOS_NSEC_PER_SEC) {
+        return (ns * g_clock_ns_to_cycles_mult) >> g_clock_ns_to_cycles_shift;
+    }
+
+    return (ns / KOS_NSEC_PER_SEC) * g_clock_tsc->frequency +
+           (((ns % KOS_NSEC_PER_SEC) * g_clock_ns_to_cycles_mult) >> g_clock_ns_to_cycles_shift);
+}
+
+// Get a consistent snapshot of the clock state
+kos_result_t kos_clock_get_info(kos_clock_info_t* info) {
+    if (!info) {
+        return KOS_ERROR_INVALID_PARAM;
+    }
+    if (!g_clock_initialized) {
+        return KOS_ERROR_INVALID_STATE;
+    }
+
+    uint32_t seq;
+    do {
+        seq = kos_read_seqbegin(&g_clock.lock);
+        info->source_name = g_clock.cs->name;
+        info->frequency = g_clock.cs->frequency;
+        info->mult = g_clock.mult;
+        info->shift = g_clock.shift;
+        info->cycle_last = g_clock.cycle_last;
+        info->base_ns = g_clock.base_ns;
+        info->updates = g_clock.updates;
+        info->ticks = g_vdso_time.ticks;
+        info->wall_base_ns = g_vdso_time.wall_base_ns;
+    } while (kos_read_seqretry(&g_clock.lock, seq));
+
+    return KOS_SUCCESS;
+}
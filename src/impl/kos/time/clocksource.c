@@ -0,0 +1,144 @@
+#include "kos/time/clocksource.h"
+#include "kos/utils/string.h"
+#include "debug/debug.h"
+
+// =============================================================================
+// KOS - Clocksource Implementation
+// =============================================================================
+
+// Registered clocksources, sorted by rating (best first)
+static kos_clocksource_t* g_clocksource_list = NULL;
+
+// Compute mult/shift so that ns = (cycles * mult) >> shift
+// Largest shift is chosen such that max_sec worth of cycles fits in 64 bits
+void kos_clocks_calc_mult_shift(uint32_t* mult, uint32_t* shift, uint64_t from, uint64_t to, uint32_t max_sec) {
+    if (!mult || !shift || from == 0) {
+        return;
+    }
+
+    // Bits needed to hold max_sec worth of input cycles above 32 bits
+    uint64_t tmp = ((uint64_t)max_sec * from) >> 32;
+    uint32_t shift_acc = 32;
+    while (tmp) {
+        tmp >>= 1;
+        shift_acc--;
+    }
+
+    // Find the largest shift whose mult still fits in the remaining bits
+    uint32_t sft;
+    for (sft = 32; sft > 0; sft--) {
+        tmp = (uint64_t)to << sft;
+        tmp += from / 2;
+        tmp /= from;
+        if ((tmp >> shift_acc) == 0) {
+            break;
+        }
+    }
+
+    *mult = (uint32_t)tmp;
+    *shift = sft;
+}
+
+// Convert an arbitrarily large cycle count to nanoseconds
+uint64_t kos_clocksource_cycles_to_ns(const kos_clocksource_t* cs, uint64_t cycles) {
+    if (!cs || cs->frequency == 0) {
+        return 0;
+    }
+
+    // Split into whole seconds and remainder to avoid 64-bit overflow
+    uint64_t seconds = cycles / cs->frequency;
+    uint64_t rem = cycles % cs->frequency;
+
+    return seconds * KOS_NSEC_PER_SEC + kos_clocksource_cyc2ns(cs, rem);
+}
+
+// Register a clocksource
+kos_result_t kos_clocksource_register(kos_clocksource_t* cs) {
+    if (!cs || !cs->name || !cs->read || cs->frequency == 0) {
+        return KOS_ERROR_INVALID_PARAM;
+    }
+
+    if (cs->mask == 0) {
+        cs->mask = ~0ULL;
+    }
+
+    // Precompute conversion factors if the driver did not supply them
+    if (cs->mult == 0) {
+        kos_clocks_calc_mult_shift(&cs->mult, &cs->shift, cs->frequency,
+                                   KOS_NSEC_PER_SEC, KOS_CLOCKSOURCE_MAX_DELTA_SEC);
+    }
+
+    // Insert sorted by rating
+    kos_clocksource_t** link = &g_clocksource_list;
+    while (*link) {
+        if (*link == cs) {
+            return KOS_ERROR_INVALID_STATE;
+        }
+        if ((*link)->rating < cs->rating) {
+            break;
+        }
+        link = &(*link)->next;
+    }
+    cs->next = *link;
+    *link = cs;
+
+    log_info("Clocksource registered: %s (%d kHz, rating %d)",
+             cs->name, (int)(cs->frequency / 1000), (int)cs->rating);
+
+    return KOS_SUCCESS;
+}
+
+// Unregister a clocksource
+kos_result_t kos_clocksource_unregister(kos_clocksource_t* cs) {
+    if (!cs) {
+        return KOS_ERROR_INVALID_PARAM;
+    }
+
+    kos_clocksource_t** link = &g_clocksource_list;
+    while (*link) {
+        if (*link == cs) {
+            *link = cs->next;
+            cs->next = NULL;
+            return KOS_SUCCESS;
+        }
+        link = &(*link)->next;
+    }
+
+    return KOS_ERROR_NOT_FOUND;
+}
+
+// Get the best rated stable clocksource
+kos_clocksource_t* kos_clocksource_get_best(void) {
+    for (kos_clocksource_t* cs = g_clocksource_list; cs; cs = cs->next) {
+        if (!(cs->flags & KOS_CLOCKSOURCE_FLAG_UNSTABLE)) {
+            return cs;
+        }
+    }
+
+    return g_clocksource_list;
+}
+
+// Find a clocksource by name
+kos_clocksource_t* kos_clocksource_find(const char* name) {
+    if (!name) {
+        return NULL;
+    }
+
+    for (kos_clocksource_t* cs = g_clocksource_list; cs; cs = cs->next) {
+        if (kos_strcmp(cs->name, name) == 0) {
+            return cs;
+        }
+    }
+
+    return NULL;
+}
+
+// Dump registered clocksources
+void kos_clocksource_dump(void) {
+    log_info("=== Clocksources ===");
+    for (kos_clocksource_t* cs = g_clocksource_list; cs; cs = cs->next) {
+        log_info("%s: %d kHz, mult %d, shift %d, rating %d, flags 0x%x",
+                 cs->name, (int)(cs->frequency / 1000), (int)cs->mult,
+                 (int)cs->shift, (int)cs->rating, cs->flags);
+    }
+}
@@ -0,0 +1,131 @@
+#include "kos/time/rtc.h"
+#include "kos/time/clocksource.h"
+#include "kos/cpu/ports.h"
+
+// =============================================================================
+// KOS - CMOS Real-Time Clock Implementation
+// =============================================================================
+
+#define CMOS_ADDRESS            0x70
+#define CMOS_DATA               0x71
+
+#define CMOS_REG_SECONDS        0x00
+#define CMOS_REG_MINUTES        0x02
+#define CMOS_REG_HOURS          0x04
+#define CMOS_REG_DAY            0x07
+#define CMOS_REG_MONTH          0x08
+#define CMOS_REG_YEAR           0x09
+#define CMOS_REG_STATUS_A       0x0A
+#define CMOS_REG_STATUS_B       0x0B
+
+#define CMOS_STATUS_A_UPDATING  0x80
+#define CMOS_STATUS_B_24H       0x02
+#define CMOS_STATUS_B_BINARY    0x04
+#define CMOS_HOUR_PM            0x80
+
+#define RTC_READ_ATTEMPTS       16
+
+// Read a CMOS register, NMI stays enabled
+static uint8_t kos_rtc_cmos_read(uint8_t reg) {
+    kos_port_byte_out(CMOS_ADDRESS, reg);
+    return kos_port_byte_in(CMOS_DATA);
+}
+
+// Read all fields once, raw encoding
+static bool kos_rtc_read_raw(kos_rtc_time_t* time) {
+    // Skip the update cycle, the fields are inconsistent while it runs
+    for (uint32_t spin = 0; kos_rtc_cmos_read(CMOS_REG_STATUS_A) & CMOS_STATUS_A_UPDATING; spin++) {
+        if (spin > 100000) {
+            return false;
+        }
+    }
+
+    time->second = kos_rtc_cmos_read(CMOS_REG_SECONDS);
+    time->minute = kos_rtc_cmos_read(CMOS_REG_MINUTES);
+    time->hour = kos_rtc_cmos_read(CMOS_REG_HOURS);
+    time->day = kos_rtc_cmos_read(CMOS_REG_DAY);
+    time->month = kos_rtc_cmos_read(CMOS_REG_MONTH);
+    time->year = kos_rtc_cmos_read(CMOS_REG_YEAR);
+    return true;
+}
+
+static uint32_t kos_rtc_from_bcd(uint32_t value) {
+    return (value & 0x0F) + (value >> 4) * 10;
+}
+
+// Read the RTC, retrying until two reads agree
+kos_result_t kos_rtc_read(kos_rtc_time_t* time) {
+    if (!time) {
+        return KOS_ERROR_INVALID_PARAM;
+    }
+
+    kos_rtc_time_t last;
+    if (!kos_rtc_read_raw(&last)) {
+        return KOS_ERROR_TIMEOUT;
+    }
+
+    for (uint32_t attempt = 0; ; attempt++) {
+        if (attempt == RTC_READ_ATTEMPTS) {
+            return KOS_ERROR_TIMEOUT;
+        }
+        if (!kos_rtc_read_raw(time)) {
+            return KOS_ERROR_TIMEOUT;
+        }
+        if (time->second == last.second && time->minute == last.minute &&
+            time->hour == last.hour && time->day == last.day &&
+            time->month == last.month && time->year == last.year) {
+            break;
+        }
+        last = *time;
+    }
+
+    uint8_t status_b = kos_rtc_cmos_read(CMOS_REG_STATUS_B);
+    bool pm = (time->hour & CMOS_HOUR_PM) != 0;
+    time->hour &= ~CMOS_HOUR_PM;
+
+    if (!(status_b & CMOS_STATUS_B_BINARY)) {
+        time->second = kos_rtc_from_bcd(time->second);
+        time->minute = kos_rtc_from_bcd(time->minute);
+        time->hour = kos_rtc_from_bcd(time->hour);
+        time->day = kos_rtc_from_bcd(time->day);
+        time->month = kos_rtc_from_bcd(time->month);
+        time->year = kos_rtc_from_bcd(time->year);
+    }
+
+    if (!(status_b & CMOS_STATUS_B_24H)) {
+        time->hour %= 12;
+        if (pm) {
+            time->hour += 12;
+        }
+    }
+
+    // The century register is not reliably present, assume 20xx
+    time->year += 2000;
+
+    if (time->month < 1 || time->month > 12 || time->day < 1 || time->day > 31 ||
+        time->hour > 23 || time->minute > 59 || time->second > 59) {
+        return KOS_ERROR_IO_ERROR;
+    }
+
+    return KOS_SUCCESS;
+}
+
+// Convert a UTC calendar time to nanoseconds since 1970
+uint64_t kos_rtc_to_unix_ns(const kos_rtc_time_t* time) {
+    if (!time) {
+        return 0;
+    }
+
+    // Days from civil, with March as the first month of the year
+    int64_t year = (int64_t)time->year - (time->month <= 2 ? 1 : 0);
+    int64_t era = year / 400;
+    int64_t yoe = year - era * 400;
+    int64_t month = time->month;
+    int64_t doy = (153 * (month + (month > 2 ? -3 : 9)) + 2) / 5 + (int64_t)time->day - 1;
+    int64_t doe = yoe * 365 + yoe / 4 - yoe / 100 + doy;
+    int64_t days = era * 146097 + doe - 719468;
+
+    uint64_t seconds = (uint64_t)days * 86400ULL + time->hour * 3600ULL +
+                       time->minute * 60ULL + time->second;
+    return seconds * KOS_NSEC_PER_SEC;
+}
@@ -0,0 +1,225 @@
+#include "kos/time/sleep.h"
+#include "kos/time/clock.h"
+#include "kos/time/timer.h"
+#include "kos/cpu/irqflags.h"
+#include "kos/cpu/percpu.h"
+#include "kos/cpu/ipi.h"
+#include "kos/process/process.h"
+#include "debug/debug.h"
+
+// =============================================================================
+// KOS - Sleep Implementation
+// =============================================================================
+
+#define KOS_SLEEP_CALIBRATION_ROUNDS 8
+
+// On-stack wait state shared with the wakeup timer
+typedef struct {
+    kos_timer_t timer;
+    volatile bool expired;
+    kos_process_t* process;
+    uint32_t cpu;               // CPU halting on the sleeper
+} kos_sleeper_t;
+
+// Global sleep state
+static kos_sleep_stats_t g_sleep_stats;
+static uint64_t g_sleep_spin_threshold_ns = KOS_TIMER_TICK_NS;
+static bool g_sleep_initialized = false;
+
+// Timer callback, wakes the sleeping process
+static void kos_sleep_wakeup(void* context) {
+    kos_sleeper_t* sleeper = (kos_sleeper_t*)context;
+
+    sleeper->expired = true;
+    if (sleeper->process) {
+        kos_process_wake(sleeper->process);
+    }
+
+    // APs do not run the system wheel, get a halting one out of HLT
+    if (kos_percpu_count() && sleeper->cpu != kos_this_cpu_id()) {
+        kos_smp_send_reschedule(sleeper->cpu);
+    }
+}
+
+// Busy-wait until the deadline
+static void kos_sleep_spin(uint64_t deadline_ns) {
+    while (kos_clock_monotonic_ns() < deadline_ns) {
+        asm volatile("pause");
+    }
+}
+
+// Halt until the next interrupt, CPU 0 runs due timers on the way
+static void kos_sleep_halt(kos_sleeper_t* sleeper) {
+    kos_local_irq_disable();
+
+    if (sleeper->cpu == 0 && kos_timer_work_pending()) {
+        kos_local_irq_enable();
+        kos_timer_run();
+        return;
+    }
+
+    if (sleeper->expired) {
+        kos_local_irq_enable();
+        return;
+    }
+
+    // sti delays interrupts by one instruction, so no wakeup is lost
+    asm volatile("sti; hlt" : : : "memory");
+}
+
+// Block on a timer until wake_ns, returns true if a process was blocked
+static bool kos_sleep_block(uint64_t wake_ns) {
+    kos_sleeper_t sleeper;
+    kos_process_t* current = NULL;
+    bool blocked = false;
+
+    sleeper.expired = false;
+    sleeper.process = NULL;
+    sleeper.cpu = kos_this_cpu_id();
+    kos_process_get_current(&current);
+    kos_timer_init(&sleeper.timer, kos_sleep_wakeup, &sleeper);
+
+    uint64_t flags = kos_local_irq_save();
+
+    if (kos_timer_add(&sleeper.timer, wake_ns) != KOS_SUCCESS) {
+        kos_local_irq_restore(flags);
+        return false;
+    }
+
+    // Checked and blocked with interrupts off so the wakeup cannot slip in between
+    if (current && current->state == KOS_PROCESS_STATE_RUNNING) {
+        sleeper.process = current;
+        if (kos_process_block() == HAL_SUCCESS) {
+            blocked = true;
+        } else {
+            sleeper.process = NULL;
+        }
+    }
+
+    kos_local_irq_restore(flags);
+
+    // Resumed early by a stale wake: block again. No process to block: halt
+    // out the rest.
+    bool can_block = blocked;
+    while (!sleeper.expired) {
+        if (can_block) {
+            flags = kos_local_irq_save();
+            if (!sleeper.expired && kos_process_block() != HAL_SUCCESS) {
+                can_block = false;
+            }
+            kos_local_irq_restore(flags);
+            continue;
+        }
+        kos_sleep_halt(&sleeper);
+    }
+
+    // The callback may still be touching the sleeper after setting expired
+    kos_timer_cancel_sync(&sleeper.timer);
+    return blocked;
+}
+
+// Calibrate the spin threshold from the cost of a block/wake round trip
+kos_result_t kos_sleep_init(void) {
+    if (g_sleep_initialized) {
+        return KOS_SUCCESS;
+    }
+
+    kos_timer_t probe;
+    uint64_t worst = 0;
+
+    kos_timer_init(&probe, kos_sleep_wakeup, NULL);
+    for (int i = 0; i < KOS_SLEEP_CALIBRATION_ROUNDS; i++) {
+        uint64_t start = kos_clock_cycles();
+        kos_timer_add(&probe, kos_clock_monotonic_ns() + KOS_NSEC_PER_SEC);
+        kos_timer_cancel(&probe);
+        uint64_t cost = kos_clock_cycles_to_ns(kos_clock_cycles() - start);
+        if (cost > worst) {
+            worst = cost;
+        }
+    }
+
+    // A timer fires on the first tick after its deadline, so the wakeup is up
+    // to one tick late on top of the arm/cancel and reschedule cost
+    uint64_t threshold = KOS_TIMER_TICK_NS + worst * 4;
+    if (threshold < KOS_SLEEP_MIN_SPIN_NS) {
+        threshold = KOS_SLEEP_MIN_SPIN_NS;
+    }
+    if (threshold > KOS_SLEEP_MAX_SPIN_NS) {
+        threshold = KOS_SLEEP_MAX_SPIN_NS;
+    }
+
+    g_sleep_spin_threshold_ns = threshold;
+    g_sleep_stats.spin_threshold_ns = threshold;
+    g_sleep_initialized = true;
+
+    log_info("Sleep: spin threshold %d ns (timer arm/cancel %d ns)",
+             (int)threshold, (int)worst);
+    return KOS_SUCCESS;
+}
+
+// Sleep until an absolute monotonic deadline
+kos_result_t kos_sleep_until(uint64_t deadline_ns) {
+    if (!g_sleep_initialized) {
+        kos_sleep_init();
+    }
+
+    g_sleep_stats.calls++;
+
+    uint64_t now = kos_clock_monotonic_ns();
+    if (now >= deadline_ns) {
+        return KOS_SUCCESS;
+    }
+
+    // Without interrupts no timer can fire, so only spinning can make progress
+    if (deadline_ns - now > g_sleep_spin_threshold_ns && kos_local_irq_enabled()) {
+        if (kos_sleep_block(deadline_ns - g_sleep_spin_threshold_ns)) {
+            g_sleep_stats.blocks++;
+        } else {
+            g_sleep_stats.halts++;
+        }
+    } else {
+        g_sleep_stats.spins++;
+    }
+
+    uint64_t spin_start = kos_clock_monotonic_ns();
+    kos_sleep_spin(deadline_ns);
+    now = kos_clock_monotonic_ns();
+
+    g_sleep_stats.spin_ns += now - spin_start;
+    if (now - deadline_ns > g_sleep_stats.max_overshoot_ns) {
+        g_sleep_stats.max_overshoot_ns = now - deadline_ns;
+    }
+
+    return KOS_SUCCESS;
+}
+
+// Sleep for a relative duration
+kos_result_t kos_sleep_ns(uint64_t ns) {
+    return kos_sleep_until(kos_clock_monotonic_ns() + ns);
+}
+
+// Get the calibrated spin threshold
+uint64_t kos_sleep_get_spin_threshold(void) {
+    return g_sleep_spin_threshold_ns;
+}
+
+// Get sleep statistics
+void kos_sleep_get_stats(kos_sleep_stats_t* stats) {
+    if (!stats) {
+        return;
+    }
+
+    *stats = g_sleep_stats;
+}
+
+// Dump sleep statistics
+void kos_sleep_dump_stats(void) {
+    log_info("=== Sleep Statistics ===");
+    log_info("Spin threshold: %d ns", (int)g_sleep_stats.spin_threshold_ns);
+    log_info("Calls: %u, Spins: %u, Blocks: %u, Halts: %u",
+             (uint32_t)g_sleep_stats.calls, (uint32_t)g_sleep_stats.spins,
+             (uint32_t)g_sleep_stats.blocks, (uint32_t)g_sleep_stats.halts);
+    log_info("Spin time: %d us, Max overshoot: %d ns",
+             (int)(g_sleep_stats.spin_ns / KOS_NSEC_PER_USEC),
+             (int)g_sleep_stats.max_overshoot_ns);
+}
@@ -0,0 +1,349 @@
+#include "kos/time/timer.h"
+#include "kos/time/clock.h"
+#include "kos/interrupts/softirq.h"
+#include "kos/utils/string.h"
+#include "debug/debug.h"
+
+// =============================================================================
+// KOS - Hierarchical Timing Wheel Implementation
+// =============================================================================
+
+// Timers live in the finest level that can hold their distance from the
+// wheel clock. Level 0 has one slot per tick; each upper level has slots
+// 64 times wider and is cascaded one level down whenever the level below
+// wraps. Insert and cancel are O(1), and a tick only touches one slot.
+
+#define KOS_TIMER_ROOT_MASK   (KOS_TIMER_ROOT_SIZE - 1)
+#define KOS_TIMER_LEVEL_MASK  (KOS_TIMER_LEVEL_SIZE - 1)
+#define KOS_TIMER_LEVEL_SHIFT(n) (KOS_TIMER_ROOT_BITS + (n) * KOS_TIMER_LEVEL_BITS)
+#define KOS_TIMER_MAX_DELTA   ((1ULL << KOS_TIMER_LEVEL_SHIFT(KOS_TIMER_LEVELS)) - 1)
+
+// System timing wheel, APs arm and cancel timers on it too
+static kos_timer_base_t g_timer_base = { .lock = KOS_SPINLOCK_INIT };
+
+// Convert an absolute ns deadline to a tick, rounding up so timers never fire early
+static inline uint64_t kos_timer_ns_to_tick(uint64_t ns) {
+    return (ns + KOS_TIMER_TICK_NS - 1) / KOS_TIMER_TICK_NS;
+}
+
+// Link a timer at the head of a slot
+static inline void kos_timer_link(kos_timer_t** slot, kos_timer_t* timer) {
+    timer->next = *slot;
+    if (timer->next) {
+        timer->next->pprev = &timer->next;
+    }
+    *slot = timer;
+    timer->pprev = slot;
+}
+
+// Unlink a timer from whatever slot holds it
+static inline void kos_timer_unlink(kos_timer_t* timer) {
+    *timer->pprev = timer->next;
+    if (timer->next) {
+        timer->next->pprev = timer->pprev;
+    }
+    timer->next = NULL;
+    timer->pprev = NULL;
+}
+
+// Place a timer in the slot matching its distance from the wheel clock
+static void kos_timer_enqueue(kos_timer_base_t* base, kos_timer_t* timer) {
+    uint64_t expires = timer->expires;
+    int64_t delta = (int64_t)(expires - base->clk);
+    kos_timer_t** slot;
+
+    if (delta < 0) {
+        // Already due: fire on the next processed tick
+        slot = &base->root[base->clk & KOS_TIMER_ROOT_MASK];
+    } else if (delta < KOS_TIMER_ROOT_SIZE) {
+        slot = &base->root[expires & KOS_TIMER_ROOT_MASK];
+    } else {
+        if ((uint64_t)delta > KOS_TIMER_MAX_DELTA) {
+            expires = base->clk + KOS_TIMER_MAX_DELTA;
+            delta = KOS_TIMER_MAX_DELTA;
+        }
+
+        uint32_t level = 0;
+        while (level < KOS_TIMER_LEVELS - 1 &&
+               (uint64_t)delta >= (1ULL << KOS_TIMER_LEVEL_SHIFT(level + 1))) {
+            level++;
+        }
+        slot = &base->levels[level][(expires >> KOS_TIMER_LEVEL_SHIFT(level)) & KOS_TIMER_LEVEL_MASK];
+    }
+
+    kos_timer_link(slot, timer);
+}
+
+// Redistribute one upper-level slot, returns the slot index
+static uint32_t kos_timer_cascade(kos_timer_base_t* base, uint32_t level) {
+    uint32_t index = (base->clk >> KOS_TIMER_LEVEL_SHIFT(level)) & KOS_TIMER_LEVEL_MASK;
+    kos_timer_t* list = base->levels[level][index];
+    base->levels[level][index] = NULL;
+
+    while (list) {
+        kos_timer_t* timer = list;
+        list = timer->next;
+        timer->next = NULL;
+        timer->pprev = NULL;
+        kos_timer_enqueue(base, timer);
+        base->stats.cascaded++;
+    }
+
+    return index;
+}
+
+// Empty a wheel and start it at now_ns, leaves the lock alone
+static void kos_timer_base_reset(kos_timer_base_t* base, uint64_t now_ns) {
+    kos_memset(base->root, 0, sizeof(base->root));
+    kos_memset(base->levels, 0, sizeof(base->levels));
+    kos_memset(&base->stats, 0, sizeof(base->stats));
+    base->clk = now_ns / KOS_TIMER_TICK_NS;
+    base->running = NULL;
+    base->work_pending = false;
+    base->initialized = true;
+}
+
+// Initialize a timing wheel starting at now_ns
+void kos_timer_base_init(kos_timer_base_t* base, uint64_t now_ns) {
+    if (!base) {
+        return;
+    }
+
+    kos_spin_init_named(&base->lock, "timer_base");
+    kos_timer_base_reset(base, now_ns);
+}
+
+// Initialize a timer
+void kos_timer_init(kos_timer_t* timer, kos_timer_callback_t callback, void* context) {
+    if (!timer) {
+        return;
+    }
+
+    timer->next = NULL;
+    timer->pprev = NULL;
+    timer->expires = 0;
+    timer->callback = callback;
+    timer->context = context;
+    timer->base = NULL;
+}
+
+// Arm a timer on a specific wheel
+kos_result_t kos_timer_base_add(kos_timer_base_t* base, kos_timer_t* timer, uint64_t expires_ns) {
+    if (!base || !timer || !timer->callback) {
+        return KOS_ERROR_INVALID_PARAM;
+    }
+
+    uint64_t flags = kos_spin_lock_irqsave(&base->lock);
+
+    if (!base->initialized) {
+        kos_timer_base_reset(base, kos_clock_monotonic_ns());
+    }
+
+    if (kos_timer_pending(timer)) {
+        kos_spin_unlock_irqrestore(&base->lock, flags);
+        return KOS_ERROR_INVALID_STATE;
+    }
+
+    timer->expires = kos_timer_ns_to_tick(expires_ns);
+    timer->base = base;
+    kos_timer_enqueue(base, timer);
+    base->stats.added++;
+    base->stats.pending++;
+
+    kos_spin_unlock_irqrestore(&base->lock, flags);
+    return KOS_SUCCESS;
+}
+
+// Arm a timer for an absolute monotonic deadline
+kos_result_t kos_timer_add(kos_timer_t* timer, uint64_t expires_ns) {
+    return kos_timer_base_add(&g_timer_base, timer, expires_ns);
+}
+
+// Arm a timer delay_ns from now
+kos_result_t kos_timer_add_relative(kos_timer_t* timer, uint64_t delay_ns) {
+    return kos_timer_add(timer, kos_clock_monotonic_ns() + delay_ns);
+}
+
+// Unlink a pending timer, base lock held
+static bool kos_timer_detach(kos_timer_base_t* base, kos_timer_t* timer) {
+    if (!kos_timer_pending(timer)) {
+        return false;
+    }
+
+    kos_timer_unlink(timer);
+    base->stats.pending--;
+    base->stats.cancelled++;
+    return true;
+}
+
+// Disarm a timer, returns true if it was pending
+bool kos_timer_cancel(kos_timer_t* timer) {
+    if (!timer || !timer->base) {
+        return false;
+    }
+
+    kos_timer_base_t* base = timer->base;
+    uint64_t flags = kos_spin_lock_irqsave(&base->lock);
+    bool was_pending = kos_timer_detach(base, timer);
+    kos_spin_unlock_irqrestore(&base->lock, flags);
+
+    return was_pending;
+}
+
+// Disarm a timer and wait out a callback already running on another CPU,
+// so the timer can be freed or go out of scope. Not from its own callback.
+bool kos_timer_cancel_sync(kos_timer_t* timer) {
+    if (!timer || !timer->base) {
+        return false;
+    }
+
+    kos_timer_base_t* base = timer->base;
+    while (true) {
+        uint64_t flags = kos_spin_lock_irqsave(&base->lock);
+        bool was_pending = kos_timer_detach(base, timer);
+        bool running = base->running == timer;
+        kos_spin_unlock_irqrestore(&base->lock, flags);
+
+        if (!running) {
+            return was_pending;
+        }
+        kos_cpu_relax();
+    }
+}
+
+// Re-arm a timer with a new deadline, returns true if it was pending
+bool kos_timer_mod(kos_timer_t* timer, uint64_t expires_ns) {
+    if (!timer || !timer->callback) {
+        return false;
+    }
+
+    kos_timer_base_t* base = timer->base ? timer->base : &g_timer_base;
+    uint64_t flags = kos_spin_lock_irqsave(&base->lock);
+
+    if (!base->initialized) {
+        kos_timer_base_reset(base, kos_clock_monotonic_ns());
+    }
+
+    bool was_pending = kos_timer_detach(base, timer);
+    timer->expires = kos_timer_ns_to_tick(expires_ns);
+    timer->base = base;
+    kos_timer_enqueue(base, timer);
+    base->stats.added++;
+    base->stats.pending++;
+
+    kos_spin_unlock_irqrestore(&base->lock, flags);
+    return was_pending;
+}
+
+// Process every tick up to now_ns, returns the number of expired timers
+uint32_t kos_timer_base_run(kos_timer_base_t* base, uint64_t now_ns) {
+    if (!base || !base->initialized) {
+        return 0;
+    }
+
+    uint64_t now = now_ns / KOS_TIMER_TICK_NS;
+    uint32_t fired = 0;
+
+    uint64_t flags = kos_spin_lock_irqsave(&base->lock);
+    base->work_pending = false;
+    base->stats.runs++;
+
+    // Nothing armed: jump the wheel clock instead of walking empty slots
+    if (base->stats.pending == 0) {
+        if ((int64_t)(now - base->clk) >= 0) {
+            base->clk = now + 1;
+        }
+        kos_spin_unlock_irqrestore(&base->lock, flags);
+        return 0;
+    }
+
+    while ((int64_t)(now - base->clk) >= 0) {
+        uint32_t index = base->clk & KOS_TIMER_ROOT_MASK;
+
+        // Level 0 wrapped: pull the next slot of each upper level down
+        if (index == 0) {
+            for (uint32_t level = 0; level < KOS_TIMER_LEVELS; level++) {
+                if (kos_timer_cascade(base, level) != 0) {
+                    break;
+                }
+            }
+        }
+        base->clk++;
+
+        // Detach the whole slot as one batch
+        kos_timer_t* expired = base->root[index];
+        base->root[index] = NULL;
+        if (expired) {
+            expired->pprev = &expired;
+        }
+
+        uint32_t batch = 0;
+        while (expired) {
+            kos_timer_t* timer = expired;
+            kos_timer_callback_t callback = timer->callback;
+            void* context = timer->context;
+
+            kos_timer_unlink(timer);
+            base->stats.pending--;
+            base->stats.expired++;
+            batch++;
+
+            // Callbacks may re-arm or cancel timers, so run them unlocked
+            base->running = timer;
+            kos_spin_unlock_irqrestore(&base->lock, flags);
+            callback(context);
+            flags = kos_spin_lock_irqsave(&base->lock);
+            base->running = NULL;
+        }
+
+        if (batch > base->stats.max_batch) {
+            base->stats.max_batch = batch;
+        }
+        fired += batch;
+    }
+
+    kos_spin_unlock_irqrestore(&base->lock, flags);
+    return fired;
+}
+
+// Tick hook, called from the timer interrupt
+void kos_timer_tick(void) {
+    if (g_timer_base.stats.pending != 0) {
+        g_timer_base.work_pending = true;
+        kos_softirq_raise(KOS_SOFTIRQ_TIMER);
+    }
+}
+
+// Check whether the system wheel has work to do
+bool kos_timer_work_pending(void) {
+    return g_timer_base.work_pending;
+}
+
+// Run expired timers of the system wheel, timer softirq or process context only
+void kos_timer_run(void) {
+    kos_timer_base_run(&g_timer_base, kos_clock_monotonic_ns());
+}
+
+// Get system wheel statistics
+void kos_timer_get_stats(kos_timer_stats_t* stats) {
+    if (!stats) {
+        return;
+    }
+
+    uint64_t flags = kos_spin_lock_irqsave(&g_timer_base.lock);
+    *stats = g_timer_base.stats;
+    kos_spin_unlock_irqrestore(&g_timer_base.lock, flags);
+}
+
+// Dump system wheel statistics
+void kos_timer_dump_stats(void) {
+    kos_timer_stats_t stats;
+    kos_timer_get_stats(&stats);
+
+    log_info("=== Timer Wheel Statistics ===");
+    log_info("Pending: %u", stats.pending);
+    log_info("Added: %u, Cancelled: %u, Expired: %u",
+             (uint32_t)stats.added, (uint32_t)stats.cancelled, (uint32_t)stats.expired);
+    log_info("Cascaded: %u, Runs: %u, Max batch: %u",
+             (uint32_t)stats.cascaded, (uint32_t)stats.runs, stats.max_batch);
+}
@@ -0,0 +1,69 @@
+#include "kos/utils/histogram.h"
+#include "kos/utils/string.h"
+
+// =============================================================================
+// KOS - Log-Linear Histogram Implementation
+// =============================================================================
+
+// Clear all buckets
+void kos_histogram_reset(kos_histogram_t* h) {
+    if (!h) {
+        return;
+    }
+
+    kos_memset(h, 0, sizeof(kos_histogram_t));
+}
+
+// Highest value that maps to a bucket
+uint64_t kos_histogram_bucket_high(uint32_t index) {
+    if (index < KOS_HISTOGRAM_SUB_COUNT) {
+        return index;
+    }
+
+    uint32_t shift = (index >> KOS_HISTOGRAM_SUB_BITS) - 1;
+    uint64_t sub = index & (KOS_HISTOGRAM_SUB_COUNT - 1);
+    uint64_t low = (KOS_HISTOGRAM_SUB_COUNT + sub) << shift;
+    return low + (1ULL << shift) - 1;
+}
+
+// Value at or below which per_mille/1000 of the samples fall
+uint64_t kos_histogram_percentile(const kos_histogram_t* h, uint32_t per_mille) {
+    if (!h || h->count == 0) {
+        return 0;
+    }
+
+    // Rank of the sample we are looking for, rounded up
+    uint64_t rank = (h->count * per_mille + 999) / 1000;
+    if (rank == 0) {
+        rank = 1;
+    }
+
+    uint64_t seen = 0;
+    for (uint32_t i = 0; i < KOS_HISTOGRAM_BUCKETS; i++) {
+        seen += h->buckets[i];
+        if (seen >= rank) {
+            uint64_t high = kos_histogram_bucket_high(i);
+            return high < h->max ? high : h->max;
+        }
+    }
+
+    return h->max;
+}
+
+// Compute p50/p99/p999/max in one call
+void kos_histogram_summarize(const kos_histogram_t* h, kos_histogram_summary_t* summary) {
+    if (!summary) {
+        return;
+    }
+
+    kos_memset(summary, 0, sizeof(kos_histogram_summary_t));
+    if (!h) {
+        return;
+    }
+
+    summary->count = h->count;
+    summary->p50 = kos_histogram_percentile(h, 500);
+    summary->p99 = kos_histogram_percentile(h, 990);
+    summary->p999 = kos_histogram_percentile(h, 999);
+    summary->max = h->max;
+}
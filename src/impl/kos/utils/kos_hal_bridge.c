@@ -2,6 +2,7 @@
 #include <stddef.h>
 #include <stdarg.h>
 #include "hal/hal_core.h"
+#include "kos/time/clock.h"
 
 // =============================================================================
 // KOS - HAL Bridge Functions
@@ -40,9 +41,8 @@ void hal_free(void* ptr) {
 }
 
 uint64_t hal_get_timestamp(void) {
-    // Simple stub - return a counter
-    static uint64_t counter = 0;
-    return ++counter;
+    // Monotonic time in ns
+    return kos_clock_monotonic_ns();
 }
 
 void* hal_memset(void* dest, int c, size_t n) {
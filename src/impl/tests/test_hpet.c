@@ -0,0 +1,156 @@
+#include <stdint.h>
+#include <stddef.h>
+#include <stdbool.h>
+#include "kos/utils/string.h"
+#include "kos/time/clock.h"
+#include "kos/sync/spinlock.h"
+#include "hal/hal_hpet.h"
+#include "debug/debug.h"
+
+// =============================================================================
+// KOS - HPET Comparator Test Suite
+// =============================================================================
+
+// Test framework
+typedef struct test_result {
+    char name[64];
+    bool passed;
+    const char* error_msg;
+} test_result_t;
+
+static test_result_t g_test_results[32];
+static int g_test_count = 0;
+
+#define TEST_ASSERT(condition, msg) \
+    do { \
+        if (!(condition)) { \
+            g_test_results[g_test_count].passed = false; \
+            g_test_results[g_test_count].error_msg = msg; \
+            g_test_count++; \
+            return; \
+        } \
+    } while(0)
+
+#define TEST_START(name_str) \
+    do { \
+        kos_strcpy(g_test_results[g_test_count].name, name_str); \
+        g_test_results[g_test_count].passed = true; \
+        g_test_results[g_test_count].error_msg = NULL; \
+    } while(0)
+
+#define TEST_END() \
+    do { \
+        g_test_count++; \
+    } while(0)
+
+#define EVENT_DELAY_NS      (1 * KOS_NSEC_PER_MSEC)
+#define EVENT_TIMEOUT_NS    (100 * KOS_NSEC_PER_MSEC)
+#define CANCEL_DELAY_NS     (20 * KOS_NSEC_PER_MSEC)
+
+static bool g_event_ready = false;
+static volatile uint32_t g_event_fired = 0;
+static volatile uint64_t g_event_counter = 0;
+
+// Comparator callback, interrupt context
+static void event_fired(void* context) {
+    (void)context;
+    g_event_counter = hal_hpet_read_counter();
+    __atomic_fetch_add(&g_event_fired, 1, __ATOMIC_RELAXED);
+}
+
+// Spin with interrupts on until the event fired or timeout_ns passed
+static void wait_for_event(uint32_t fired_before, uint64_t timeout_ns) {
+    uint64_t deadline = kos_clock_monotonic_ns() + timeout_ns;
+    while (g_event_fired == fired_before && kos_clock_monotonic_ns() < deadline) {
+        kos_cpu_relax();
+    }
+}
+
+// Test 1: An armed comparator interrupts once, not before its target
+void test_hpet_event_fires(void) {
+    TEST_START("One-Shot Delivery");
+
+    uint32_t before = g_event_fired;
+    uint64_t start = hal_hpet_read_counter();
+
+    TEST_ASSERT(hal_hpet_event_program_ns(EVENT_DELAY_NS), "Event reported as already passed");
+    wait_for_event(before, EVENT_TIMEOUT_NS);
+    TEST_ASSERT(g_event_fired == before + 1, "Comparator interrupt never arrived");
+
+    uint64_t waited = kos_clocksource_cyc2ns(hal_hpet_get_clocksource(),
+                                             (g_event_counter - start) & hal_hpet_get_clocksource()->mask);
+    TEST_ASSERT(waited >= EVENT_DELAY_NS, "Comparator fired early");
+
+    wait_for_event(before + 1, 5 * EVENT_DELAY_NS);
+    TEST_ASSERT(g_event_fired == before + 1, "One-shot event fired twice");
+
+    TEST_END();
+}
+
+// Test 2: A cancelled event never fires
+void test_hpet_event_cancel(void) {
+    TEST_START("Cancel Armed Event");
+
+    uint32_t before = g_event_fired;
+
+    TEST_ASSERT(hal_hpet_event_program_ns(CANCEL_DELAY_NS), "Event reported as already passed");
+    hal_hpet_event_cancel();
+    wait_for_event(before, 2 * CANCEL_DELAY_NS);
+    TEST_ASSERT(g_event_fired == before, "Cancelled event fired");
+
+    TEST_END();
+}
+
+// Test 3: A target in the past is reported and not delivered
+void test_hpet_event_missed(void) {
+    TEST_START("Missed Target");
+
+    uint32_t before = g_event_fired;
+
+    TEST_ASSERT(!hal_hpet_event_program_counter(hal_hpet_read_counter() - 1), "Past target accepted");
+    wait_for_event(before, 5 * EVENT_DELAY_NS);
+    TEST_ASSERT(g_event_fired == before, "Missed target still delivered");
+
+    TEST_END();
+}
+
+// Run all HPET tests
+void run_hpet_tests(void) {
+    log_info("Starting HPET Comparator Tests...");
+
+    g_test_count = 0;
+
+    // The comparator needs FSB delivery, QEMU offers it with -global hpet.msi=on
+    if (!g_event_ready) {
+        g_event_ready = hal_hpet_event_init(event_fired, NULL);
+    }
+    if (!g_event_ready) {
+        log_info("HPET Comparator Tests skipped: no FSB-capable comparator");
+        return;
+    }
+
+    test_hpet_event_fires();
+    test_hpet_event_cancel();
+    test_hpet_event_missed();
+
+    int passed = 0;
+    int failed = 0;
+
+    log_info("HPET Comparator Test Results:");
+    for (int i = 0; i < g_test_count; i++) {
+        if (g_test_results[i].passed) {
+            log_info("  ✓ %s", g_test_results[i].name);
+            passed++;
+        } else {
+            log_error("  ✗ %s: %s", g_test_results[i].name, g_test_results[i].error_msg);
+            failed++;
+        }
+    }
+
+    log_info("HPET Comparator Tests Summary: %d passed, %d failed", passed, failed);
+}
+
+// Entry point for HPET testing
+void test_hpet_system(void) {
+    run_hpet_tests();
+}
@@ -0,0 +1,259 @@
+#include <stdint.h>
+#include <stddef.h>
+#include <stdbool.h>
+#include "kos/utils/string.h"
+#include "kos/sync/ring.h"
+#include "kos/time/clock.h"
+#include "debug/debug.h"
+
+// =============================================================================
+// KOS - Lock-Free Ring Test Suite
+// =============================================================================
+
+// Test framework
+typedef struct test_result {
+    char name[64];
+    bool passed;
+    const char* error_msg;
+} test_result_t;
+
+static test_result_t g_test_results[32];
+static int g_test_count = 0;
+
+#define TEST_ASSERT(condition, msg) \
+    do { \
+        if (!(condition)) { \
+            g_test_results[g_test_count].passed = false; \
+            g_test_results[g_test_count].error_msg = msg; \
+            g_test_count++; \
+            return; \
+        } \
+    } while(0)
+
+#define TEST_START(name_str) \
+    do { \
+        kos_strcpy(g_test_results[g_test_count].name, name_str); \
+        g_test_results[g_test_count].passed = true; \
+        g_test_results[g_test_count].error_msg = NULL; \
+    } while(0)
+
+#define TEST_END() \
+    do { \
+        g_test_count++; \
+    } while(0)
+
+#define RING_SMALL      8
+#define RING_BENCH      1024
+#define BENCH_ITEMS     (1U << 20)
+#define BENCH_BATCH     32
+
+#define ITEM(x) ((void*)(uintptr_t)(x))
+
+static kos_spsc_ring_t g_spsc;
+static kos_mpsc_ring_t g_mpsc;
+static void* g_spsc_slots[RING_BENCH];
+static kos_mpsc_slot_t g_mpsc_slots[RING_BENCH];
+
+// Test 1: Capacities that are not powers of two are rejected
+void test_ring_init(void) {
+    TEST_START("Init Validation");
+
+    TEST_ASSERT(kos_spsc_init(&g_spsc, g_spsc_slots, 6) != KOS_SUCCESS, "SPSC accepted capacity 6");
+    TEST_ASSERT(kos_spsc_init(&g_spsc, g_spsc_slots, 1) != KOS_SUCCESS, "SPSC accepted capacity 1");
+    TEST_ASSERT(kos_mpsc_init(&g_mpsc, g_mpsc_slots, 12) != KOS_SUCCESS, "MPSC accepted capacity 12");
+    TEST_ASSERT(kos_spsc_init(&g_spsc, g_spsc_slots, RING_SMALL) == KOS_SUCCESS, "SPSC rejected capacity 8");
+    TEST_ASSERT(kos_mpsc_init(&g_mpsc, g_mpsc_slots, RING_SMALL) == KOS_SUCCESS, "MPSC rejected capacity 8");
+
+    TEST_END();
+}
+
+// Test 2: SPSC keeps FIFO order across many wraps
+void test_ring_spsc_order(void) {
+    TEST_START("SPSC Order Across Wraps");
+
+    kos_spsc_init(&g_spsc, g_spsc_slots, RING_SMALL);
+
+    uint32_t next_in = 0;
+    uint32_t next_out = 0;
+    for (uint32_t round = 0; round < 100; round++) {
+        // Uneven batch sizes so head and tail drift against the wrap point
+        for (uint32_t i = 0; i < 1 + round % 5; i++) {
+            if (kos_spsc_enqueue(&g_spsc, ITEM(next_in))) {
+                next_in++;
+            }
+        }
+        void* item;
+        for (uint32_t i = 0; i < 1 + round % 3; i++) {
+            if (kos_spsc_dequeue(&g_spsc, &item)) {
+                TEST_ASSERT(item == ITEM(next_out), "SPSC item out of order");
+                next_out++;
+            }
+        }
+    }
+    TEST_ASSERT(kos_spsc_count(&g_spsc) == next_in - next_out, "SPSC count wrong");
+
+    TEST_END();
+}
+
+// Test 3: Batches are cut to the free space and the items available
+void test_ring_spsc_batch(void) {
+    TEST_START("SPSC Partial Batches");
+
+    kos_spsc_init(&g_spsc, g_spsc_slots, RING_SMALL);
+
+    void* items[RING_SMALL + 4];
+    for (uint32_t i = 0; i < RING_SMALL + 4; i++) {
+        items[i] = ITEM(i + 1);
+    }
+
+    TEST_ASSERT(kos_spsc_enqueue_batch(&g_spsc, items, RING_SMALL + 4) == RING_SMALL, "Overfull batch not cut");
+    TEST_ASSERT(!kos_spsc_enqueue(&g_spsc, ITEM(99)), "Enqueue into full ring");
+
+    void* out[RING_SMALL + 4];
+    TEST_ASSERT(kos_spsc_dequeue_batch(&g_spsc, out, 3) == 3, "Short dequeue wrong");
+    TEST_ASSERT(kos_spsc_dequeue_batch(&g_spsc, out + 3, RING_SMALL + 4) == RING_SMALL - 3, "Long dequeue not cut");
+    for (uint32_t i = 0; i < RING_SMALL; i++) {
+        TEST_ASSERT(out[i] == items[i], "Batch item mismatch");
+    }
+    TEST_ASSERT(kos_spsc_dequeue_batch(&g_spsc, out, 1) == 0, "Dequeue from empty ring");
+
+    TEST_END();
+}
+
+// Test 4: MPSC consumer stops at a claimed but unpublished slot
+void test_ring_mpsc_publish(void) {
+    TEST_START("MPSC Publish Order");
+
+    kos_mpsc_init(&g_mpsc, g_mpsc_slots, RING_SMALL);
+
+    TEST_ASSERT(kos_mpsc_enqueue(&g_mpsc, ITEM(1)), "First enqueue failed");
+
+    // A producer that claimed slot 1 and was interrupted before publishing
+    uint32_t stalled = g_mpsc.head++;
+
+    TEST_ASSERT(kos_mpsc_enqueue(&g_mpsc, ITEM(3)), "Enqueue after stalled claim failed");
+
+    void* out[4];
+    TEST_ASSERT(kos_mpsc_dequeue_batch(&g_mpsc, out, 4) == 1, "Consumer read past unpublished slot");
+    TEST_ASSERT(out[0] == ITEM(1), "Wrong first item");
+
+    // The stalled producer finishes
+    g_mpsc_slots[stalled & (RING_SMALL - 1)].item = ITEM(2);
+    __atomic_store_n(&g_mpsc_slots[stalled & (RING_SMALL - 1)].sequence, stalled + 1, __ATOMIC_RELEASE);
+
+    TEST_ASSERT(kos_mpsc_dequeue_batch(&g_mpsc, out, 4) == 2, "Published items not visible");
+    TEST_ASSERT(out[0] == ITEM(2) && out[1] == ITEM(3), "Items out of order");
+
+    TEST_END();
+}
+
+// Test 5: MPSC fills, refuses and recovers across wraps
+void test_ring_mpsc_full(void) {
+    TEST_START("MPSC Full And Wrap");
+
+    kos_mpsc_init(&g_mpsc, g_mpsc_slots, RING_SMALL);
+
+    void* items[RING_SMALL];
+    void* out[RING_SMALL];
+    for (uint32_t lap = 0; lap < 5; lap++) {
+        for (uint32_t i = 0; i < RING_SMALL; i++) {
+            items[i] = ITEM(lap * RING_SMALL + i);
+        }
+        TEST_ASSERT(kos_mpsc_enqueue_batch(&g_mpsc, items, RING_SMALL) == RING_SMALL, "Batch into empty ring cut");
+        TEST_ASSERT(!kos_mpsc_enqueue(&g_mpsc, ITEM(0)), "Enqueue into full ring");
+        TEST_ASSERT(kos_mpsc_dequeue_batch(&g_mpsc, out, RING_SMALL) == RING_SMALL, "Full dequeue cut");
+        for (uint32_t i = 0; i < RING_SMALL; i++) {
+            TEST_ASSERT(out[i] == items[i], "Item mismatch after wrap");
+        }
+    }
+    TEST_ASSERT(kos_mpsc_count(&g_mpsc) == 0, "Ring not empty");
+
+    TEST_END();
+}
+
+// Test 6: Same-CPU throughput, single items against batches
+void test_ring_throughput(void) {
+    TEST_START("Throughput");
+
+    void* batch[BENCH_BATCH];
+    for (uint32_t i = 0; i < BENCH_BATCH; i++) {
+        batch[i] = ITEM(i);
+    }
+
+    kos_spsc_init(&g_spsc, g_spsc_slots, RING_BENCH);
+    kos_mpsc_init(&g_mpsc, g_mpsc_slots, RING_BENCH);
+
+    uint64_t moved = 0;
+    uint64_t start = kos_clock_cycles();
+    for (uint32_t i = 0; i < BENCH_ITEMS; i++) {
+        void* item;
+        kos_spsc_enqueue(&g_spsc, batch[0]);
+        moved += kos_spsc_dequeue(&g_spsc, &item);
+    }
+    uint64_t spsc_single = kos_clock_cycles() - start;
+
+    start = kos_clock_cycles();
+    for (uint32_t i = 0; i < BENCH_ITEMS / BENCH_BATCH; i++) {
+        kos_spsc_enqueue_batch(&g_spsc, batch, BENCH_BATCH);
+        moved += kos_spsc_dequeue_batch(&g_spsc, batch, BENCH_BATCH);
+    }
+    uint64_t spsc_batch = kos_clock_cycles() - start;
+
+    start = kos_clock_cycles();
+    for (uint32_t i = 0; i < BENCH_ITEMS; i++) {
+        void* item;
+        kos_mpsc_enqueue(&g_mpsc, batch[0]);
+        moved += kos_mpsc_dequeue(&g_mpsc, &item);
+    }
+    uint64_t mpsc_single = kos_clock_cycles() - start;
+
+    start = kos_clock_cycles();
+    for (uint32_t i = 0; i < BENCH_ITEMS / BENCH_BATCH; i++) {
+        kos_mpsc_enqueue_batch(&g_mpsc, batch, BENCH_BATCH);
+        moved += kos_mpsc_dequeue_batch(&g_mpsc, batch, BENCH_BATCH);
+    }
+    uint64_t mpsc_batch = kos_clock_cycles() - start;
+
+    TEST_ASSERT(moved == 4ULL * BENCH_ITEMS, "Benchmark lost items");
+
+    log_info("Ring throughput, cycles per item (single / batch of %d):", BENCH_BATCH);
+    log_info("  SPSC %u / %u", (uint32_t)(spsc_single / BENCH_ITEMS), (uint32_t)(spsc_batch / BENCH_ITEMS));
+    log_info("  MPSC %u / %u", (uint32_t)(mpsc_single / BENCH_ITEMS), (uint32_t)(mpsc_batch / BENCH_ITEMS));
+
+    TEST_END();
+}
+
+// Test runner
+void run_ring_tests(void) {
+    log_info("Starting Lock-Free Ring Tests...");
+
+    g_test_count = 0;
+
+    test_ring_init();
+    test_ring_spsc_order();
+    test_ring_spsc_batch();
+    test_ring_mpsc_publish();
+    test_ring_mpsc_full();
+    test_ring_throughput();
+
+    int passed = 0;
+    int failed = 0;
+
+    log_info("Ring Test Results:");
+    for (int i = 0; i < g_test_count; i++) {
+        if (g_test_results[i].passed) {
+            log_info("  ✓ %s", g_test_results[i].name);
+            passed++;
+        } else {
+            log_error("  ✗ %s: %s", g_test_results[i].name, g_test_results[i].error_msg);
+            failed++;
+        }
+    }
+
+    log_info("Ring Tests Summary: %d passed, %d failed", passed, failed);
+}
+
+// Entry point for ring testing
+void test_ring_system(void) {
+    run_ring_tests();
+}
@@ -12,6 +12,11 @@
 extern void test_memory_system(void);
 extern void test_logging_system(void);
 extern void test_integration_system(void);
+extern void test_timer_system(void);
+extern void test_ring_system(void);
+extern void test_workqueue_system(void);
+extern void test_wait_system(void);
+extern void test_switch_system(void);
 
 // Test suite structure
 typedef struct {
@@ -25,6 +30,11 @@ static test_suite_t g_test_suites[] = {
     {"Memory System", test_memory_system, true},
     {"Logging System", test_logging_system, true},
     {"Integration Tests", test_integration_system, true},
+    {"Timer Wheel", test_timer_system, true},
+    {"Lock-Free Rings", test_ring_system, true},
+    {"Work Queues", test_workqueue_system, true},
+    {"Wait Queues", test_wait_system, true},
+    {"Context Switch", test_switch_system, true},
 };
 
 static const int g_num_test_suites = sizeof(g_test_suites) / sizeof(test_suite_t);
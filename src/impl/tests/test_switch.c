@@ -0,0 +1,145 @@
+#include <stdint.h>
+#include <stddef.h>
+#include <stdbool.h>
+#include "kos/utils/string.h"
+#include "kos/process/process.h"
+#include "kos/cpu/irqflags.h"
+#include "debug/debug.h"
+
+// =============================================================================
+// KOS - Context Switch Test Suite
+// =============================================================================
+
+// Test framework
+typedef struct test_result {
+    char name[64];
+    bool passed;
+    const char* error_msg;
+} test_result_t;
+
+static test_result_t g_test_results[32];
+static int g_test_count = 0;
+
+#define TEST_ASSERT(condition, msg) \
+    do { \
+        if (!(condition)) { \
+            g_test_results[g_test_count].passed = false; \
+            g_test_results[g_test_count].error_msg = msg; \
+            g_test_count++; \
+            return; \
+        } \
+    } while(0)
+
+#define TEST_START(name_str) \
+    do { \
+        kos_strcpy(g_test_results[g_test_count].name, name_str); \
+        g_test_results[g_test_count].passed = true; \
+        g_test_results[g_test_count].error_msg = NULL; \
+    } while(0)
+
+#define TEST_END() \
+    do { \
+        g_test_count++; \
+    } while(0)
+
+static kos_cpu_context_t g_switch_main;
+static kos_cpu_context_t g_switch_peer;
+static uint8_t g_switch_stack[4096] __attribute__((aligned(16)));
+static volatile uint32_t g_switch_count = 0;
+static volatile uint32_t g_entry_runs = 0;
+static void* volatile g_entry_arg = NULL;
+
+// Peer side of the raw switch test, never returns
+static void switch_peer(void) {
+    while (true) {
+        g_switch_count++;
+        kos_context_switch(&g_switch_peer, &g_switch_main);
+    }
+}
+
+// Entry point of the spawned test process
+static int32_t process_entry(void* arg) {
+    g_entry_arg = arg;
+    g_entry_runs++;
+    return 42;
+}
+
+// Test 1: Switching to a peer stack and back resumes the caller intact
+void test_switch_raw(void) {
+    TEST_START("Raw Context Switch");
+
+    volatile uint64_t canary = 0x4B4F53;
+    kos_memset(&g_switch_peer, 0, sizeof(g_switch_peer));
+    g_switch_peer.rsp = (uint64_t)(uintptr_t)&g_switch_stack[sizeof(g_switch_stack)] - 8;
+    g_switch_peer.rip = (uint64_t)(uintptr_t)switch_peer;
+    g_switch_count = 0;
+
+    uint64_t flags = kos_local_irq_save();
+    for (int i = 0; i < 16; i++) {
+        kos_context_switch(&g_switch_main, &g_switch_peer);
+    }
+    kos_local_irq_restore(flags);
+
+    TEST_ASSERT(g_switch_count == 16, "Peer did not run once per switch");
+    TEST_ASSERT(canary == 0x4B4F53, "Caller stack clobbered");
+
+    TEST_END();
+}
+
+// Test 2: A spawned process starts at its entry and its return value is the exit code
+void test_switch_spawn(void) {
+    TEST_START("Process Entry And Exit");
+
+    kos_process_t* process = NULL;
+    int marker = 0;
+    g_entry_runs = 0;
+    g_entry_arg = NULL;
+
+    TEST_ASSERT(kos_process_spawn(&process, "switch-test", process_entry, &marker,
+                                  KOS_PROCESS_PRIORITY_NORMAL) == HAL_SUCCESS, "Spawn failed");
+    for (int i = 0; i < 4 && process->state != KOS_PROCESS_STATE_TERMINATED; i++) {
+        kos_process_yield();
+    }
+
+    bool terminated = process->state == KOS_PROCESS_STATE_TERMINATED;
+    int32_t exit_code = process->exit_code;
+    kos_process_destroy(process);
+
+    TEST_ASSERT(terminated, "Process never ran to completion");
+    TEST_ASSERT(g_entry_runs == 1, "Entry did not run exactly once");
+    TEST_ASSERT(g_entry_arg == &marker, "Entry got the wrong argument");
+    TEST_ASSERT(exit_code == 42, "Return value not kept as exit code");
+
+    TEST_END();
+}
+
+// Run all context switch tests
+void run_switch_tests(void) {
+    log_info("Starting Context Switch Tests...");
+
+    g_test_count = 0;
+
+    test_switch_raw();
+    test_switch_spawn();
+
+    int passed = 0;
+    int failed = 0;
+
+    log_info("Context Switch Test Results:");
+    for (int i = 0; i < g_test_count; i++) {
+        if (g_test_results[i].passed) {
+            log_info("  ✓ %s", g_test_results[i].name);
+            passed++;
+        } else {
+            log_error("  ✗ %s: %s", g_test_results[i].name, g_test_results[i].error_msg);
+            failed++;
+        }
+    }
+
+    log_info("Context Switch Tests Summary: %d passed, %d failed", passed, failed);
+}
+
+// Entry point for context switch testing
+void test_switch_system(void) {
+    run_switch_tests();
+}
@@ -0,0 +1,221 @@
+#include <stdint.h>
+#include <stddef.h>
+#include <stdbool.h>
+#include "kos/utils/string.h"
+#include "kos/time/timer.h"
+#include "kos/time/clocksource.h"
+#include "debug/debug.h"
+
+// =============================================================================
+// KOS - Timer Wheel Test Suite
+// =============================================================================
+
+// Test framework
+typedef struct test_result {
+    char name[64];
+    bool passed;
+    const char* error_msg;
+} test_result_t;
+
+static test_result_t g_test_results[32];
+static int g_test_count = 0;
+
+#define TEST_ASSERT(condition, msg) \
+    do { \
+        if (!(condition)) { \
+            g_test_results[g_test_count].passed = false; \
+            g_test_results[g_test_count].error_msg = msg; \
+            g_test_count++; \
+            return; \
+        } \
+    } while(0)
+
+#define TEST_START(name_str) \
+    do { \
+        kos_strcpy(g_test_results[g_test_count].name, name_str); \
+        g_test_results[g_test_count].passed = true; \
+        g_test_results[g_test_count].error_msg = NULL; \
+    } while(0)
+
+#define TEST_END() \
+    do { \
+        g_test_count++; \
+    } while(0)
+
+#define MS(x) ((uint64_t)(x) * KOS_NSEC_PER_MSEC)
+#define BATCH_TIMERS 512
+
+// Private wheel driven with simulated time
+static kos_timer_base_t g_test_base;
+static kos_timer_t g_test_timers[BATCH_TIMERS];
+static uint32_t g_fired;
+
+static void count_callback(void* context) {
+    (void)context;
+    g_fired++;
+}
+
+// Re-arming callback state
+typedef struct {
+    kos_timer_t timer;
+    uint64_t next_ns;
+    uint32_t remaining;
+} rearm_state_t;
+
+static void rearm_callback(void* context) {
+    rearm_state_t* state = (rearm_state_t*)context;
+    g_fired++;
+    if (--state->remaining > 0) {
+        state->next_ns += MS(10);
+        kos_timer_base_add(&g_test_base, &state->timer, state->next_ns);
+    }
+}
+
+// Test 1: Timers expire at their tick across wheel levels
+void test_timer_expiry_levels(void) {
+    TEST_START("Expiry Across Levels");
+
+    kos_timer_base_init(&g_test_base, 0);
+    g_fired = 0;
+
+    kos_timer_init(&g_test_timers[0], count_callback, NULL);
+    kos_timer_init(&g_test_timers[1], count_callback, NULL);
+    kos_timer_init(&g_test_timers[2], count_callback, NULL);
+
+    kos_timer_base_add(&g_test_base, &g_test_timers[0], MS(5));       // Level 0
+    kos_timer_base_add(&g_test_base, &g_test_timers[1], MS(300));     // Level 1
+    kos_timer_base_add(&g_test_base, &g_test_timers[2], MS(20000));   // Level 2
+
+    kos_timer_base_run(&g_test_base, MS(4));
+    TEST_ASSERT(g_fired == 0, "Timer fired early");
+
+    kos_timer_base_run(&g_test_base, MS(5));
+    TEST_ASSERT(g_fired == 1, "Level 0 timer did not fire on time");
+
+    kos_timer_base_run(&g_test_base, MS(299));
+    TEST_ASSERT(g_fired == 1, "Cascaded timer fired early");
+
+    kos_timer_base_run(&g_test_base, MS(300));
+    TEST_ASSERT(g_fired == 2, "Level 1 timer did not fire on time");
+
+    kos_timer_base_run(&g_test_base, MS(20000));
+    TEST_ASSERT(g_fired == 3, "Level 2 timer did not fire on time");
+    TEST_ASSERT(g_test_base.stats.pending == 0, "Pending count not zero");
+
+    TEST_END();
+}
+
+// Test 2: Cancelled timers never fire
+void test_timer_cancel(void) {
+    TEST_START("Cancel");
+
+    kos_timer_base_init(&g_test_base, 0);
+    g_fired = 0;
+
+    kos_timer_init(&g_test_timers[0], count_callback, NULL);
+    kos_timer_base_add(&g_test_base, &g_test_timers[0], MS(50));
+    TEST_ASSERT(kos_timer_pending(&g_test_timers[0]), "Timer not pending after add");
+
+    TEST_ASSERT(kos_timer_cancel(&g_test_timers[0]), "Cancel of pending timer failed");
+    TEST_ASSERT(!kos_timer_cancel(&g_test_timers[0]), "Second cancel reported pending");
+
+    kos_timer_base_run(&g_test_base, MS(100));
+    TEST_ASSERT(g_fired == 0, "Cancelled timer fired");
+    TEST_ASSERT(g_test_base.stats.pending == 0, "Pending count not zero");
+
+    TEST_END();
+}
+
+// Test 3: Modifying a timer moves its deadline
+void test_timer_mod(void) {
+    TEST_START("Modify Deadline");
+
+    kos_timer_base_init(&g_test_base, 0);
+    g_fired = 0;
+
+    kos_timer_init(&g_test_timers[0], count_callback, NULL);
+    kos_timer_base_add(&g_test_base, &g_test_timers[0], MS(10));
+    TEST_ASSERT(kos_timer_mod(&g_test_timers[0], MS(1000)), "Mod did not report pending");
+
+    kos_timer_base_run(&g_test_base, MS(500));
+    TEST_ASSERT(g_fired == 0, "Timer fired at old deadline");
+
+    kos_timer_base_run(&g_test_base, MS(1000));
+    TEST_ASSERT(g_fired == 1, "Timer did not fire at new deadline");
+
+    TEST_END();
+}
+
+// Test 4: Timers sharing a tick expire as one batch
+void test_timer_batch(void) {
+    TEST_START("Batched Expiry");
+
+    kos_timer_base_init(&g_test_base, 0);
+    g_fired = 0;
+
+    for (int i = 0; i < BATCH_TIMERS; i++) {
+        kos_timer_init(&g_test_timers[i], count_callback, NULL);
+        kos_timer_base_add(&g_test_base, &g_test_timers[i], MS(700));
+    }
+    TEST_ASSERT(g_test_base.stats.pending == BATCH_TIMERS, "Pending count wrong");
+
+    uint32_t fired = kos_timer_base_run(&g_test_base, MS(700));
+    TEST_ASSERT(fired == BATCH_TIMERS, "Not all timers fired");
+    TEST_ASSERT(g_test_base.stats.max_batch == BATCH_TIMERS, "Timers not expired as one batch");
+
+    TEST_END();
+}
+
+// Test 5: Callbacks may re-arm their own timer
+void test_timer_rearm(void) {
+    TEST_START("Re-arm From Callback");
+
+    static rearm_state_t state;
+    kos_timer_base_init(&g_test_base, 0);
+    g_fired = 0;
+
+    state.remaining = 5;
+    state.next_ns = MS(10);
+    kos_timer_init(&state.timer, rearm_callback, &state);
+    kos_timer_base_add(&g_test_base, &state.timer, state.next_ns);
+
+    kos_timer_base_run(&g_test_base, MS(100));
+    TEST_ASSERT(g_fired == 5, "Periodic re-arm did not fire five times");
+    TEST_ASSERT(!kos_timer_pending(&state.timer), "Timer still pending");
+
+    TEST_END();
+}
+
+// Test runner
+void run_timer_tests(void) {
+    log_info("Starting Timer Wheel Tests...");
+
+    g_test_count = 0;
+
+    test_timer_expiry_levels();
+    test_timer_cancel();
+    test_timer_mod();
+    test_timer_batch();
+    test_timer_rearm();
+
+    int passed = 0;
+    int failed = 0;
+
+    log_info("Timer Test Results:");
+    for (int i = 0; i < g_test_count; i++) {
+        if (g_test_results[i].passed) {
+            log_info("  ✓ %s", g_test_results[i].name);
+            passed++;
+        } else {
+            log_error("  ✗ %s: %s", g_test_results[i].name, g_test_results[i].error_msg);
+            failed++;
+        }
+    }
+
+    log_info("Timer Tests Summary: %d passed, %d failed", passed, failed);
+}
+
+// Entry point for timer testing
+void test_timer_system(void) {
+    run_timer_tests();
+}
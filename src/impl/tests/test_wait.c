@@ -0,0 +1,184 @@
+#include <stdint.h>
+#include <stddef.h>
+#include <stdbool.h>
+#include "kos/utils/string.h"
+#include "kos/sync/wait.h"
+#include "kos/sync/futex.h"
+#include "kos/time/timer.h"
+#include "kos/time/clock.h"
+#include "debug/debug.h"
+
+// =============================================================================
+// KOS - Wait Queue Test Suite
+// =============================================================================
+
+// Test framework
+typedef struct test_result {
+    char name[64];
+    bool passed;
+    const char* error_msg;
+} test_result_t;
+
+static test_result_t g_test_results[32];
+static int g_test_count = 0;
+
+#define TEST_ASSERT(condition, msg) \
+    do { \
+        if (!(condition)) { \
+            g_test_results[g_test_count].passed = false; \
+            g_test_results[g_test_count].error_msg = msg; \
+            g_test_count++; \
+            return; \
+        } \
+    } while(0)
+
+#define TEST_START(name_str) \
+    do { \
+        kos_strcpy(g_test_results[g_test_count].name, name_str); \
+        g_test_results[g_test_count].passed = true; \
+        g_test_results[g_test_count].error_msg = NULL; \
+    } while(0)
+
+#define TEST_END() \
+    do { \
+        g_test_count++; \
+    } while(0)
+
+static kos_wait_queue_t g_test_wq = KOS_WAIT_QUEUE_INIT;
+static volatile uint32_t g_wait_flag = 0;
+
+// Timer callback standing in for another CPU: set the condition, then wake
+static void wait_set_flag(void* context) {
+    (void)context;
+    __atomic_store_n(&g_wait_flag, 1, __ATOMIC_RELEASE);
+    kos_wake_up(&g_test_wq);
+}
+
+// Timer callback for the futex variant
+static void futex_set_flag(void* context) {
+    (void)context;
+    __atomic_store_n(&g_wait_flag, 1, __ATOMIC_RELEASE);
+    kos_futex_wake(&g_wait_flag, 1);
+}
+
+// Test 1: A wakeup takes every plain waiter and only one exclusive waiter
+void test_wait_exclusive(void) {
+    TEST_START("Exclusive Wakeup");
+
+    kos_wait_entry_t plain[2];
+    kos_wait_entry_t exclusive[3];
+
+    for (int i = 0; i < 2; i++) {
+        kos_wait_entry_init(&plain[i], 0, KOS_WAIT_KEY_ANY);
+        kos_wait_prepare(&g_test_wq, &plain[i]);
+    }
+    for (int i = 0; i < 3; i++) {
+        kos_wait_entry_init(&exclusive[i], KOS_WAIT_EXCLUSIVE, KOS_WAIT_KEY_ANY);
+        kos_wait_prepare(&g_test_wq, &exclusive[i]);
+    }
+
+    TEST_ASSERT(kos_wake_up(&g_test_wq) == 3, "Wrong number of waiters woken");
+    TEST_ASSERT(plain[0].woken && plain[1].woken, "Plain waiter left asleep");
+    TEST_ASSERT(exclusive[0].woken, "First exclusive waiter not woken");
+    TEST_ASSERT(!exclusive[1].woken && !exclusive[2].woken, "Herd of exclusive waiters woken");
+    TEST_ASSERT(kos_wake_up_all(&g_test_wq) == 2, "Wake all missed waiters");
+    TEST_ASSERT(!kos_wait_queue_active(&g_test_wq), "Queue not empty");
+    TEST_ASSERT(kos_wake_up(&g_test_wq) == 0, "Woke an empty queue");
+
+    for (int i = 0; i < 2; i++) {
+        kos_wait_finish(&g_test_wq, &plain[i]);
+    }
+    for (int i = 0; i < 3; i++) {
+        kos_wait_finish(&g_test_wq, &exclusive[i]);
+    }
+
+    TEST_END();
+}
+
+// Test 2: kos_wait_event returns once a wakeup follows the condition
+void test_wait_event(void) {
+    TEST_START("Wait Event");
+
+    kos_timer_t timer;
+    g_wait_flag = 0;
+    kos_timer_init(&timer, wait_set_flag, NULL);
+    kos_timer_add_relative(&timer, 5 * KOS_NSEC_PER_MSEC);
+
+    kos_result_t result;
+    kos_wait_event_timeout(&g_test_wq, g_wait_flag != 0, KOS_NSEC_PER_SEC, &result);
+    kos_timer_cancel_sync(&timer);
+    TEST_ASSERT(result == KOS_SUCCESS, "Wait timed out despite the wakeup");
+    TEST_ASSERT(g_wait_flag == 1, "Returned before the condition held");
+
+    TEST_END();
+}
+
+// Test 3: A timed wait on a condition nobody sets times out
+void test_wait_timeout(void) {
+    TEST_START("Wait Timeout");
+
+    uint64_t start = kos_clock_monotonic_ns();
+    kos_result_t result;
+    kos_wait_event_timeout(&g_test_wq, false, 5 * KOS_NSEC_PER_MSEC, &result);
+    TEST_ASSERT(result == KOS_ERROR_TIMEOUT, "Wait did not time out");
+    TEST_ASSERT(kos_clock_monotonic_ns() - start >= 5 * KOS_NSEC_PER_MSEC, "Timed out early");
+    TEST_ASSERT(!kos_wait_queue_active(&g_test_wq), "Entry left queued");
+
+    TEST_END();
+}
+
+// Test 4: Futex wait checks the word and is woken by address
+void test_futex_wait_wake(void) {
+    TEST_START("Futex Wait And Wake");
+
+    kos_timer_t timer;
+    g_wait_flag = 0;
+
+    TEST_ASSERT(kos_futex_wait(&g_wait_flag, 1, 0) == KOS_ERROR_INVALID_STATE, "Slept on a stale value");
+    TEST_ASSERT(kos_futex_wait((volatile uint32_t*)((uintptr_t)&g_wait_flag + 1), 0, 0) == KOS_ERROR_INVALID_PARAM,
+                "Misaligned word accepted");
+    TEST_ASSERT(kos_futex_wake(&g_wait_flag, 1) == 0, "Woke a futex nobody waits on");
+
+    kos_timer_init(&timer, futex_set_flag, NULL);
+    kos_timer_add_relative(&timer, 5 * KOS_NSEC_PER_MSEC);
+    kos_result_t result = kos_futex_wait(&g_wait_flag, 0, KOS_NSEC_PER_SEC);
+    kos_timer_cancel_sync(&timer);
+    TEST_ASSERT(result == KOS_SUCCESS, "Futex wait missed the wake");
+    TEST_ASSERT(kos_futex_wait(&g_wait_flag, 1, 5 * KOS_NSEC_PER_MSEC) == KOS_ERROR_TIMEOUT,
+                "Futex wait did not time out");
+
+    TEST_END();
+}
+
+// Run all wait queue tests
+void run_wait_tests(void) {
+    log_info("Starting Wait Queue Tests...");
+
+    g_test_count = 0;
+
+    test_wait_exclusive();
+    test_wait_event();
+    test_wait_timeout();
+    test_futex_wait_wake();
+
+    int passed = 0;
+    int failed = 0;
+
+    log_info("Wait Queue Test Results:");
+    for (int i = 0; i < g_test_count; i++) {
+        if (g_test_results[i].passed) {
+            log_info("  ✓ %s", g_test_results[i].name);
+            passed++;
+        } else {
+            log_error("  ✗ %s: %s", g_test_results[i].name, g_test_results[i].error_msg);
+            failed++;
+        }
+    }
+
+    log_info("Wait Queue Tests Summary: %d passed, %d failed", passed, failed);
+}
+
+// Entry point for wait queue testing
+void test_wait_system(void) {
+    run_wait_tests();
+}
@@ -0,0 +1,236 @@
+#include <stdint.h>
+#include <stddef.h>
+#include <stdbool.h>
+#include "kos/utils/string.h"
+#include "kos/process/workqueue.h"
+#include "kos/time/clock.h"
+#include "debug/debug.h"
+
+// =============================================================================
+// KOS - Work Queue Test Suite
+// =============================================================================
+
+// Test framework
+typedef struct test_result {
+    char name[64];
+    bool passed;
+    const char* error_msg;
+} test_result_t;
+
+static test_result_t g_test_results[32];
+static int g_test_count = 0;
+
+#define TEST_ASSERT(condition, msg) \
+    do { \
+        if (!(condition)) { \
+            g_test_results[g_test_count].passed = false; \
+            g_test_results[g_test_count].error_msg = msg; \
+            g_test_count++; \
+            return; \
+        } \
+    } while(0)
+
+#define TEST_START(name_str) \
+    do { \
+        kos_strcpy(g_test_results[g_test_count].name, name_str); \
+        g_test_results[g_test_count].passed = true; \
+        g_test_results[g_test_count].error_msg = NULL; \
+    } while(0)
+
+#define TEST_END() \
+    do { \
+        g_test_count++; \
+    } while(0)
+
+#define RANGE_SIZE      1000
+#define RANGE_CHUNK     7
+
+// Private queue, the suite itself runs as an item of the system queue
+static kos_workqueue_t* g_test_wq = NULL;
+
+static volatile uint32_t g_work_runs = 0;
+static uint8_t g_range_hits[RANGE_SIZE];
+static kos_work_item_t g_self_work;
+static volatile bool g_self_cancelled = false;
+
+static void count_work(void* data) {
+    (void)data;
+    __atomic_fetch_add(&g_work_runs, 1, __ATOMIC_RELAXED);
+}
+
+// Flushes its own queue and cancels itself, both must return
+static void self_flush_work(void* data) {
+    (void)data;
+    kos_flush_workqueue(g_test_wq);
+    g_self_cancelled = kos_cancel_work(&g_self_work);
+    kos_flush_work(&g_self_work);
+    __atomic_fetch_add(&g_work_runs, 1, __ATOMIC_RELAXED);
+}
+
+static kos_result_t mark_range(uint64_t start, uint64_t end, void* arg) {
+    (void)arg;
+    for (uint64_t i = start; i < end; i++) {
+        __atomic_fetch_add(&g_range_hits[i], 1, __ATOMIC_RELAXED);
+    }
+    return KOS_SUCCESS;
+}
+
+static kos_result_t fail_range(uint64_t start, uint64_t end, void* arg) {
+    (void)end;
+    (void)arg;
+    return start == 0 ? KOS_ERROR_IO_ERROR : KOS_SUCCESS;
+}
+
+// Test 1: A queued item runs once and cannot be queued twice while pending
+void test_workqueue_queue_flush(void) {
+    TEST_START("Queue And Flush");
+
+    kos_work_item_t work = KOS_WORK_ITEM_INIT(count_work, NULL);
+    g_work_runs = 0;
+
+    TEST_ASSERT(kos_queue_work(g_test_wq, &work), "Queue refused an idle item");
+    TEST_ASSERT(!kos_queue_work(g_test_wq, &work), "Pending item queued twice");
+    kos_flush_work(&work);
+    TEST_ASSERT(g_work_runs == 1, "Item did not run exactly once");
+    TEST_ASSERT(!work.pending, "Item still pending after flush");
+
+    TEST_END();
+}
+
+// Test 2: Cancelling a pending item keeps it from running
+void test_workqueue_cancel(void) {
+    TEST_START("Cancel Pending Item");
+
+    kos_work_item_t work = KOS_WORK_ITEM_INIT(count_work, NULL);
+    g_work_runs = 0;
+
+    // Nothing runs the calling CPU's pool until we flush it
+    TEST_ASSERT(kos_queue_work(g_test_wq, &work), "Queue refused an idle item");
+    TEST_ASSERT(kos_cancel_work(&work), "Cancel missed a pending item");
+    TEST_ASSERT(!kos_cancel_work(&work), "Cancel reported an idle item");
+    kos_flush_workqueue(g_test_wq);
+    TEST_ASSERT(g_work_runs == 0, "Cancelled item ran");
+
+    TEST_END();
+}
+
+// Test 3: Flushing a queue waits for everything queued before it
+void test_workqueue_flush_queue(void) {
+    TEST_START("Flush Work Queue");
+
+    kos_work_item_t items[4];
+    g_work_runs = 0;
+    for (int i = 0; i < 4; i++) {
+        kos_work_item_init(&items[i], count_work, NULL);
+        TEST_ASSERT(kos_queue_work(g_test_wq, &items[i]), "Queue refused an idle item");
+    }
+    kos_flush_workqueue(g_test_wq);
+    TEST_ASSERT(g_work_runs == 4, "Flush returned before all items ran");
+
+    TEST_END();
+}
+
+// Test 4: Delayed work can be cancelled before its timer fires
+void test_workqueue_delayed_cancel(void) {
+    TEST_START("Cancel Delayed Work");
+
+    kos_delayed_work_t dwork;
+    kos_delayed_work_init(&dwork, count_work, NULL);
+    g_work_runs = 0;
+
+    TEST_ASSERT(kos_queue_delayed_work(g_test_wq, &dwork, 1000 * KOS_NSEC_PER_MSEC), "Delayed queue refused");
+    TEST_ASSERT(!kos_queue_delayed_work(g_test_wq, &dwork, 1000 * KOS_NSEC_PER_MSEC), "Delayed item queued twice");
+    TEST_ASSERT(kos_cancel_delayed_work(&dwork), "Cancel missed the armed timer");
+    TEST_ASSERT(!dwork.work.pending, "Item still pending after cancel");
+    TEST_ASSERT(g_work_runs == 0, "Cancelled delayed item ran");
+
+    TEST_END();
+}
+
+// Test 5: parallel_for covers the range exactly once
+void test_workqueue_parallel_cover(void) {
+    TEST_START("Parallel For Coverage");
+
+    kos_memset(g_range_hits, 0, sizeof(g_range_hits));
+    TEST_ASSERT(kos_parallel_for(0, RANGE_SIZE, RANGE_CHUNK, mark_range, NULL) == KOS_SUCCESS,
+                "parallel_for failed");
+    for (int i = 0; i < RANGE_SIZE; i++) {
+        TEST_ASSERT(g_range_hits[i] == 1, "Index not visited exactly once");
+    }
+
+    TEST_END();
+}
+
+// Test 6: parallel_for reports chunk errors and rejects bad arguments
+void test_workqueue_parallel_errors(void) {
+    TEST_START("Parallel For Errors");
+
+    TEST_ASSERT(kos_parallel_for(0, RANGE_SIZE, RANGE_CHUNK, fail_range, NULL) == KOS_ERROR_IO_ERROR,
+                "Chunk error was lost");
+    TEST_ASSERT(kos_parallel_for(0, RANGE_SIZE, 0, mark_range, NULL) == KOS_ERROR_INVALID_PARAM,
+                "Zero chunk accepted");
+    TEST_ASSERT(kos_parallel_for(5, 5, RANGE_CHUNK, mark_range, NULL) == KOS_SUCCESS,
+                "Empty range failed");
+
+    TEST_END();
+}
+
+// Test 7: An item may flush its own queue and cancel itself without hanging
+void test_workqueue_self_flush(void) {
+    TEST_START("Flush From Work Item");
+
+    kos_work_item_init(&g_self_work, self_flush_work, NULL);
+    g_work_runs = 0;
+    g_self_cancelled = true;
+
+    TEST_ASSERT(kos_queue_work(g_test_wq, &g_self_work), "Queue refused an idle item");
+    kos_flush_work(&g_self_work);
+    TEST_ASSERT(g_work_runs == 1, "Item did not run exactly once");
+    TEST_ASSERT(!g_self_cancelled, "Running item reported as pending");
+
+    TEST_END();
+}
+
+// Run all work queue tests
+void run_workqueue_tests(void) {
+    log_info("Starting Work Queue Tests...");
+
+    g_test_count = 0;
+    kos_workqueue_init();
+    if (!g_test_wq) {
+        g_test_wq = kos_workqueue_create("test", 0);
+    }
+    if (!g_test_wq) {
+        log_error("Work Queue Tests: no free queue");
+        return;
+    }
+
+    test_workqueue_queue_flush();
+    test_workqueue_cancel();
+    test_workqueue_flush_queue();
+    test_workqueue_delayed_cancel();
+    test_workqueue_parallel_cover();
+    test_workqueue_parallel_errors();
+    test_workqueue_self_flush();
+
+    int passed = 0;
+    int failed = 0;
+
+    log_info("Work Queue Test Results:");
+    for (int i = 0; i < g_test_count; i++) {
+        if (g_test_results[i].passed) {
+            log_info("  ✓ %s", g_test_results[i].name);
+            passed++;
+        } else {
+            log_error("  ✗ %s: %s", g_test_results[i].name, g_test_results[i].error_msg);
+            failed++;
+        }
+    }
+
+    log_info("Work Queue Tests Summary: %d passed, %d failed", passed, failed);
+}
+
+// Entry point for work queue testing
+void test_workqueue_system(void) {
+    run_workqueue_tests();
+}
@@ -0,0 +1,90 @@
+; ap_trampoline.asm - Application processor startup, real mode to long mode
+;
+; Copied to AP_TRAMPOLINE_BASE before each startup IPI, so every address
+; below goes through TRAMP(). The BSP fills the parameter block at the end,
+; its layout must match kos_smp_trampoline_t in kos/cpu/smp.c.
+
+global ap_trampoline_start
+global ap_trampoline_params
+global ap_trampoline_end
+
+%define AP_TRAMPOLINE_BASE 0x8000
+%define TRAMP(x) ((x) - ap_trampoline_start + AP_TRAMPOLINE_BASE)
+
+section .text
+
+bits 16
+ap_trampoline_start:
+    cli
+    cld
+    xor ax, ax
+    mov ds, ax
+    lgdt [TRAMP(ap_gdt.pointer)]
+    mov eax, cr0
+    or eax, 1
+    mov cr0, eax
+    jmp dword 0x08:TRAMP(ap_protected_mode)
+
+bits 32
+ap_protected_mode:
+    mov ax, 0x10
+    mov ds, ax
+    mov es, ax
+    mov ss, ax
+
+    ; Same paging, CR4 and EFER as the BSP
+    mov eax, [TRAMP(ap_trampoline_params.cr4)]
+    mov cr4, eax
+    mov eax, [TRAMP(ap_trampoline_params.cr3)]
+    mov cr3, eax
+    mov ecx, 0xC0000080
+    mov eax, [TRAMP(ap_trampoline_params.efer)]
+    mov edx, [TRAMP(ap_trampoline_params.efer) + 4]
+    wrmsr
+    mov eax, cr0
+    or eax, 1 << 31
+    mov cr0, eax
+    jmp 0x18:TRAMP(ap_long_mode)
+
+bits 64
+ap_long_mode:
+    mov ax, 0x10
+    mov ds, ax
+    mov es, ax
+    mov ss, ax
+    mov fs, ax
+    mov gs, ax
+
+    mov rsp, [TRAMP(ap_trampoline_params.stack)]
+    mov edi, [TRAMP(ap_trampoline_params.cpu_id)]
+    mov rax, [TRAMP(ap_trampoline_params.entry)]
+    mov dword [TRAMP(ap_trampoline_params.started)], 1
+    xor ebp, ebp
+    call rax                    ; Does not return
+.halt:
+    cli
+    hlt
+    jmp .halt
+
+; Temporary GDT: 32-bit code, data, 64-bit code
+align 8
+ap_gdt:
+    dq 0
+    dq 0x00CF9A000000FFFF
+    dq 0x00CF92000000FFFF
+    dq 0x00AF9A000000FFFF
+.pointer:
+    dw ap_gdt.pointer - ap_gdt - 1
+    dd TRAMP(ap_gdt)
+
+align 8
+ap_trampoline_params:
+.cr3:       dq 0
+.cr4:       dq 0
+.efer:      dq 0
+.stack:     dq 0
+.entry:     dq 0
+.cpu_id:    dd 0
+.started:   dd 0
+
+ap_trampoline_end:
@@ -14,12 +14,12 @@ gdt64:
 .data_segment: equ gdt64 + 16
     dq (1 << 47) | (1 << 44) | (1 << 53)
 
-.user_code_segment: equ gdt64 + 24
-    dq (1 << 47) | (3 << 45) | (1 << 43) | (1 << 44) | (1 << 53)
-
-.user_data_segment: equ gdt64 + 32
+.user_data_segment: equ gdt64 + 24
     dq (1 << 47) | (3 << 45) | (1 << 44) | (1 << 53)
 
+.user_code_segment: equ gdt64 + 32
+    dq (1 << 47) | (3 << 45) | (1 << 43) | (1 << 44) | (1 << 53)
+
 .pointer:
     dw gdt64_end - gdt64 - 1
     dq gdt64
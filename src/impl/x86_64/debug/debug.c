@@ -1,11 +1,18 @@
 #include "ports.h"
 #include "string.h"
 #include "debug.h"
+#include "kos/interrupts/softirq.h"
+#include "kos/sync/spinlock.h"
 #include <stdarg.h>
 #include <stddef.h>
 
 #define SERIAL_PORT 0x3F8
 
+// Bytes logged from IRQ context wait here for the worker, so interrupt
+// handlers never spin on the UART with interrupts off
+#define SERIAL_DEFER_SIZE 4096
+#define SERIAL_DEFER_CHUNK 64
+
 #define DEBUG_MODE 1
 
 const char* LOG_TYPE_STR[] = {
@@ -137,10 +144,80 @@ void log_message(const char* func, const char* message, const log_type_t type)
 	serial_print("\n");
 }
 
-void serial_write(char c) {
-	#if DEBUG_MODE
+static char serial_defer_buffer[SERIAL_DEFER_SIZE];
+static uint32_t serial_defer_head = 0;
+static uint32_t serial_defer_tail = 0;
+static kos_spinlock_t serial_defer_lock = KOS_SPINLOCK_INIT;
+
+// Poll the UART until it takes one byte
+static void serial_transmit(char c) {
     while ((port_byte_in(SERIAL_PORT + 5) & 0x20) == 0);
     port_byte_out(SERIAL_PORT, c);
+}
+
+// Write out the bytes queued from IRQ context, a chunk per lock hold
+static void serial_defer_flush(void) {
+    char chunk[SERIAL_DEFER_CHUNK];
+
+    for (;;) {
+        uint32_t count = 0;
+        uint64_t flags = kos_spin_lock_irqsave(&serial_defer_lock);
+        while (serial_defer_tail != serial_defer_head && count < SERIAL_DEFER_CHUNK) {
+            chunk[count++] = serial_defer_buffer[serial_defer_tail % SERIAL_DEFER_SIZE];
+            serial_defer_tail++;
+        }
+        kos_spin_unlock_irqrestore(&serial_defer_lock, flags);
+
+        if (count == 0) {
+            return;
+        }
+        for (uint32_t i = 0; i < count; i++) {
+            serial_transmit(chunk[i]);
+        }
+    }
+}
+
+// Worker callback, drains the queue with interrupts enabled
+static void serial_defer_worker(void* data) {
+    (void)data;
+    serial_defer_flush();
+}
+
+static kos_work_t serial_defer_work = KOS_WORK_INIT(serial_defer_worker, NULL);
+
+// Queue a byte from IRQ context, false when the queue is full
+static bool serial_defer_push(char c) {
+    uint64_t flags = kos_spin_lock_irqsave(&serial_defer_lock);
+
+    if (serial_defer_head - serial_defer_tail >= SERIAL_DEFER_SIZE) {
+        kos_spin_unlock_irqrestore(&serial_defer_lock, flags);
+        return false;
+    }
+
+    bool was_empty = serial_defer_head == serial_defer_tail;
+    serial_defer_buffer[serial_defer_head % SERIAL_DEFER_SIZE] = c;
+    serial_defer_head++;
+    kos_spin_unlock_irqrestore(&serial_defer_lock, flags);
+
+    if (was_empty) {
+        kos_work_queue(&serial_defer_work);
+    }
+    return true;
+}
+
+void serial_write(char c) {
+	#if DEBUG_MODE
+    if (kos_in_interrupt()) {
+        if (serial_defer_push(c)) {
+            return;
+        }
+    }
+
+    // Keep the output in order, and write it out inline once the queue is full
+    if (__atomic_load_n(&serial_defer_head, __ATOMIC_RELAXED) != serial_defer_tail) {
+        serial_defer_flush();
+    }
+    serial_transmit(c);
 	#endif
 }
 
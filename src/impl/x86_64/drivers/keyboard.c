@@ -6,6 +6,8 @@
 #include "keyboard.h"
 #include "vga.h"
 #include "cursor.h"
+#include "kos/interrupts/interrupt.h"
+#include "kos/interrupts/softirq.h"
 #include <stdint.h>
 
 static keycode_t scancode_map[128] = {
@@ -127,6 +129,17 @@ static int index_listener_realese = 0;
 
 int extended;
 
+// Scancodes queued by the interrupt, drained by the worker
+#define SCANCODE_QUEUE_SIZE 64
+static volatile uint8_t scancode_queue[SCANCODE_QUEUE_SIZE];
+static volatile uint32_t scancode_head = 0;
+static volatile uint32_t scancode_tail = 0;
+static uint32_t scancode_dropped = 0;
+
+void handle_scancode(uint8_t sc, int is_release);
+static void keyboard_work(void* data);
+static kos_work_t keyboard_work_item = KOS_WORK_INIT(keyboard_work, NULL);
+
 void add_keyboard_listener(key_pressed_fn a_listener)
 {
     if (index_listener >= MAX_LISTENER)
@@ -147,22 +160,48 @@ void add_keyboard_release_listener(key_realesed_fn a_listener)
     _listener_realese[index_listener_realese++] = a_listener;
 }
 
+// Top half: acknowledge the controller and queue the scancode
 void keyboard_callback()
 {
-    int is_release;
-
     uint8_t scancode = port_byte_in(0x60);
-    is_release = scancode & 0x80;
 
-    // Bounds checking for scancode
-    uint8_t scancode_index = scancode & 0x7F;
-    if (scancode_index >= 128) {
-        return; // Invalid scancode, ignore
+    uint32_t next = (scancode_head + 1) % SCANCODE_QUEUE_SIZE;
+    if (next == scancode_tail) {
+        scancode_dropped++;
+        return;
     }
 
-    keycode_t key_released = scancode_map[scancode_index];
+    scancode_queue[scancode_head] = scancode;
+    scancode_head = next;
+
+    kos_work_queue(&keyboard_work_item);
+}
+
+static kos_irq_return_t keyboard_irq_handler(uint32_t irq, void* context)
+{
+    (void)irq;
+    (void)context;
+    keyboard_callback();
+    return KOS_IRQ_HANDLED;
+}
 
-    handle_scancode(scancode, is_release);
+void keyboard_install()
+{
+    kos_interrupt_register_handler(KOS_IRQ_KEYBOARD, keyboard_irq_handler, NULL, "PS/2 keyboard");
+}
+
+// Bottom half: decode scancodes and notify listeners with interrupts enabled
+static void keyboard_work(void* data)
+{
+    (void)data;
+
+    while (scancode_tail != scancode_head)
+    {
+        uint8_t scancode = scancode_queue[scancode_tail];
+        scancode_tail = (scancode_tail + 1) % SCANCODE_QUEUE_SIZE;
+
+        handle_scancode(scancode, scancode & 0x80);
+    }
 }
 
 void handle_scancode(uint8_t sc, int is_release)
@@ -1,6 +1,8 @@
 #include <stdint.h>
 #include <string.h>
 #include "idt.h"
+#include "kos/interrupts/interrupt.h"
+#include "kos/cpu/ipi.h"
 
 extern void load_idt(struct IDTPointer* idt_ptr);
 extern void irq0_stub(); extern void irq1_stub(); extern void irq2_stub(); extern void irq3_stub();
@@ -8,6 +10,8 @@ extern void irq4_stub(); extern void irq5_stub(); extern void irq6_stub(); exter
 extern void irq8_stub(); extern void irq9_stub(); extern void irq10_stub(); extern void irq11_stub();
 extern void irq12_stub(); extern void irq13_stub(); extern void irq14_stub(); extern void irq15_stub();
 extern void isr128();
+extern const uint64_t irq_dynamic_stubs[KOS_IRQ_DYNAMIC_COUNT];
+extern const uint64_t ipi_stubs[KOS_IPI_VECTOR_COUNT];
 
 static struct IDTEntry idt[IDT_ENTRIES];
 static struct IDTPointer idt_ptr;
@@ -40,8 +44,19 @@ void init_idt(void) {
     set_idt_gate(45, (uint64_t)irq13_stub, 0x08, 0x8E);
     set_idt_gate(46, (uint64_t)irq14_stub, 0x08, 0x8E);
     set_idt_gate(47, (uint64_t)irq15_stub, 0x08, 0x8E);
+    for (int i = 0; i < KOS_IRQ_DYNAMIC_COUNT; i++) {
+        set_idt_gate(KOS_IRQ_DYNAMIC_VECTOR_BASE + i, irq_dynamic_stubs[i], 0x08, 0x8E);
+    }
+    for (int i = 0; i < KOS_IPI_VECTOR_COUNT; i++) {
+        set_idt_gate(KOS_IPI_VECTOR_BASE + i, ipi_stubs[i], 0x08, 0x8E);
+    }
     set_idt_gate(0x80, (uint64_t)isr128,    0x08, 0xEE);
     idt_ptr.limit = (uint16_t)(sizeof(idt) - 1);
     idt_ptr.base  = (uint64_t)&idt;
     load_idt(&idt_ptr);
 }
+
+// Application processors share the boot CPU's table
+void idt_load_cpu(void) {
+    load_idt(&idt_ptr);
+}
@@ -1,6 +1,11 @@
 #include "ports.h"
 #include "irq.h"
 #include "logging.h"
+#include "idt.h"
+#include "pic.h"
+#include "kos/interrupts/interrupt.h"
+#include "kos/interrupts/softirq.h"
+#include "kos/cpu/ipi.h"
 #include <stddef.h>
 
 // IRQ stub declarations
@@ -9,23 +14,6 @@ extern void irq4_stub(), irq5_stub(), irq6_stub(), irq7_stub();
 extern void irq8_stub(), irq9_stub(), irq10_stub(), irq11_stub();
 extern void irq12_stub(), irq13_stub(), irq14_stub(), irq15_stub();
 
-// IRQ handler table
-static void (*irq_routines[16])(struct registers*) = {NULL};
-
-void irq_install_handler(int irq, void (*handler)(struct registers *r)) {
-    if (irq >= 0 && irq < 16) {
-        irq_routines[irq] = handler;
-        LOG_DEBUG("IRQ handler installed for IRQ %d", irq);
-    }
-}
-
-void irq_uninstall_handler(int irq) {
-    if (irq >= 0 && irq < 16) {
-        irq_routines[irq] = NULL;
-        LOG_DEBUG("IRQ handler uninstalled for IRQ %d", irq);
-    }
-}
-
 void irq_remap(void) {
     port_byte_out(0x20, 0x11);
     port_byte_out(0xA0, 0x11);
@@ -38,6 +26,9 @@ void irq_remap(void) {
     port_byte_out(0x21, 0x0);
     port_byte_out(0xA1, 0x0);
     
+    // Masking, EOI and priority hold-off go through the generic layer
+    pic_register_chip();
+    
     LOG_DEBUG("IRQ remapping completed");
 }
 
@@ -65,45 +56,26 @@ void irq_install(void) {
     LOG_DEBUG("IRQ gates installed in IDT");
 }
 
+// Common IRQ entry, called by irq_common_stub
 struct cpu_status_s *irq_handler(struct cpu_status_s *css) {
     // Validate input pointer
     if (!css) return NULL;
     
-    // Send EOI to slave PIC if needed (IRQ 8-15)
-    if (css->vector_number >= 40) {
-        port_byte_out(0xA0, 0x20);
-    }
-
-    // Handle specific IRQs
-    switch (css->vector_number) {
-        case 32:  // IRQ0 - Timer
-            timer_callback();
-            break;
-        case 33:  // IRQ1 - Keyboard
-            keyboard_callback();
-            break;
-        default: {
-            // Call custom handler if registered
-            int irq = css->vector_number - 32;
-            if (irq >= 0 && irq < 16 && irq_routines[irq]) {
-                // Create a compatible registers structure for legacy handlers
-                struct registers regs = {0};
-                // Map 64-bit registers to 32-bit structure
-                regs.eax = css->rax & 0xFFFFFFFF;
-                regs.ebx = css->rbx & 0xFFFFFFFF;
-                regs.ecx = css->rcx & 0xFFFFFFFF;
-                regs.edx = css->rdx & 0xFFFFFFFF;
-                regs.int_no = css->vector_number;
-                regs.err_code = css->error_code;
-                
-                irq_routines[irq](&regs);
-            }
-            break;
-        }
+    // IPIs bypass the line table and the bottom halves
+    if (css->vector_number >= KOS_IPI_VECTOR_BASE &&
+        css->vector_number < KOS_IPI_VECTOR_BASE + KOS_IPI_VECTOR_COUNT) {
+        kos_ipi_handle((uint32_t)css->vector_number);
+        return css;
     }
+    
+    kos_irq_enter();
+    
+    // Every line goes through the same handler chain table, which sends the
+    // EOI early and lets higher priority lines in while the handlers run
+    kos_interrupt_dispatch(kos_interrupt_vector_to_irq((uint32_t)css->vector_number));
 
-    // Send EOI to master PIC
-    port_byte_out(0x20, 0x20);
+    // Bottom halves run here with interrupts enabled
+    kos_irq_exit();
 
     return css;
 }
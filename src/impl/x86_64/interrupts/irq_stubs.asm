@@ -6,12 +6,23 @@ global irq4_stub, irq5_stub, irq6_stub, irq7_stub
 global irq8_stub, irq9_stub, irq10_stub, irq11_stub
 global irq12_stub, irq13_stub, irq14_stub, irq15_stub
 
+global irq_dynamic_stubs
+global ipi_stubs
+
 extern irq_handler
 
+; Dynamic (MSI/MSI-X) vectors, must match KOS_IRQ_DYNAMIC_VECTOR_BASE/COUNT
+%define IRQ_DYNAMIC_VECTOR_BASE 0x30
+%define IRQ_DYNAMIC_COUNT       80
+
+; Inter-processor interrupts, must match KOS_IPI_VECTOR_BASE/COUNT
+%define IPI_VECTOR_BASE         0xF0
+%define IPI_COUNT               3
+
 %macro IRQ_STUB 1
 irq%1_stub:
     push 0          ; Dummy error code (not all IRQs have one)
-    push %1         ; IRQ number (32 + IRQ number)
+    push 32 + %1    ; Vector number (PIC remapped to 32)
     jmp irq_common_stub
 %endmacro
 
@@ -32,54 +43,93 @@ IRQ_STUB 13
 IRQ_STUB 14
 IRQ_STUB 15
 
+%macro IRQ_DYNAMIC_STUB 1
+irq_dynamic%1_stub:
+    push 0
+    push IRQ_DYNAMIC_VECTOR_BASE + %1
+    jmp irq_common_stub
+%endmacro
+
+%assign i 0
+%rep IRQ_DYNAMIC_COUNT
+IRQ_DYNAMIC_STUB i
+%assign i i + 1
+%endrep
+
+%macro IPI_STUB 1
+ipi%1_stub:
+    push 0
+    push IPI_VECTOR_BASE + %1
+    jmp irq_common_stub
+%endmacro
+
+%assign i 0
+%rep IPI_COUNT
+IPI_STUB i
+%assign i i + 1
+%endrep
+
 ; Common IRQ handler logic
 irq_common_stub:
-    ; Save general-purpose registers in the order expected by cpu_status_s
-    push rax
-    push rbx
-    push rcx
-    push rdx
-    push rbp
-    push rsi
-    push rdi
-    push r8
-    push r9
-    push r10
-    push r11
-    push r12
-    push r13
-    push r14
+    ; Save general-purpose registers so the stack matches cpu_status_s (rax lowest)
     push r15
+    push r14
+    push r13
+    push r12
+    push r11
+    push r10
+    push r9
+    push r8
+    push rdi
+    push rsi
+    push rbp
+    push rdx
+    push rcx
+    push rbx
+    push rax
 
-    ; Save RSP, RBP, and other state for iretq frame
-    mov rax, rsp
-    push rax        ; Save current RSP
-    
-    ; Set up first function argument for irq_handler (pointer to cpu_status_s)
+    ; First argument: pointer to cpu_status_s, the stack stays 16-byte aligned
     mov rdi, rsp
+    cld
     call irq_handler
-    
-    ; Restore RSP from saved value
-    pop rsp
 
     ; Restore registers in reverse order
-    pop r15
-    pop r14
-    pop r13
-    pop r12
-    pop r11
-    pop r10
-    pop r9
-    pop r8
-    pop rdi
-    pop rsi
-    pop rbp
-    pop rdx
-    pop rcx
-    pop rbx
     pop rax
+    pop rbx
+    pop rcx
+    pop rdx
+    pop rbp
+    pop rsi
+    pop rdi
+    pop r8
+    pop r9
+    pop r10
+    pop r11
+    pop r12
+    pop r13
+    pop r14
+    pop r15
 
-    ; Remove pushed irq number and dummy error code
+    ; Remove pushed vector number and dummy error code
     add rsp, 16
 
     iretq
+
+section .rodata
+align 8
+
+; Stub addresses for the IDT, indexed by dynamic line
+irq_dynamic_stubs:
+%assign i 0
+%rep IRQ_DYNAMIC_COUNT
+    dq irq_dynamic%+i%+_stub
+%assign i i + 1
+%endrep
+
+; Stub addresses for the IDT, indexed by IPI type
+ipi_stubs:
+%assign i 0
+%rep IPI_COUNT
+    dq ipi%+i%+_stub
+%assign i i + 1
+%endrep
@@ -1,35 +1,47 @@
 global isr128
-extern syscall_handler
+extern kos_syscall_dispatch
 
+; int 0x80 compatibility path: same registers as SYSCALL, returns with iretq
 isr128:
-    ; Save registers
-    push rax
+    ; Kernel GS only when coming from ring 3
+    test qword [rsp + 8], 3
+    jz .kernel_entry
+    swapgs
+.kernel_entry:
     push rcx
+    push r11
+
+    ; Build kos_syscall_frame_t from the interrupt frame and the registers
+    push qword [rsp + 40]           ; RSP
+    push qword [rsp + 40]           ; RFLAGS
+    push qword [rsp + 32]           ; RIP
+    push r9
+    push r8
+    push r10
     push rdx
-    push rbx
-    push rbp
     push rsi
     push rdi
-    push r8
-    push r9
-    push r10
-    push r11
+    push rax
 
-    ; Call the syscall handler in C
-    call syscall_handler
+    mov rdi, rsp
+    sub rsp, 8                      ; Keep the call 16-byte aligned
+    sti
+    call kos_syscall_dispatch       ; Result stays in RAX
+    cli
+    add rsp, 16                     ; Alignment and number
 
-    ; Restore registers
-    pop r11
-    pop r10
-    pop r9
-    pop r8
     pop rdi
     pop rsi
-    pop rbp
-    pop rbx
     pop rdx
+    pop r10
+    pop r8
+    pop r9
+    add rsp, 24                     ; RIP, RFLAGS, RSP
+    pop r11
     pop rcx
-    pop rax
 
+    test qword [rsp + 8], 3
+    jz .kernel_exit
+    swapgs
+.kernel_exit:
     iretq
-
@@ -1,6 +1,26 @@
 #include "pic.h"
 #include "ports.h" // You may need to define IO operations like outb, inb
+#include "kos/interrupts/interrupt.h"
 
+#define PIC_MASTER_CMD   0x20
+#define PIC_MASTER_DATA  0x21
+#define PIC_SLAVE_CMD    0xA0
+#define PIC_SLAVE_DATA   0xA1
+#define PIC_EOI          0x20
+#define PIC_CASCADE_LINE 2
+
+// Lines masked on request and lines held off by the running handler's priority
+static uint16_t g_pic_line_mask = 0;
+static uint16_t g_pic_priority_mask = 0;
+
+// Write both IMRs, the cascade stays open so slave lines are masked on the slave
+static void pic_write_mask(void)
+{
+    uint16_t mask = (g_pic_line_mask | g_pic_priority_mask) & ~(1U << PIC_CASCADE_LINE);
+
+    port_byte_out(PIC_MASTER_DATA, (uint8_t)(mask & 0xFF));
+    port_byte_out(PIC_SLAVE_DATA, (uint8_t)(mask >> 8));
+}
 
 void pic_initialize()
 {
@@ -20,3 +40,50 @@ void pic_initialize()
     // Unmask IRQ1 (keyboard)
     port_byte_out(0xFD, 0x21); // 0xFD unmask IRQ1
 }
+
+void pic_mask_irq(uint32_t irq)
+{
+    g_pic_line_mask |= (uint16_t)(1U << irq);
+    pic_write_mask();
+}
+
+void pic_unmask_irq(uint32_t irq)
+{
+    g_pic_line_mask &= (uint16_t)~(1U << irq);
+    pic_write_mask();
+}
+
+// Replace the set of lines held off by priority
+void pic_mask_lines(uint32_t lines)
+{
+    if (g_pic_priority_mask == (uint16_t)lines) {
+        return;
+    }
+
+    g_pic_priority_mask = (uint16_t)lines;
+    pic_write_mask();
+}
+
+void pic_send_eoi(uint32_t irq)
+{
+    if (irq >= 8) {
+        port_byte_out(PIC_SLAVE_CMD, PIC_EOI);
+    }
+    port_byte_out(PIC_MASTER_CMD, PIC_EOI);
+}
+
+static const kos_irq_chip_t g_pic_chip = {
+    .name = "8259 PIC",
+    .mask = pic_mask_irq,
+    .unmask = pic_unmask_irq,
+    .eoi = pic_send_eoi,
+    .mask_lines = pic_mask_lines
+};
+
+// Hand the PIC to the generic interrupt layer, the IMRs start fully open
+void pic_register_chip(void)
+{
+    g_pic_line_mask = 0;
+    g_pic_priority_mask = 0;
+    kos_interrupt_set_chip(&g_pic_chip);
+}
@@ -3,49 +3,105 @@
 #include "print.h"
 #include "irq.h"
 #include "logging.h"
+#include "kos/time/clock.h"
+#include "kos/time/timer.h"
+#include "kos/time/sleep.h"
+#include "kos/interrupts/softirq.h"
 
 #define PIT_FREQUENCY 1193180
 #define TIMER_DEFAULT_HZ 1000
 
 volatile unsigned long g_system_ticks = 0;
+static int g_timer_hz = TIMER_DEFAULT_HZ;
+static uint16_t g_timer_divisor = 0;
+
+// Uptime report, logged from the worker instead of the interrupt
+static void uptime_work(void* data);
+static void uptime_timer(void* data);
+static kos_work_t g_uptime_work = KOS_WORK_INIT(uptime_work, NULL);
+static kos_timer_t g_uptime_timer;
+static uint64_t g_uptime_next_ns = 0;
 
 void timer_phase(int hz) {
     if (hz <= 0) hz = TIMER_DEFAULT_HZ;
     
+    g_timer_hz = hz;
     int divisor = PIT_FREQUENCY / hz;
-    port_byte_out(0x43, 0x36);
+    g_timer_divisor = (uint16_t)divisor;
+    
+    // Rate generator rather than square wave, the count falls by one per
+    // input clock so the latched value tells how long ago the IRQ fired
+    port_byte_out(0x43, 0x34);
     port_byte_out(0x40, divisor & 0xFF);
     port_byte_out(0x40, divisor >> 8);
     
     LOG_DEBUG("Timer configured for %d Hz", hz);
 }
 
+// Announce the next tick to the interrupt core. The counter reloaded on the
+// edge that raised this IRQ, so the ticks it has counted down since then
+// date the edge in TSC cycles.
+static void timer_stamp_deadline(void) {
+    if (!g_timer_divisor) {
+        return;
+    }
+    
+    port_byte_out(0x43, 0x00);
+    uint16_t count = port_byte_in(0x40);
+    count |= (uint16_t)port_byte_in(0x40) << 8;
+    
+    uint64_t elapsed = count <= g_timer_divisor ? g_timer_divisor - count : 0;
+    uint64_t now = kos_clock_cycles();
+    uint64_t since_edge = kos_clock_ns_to_cycles(elapsed * KOS_NSEC_PER_SEC / PIT_FREQUENCY);
+    uint64_t period = kos_clock_ns_to_cycles((uint64_t)g_timer_divisor * KOS_NSEC_PER_SEC / PIT_FREQUENCY);
+    
+    kos_interrupt_set_expected(KOS_IRQ_TIMER, now - since_edge + period);
+}
+
 void timer_callback(void) {
     g_system_ticks++;
     
-    // Log every second (assuming 1000 Hz)
-    if (g_system_ticks % 1000 == 0) {
-        LOG_INFO("System uptime: %lu seconds", g_system_ticks / 1000);
-    }
+    // Fold elapsed clocksource cycles into the monotonic clock
+    kos_clock_update();
+    
+    // Flag expired kernel timers for deferred processing
+    kos_timer_tick();
+}
+
+static void uptime_work(void* data) {
+    (void)data;
+    LOG_INFO("System uptime: %lu seconds", (unsigned long)(kos_clock_monotonic_ns() / KOS_NSEC_PER_SEC));
+}
+
+static void uptime_timer(void* data) {
+    (void)data;
+    kos_work_queue(&g_uptime_work);
+    
+    g_uptime_next_ns += KOS_NSEC_PER_SEC;
+    kos_timer_add(&g_uptime_timer, g_uptime_next_ns);
 }
 
-void timer_handler(struct registers *r) {
-    (void)r; // Unused parameter
+kos_irq_return_t timer_handler(uint32_t irq, void* context) {
+    (void)irq;
+    (void)context;
+    timer_stamp_deadline();
     timer_callback();
+    return KOS_IRQ_HANDLED;
 }
 
 void timer_install(void) {
-    irq_install_handler(0, timer_handler);
+    kos_interrupt_register_handler(KOS_IRQ_TIMER, timer_handler, NULL, "PIT");
+    
+    kos_timer_init(&g_uptime_timer, uptime_timer, NULL);
+    g_uptime_next_ns = kos_clock_monotonic_ns() + KOS_NSEC_PER_SEC;
+    kos_timer_add(&g_uptime_timer, g_uptime_next_ns);
     LOG_DEBUG("Timer interrupt handler installed");
 }
 
 void timer_wait(int ticks) {
     if (ticks <= 0) return;
     
-    unsigned long target_ticks = g_system_ticks + ticks;
-    while (g_system_ticks < target_ticks) {
-        asm volatile("hlt");
-    }
+    kos_sleep_ns((uint64_t)ticks * KOS_NSEC_PER_SEC / g_timer_hz);
 }
 
 unsigned long timer_get_ticks(void) {
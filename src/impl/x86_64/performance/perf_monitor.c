@@ -1,27 +1,40 @@
 #include "perf_monitor.h"
 #include "debug/debug.h"
 #include "print.h"
+#include "kos/time/clock.h"
+#include "kos/interrupts/interrupt.h"
+#include "kos/sync/seqlock.h"
+#include "kos/utils/string.h"
 #include <string.h>
 
-// Global performance metrics
+// Global performance metrics, every write goes through the sequence lock so
+// readers copy a consistent set without stalling the writers
 static perf_metrics_t g_perf_metrics;
+static kos_seqlock_t g_perf_lock = KOS_SEQLOCK_INIT;
+
+// Event counts are per-CPU counters, perf_update folds them into the metrics
+KOS_COUNTER_DEFINE(io, disk_reads);
+KOS_COUNTER_DEFINE(io, disk_writes);
+KOS_COUNTER_DEFINE(net, network_packets);
+KOS_COUNTER_DECLARE(interrupts);
+KOS_COUNTER_DECLARE(context_switches);
 static int perf_initialized = 0;
 
-// CPUID helper for RDTSC
+// Read the cycle counter
 static uint64_t rdtsc(void) {
-    uint32_t low, high;
-    __asm__ volatile("rdtsc" : "=a"(low), "=d"(high));
-    return ((uint64_t)high << 32) | low;
+    return kos_clock_cycles();
 }
 
-// Get current timestamp (simplified)
+// Get current timestamp in ns
 static uint64_t get_timestamp(void) {
-    return rdtsc();
+    return kos_clock_monotonic_ns();
 }
 
 void perf_init(void) {
     if (perf_initialized) return;
     
+    uint64_t flags = kos_write_seqlock_irqsave(&g_perf_lock);
+    
     // Initialize all counters to zero
     memset(&g_perf_metrics, 0, sizeof(perf_metrics_t));
     
@@ -30,6 +43,8 @@ void perf_init(void) {
     g_perf_metrics.last_update_time = g_perf_metrics.boot_time;
     g_perf_metrics.memory_total = 0x200000; // 2MB heap size
     
+    kos_write_sequnlock_irqrestore(&g_perf_lock, flags);
+    
     perf_initialized = 1;
     
     log_info("Performance monitor initialized");
@@ -41,11 +56,26 @@ void perf_update(void) {
         return;
     }
     
+    // Interrupt load comes from the per-line rate estimators, gathered
+    // with the counters before the write section so readers never wait
+    uint32_t rate = 0;
+    for (int i = 0; i < KOS_IRQ_LINES; i++) {
+        rate += kos_interrupt_get_rate((kos_irq_t)i);
+    }
+    uint32_t throttled = kos_interrupt_throttled_count();
+    uint64_t interrupts = kos_counter_read(&kos_counter_interrupts);
+    uint64_t context_switches = kos_counter_read(&kos_counter_context_switches);
+    uint64_t disk_reads = kos_counter_read(&kos_counter_disk_reads);
+    uint64_t disk_writes = kos_counter_read(&kos_counter_disk_writes);
+    uint64_t network_packets = kos_counter_read(&kos_counter_network_packets);
+    
+    uint64_t flags = kos_write_seqlock_irqsave(&g_perf_lock);
+    
     uint64_t current_time = get_timestamp();
     uint64_t time_delta = current_time - g_perf_metrics.last_update_time;
     
-    // Update uptime (simplified conversion)
-    g_perf_metrics.uptime_seconds = (current_time - g_perf_metrics.boot_time) / 1000000;
+    // Update uptime
+    g_perf_metrics.uptime_seconds = (uint32_t)((current_time - g_perf_metrics.boot_time) / KOS_NSEC_PER_SEC);
     
     // Update CPU metrics
     g_perf_metrics.cpu_cycles = rdtsc();
@@ -67,20 +97,42 @@ void perf_update(void) {
     g_perf_metrics.memory_usage_percent = 
         (g_perf_metrics.memory_used * 100) / g_perf_metrics.memory_total;
     
+    g_perf_metrics.interrupts_count = interrupts;
+    g_perf_metrics.interrupt_rate = rate;
+    g_perf_metrics.throttled_lines = throttled;
+    g_perf_metrics.context_switches = context_switches;
+    g_perf_metrics.disk_reads = disk_reads;
+    g_perf_metrics.disk_writes = disk_writes;
+    g_perf_metrics.network_packets = network_packets;
+    
     g_perf_metrics.last_update_time = current_time;
+    
+    kos_write_sequnlock_irqrestore(&g_perf_lock, flags);
 }
 
-perf_metrics_t* perf_get_metrics(void) {
+// Copy a consistent snapshot of the metrics, retries instead of blocking
+// perf_update; call perf_update first for fresh values
+void perf_get_metrics(perf_metrics_t* metrics) {
+    if (!metrics) {
+        return;
+    }
     if (!perf_initialized) {
         perf_init();
     }
     
-    perf_update();
-    return &g_perf_metrics;
+    uint32_t seq;
+    do {
+        seq = kos_read_seqbegin(&g_perf_lock);
+        kos_memcpy(metrics, &g_perf_metrics, sizeof(perf_metrics_t));
+    } while (kos_read_seqretry(&g_perf_lock, seq));
 }
 
 void perf_print_stats(void) {
-    perf_metrics_t* metrics = perf_get_metrics();
+    perf_metrics_t snapshot;
+    perf_metrics_t* metrics = &snapshot;
+    
+    perf_update();
+    perf_get_metrics(&snapshot);
     
     printf("\n=== KOS Performance Monitor ===\n");
     printf("Uptime: %d seconds\n", metrics->uptime_seconds);
@@ -96,16 +148,19 @@ void perf_print_stats(void) {
     printf("  Free: %llu bytes\n", metrics->memory_free);
     
     printf("\nSystem Statistics:\n");
-    printf("  Interrupts: %d\n", metrics->interrupts_count);
-    printf("  Context Switches: %d\n", metrics->context_switches);
+    printf("  Interrupts: %llu (%d/sec)\n", metrics->interrupts_count, metrics->interrupt_rate);
+    if (metrics->throttled_lines) {
+        printf("  Throttled IRQ lines: %d\n", metrics->throttled_lines);
+    }
+    printf("  Context Switches: %llu\n", metrics->context_switches);
     
     printf("\nI/O Statistics:\n");
-    printf("  Disk Reads: %d\n", metrics->disk_reads);
-    printf("  Disk Writes: %d\n", metrics->disk_writes);
-    printf("  Network Packets: %d\n", metrics->network_packets);
+    printf("  Disk Reads: %llu\n", metrics->disk_reads);
+    printf("  Disk Writes: %llu\n", metrics->disk_writes);
+    printf("  Network Packets: %llu\n", metrics->network_packets);
     
     // Check for performance alerts
-    perf_alert_t alert = perf_check_alerts();
+    perf_alert_t alert = perf_check_metrics(metrics);
     if (alert != PERF_ALERT_NONE) {
         printf("\nALERT: %s\n", perf_alert_string(alert));
     }
@@ -116,6 +171,7 @@ void perf_print_stats(void) {
 void perf_reset_counters(void) {
     if (!perf_initialized) return;
     
+    uint64_t flags = kos_write_seqlock_irqsave(&g_perf_lock);
     g_perf_metrics.cpu_cycles = 0;
     g_perf_metrics.cpu_instructions = 0;
     g_perf_metrics.cpu_cache_hits = 0;
@@ -125,6 +181,9 @@ void perf_reset_counters(void) {
     g_perf_metrics.disk_reads = 0;
     g_perf_metrics.disk_writes = 0;
     g_perf_metrics.network_packets = 0;
+    kos_write_sequnlock_irqrestore(&g_perf_lock, flags);
+    
+    kos_counter_reset_all();
     
     log_info("Performance counters reset");
 }
@@ -138,12 +197,16 @@ uint64_t perf_get_timestamp(void) {
 }
 
 void perf_log_timing(const char* name, uint64_t cycles) {
-    log_info("Timing [%s]: %llu cycles", name, cycles);
+    log_info("Timing [%s]: %llu cycles (%llu ns)", name, cycles, kos_clock_cycles_to_ns(cycles));
 }
 
 perf_alert_t perf_check_alerts(void) {
-    perf_metrics_t* metrics = perf_get_metrics();
-    
+    perf_metrics_t snapshot;
+    perf_get_metrics(&snapshot);
+    return perf_check_metrics(&snapshot);
+}
+
+perf_alert_t perf_check_metrics(const perf_metrics_t* metrics) {
     if (metrics->cpu_usage_percent > PERF_CPU_HIGH_USAGE) {
         return PERF_ALERT_CPU_HIGH;
     }
@@ -152,7 +215,8 @@ perf_alert_t perf_check_alerts(void) {
         return PERF_ALERT_MEMORY_HIGH;
     }
     
-    if (metrics->interrupts_count > PERF_INTERRUPT_THRESHOLD) {
+    // A storm is a line over its rate budget, not a large lifetime count
+    if (metrics->throttled_lines != 0) {
         return PERF_ALERT_INTERRUPT_STORM;
     }
     
@@ -173,34 +237,3 @@ const char* perf_alert_string(perf_alert_t alert) {
             return "No alerts";
     }
 }
-
-// Hook functions for system integration
-void perf_increment_interrupts(void) {
-    if (perf_initialized) {
-        g_perf_metrics.interrupts_count++;
-    }
-}
-
-void perf_increment_context_switches(void) {
-    if (perf_initialized) {
-        g_perf_metrics.context_switches++;
-    }
-}
-
-void perf_increment_disk_reads(void) {
-    if (perf_initialized) {
-        g_perf_metrics.disk_reads++;
-    }
-}
-
-void perf_increment_disk_writes(void) {
-    if (perf_initialized) {
-        g_perf_metrics.disk_writes++;
-    }
-}
-
-void perf_increment_network_packets(void) {
-    if (perf_initialized) {
-        g_perf_metrics.network_packets++;
-    }
-}
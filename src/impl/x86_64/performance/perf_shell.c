@@ -4,6 +4,22 @@
 #include "print.h"
 #include <string.h>
 #include "kos/utils/string.h"
+#include "kos/time/sleep.h"
+#include "kos/time/clocksource.h"
+#include "kos/interrupts/interrupt.h"
+#include "kos/syscall/syscall.h"
+#include "kos/syscall/batch.h"
+#include "kos/drivers/driver_framework.h"
+#include "kos/cpu/ipi.h"
+#include "kos/cpu/smp.h"
+#include "kos/time/clock.h"
+#include "kos/time/vdso.h"
+#include "kos/sync/lockstat.h"
+#include "kos/sync/ring.h"
+#include "kos/cpu/counter.h"
+#include "kos/process/workqueue.h"
+#include "kos/process/process.h"
+#include "kos/cpu/irqflags.h"
 
 static int monitor_running = 0;
 
@@ -37,7 +53,10 @@ void perf_cmd_monitor(void) {
         printf("Press Ctrl+C to stop\n\n");
         
         // Print current stats
-        perf_metrics_t* metrics = perf_get_metrics();
+        perf_metrics_t snapshot;
+        perf_metrics_t* metrics = &snapshot;
+        perf_update();
+        perf_get_metrics(&snapshot);
         
         printf("Uptime: %d seconds\n", metrics->uptime_seconds);
         printf("CPU Usage: %d%%\n", metrics->cpu_usage_percent);
@@ -45,19 +64,18 @@ void perf_cmd_monitor(void) {
                metrics->memory_usage_percent, 
                metrics->memory_used, 
                metrics->memory_total);
-        printf("Interrupts: %d\n", metrics->interrupts_count);
-        printf("Context Switches: %d\n", metrics->context_switches);
+        printf("Interrupts: %llu (%d/sec)\n", metrics->interrupts_count, metrics->interrupt_rate);
+        printf("Context Switches: %llu\n", metrics->context_switches);
         
         // Check alerts
-        perf_alert_t alert = perf_check_alerts();
+        perf_alert_t alert = perf_check_metrics(metrics);
         if (alert != PERF_ALERT_NONE) {
             printf("\n⚠ ALERT: %s\n", perf_alert_string(alert));
         }
         
         printf("\nUpdating in 2 seconds...\n");
         
-        // Simple delay (would be replaced with proper timer)
-        for (volatile int i = 0; i < 1000000; i++);
+        kos_sleep_ns(2 * KOS_NSEC_PER_SEC);
         
         // Check for keypress (simplified - in real implementation would use keyboard handler)
         // For now, just run 5 iterations
@@ -75,9 +93,10 @@ void perf_cmd_alerts(void) {
     printf("Thresholds:\n");
     printf("  CPU High Usage: %d%%\n", PERF_CPU_HIGH_USAGE);
     printf("  Memory High Usage: %d%%\n", PERF_MEM_HIGH_USAGE);
-    printf("  Interrupt Threshold: %d/sec\n", PERF_INTERRUPT_THRESHOLD);
+    printf("  Interrupt Storm Budget: %d/sec per line\n", KOS_IRQ_STORM_DEFAULT_RATE);
     printf("\n");
     
+    perf_update();
     perf_alert_t alert = perf_check_alerts();
     printf("Current Status: %s\n", perf_alert_string(alert));
     
@@ -96,8 +115,8 @@ void perf_cmd_alerts(void) {
                 printf("  - Check for memory leaks\n");
                 break;
             case PERF_ALERT_INTERRUPT_STORM:
-                printf("  - Check interrupt handlers\n");
-                printf("  - Disable unnecessary hardware\n");
+                printf("  - Throttled lines are polled until they calm down\n");
+                printf("  - %d IRQ line(s) currently throttled, see 'perf irq'\n", kos_interrupt_throttled_count());
                 break;
             default:
                 break;
@@ -155,6 +174,532 @@ void perf_cmd_benchmark(void) {
     printf("\nBenchmark completed. Check logs for detailed timing.\n");
 }
 
+void perf_cmd_irq(void) {
+    printf("Interrupt Latency (ns):\n");
+    printf("IRQ Name Kind Count p50 p99 p999 max\n");
+    
+    for (int irq = 0; irq < KOS_IRQ_LINES; irq++) {
+        kos_histogram_summary_t latency;
+        kos_histogram_summary_t duration;
+        if (kos_interrupt_get_latency((kos_irq_t)irq, &latency, &duration) != KOS_SUCCESS ||
+            duration.count == 0) {
+            continue;
+        }
+        
+        printf("%d %s handler %d %d %d %d %d\n", irq, kos_interrupt_get_name((kos_irq_t)irq),
+               (int)duration.count, (int)duration.p50, (int)duration.p99,
+               (int)duration.p999, (int)duration.max);
+        if (latency.count > 0) {
+            printf("%d %s entry %d %d %d %d %d\n", irq, kos_interrupt_get_name((kos_irq_t)irq),
+                   (int)latency.count, (int)latency.p50, (int)latency.p99,
+                   (int)latency.p999, (int)latency.max);
+        }
+    }
+}
+
+// Round trips per syscall benchmark, fewer from ring 3 where interrupts stay off
+#define PERF_SYSCALL_ITERATIONS 100000
+#define PERF_USER_ITERATIONS    10000
+
+// Filled in by the ring 3 stub in perf_user.asm
+typedef struct {
+    uint64_t iterations;
+    uint64_t int80_cycles;
+    uint64_t syscall_cycles;
+} perf_user_result_t;
+
+extern void perf_user_syscall_bench(void);
+
+static perf_user_result_t perf_user_result;
+static uint8_t perf_user_stack[4096] __attribute__((aligned(16)));
+
+// Nothing runs in ring 3 yet, so the boot identity map carries the user bit
+// only on its 2 MB entries. The ring 3 stub gets the first GB by setting it
+// on the two levels above for the length of the run.
+#define PERF_PTE_USER   0x4ULL
+#define PERF_PTE_ADDR   0x000FFFFFFFFFF000ULL
+
+static void perf_user_map(bool enable) {
+    uint64_t cr3;
+    asm volatile("mov %%cr3, %0" : "=r" (cr3));
+    uint64_t* l4 = (uint64_t*)(uintptr_t)(cr3 & PERF_PTE_ADDR);
+    uint64_t* l3 = (uint64_t*)(uintptr_t)(l4[0] & PERF_PTE_ADDR);
+
+    if (enable) {
+        l4[0] |= PERF_PTE_USER;
+        l3[0] |= PERF_PTE_USER;
+    } else {
+        l3[0] &= ~PERF_PTE_USER;
+        l4[0] &= ~PERF_PTE_USER;
+    }
+    asm volatile("mov %0, %%cr3" : : "r" (cr3) : "memory");
+}
+
+// Process entry, drops into the ring 3 stub and ends through exit
+static int32_t perf_user_entry(void* arg) {
+    kos_syscall_enter_user((uint64_t)(uintptr_t)perf_user_syscall_bench,
+                           (uint64_t)(uintptr_t)&perf_user_stack[sizeof(perf_user_stack)],
+                           (uint64_t)(uintptr_t)arg);
+}
+
+// Time SYSCALL and int 0x80 from a ring 3 process, false if it could not run
+static bool perf_user_syscall_run(void) {
+    kos_process_t* process = NULL;
+
+    kos_memset(&perf_user_result, 0, sizeof(perf_user_result));
+    perf_user_result.iterations = PERF_USER_ITERATIONS;
+
+    perf_user_map(true);
+    if (kos_process_spawn(&process, "syscall-bench", perf_user_entry, &perf_user_result,
+                          KOS_PROCESS_PRIORITY_NORMAL) != HAL_SUCCESS) {
+        perf_user_map(false);
+        return false;
+    }
+
+    while (process->state != KOS_PROCESS_STATE_TERMINATED) {
+        if (kos_process_yield() != HAL_SUCCESS) {
+            break;
+        }
+    }
+
+    // A failed yield means the process never ran, so it can go either way
+    bool finished = process->state == KOS_PROCESS_STATE_TERMINATED;
+    kos_process_destroy(process);
+    perf_user_map(false);
+    return finished && perf_user_result.syscall_cycles != 0;
+}
+
+void perf_cmd_syscall(void) {
+    printf("System Call Round Trip (%d iterations):\n", PERF_SYSCALL_ITERATIONS);
+    
+    // int 0x80: full trap frame, gate lookup and iretq
+    uint64_t start = kos_clock_cycles();
+    for (int i = 0; i < PERF_SYSCALL_ITERATIONS; i++) {
+        uint64_t ret = KOS_SYS_NOP;
+        asm volatile("int $0x80" : "+a" (ret) : : "memory");
+    }
+    uint64_t trap_cycles = kos_clock_cycles() - start;
+    
+    // Table dispatch alone, the part SYSCALL shares with int 0x80
+    kos_syscall_frame_t frame;
+    kos_memset(&frame, 0, sizeof(frame));
+    start = kos_clock_cycles();
+    for (int i = 0; i < PERF_SYSCALL_ITERATIONS; i++) {
+        frame.number = KOS_SYS_NOP;
+        kos_syscall_dispatch(&frame);
+    }
+    uint64_t dispatch_cycles = kos_clock_cycles() - start;
+    
+    // Clock read through the shared time page, what processes pay per timestamp.
+    // Outside TSC mode the reader falls back to SYSCALL, which ring 0 must not issue.
+    const kos_vdso_time_t* page = kos_vdso_get_page();
+    bool vdso_tsc = page->mode == KOS_VDSO_MODE_TSC;
+    uint64_t vdso_cycles = 0;
+    if (vdso_tsc) {
+        volatile uint64_t sink = 0;
+        start = kos_clock_cycles();
+        for (int i = 0; i < PERF_SYSCALL_ITERATIONS; i++) {
+            sink += kos_vdso_monotonic_ns(page);
+        }
+        vdso_cycles = kos_clock_cycles() - start;
+        (void)sink;
+    }
+    
+    printf("  int 0x80  %d ns, %d cycles (ring 0, no privilege change)\n",
+           (int)(kos_clock_cycles_to_ns(trap_cycles) / PERF_SYSCALL_ITERATIONS),
+           (int)(trap_cycles / PERF_SYSCALL_ITERATIONS));
+    printf("  dispatch  %d ns, %d cycles\n",
+           (int)(kos_clock_cycles_to_ns(dispatch_cycles) / PERF_SYSCALL_ITERATIONS),
+           (int)(dispatch_cycles / PERF_SYSCALL_ITERATIONS));
+    if (vdso_tsc) {
+        printf("  vdso time %d ns, %d cycles\n",
+               (int)(kos_clock_cycles_to_ns(vdso_cycles) / PERF_SYSCALL_ITERATIONS),
+               (int)(vdso_cycles / PERF_SYSCALL_ITERATIONS));
+    } else {
+        printf("  vdso time skipped, clock is not on the TSC\n");
+    }
+    
+    // Full round trips from ring 3, the path processes actually take
+    if (perf_user_syscall_run()) {
+        uint64_t int80 = perf_user_result.int80_cycles;
+        uint64_t fast = perf_user_result.syscall_cycles;
+        printf("  ring 3 int 0x80  %d ns, %d cycles\n",
+               (int)(kos_clock_cycles_to_ns(int80) / PERF_USER_ITERATIONS),
+               (int)(int80 / PERF_USER_ITERATIONS));
+        printf("  ring 3 syscall   %d ns, %d cycles\n",
+               (int)(kos_clock_cycles_to_ns(fast) / PERF_USER_ITERATIONS),
+               (int)(fast / PERF_USER_ITERATIONS));
+    } else {
+        printf("  ring 3 skipped, scheduler not running on this CPU\n");
+    }
+    
+    kos_syscall_dump_stats();
+}
+
+// Batch benchmark: ops per batch and batches per run
+#define PERF_BATCH_OPS          16
+#define PERF_BATCH_ROUNDS       10000
+#define PERF_BATCH_DEVICE_ID    0xB47C0001
+
+// Null device the batch benchmark talks to
+static hal_result_t perf_null_ioctl(kos_device_t* device, uint32_t request, void* arg) {
+    (void)device; (void)request; (void)arg;
+    return HAL_SUCCESS;
+}
+
+static kos_driver_ops_t perf_null_ops = { .ioctl = perf_null_ioctl };
+static kos_driver_t perf_null_driver = { .name = "perf-null", .ops = &perf_null_ops };
+static kos_device_t perf_null_device;
+
+static inline int64_t perf_int80(uint64_t nr, uint64_t a0, uint64_t a1, uint64_t a2) {
+    int64_t ret = (int64_t)nr;
+    asm volatile("int $0x80" : "+a" (ret) : "D" (a0), "S" (a1), "d" (a2) : "memory");
+    return ret;
+}
+
+void perf_cmd_batch(void) {
+    if (kos_driver_manager_init() != HAL_SUCCESS) {
+        printf("Driver manager unavailable\n");
+        return;
+    }
+    
+    kos_memset(&perf_null_device, 0, sizeof(perf_null_device));
+    perf_null_device.info.device_id = PERF_BATCH_DEVICE_ID;
+    perf_null_device.driver = &perf_null_driver;
+    perf_null_device.is_open = true;
+    kos_driver_manager_register_device(&perf_null_device);
+    
+    printf("Batched System Calls (%d ops x %d rounds):\n", PERF_BATCH_OPS, PERF_BATCH_ROUNDS);
+    
+    // One kernel entry per ioctl
+    uint64_t start = kos_clock_cycles();
+    for (int round = 0; round < PERF_BATCH_ROUNDS; round++) {
+        for (int i = 0; i < PERF_BATCH_OPS; i++) {
+            perf_int80(KOS_SYS_DEVICE_IOCTL, PERF_BATCH_DEVICE_ID, 0, 0);
+        }
+    }
+    uint64_t single_cycles = kos_clock_cycles() - start;
+    
+    // The same ioctls, one kernel entry per round
+    kos_batch_op_t ops[PERF_BATCH_OPS];
+    kos_memset(ops, 0, sizeof(ops));
+    for (int i = 0; i < PERF_BATCH_OPS; i++) {
+        ops[i].opcode = KOS_BATCH_OP_IOCTL;
+        ops[i].device_id = PERF_BATCH_DEVICE_ID;
+    }
+    start = kos_clock_cycles();
+    for (int round = 0; round < PERF_BATCH_ROUNDS; round++) {
+        perf_int80(KOS_SYS_BATCH, (uint64_t)(uintptr_t)ops, PERF_BATCH_OPS, 0);
+    }
+    uint64_t batch_cycles = kos_clock_cycles() - start;
+    
+    kos_driver_manager_unregister_device(&perf_null_device);
+    
+    uint64_t total_ops = (uint64_t)PERF_BATCH_OPS * PERF_BATCH_ROUNDS;
+    printf("  single  %d ns/op, %d cycles/op\n",
+           (int)(kos_clock_cycles_to_ns(single_cycles) / total_ops), (int)(single_cycles / total_ops));
+    printf("  batched %d ns/op, %d cycles/op\n",
+           (int)(kos_clock_cycles_to_ns(batch_cycles) / total_ops), (int)(batch_cycles / total_ops));
+}
+
+// Remote call round trips per target CPU
+#define PERF_IPI_ITERATIONS 10000
+
+void perf_cmd_ipi(void) {
+    uint32_t self = kos_smp_this_cpu_id();
+    
+    printf("IPI Round Trip (cycles / ns, %d calls per CPU):\n", PERF_IPI_ITERATIONS);
+    printf("CPU p50 p99 p999 max\n");
+    for (uint32_t cpu = 0; cpu < kos_smp_cpu_count(); cpu++) {
+        kos_histogram_summary_t summary;
+        if (cpu == self || kos_ipi_benchmark(cpu, PERF_IPI_ITERATIONS, &summary) != KOS_SUCCESS) {
+            continue;
+        }
+        printf("%d %d/%d %d/%d %d/%d %d/%d\n", (int)cpu,
+               (int)summary.p50, (int)kos_clock_cycles_to_ns(summary.p50),
+               (int)summary.p99, (int)kos_clock_cycles_to_ns(summary.p99),
+               (int)summary.p999, (int)kos_clock_cycles_to_ns(summary.p999),
+               (int)summary.max, (int)kos_clock_cycles_to_ns(summary.max));
+    }
+    
+    kos_ipi_dump_stats();
+}
+
+// Busiest lock classes by total wait
+#define PERF_LOCKSTAT_ROWS 16
+
+void perf_cmd_lockstat(void) {
+    if (!kos_lockstat_is_compiled()) {
+        printf("Lock statistics not compiled in, rebuild with LOCKSTAT=1\n");
+        return;
+    }
+    
+    kos_lockstat_class_t classes[PERF_LOCKSTAT_ROWS];
+    uint32_t count = kos_lockstat_snapshot(classes, PERF_LOCKSTAT_ROWS);
+    
+    printf("Lock Statistics (cycles):\n");
+    printf("lock site acq contended wait_avg wait_max hold_avg hold_max\n");
+    for (uint32_t i = 0; i < count; i++) {
+        const kos_lockstat_class_t* class = &classes[i];
+        uint64_t wait_avg = class->contended ? class->wait_cycles / class->contended : 0;
+        uint64_t hold_avg = class->hold_cycles / class->acquisitions;
+        printf("%s %s:%d %d %d %d %d %d %d\n", class->name ? class->name : "(unnamed)",
+               class->file, (int)class->line, (int)class->acquisitions, (int)class->contended,
+               (int)wait_avg, (int)class->max_wait_cycles, (int)hold_avg, (int)class->max_hold_cycles);
+    }
+    
+    kos_lockstat_dump();
+}
+
+// Cross-CPU ring throughput, consumer on the next online CPU
+#define PERF_RING_SIZE  1024
+#define PERF_RING_ITEMS (1U << 20)
+#define PERF_RING_BATCH 32
+
+static kos_spsc_ring_t perf_spsc;
+static kos_mpsc_ring_t perf_mpsc;
+static void* perf_spsc_slots[PERF_RING_SIZE];
+static kos_mpsc_slot_t perf_mpsc_slots[PERF_RING_SIZE];
+static volatile bool perf_ring_done;
+
+// Runs on the remote CPU with interrupts off until every item arrived
+static void perf_ring_consume(void* arg) {
+    bool mpsc = arg != NULL;
+    void* items[PERF_RING_BATCH];
+    uint32_t received = 0;
+    
+    while (received < PERF_RING_ITEMS) {
+        uint32_t n = mpsc ? kos_mpsc_dequeue_batch(&perf_mpsc, items, PERF_RING_BATCH)
+                          : kos_spsc_dequeue_batch(&perf_spsc, items, PERF_RING_BATCH);
+        if (n == 0) {
+            asm volatile("pause");
+        }
+        received += n;
+    }
+    __atomic_store_n(&perf_ring_done, true, __ATOMIC_RELEASE);
+}
+
+static uint64_t perf_ring_run(uint32_t cpu, bool mpsc, uint32_t batch) {
+    void* items[PERF_RING_BATCH];
+    for (uint32_t i = 0; i < PERF_RING_BATCH; i++) {
+        items[i] = (void*)(uintptr_t)(i + 1);
+    }
+    
+    kos_spsc_init(&perf_spsc, perf_spsc_slots, PERF_RING_SIZE);
+    kos_mpsc_init(&perf_mpsc, perf_mpsc_slots, PERF_RING_SIZE);
+    perf_ring_done = false;
+    
+    if (kos_smp_call_function_single(cpu, perf_ring_consume, mpsc ? &perf_mpsc : NULL, false) != KOS_SUCCESS) {
+        return 0;
+    }
+    
+    uint64_t start = kos_clock_cycles();
+    uint32_t sent = 0;
+    while (sent < PERF_RING_ITEMS) {
+        uint32_t n = mpsc ? kos_mpsc_enqueue_batch(&perf_mpsc, items, batch)
+                          : kos_spsc_enqueue_batch(&perf_spsc, items, batch);
+        if (n == 0) {
+            asm volatile("pause");
+        }
+        sent += n;
+    }
+    while (!__atomic_load_n(&perf_ring_done, __ATOMIC_ACQUIRE)) {
+        asm volatile("pause");
+    }
+    return kos_clock_cycles() - start;
+}
+
+void perf_cmd_ring(void) {
+    uint32_t self = kos_smp_this_cpu_id();
+    uint32_t cpu = self;
+    for (uint32_t i = 1; i < kos_smp_cpu_count(); i++) {
+        kos_cpu_local_t* local = kos_percpu_get((self + i) % kos_smp_cpu_count());
+        if (local && local->online) {
+            cpu = local->cpu_id;
+            break;
+        }
+    }
+    if (cpu == self) {
+        printf("Ring benchmark needs a second online CPU\n");
+        return;
+    }
+    
+    printf("Ring Throughput CPU %d -> CPU %d (%d items, cycles/item):\n",
+           (int)self, (int)cpu, PERF_RING_ITEMS);
+    printf("ring single batch%d\n", PERF_RING_BATCH);
+    for (int mpsc = 0; mpsc <= 1; mpsc++) {
+        uint64_t single = perf_ring_run(cpu, mpsc, 1);
+        uint64_t batched = perf_ring_run(cpu, mpsc, PERF_RING_BATCH);
+        printf("%s %d %d\n", mpsc ? "mpsc" : "spsc",
+               (int)(single / PERF_RING_ITEMS), (int)(batched / PERF_RING_ITEMS));
+    }
+}
+
+// Bulk job sizes for the parallel_for benchmark
+#define PERF_PARALLEL_BYTES  (1U << 20)
+#define PERF_PARALLEL_CHUNK  (64U << 10)
+#define PERF_PARALLEL_CHUNKS (PERF_PARALLEL_BYTES / PERF_PARALLEL_CHUNK)
+
+static uint8_t perf_parallel_buffer[PERF_PARALLEL_BYTES] __attribute__((aligned(64)));
+static uint64_t perf_parallel_sums[PERF_PARALLEL_CHUNKS];
+
+static kos_result_t perf_parallel_zero(uint64_t start, uint64_t end, void* arg) {
+    (void)arg;
+    kos_memset(perf_parallel_buffer + start, 0, end - start);
+    return KOS_SUCCESS;
+}
+
+// Each chunk writes its own partial sum, the caller joins them
+static kos_result_t perf_parallel_checksum(uint64_t start, uint64_t end, void* arg) {
+    (void)arg;
+    const uint64_t* words = (const uint64_t*)(perf_parallel_buffer + start);
+    uint64_t sum = 0;
+    for (uint64_t i = 0; i < (end - start) / sizeof(uint64_t); i++) {
+        sum += words[i];
+    }
+    perf_parallel_sums[start / PERF_PARALLEL_CHUNK] = sum;
+    return KOS_SUCCESS;
+}
+
+// Run one bulk job inline or split over every CPU, returns cycles
+static uint64_t perf_parallel_run(kos_parallel_fn_t fn, bool parallel) {
+    uint64_t start = kos_clock_cycles();
+    if (parallel) {
+        kos_parallel_for(0, PERF_PARALLEL_BYTES, PERF_PARALLEL_CHUNK, fn, NULL);
+    } else {
+        for (uint64_t offset = 0; offset < PERF_PARALLEL_BYTES; offset += PERF_PARALLEL_CHUNK) {
+            fn(offset, offset + PERF_PARALLEL_CHUNK, NULL);
+        }
+    }
+    return kos_clock_cycles() - start;
+}
+
+void perf_cmd_parallel(void) {
+    printf("Parallel For (%d KiB, %d KiB chunks, %d CPUs, cycles):\n",
+           (int)(PERF_PARALLEL_BYTES >> 10), (int)(PERF_PARALLEL_CHUNK >> 10), (int)kos_smp_online_count());
+    printf("job serial parallel\n");
+    
+    uint64_t serial = perf_parallel_run(perf_parallel_zero, false);
+    uint64_t parallel = perf_parallel_run(perf_parallel_zero, true);
+    printf("zero %d %d\n", (int)serial, (int)parallel);
+    
+    serial = perf_parallel_run(perf_parallel_checksum, false);
+    parallel = perf_parallel_run(perf_parallel_checksum, true);
+    uint64_t sum = 0;
+    for (uint32_t i = 0; i < PERF_PARALLEL_CHUNKS; i++) {
+        sum += perf_parallel_sums[i];
+    }
+    printf("checksum %d %d (sum %d)\n", (int)serial, (int)parallel, (int)sum);
+    
+    kos_workqueue_dump_stats();
+}
+
+void perf_cmd_counters(void) {
+    uint32_t count = kos_counter_count();
+    uint32_t cpus = kos_percpu_count();
+
+    printf("Event Counters (%d defined, %d CPUs):\n", (int)count, (int)cpus);
+
+    // One group per subsystem, in the order the first member was defined
+    for (uint32_t i = 0; i < count; i++) {
+        const kos_counter_t* first = kos_counter_at(i);
+        bool seen = false;
+        for (uint32_t j = 0; j < i && !seen; j++) {
+            seen = kos_strcmp(kos_counter_at(j)->subsystem, first->subsystem) == 0;
+        }
+        if (seen) {
+            continue;
+        }
+
+        printf("%s:\n", first->subsystem);
+        for (uint32_t j = i; j < count; j++) {
+            const kos_counter_t* counter = kos_counter_at(j);
+            if (kos_strcmp(counter->subsystem, first->subsystem) != 0) {
+                continue;
+            }
+            printf("  %s %llu", counter->name, kos_counter_read(counter));
+            if (cpus > 1) {
+                printf(" (");
+                for (uint32_t cpu = 0; cpu < cpus; cpu++) {
+                    printf(cpu ? " %llu" : "%llu", kos_counter_read_cpu(counter, cpu));
+                }
+                printf(")");
+            }
+            printf("\n");
+        }
+    }
+}
+
+#define PERF_SWITCH_ROUNDS 100000
+
+static kos_cpu_context_t perf_switch_main;
+static kos_cpu_context_t perf_switch_peer;
+static uint8_t perf_switch_stack[8192] __attribute__((aligned(16)));
+
+// Bounces straight back, never returns
+static void perf_switch_bounce(void) {
+    while (true) {
+        kos_context_switch(&perf_switch_peer, &perf_switch_main);
+    }
+}
+
+// Both sides yield to each other until their rounds are done
+static int32_t perf_switch_pingpong(void* arg) {
+    (void)arg;
+    for (uint32_t i = 0; i < PERF_SWITCH_ROUNDS; i++) {
+        kos_process_yield();
+    }
+    return 0;
+}
+
+void perf_cmd_switch(void) {
+    printf("Context Switch Cost (%d round trips, cycles/switch):\n", PERF_SWITCH_ROUNDS);
+    
+    // Bare kos_context_switch between two stacks, entered as if called
+    kos_memset(&perf_switch_peer, 0, sizeof(perf_switch_peer));
+    perf_switch_peer.rsp = (uint64_t)(uintptr_t)&perf_switch_stack[sizeof(perf_switch_stack)] - 8;
+    perf_switch_peer.rip = (uint64_t)(uintptr_t)perf_switch_bounce;
+    
+    uint64_t flags = kos_local_irq_save();
+    uint64_t start = kos_clock_cycles();
+    for (uint32_t i = 0; i < PERF_SWITCH_ROUNDS; i++) {
+        kos_context_switch(&perf_switch_main, &perf_switch_peer);
+    }
+    uint64_t raw = kos_clock_cycles() - start;
+    kos_local_irq_restore(flags);
+    printf("  raw switch     %llu\n", raw / (2 * PERF_SWITCH_ROUNDS));
+    
+    // Two kernel processes yielding to each other through the scheduler
+    kos_process_t* ping = NULL;
+    kos_process_t* pong = NULL;
+    if (kos_process_spawn(&ping, "ping", perf_switch_pingpong, NULL, KOS_PROCESS_PRIORITY_NORMAL) != HAL_SUCCESS ||
+        kos_process_spawn(&pong, "pong", perf_switch_pingpong, NULL, KOS_PROCESS_PRIORITY_NORMAL) != HAL_SUCCESS) {
+        printf("  process yield  (cannot create processes)\n");
+        if (ping) {
+            kos_process_destroy(ping);
+        }
+        return;
+    }
+    
+    // The idle process only gets the CPU back once both have exited
+    start = kos_clock_cycles();
+    while (ping->state != KOS_PROCESS_STATE_TERMINATED || pong->state != KOS_PROCESS_STATE_TERMINATED) {
+        if (kos_process_yield() != HAL_SUCCESS) {
+            break;
+        }
+    }
+    uint64_t yield = kos_clock_cycles() - start;
+    
+    if (ping->state == KOS_PROCESS_STATE_TERMINATED && pong->state == KOS_PROCESS_STATE_TERMINATED) {
+        printf("  process yield  %llu\n", yield / (2 * PERF_SWITCH_ROUNDS));
+    } else {
+        printf("  process yield  (scheduler not running on this CPU)\n");
+    }
+    
+    kos_process_destroy(ping);
+    kos_process_destroy(pong);
+}
+
 void perf_show_help(void) {
     printf("Performance Monitor Commands:\n");
     printf("  perf stats     - Show current performance statistics\n");
@@ -162,6 +707,15 @@ void perf_show_help(void) {
     printf("  perf monitor   - Start real-time performance monitoring\n");
     printf("  perf alerts    - Show performance alerts and thresholds\n");
     printf("  perf benchmark - Run performance benchmarks\n");
+    printf("  perf irq       - Show per-IRQ latency percentiles\n");
+    printf("  perf syscall   - Measure system call round trip cost\n");
+    printf("  perf batch     - Compare single and batched device calls\n");
+    printf("  perf ipi       - Measure IPI round trip to each CPU\n");
+    printf("  perf lockstat  - Show lock contention and hold times\n");
+    printf("  perf ring      - Measure cross-CPU ring throughput\n");
+    printf("  perf counters  - Show event counters by subsystem\n");
+    printf("  perf parallel  - Compare serial and parallel bulk jobs\n");
+    printf("  perf switch    - Measure context switch cost\n");
     printf("  perf help      - Show this help message\n");
 }
 
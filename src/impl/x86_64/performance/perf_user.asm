@@ -0,0 +1,57 @@
+section .text
+bits 64
+
+global perf_user_syscall_bench
+
+; System call numbers, must match kos_syscall_nr_t in kos/syscall/syscall.h
+%define SYS_NOP  0
+%define SYS_EXIT 11
+
+; Result block offsets, must match perf_user_result_t in perf_shell.c
+%define RESULT_ITERATIONS 0
+%define RESULT_INT80      8
+%define RESULT_SYSCALL    16
+
+; Read the TSC into RAX
+%macro READ_TSC 0
+    rdtsc
+    shl rdx, 32
+    or rax, rdx
+%endmacro
+
+; Ring 3 half of "perf syscall", entered through kos_syscall_enter_user with
+; RDI pointing at the result block and interrupts off. Times the nop call
+; through int 0x80 and through SYSCALL, then exits. Only callee-saved
+; registers carry state across the calls.
+perf_user_syscall_bench:
+    mov rbx, rdi
+    mov r12, [rbx + RESULT_ITERATIONS]
+
+    READ_TSC
+    mov r13, rax
+    mov r14, r12
+.int80:
+    mov eax, SYS_NOP
+    int 0x80
+    dec r14
+    jnz .int80
+    READ_TSC
+    sub rax, r13
+    mov [rbx + RESULT_INT80], rax
+
+    READ_TSC
+    mov r13, rax
+    mov r14, r12
+.syscall:
+    mov eax, SYS_NOP
+    syscall
+    dec r14
+    jnz .syscall
+    READ_TSC
+    sub rax, r13
+    mov [rbx + RESULT_SYSCALL], rax
+
+    xor edi, edi
+    mov eax, SYS_EXIT
+    syscall
+    ud2
@@ -0,0 +1,60 @@
+section .text
+bits 64
+
+global kos_context_switch
+global kos_context_start
+
+extern kos_process_bootstrap
+
+; kos_cpu_context_t offsets, must match KOS_CPU_CONTEXT_* in kos/process/process.h
+%define CTX_RBX 0
+%define CTX_RBP 8
+%define CTX_R12 16
+%define CTX_R13 24
+%define CTX_R14 32
+%define CTX_R15 40
+%define CTX_RSP 48
+%define CTX_RIP 56
+%define CTX_CR3 64
+
+; void kos_context_switch(kos_cpu_context_t* old (RDI), kos_cpu_context_t* new (RSI))
+; Called with interrupts off. The caller-saved registers are dead across the
+; call by the ABI, so the old flow resumes at its return address with only
+; the callee-saved ones restored.
+kos_context_switch:
+    mov [rdi + CTX_RBX], rbx
+    mov [rdi + CTX_RBP], rbp
+    mov [rdi + CTX_R12], r12
+    mov [rdi + CTX_R13], r13
+    mov [rdi + CTX_R14], r14
+    mov [rdi + CTX_R15], r15
+    mov rax, [rsp]                  ; Resume at our return address
+    mov [rdi + CTX_RIP], rax
+    lea rax, [rsp + 8]              ; with the stack as after a ret
+    mov [rdi + CTX_RSP], rax
+
+    ; Reloading CR3 flushes the TLB, skip it when the space does not change
+    mov rax, [rsi + CTX_CR3]
+    test rax, rax
+    jz .same_space
+    mov rcx, cr3
+    cmp rax, rcx
+    je .same_space
+    mov cr3, rax
+.same_space:
+    mov rbx, [rsi + CTX_RBX]
+    mov rbp, [rsi + CTX_RBP]
+    mov r12, [rsi + CTX_R12]
+    mov r13, [rsi + CTX_R13]
+    mov r14, [rsi + CTX_R14]
+    mov r15, [rsi + CTX_R15]
+    mov rsp, [rsi + CTX_RSP]
+    jmp [rsi + CTX_RIP]
+
+; First run of a process: RBX holds the entry point and R12 its argument,
+; RSP is 16-byte aligned. kos_process_bootstrap never returns.
+kos_context_start:
+    mov rdi, rbx
+    mov rsi, r12
+    call kos_process_bootstrap
+    ud2
@@ -0,0 +1,87 @@
+section .text
+bits 64
+
+global syscall_entry
+global kos_syscall_enter_user
+
+extern kos_syscall_dispatch
+extern kos_syscall_bad_return
+
+; Per-CPU block offsets, must match KOS_CPU_LOCAL_* in kos/cpu/percpu.h
+%define CPU_KERNEL_STACK 8
+%define CPU_USER_STACK   16
+
+; Ring 3 selectors, the ones SYSRET loads from STAR
+%define USER_DS          0x1B
+%define USER_CS          0x23
+
+; SYSCALL lands here with RCX = user RIP, R11 = user RFLAGS and interrupts
+; masked by SFMASK. The stack is still the caller's, so switch to the kernel
+; stack of the running process, which the scheduler keeps in gs:KERNEL_STACK
+; and TSS.RSP0, before touching memory through RSP.
+syscall_entry:
+    swapgs
+    mov [gs:CPU_USER_STACK], rsp
+    mov rsp, [gs:CPU_KERNEL_STACK]
+
+    ; Build kos_syscall_frame_t, see kos/syscall/syscall.h
+    push qword [gs:CPU_USER_STACK]
+    push r11
+    push rcx
+    push r9
+    push r8
+    push r10
+    push rdx
+    push rsi
+    push rdi
+    push rax
+
+    mov rdi, rsp
+    sti
+    call kos_syscall_dispatch       ; Result stays in RAX
+    cli
+
+    ; SYSRET with a non-canonical RIP faults in ring 0 on the user stack
+    mov rcx, [rsp + 56]
+    mov r11, rcx
+    shl r11, 16
+    sar r11, 16
+    cmp r11, rcx
+    jne .bad_return
+
+    add rsp, 8                      ; Number
+    pop rdi
+    pop rsi
+    pop rdx
+    pop r10
+    pop r8
+    pop r9
+    pop rcx
+    pop r11
+    pop rsp
+    swapgs
+    o64 sysret
+
+.bad_return:
+    mov rdi, rsp
+    call kos_syscall_bad_return     ; Does not return
+.halt:
+    hlt
+    jmp .halt
+
+; kos_syscall_enter_user(rip, rsp, arg): iretq to ring 3 with RDI = arg and
+; interrupts off. User GS goes in first, so the next entry's SWAPGS finds
+; the per-CPU block again.
+kos_syscall_enter_user:
+    cli
+    push USER_DS
+    push rsi                        ; User RSP
+    push 0x002                      ; RFLAGS, IF clear
+    push USER_CS
+    push rdi                        ; User RIP
+    mov rdi, rdx
+    xor esi, esi
+    xor edx, edx
+    xor eax, eax
+    swapgs
+    iretq
@@ -1,8 +1,38 @@
 // syscall.c
 #include <stdint.h>
 
-void syscall_handler() {
-    // Here you could use inline assembly to read args from registers
-    // For now just print something or toggle a flag
+#define MSR_EFER        0xC0000080
+#define MSR_STAR        0xC0000081
+#define MSR_LSTAR       0xC0000082
+#define MSR_SFMASK      0xC0000084
+
+#define EFER_SCE        (1ULL << 0)
+
+// SYSCALL loads CS = STAR[47:32], SS = +8. SYSRET loads SS = STAR[63:48] + 8
+// and CS = +16, which is why user data sits before user code in the GDT.
+#define STAR_KERNEL_CS  0x08ULL
+#define STAR_USER_BASE  0x13ULL     // 0x10 | RPL 3
+
+// Flags cleared on entry: TF, IF, DF, IOPL, NT, AC
+#define SFMASK_FLAGS    0x47700ULL
+
+extern void syscall_entry(void);
+
+static inline uint64_t rdmsr(uint32_t msr) {
+    uint32_t lo, hi;
+    asm volatile("rdmsr" : "=a" (lo), "=d" (hi) : "c" (msr));
+    return ((uint64_t)hi << 32) | lo;
+}
+
+static inline void wrmsr(uint32_t msr, uint64_t value) {
+    asm volatile("wrmsr" : : "c" (msr), "a" ((uint32_t)value), "d" ((uint32_t)(value >> 32)));
 }
 
+// Enable SYSCALL/SYSRET on this CPU. GS must already point at its per-CPU
+// block, the entry stub switches stacks through it.
+void syscall_init(void) {
+    wrmsr(MSR_STAR, (STAR_KERNEL_CS << 32) | (STAR_USER_BASE << 48));
+    wrmsr(MSR_LSTAR, (uint64_t)syscall_entry);
+    wrmsr(MSR_SFMASK, SFMASK_FLAGS);
+    wrmsr(MSR_EFER, rdmsr(MSR_EFER) | EFER_SCE);
+}
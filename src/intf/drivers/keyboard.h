@@ -68,6 +68,7 @@ void keyboard_init();
 
 // Keyboard interrupt handler callback
 void keyboard_callback();
+void keyboard_install();
 void key_realesed(const keycode_t Key);
 
 // this is the declaration of a pointer to function which gets a key.
@@ -0,0 +1,87 @@
+#pragma once
+
+#include <stdint.h>
+#include <stddef.h>
+#include <stdbool.h>
+
+// =============================================================================
+// KOS - HAL ACPI Table Interface
+// =============================================================================
+
+// Root System Description Pointer
+typedef struct __attribute__((packed)) {
+    char signature[8];
+    uint8_t checksum;
+    char oem_id[6];
+    uint8_t revision;
+    uint32_t rsdt_address;
+    // ACPI 2.0+
+    uint32_t length;
+    uint64_t xsdt_address;
+    uint8_t extended_checksum;
+    uint8_t reserved[3];
+} hal_acpi_rsdp_t;
+
+// Common System Description Table header
+typedef struct __attribute__((packed)) {
+    char signature[4];
+    uint32_t length;
+    uint8_t revision;
+    uint8_t checksum;
+    char oem_id[6];
+    char oem_table_id[8];
+    uint32_t oem_revision;
+    uint32_t creator_id;
+    uint32_t creator_revision;
+} hal_acpi_sdt_header_t;
+
+// Generic Address Structure
+typedef struct __attribute__((packed)) {
+    uint8_t address_space_id;
+    uint8_t register_bit_width;
+    uint8_t register_bit_offset;
+    uint8_t access_size;
+    uint64_t address;
+} hal_acpi_generic_address_t;
+
+#define HAL_ACPI_ADDRESS_SPACE_MEMORY 0
+#define HAL_ACPI_ADDRESS_SPACE_IO     1
+
+// HPET Description Table
+typedef struct __attribute__((packed)) {
+    hal_acpi_sdt_header_t header;
+    uint32_t event_timer_block_id;
+    hal_acpi_generic_address_t base_address;
+    uint8_t hpet_number;
+    uint16_t minimum_tick;
+    uint8_t page_protection;
+} hal_acpi_hpet_t;
+
+// Multiple APIC Description Table, followed by variable-length entries
+typedef struct __attribute__((packed)) {
+    hal_acpi_sdt_header_t header;
+    uint32_t local_apic_address;
+    uint32_t flags;
+} hal_acpi_madt_t;
+
+typedef struct __attribute__((packed)) {
+    uint8_t type;
+    uint8_t length;
+} hal_acpi_madt_entry_t;
+
+// Processor Local APIC entry
+typedef struct __attribute__((packed)) {
+    hal_acpi_madt_entry_t header;
+    uint8_t acpi_processor_id;
+    uint8_t apic_id;
+    uint32_t flags;
+} hal_acpi_madt_lapic_t;
+
+#define HAL_ACPI_MADT_TYPE_LAPIC            0
+#define HAL_ACPI_MADT_LAPIC_ENABLED         0x01
+#define HAL_ACPI_MADT_LAPIC_ONLINE_CAPABLE  0x02
+
+// ACPI functions
+bool hal_acpi_init(void);
+const hal_acpi_rsdp_t* hal_acpi_get_rsdp(void);
+const hal_acpi_sdt_header_t* hal_acpi_find_table(const char* signature, uint32_t instance);
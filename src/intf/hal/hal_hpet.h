@@ -0,0 +1,56 @@
+#pragma once
+
+#include <stdint.h>
+#include <stdbool.h>
+#include "kos/time/clocksource.h"
+
+// =============================================================================
+// KOS - HAL High Precision Event Timer Interface
+// =============================================================================
+
+// HPET register offsets
+#define HAL_HPET_REG_CAPABILITIES       0x000
+#define HAL_HPET_REG_CONFIG             0x010
+#define HAL_HPET_REG_INTERRUPT_STATUS   0x020
+#define HAL_HPET_REG_MAIN_COUNTER       0x0F0
+#define HAL_HPET_REG_TIMER_CONFIG(n)    (0x100 + 0x20 * (n))
+#define HAL_HPET_REG_TIMER_COMPARATOR(n) (0x108 + 0x20 * (n))
+#define HAL_HPET_REG_TIMER_FSB_ROUTE(n) (0x110 + 0x20 * (n))
+
+// General capabilities
+#define HAL_HPET_CAP_COUNTER_64BIT      (1ULL << 13)
+#define HAL_HPET_CAP_LEGACY_ROUTE       (1ULL << 15)
+
+// General configuration
+#define HAL_HPET_CONFIG_ENABLE          (1ULL << 0)
+#define HAL_HPET_CONFIG_LEGACY_ROUTE    (1ULL << 1)
+
+// Timer N configuration
+#define HAL_HPET_TIMER_LEVEL_TRIGGER    (1ULL << 1)
+#define HAL_HPET_TIMER_INT_ENABLE       (1ULL << 2)
+#define HAL_HPET_TIMER_PERIODIC         (1ULL << 3)
+#define HAL_HPET_TIMER_PERIODIC_CAP     (1ULL << 4)
+#define HAL_HPET_TIMER_64BIT_CAP        (1ULL << 5)
+#define HAL_HPET_TIMER_FORCE_32BIT      (1ULL << 8)
+#define HAL_HPET_TIMER_ROUTE_SHIFT      9
+#define HAL_HPET_TIMER_ROUTE_MASK       (0x1FULL << 9)
+#define HAL_HPET_TIMER_FSB_ENABLE       (1ULL << 14)
+#define HAL_HPET_TIMER_FSB_CAP          (1ULL << 15)
+
+// Comparator event callback, runs in interrupt context
+typedef void (*hal_hpet_event_handler_t)(void* context);
+
+// HPET functions
+bool hal_hpet_init(void);
+bool hal_hpet_is_available(void);
+uint64_t hal_hpet_read_counter(void);
+uint64_t hal_hpet_get_frequency(void);
+kos_clocksource_t* hal_hpet_get_clocksource(void);
+
+// One-shot comparator events, delivered to the boot CPU as a message (FSB)
+// on a dynamic vector. Needs a comparator with FSB delivery.
+bool hal_hpet_event_init(hal_hpet_event_handler_t handler, void* context);
+bool hal_hpet_event_program_ns(uint64_t delta_ns);
+bool hal_hpet_event_program_counter(uint64_t counter);
+void hal_hpet_event_cancel(void);
+int32_t hal_hpet_event_get_irq(void);
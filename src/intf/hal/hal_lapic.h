@@ -0,0 +1,63 @@
+#pragma once
+
+#include <stdint.h>
+#include <stdbool.h>
+
+// =============================================================================
+// KOS - HAL Local APIC Interface
+// =============================================================================
+
+// IA32_APIC_BASE MSR
+#define HAL_LAPIC_BASE_MSR              0x1B
+#define HAL_LAPIC_BASE_BSP              (1ULL << 8)
+#define HAL_LAPIC_BASE_ENABLE           (1ULL << 11)
+#define HAL_LAPIC_BASE_ADDR_MASK        0xFFFFFF000ULL
+
+// Register offsets
+#define HAL_LAPIC_REG_ID                0x020
+#define HAL_LAPIC_REG_VERSION           0x030
+#define HAL_LAPIC_REG_TPR               0x080
+#define HAL_LAPIC_REG_EOI               0x0B0
+#define HAL_LAPIC_REG_SVR               0x0F0
+#define HAL_LAPIC_REG_ICR_LOW           0x300
+#define HAL_LAPIC_REG_ICR_HIGH          0x310
+
+// Interrupt command register
+#define HAL_LAPIC_ICR_FIXED             0x00000
+#define HAL_LAPIC_ICR_INIT              0x00500
+#define HAL_LAPIC_ICR_STARTUP           0x00600
+#define HAL_LAPIC_ICR_PENDING           0x01000
+#define HAL_LAPIC_ICR_ASSERT            0x04000
+#define HAL_LAPIC_ICR_LEVEL             0x08000
+#define HAL_LAPIC_ICR_DEST_SHIFT        24
+
+// Spurious vector register
+#define HAL_LAPIC_SVR_ENABLE            (1U << 8)
+#define HAL_LAPIC_SPURIOUS_VECTOR       0xFF
+
+// MSI message format (Intel SDM 10.11): address selects the destination
+// APIC, data carries the vector, fixed delivery, edge triggered
+#define HAL_LAPIC_MSI_ADDRESS_BASE      0xFEE00000U
+#define HAL_LAPIC_MSI_DEST_SHIFT        12
+
+#define HAL_LAPIC_MAX_CPUS              32
+#define HAL_LAPIC_INVALID_ID            0xFFFFFFFFU
+
+// Local APIC functions
+bool hal_lapic_init(void);
+bool hal_lapic_init_ap(void);
+bool hal_lapic_is_available(void);
+uint32_t hal_lapic_get_id(void);
+void hal_lapic_eoi(void);
+
+// CPU discovery from the MADT, returns the number of usable CPUs
+uint32_t hal_lapic_enumerate_cpus(void);
+uint32_t hal_lapic_cpu_count(void);
+
+// Inter-processor interrupts
+bool hal_lapic_send_ipi(uint32_t apic_id, uint32_t command);
+bool hal_lapic_send_init(uint32_t apic_id);
+bool hal_lapic_send_startup(uint32_t apic_id, uint32_t page);
+
+// CPU index to APIC ID, HAL_LAPIC_INVALID_ID if the CPU is not known
+uint32_t hal_lapic_cpu_to_apic_id(uint32_t cpu);
@@ -0,0 +1,29 @@
+#pragma once
+
+#include <stdint.h>
+#include <stddef.h>
+#include <stdbool.h>
+
+// =============================================================================
+// KOS - HAL Memory-Mapped I/O Interface
+// =============================================================================
+
+// Identity-map a physical MMIO range as uncached, returns NULL on failure
+volatile void* hal_mmio_map(uint64_t phys_addr, uint64_t size);
+
+// MMIO register access
+static inline uint32_t hal_mmio_read32(volatile void* base, uint32_t offset) {
+    return *(volatile uint32_t*)((uintptr_t)base + offset);
+}
+
+static inline void hal_mmio_write32(volatile void* base, uint32_t offset, uint32_t value) {
+    *(volatile uint32_t*)((uintptr_t)base + offset) = value;
+}
+
+static inline uint64_t hal_mmio_read64(volatile void* base, uint32_t offset) {
+    return *(volatile uint64_t*)((uintptr_t)base + offset);
+}
+
+static inline void hal_mmio_write64(volatile void* base, uint32_t offset, uint64_t value) {
+    *(volatile uint64_t*)((uintptr_t)base + offset) = value;
+}
@@ -0,0 +1,43 @@
+#pragma once
+
+#include <stdint.h>
+#include <stdbool.h>
+#include "kos/time/clocksource.h"
+
+// =============================================================================
+// KOS - HAL Time Stamp Counter Interface
+// =============================================================================
+
+// Source used to determine the TSC frequency
+typedef enum {
+    HAL_TSC_CALIBRATION_NONE = 0,
+    HAL_TSC_CALIBRATION_CPUID_15H = 1,     // Crystal clock ratio (exact)
+    HAL_TSC_CALIBRATION_HYPERVISOR = 2,    // Hypervisor timing leaf 0x40000010
+    HAL_TSC_CALIBRATION_HPET = 3,          // Measured against HPET main counter
+    HAL_TSC_CALIBRATION_PIT = 4,           // Measured against PIT channel 2
+    HAL_TSC_CALIBRATION_CPUID_16H = 5,     // Nominal base frequency
+    HAL_TSC_CALIBRATION_DEFAULT = 6        // Nothing worked, guessed
+} hal_tsc_calibration_t;
+
+// Read the time stamp counter
+static inline uint64_t hal_tsc_read(void) {
+    uint32_t low, high;
+    asm volatile("rdtsc" : "=a" (low), "=d" (high));
+    return ((uint64_t)high << 32) | low;
+}
+
+// Read the time stamp counter, ordered against earlier loads
+static inline uint64_t hal_tsc_read_ordered(void) {
+    uint32_t low, high;
+    asm volatile("lfence; rdtsc" : "=a" (low), "=d" (high) : : "memory");
+    return ((uint64_t)high << 32) | low;
+}
+
+// TSC functions
+uint64_t hal_tsc_calibrate(void);
+uint64_t hal_tsc_get_frequency(void);
+bool hal_tsc_is_present(void);
+bool hal_tsc_is_invariant(void);
+hal_tsc_calibration_t hal_tsc_get_calibration_source(void);
+const char* hal_tsc_calibration_source_name(hal_tsc_calibration_t source);
+kos_clocksource_t* hal_tsc_get_clocksource(void);
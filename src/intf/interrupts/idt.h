@@ -28,4 +28,6 @@ struct IDTPointer {
     uint64_t base;
 } __attribute__((packed));
 
+void set_idt_gate(int n, uint64_t handler, uint16_t sel, uint8_t flags);
 extern void init_idt();
+extern void idt_load_cpu(void);
@@ -1,7 +1,6 @@
 #pragma once
 #include "isr.h"
 
-void irq_install_handler(int irq, void (*handler)(struct registers *r));
-void irq_uninstall_handler(int irq);
 void irq_remap(void);
-void irq_install(void);
\ No newline at end of file
+void irq_install(void);
+struct cpu_status_s *irq_handler(struct cpu_status_s *css);
\ No newline at end of file
@@ -1,7 +1,15 @@
 #ifndef PIC_H
 #define PIC_H
 
+#include <stdint.h>
+
 void pic_initialize();  // Function to initialize the PIC
 void pic_unmask_irq1(); // Function to unmask IRQ1 for the keyboard
 
+void pic_mask_irq(uint32_t irq);      // Mask one line in the IMR
+void pic_unmask_irq(uint32_t irq);    // Unmask one line in the IMR
+void pic_mask_lines(uint32_t lines);  // Hold off a set of lines for priority nesting
+void pic_send_eoi(uint32_t irq);      // Acknowledge a line
+void pic_register_chip(void);         // Register the PIC with the interrupt layer
+
 #endif
@@ -25,6 +25,7 @@
 #define KOS_VGA_MEMORY_ADDR    0xB8000
 #define KOS_VGA_WIDTH          80
 #define KOS_VGA_HEIGHT         25
+#define KOS_CACHE_LINE_SIZE    64
 
 // System Limits
 #define KOS_MAX_IRQ_HANDLERS   16
@@ -58,3 +59,8 @@
 #define KOS_FEATURE_TIMER      1
 #define KOS_FEATURE_SERIAL     1
 #define KOS_FEATURE_HEAP       1
+
+// Lock statistics, build with -DKOS_FEATURE_LOCKSTAT=1 to enable
+#ifndef KOS_FEATURE_LOCKSTAT
+#define KOS_FEATURE_LOCKSTAT   0
+#endif
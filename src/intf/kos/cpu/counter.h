@@ -0,0 +1,62 @@
+#pragma once
+
+#include <stdint.h>
+#include <stdbool.h>
+#include <stddef.h>
+#include "../types.h"
+#include "percpu.h"
+
+// =============================================================================
+// KOS - Per-CPU Event Counter Interface
+// =============================================================================
+
+// KOS_COUNTER_DEFINE places a descriptor in the kos_counters section, its
+// position there is the counter's index into every CPU's slot array. An
+// increment is a single add through GS on the local slot: no lock, no
+// atomic, no shared cache line, and an interrupt cannot split it. Reads sum
+// the slots of all CPUs. Counters work once kos_percpu_init_boot has run.
+
+// Descriptor, exactly 16 bytes so the section packs like an array
+typedef struct kos_counter {
+    const char* subsystem;
+    const char* name;
+} __attribute__((aligned(16))) kos_counter_t;
+
+_Static_assert(sizeof(kos_counter_t) == 16, "counter section stride");
+
+// Section bounds, provided by the linker
+extern kos_counter_t __start_kos_counters[];
+extern kos_counter_t __stop_kos_counters[];
+
+// Define a counter, one line per metric
+#define KOS_COUNTER_DEFINE(subsys, cname) \
+    kos_counter_t kos_counter_##cname \
+        __attribute__((used, section("kos_counters"), aligned(16))) = { #subsys, #cname }
+
+// Make a counter defined in another file visible
+#define KOS_COUNTER_DECLARE(cname) extern kos_counter_t kos_counter_##cname
+
+// Slot index of a counter, masked so an oversized section aliases instead
+// of writing past the block (kos_counter_init reports it)
+static inline uint32_t kos_counter_index(const kos_counter_t* counter) {
+    return (uint32_t)(counter - __start_kos_counters) & (KOS_COUNTER_MAX - 1);
+}
+
+// Add to the calling CPU's slot
+static inline void kos_counter_add_slot(uint32_t index, uint64_t value) {
+    uintptr_t offset = offsetof(kos_cpu_local_t, counters) + (uintptr_t)index * sizeof(uint64_t);
+    asm volatile("addq %1, %%gs:(%0)" : : "r" (offset), "er" (value));
+}
+
+#define kos_counter_add(cname, value) \
+    kos_counter_add_slot(kos_counter_index(&kos_counter_##cname), (value))
+#define kos_counter_inc(cname) kos_counter_add(cname, 1)
+
+// Counter functions
+kos_result_t kos_counter_init(void);
+uint32_t kos_counter_count(void);
+const kos_counter_t* kos_counter_at(uint32_t index);
+uint64_t kos_counter_read(const kos_counter_t* counter);
+uint64_t kos_counter_read_cpu(const kos_counter_t* counter, uint32_t cpu_id);
+void kos_counter_reset(const kos_counter_t* counter);
+void kos_counter_reset_all(void);
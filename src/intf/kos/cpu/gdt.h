@@ -17,3 +17,5 @@ kos_result_t kos_gdt_create_entry(kos_gdt_entry_t* entry, u32 base, u32 limit,
 // Convenience functions
 kos_result_t kos_gdt_setup_kernel_segments(kos_gdt_t* gdt);
 kos_result_t kos_gdt_setup_user_segments(kos_gdt_t* gdt);
+kos_result_t kos_gdt_setup_tss(kos_gdt_t* gdt, kos_tss_t* tss);
+void kos_gdt_load_tss(void);
@@ -13,16 +13,20 @@ typedef uint16_t u16;
 typedef uint32_t u32;
 typedef uint64_t u64;
 
-// GDT entry indices
+// GDT entry indices, user data sits below user code because SYSRET loads
+// SS from STAR[63:48] + 8 and CS from STAR[63:48] + 16
 typedef enum {
     KOS_GDT_NULL = 0,
     KOS_GDT_KERNEL_CODE = 1,
     KOS_GDT_KERNEL_DATA = 2,
-    KOS_GDT_USER_CODE = 3,
-    KOS_GDT_USER_DATA = 4,
-    KOS_GDT_MAX_ENTRIES = 5
+    KOS_GDT_USER_DATA = 3,
+    KOS_GDT_USER_CODE = 4,
+    KOS_GDT_TSS = 5,            // 16-byte system descriptor, two slots
+    KOS_GDT_MAX_ENTRIES = 7
 } kos_gdt_index_t;
 
+#define KOS_GDT_TSS_SELECTOR    (KOS_GDT_TSS * 8)
+
 // GDT access rights
 typedef enum {
     KOS_GDT_ACCESS_CODE_READABLE = 0x1,
@@ -57,3 +61,14 @@ typedef struct {
     kos_gdt_entry_t entries[KOS_GDT_MAX_ENTRIES];
     kos_gdt_pointer_t pointer;
 } kos_gdt_t;
+
+// 64-bit task state segment, one per CPU
+typedef struct {
+    u32 reserved0;
+    u64 rsp[3];                 // Stack for entry from ring 0-2
+    u64 reserved1;
+    u64 ist[7];                 // Interrupt stack table
+    u64 reserved2;
+    u16 reserved3;
+    u16 iomap_base;
+} __attribute__((packed)) kos_tss_t;
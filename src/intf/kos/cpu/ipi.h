@@ -0,0 +1,74 @@
+#pragma once
+
+#include <stdint.h>
+#include <stdbool.h>
+#include "../types.h"
+#include "percpu.h"
+#include "../utils/histogram.h"
+
+// =============================================================================
+// KOS - Inter-Processor Interrupt Interface
+// =============================================================================
+
+// IPIs use the top vectors, above every device class, so a target takes
+// them whatever its task priority. The handlers run with interrupts off
+// and must stay short.
+
+#define KOS_IPI_VECTOR_BASE         0xF0    // Must match irq_stubs.asm
+#define KOS_IPI_VECTOR_COUNT        3
+
+// IPI types
+typedef enum {
+    KOS_IPI_CALL_FUNCTION = 0,
+    KOS_IPI_RESCHEDULE = 1,
+    KOS_IPI_TLB_SHOOTDOWN = 2,
+    KOS_IPI_TYPE_COUNT = KOS_IPI_VECTOR_COUNT
+} kos_ipi_type_t;
+
+// Set of CPUs by index
+typedef uint64_t kos_cpumask_t;
+
+#define KOS_CPUMASK_CPU(cpu)        (1ULL << (cpu))
+#define KOS_CPUMASK_ALL             (~0ULL)
+
+// Pending remote calls without a waiter, more fall back to waiting
+#define KOS_IPI_ASYNC_CALLS         16
+
+// Pages queued per target before a shootdown becomes a full flush
+#define KOS_TLB_BATCH_MAX           32
+
+typedef void (*kos_smp_call_fn_t)(void* arg);
+
+// Per-type counters
+typedef struct {
+    uint64_t sent[KOS_IPI_TYPE_COUNT];
+    uint64_t received[KOS_IPI_TYPE_COUNT];
+    uint64_t calls_run;
+    uint64_t tlb_pages;             // Pages queued for invalidation
+    uint64_t tlb_full_flushes;
+    uint64_t tlb_coalesced;         // Requests that rode on a pending IPI
+} kos_ipi_stats_t;
+
+// Remote calls, fn runs in interrupt context on every target. Callers that
+// wait must have interrupts enabled, or two CPUs calling each other deadlock.
+kos_result_t kos_smp_call_function(kos_cpumask_t mask, kos_smp_call_fn_t fn, void* arg, bool wait);
+kos_result_t kos_smp_call_function_single(uint32_t cpu, kos_smp_call_fn_t fn, void* arg, bool wait);
+
+// Ask a CPU to run its scheduler at the next opportunity
+void kos_smp_send_reschedule(uint32_t cpu);
+bool kos_smp_test_and_clear_resched(void);
+
+// TLB shootdown, queued per target and sent once per batch
+void kos_tlb_invalidate(kos_cpumask_t mask, uintptr_t addr, uint32_t pages);
+void kos_tlb_sync(kos_cpumask_t mask);
+
+// Entry from the low-level handler
+void kos_ipi_handle(uint32_t vector);
+
+// Statistics functions
+void kos_ipi_get_stats(kos_ipi_stats_t* stats);
+void kos_ipi_reset_stats(void);
+void kos_ipi_dump_stats(void);
+
+// Round trip of a no-op remote call to cpu, latencies in cycles
+kos_result_t kos_ipi_benchmark(uint32_t cpu, uint32_t iterations, kos_histogram_summary_t* summary);
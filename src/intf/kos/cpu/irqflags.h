@@ -0,0 +1,50 @@
+#pragma once
+
+#include <stdint.h>
+#include <stdbool.h>
+
+// =============================================================================
+// KOS - Local Interrupt Flag Control
+// =============================================================================
+
+#define KOS_RFLAGS_IF 0x200
+
+// Save RFLAGS and disable interrupts on this CPU
+static inline uint64_t kos_local_irq_save(void) {
+    uint64_t flags;
+    asm volatile("pushfq; pop %0; cli" : "=r" (flags) : : "memory");
+    return flags;
+}
+
+// Restore a previously saved interrupt state
+static inline void kos_local_irq_restore(uint64_t flags) {
+    if (flags & KOS_RFLAGS_IF) {
+        asm volatile("sti" : : : "memory");
+    }
+}
+
+static inline void kos_local_irq_enable(void) {
+    asm volatile("sti" : : : "memory");
+}
+
+static inline void kos_local_irq_disable(void) {
+    asm volatile("cli" : : : "memory");
+}
+
+// Task priority (CR8 mirrors LAPIC TPR[7:4]): vectors of class <= TPR are held off
+static inline uint64_t kos_read_cr8(void) {
+    uint64_t tpr;
+    asm volatile("mov %%cr8, %0" : "=r" (tpr));
+    return tpr;
+}
+
+static inline void kos_write_cr8(uint64_t tpr) {
+    asm volatile("mov %0, %%cr8" : : "r" (tpr) : "memory");
+}
+
+// Check whether interrupts are enabled on this CPU
+static inline bool kos_local_irq_enabled(void) {
+    uint64_t flags;
+    asm volatile("pushfq; pop %0" : "=r" (flags));
+    return (flags & KOS_RFLAGS_IF) != 0;
+}
@@ -0,0 +1,85 @@
+#pragma once
+
+#include <stdint.h>
+#include <stdbool.h>
+#include <stddef.h>
+#include "../types.h"
+#include "../config.h"
+#include "gdt.h"
+
+// =============================================================================
+// KOS - Per-CPU Data Interface
+// =============================================================================
+
+// Each CPU finds its own block through GS. In the kernel GS_BASE points at
+// the block; user GS lives in KERNEL_GS_BASE and SWAPGS exchanges the two on
+// every ring transition. The block also holds the CPU's own GDT and TSS.
+
+#define KOS_CPU_MAX                 32
+#define KOS_CPU_SYSCALL_STACK_SIZE  16384
+#define KOS_COUNTER_MAX             64      // Event counter slots, a power of two
+
+// Field offsets used by the assembly entry paths
+#define KOS_CPU_LOCAL_SELF          0
+#define KOS_CPU_LOCAL_KERNEL_STACK  8
+#define KOS_CPU_LOCAL_USER_STACK    16
+
+struct kos_tasklet;
+
+// Tasklet queue, empty when head is NULL
+typedef struct {
+    struct kos_tasklet* head;
+    struct kos_tasklet* tail;
+} kos_tasklet_list_t;
+
+// Interrupt entry and bottom-half state, see interrupt.c and softirq.c
+typedef struct {
+    uint32_t hardirq_nesting;           // kos_irq_enter depth
+    uint32_t dispatch_nesting;          // Handlers stacked in kos_interrupt_dispatch
+    int running_priority;               // Priority of the innermost handler
+    uintptr_t stack_base;               // Frame of the outermost handler
+    uint64_t hardirq_start;             // kos_clock_cycles() at the outermost entry
+    volatile uint32_t softirq_pending;
+    volatile bool in_softirq;
+    kos_tasklet_list_t tasklet_hi;
+    kos_tasklet_list_t tasklet_normal;
+} kos_cpu_irq_t;
+
+typedef struct kos_cpu_local {
+    struct kos_cpu_local* self;     // gs:0, lets C read the block address
+    uint64_t kernel_stack;          // gs:8, stack SYSCALL switches to, the running process's
+    uint64_t user_stack;            // gs:16, user RSP saved on SYSCALL
+    uint32_t cpu_id;
+    uint32_t apic_id;
+    volatile bool online;
+    volatile bool need_resched;     // Set by the reschedule IPI
+    volatile uint64_t rcu_qs_seq;   // Last grace period this CPU was quiescent in
+    kos_cpu_irq_t irq;
+    kos_gdt_t gdt;
+    kos_tss_t tss;
+    uint64_t counters[KOS_COUNTER_MAX] __attribute__((aligned(KOS_CACHE_LINE_SIZE)));  // See counter.h
+} kos_cpu_local_t;
+
+_Static_assert(offsetof(kos_cpu_local_t, self) == KOS_CPU_LOCAL_SELF, "percpu layout");
+_Static_assert(offsetof(kos_cpu_local_t, kernel_stack) == KOS_CPU_LOCAL_KERNEL_STACK, "percpu layout");
+_Static_assert(offsetof(kos_cpu_local_t, user_stack) == KOS_CPU_LOCAL_USER_STACK, "percpu layout");
+
+// Block of the calling CPU
+static inline kos_cpu_local_t* kos_this_cpu(void) {
+    kos_cpu_local_t* cpu;
+    asm volatile("mov %%gs:0, %0" : "=r" (cpu));
+    return cpu;
+}
+
+// Per-CPU functions
+kos_result_t kos_percpu_init(uint32_t cpu_id, uint32_t apic_id);
+kos_result_t kos_percpu_init_boot(void);
+kos_cpu_local_t* kos_percpu_get(uint32_t cpu_id);
+uint32_t kos_percpu_count(void);
+void kos_percpu_set_kernel_stack(uint64_t stack_top);
+kos_cpu_irq_t* kos_percpu_irq(void);
+
+// Index of the calling CPU, 0 until the per-CPU blocks exist
+static inline uint32_t kos_this_cpu_id(void) {
+    return kos_percpu_count() ? kos_this_cpu()->cpu_id : 0;
+}
@@ -0,0 +1,28 @@
+#pragma once
+
+#include <stdint.h>
+#include <stdbool.h>
+#include "../types.h"
+#include "percpu.h"
+
+// =============================================================================
+// KOS - Symmetric Multiprocessing Interface
+// =============================================================================
+
+// The boot CPU starts every CPU listed in the MADT with INIT-SIPI-SIPI.
+// Each one enters long mode through a low-memory trampoline and sets up
+// its own GDT, TSS, GS block and syscall MSRs. Then it loads the shared
+// IDT and settles into its own idle loop.
+
+#define KOS_SMP_TRAMPOLINE_BASE     0x8000      // Must match ap_trampoline.asm
+#define KOS_SMP_AP_STACK_SIZE       16384
+#define KOS_SMP_INIT_DELAY_NS       10000000ULL // INIT to first SIPI
+#define KOS_SMP_SIPI_DELAY_NS       200000ULL   // Between the two SIPIs
+#define KOS_SMP_START_TIMEOUT_NS    100000000ULL
+
+// SMP functions
+kos_result_t kos_smp_init(void);
+uint32_t kos_smp_cpu_count(void);
+uint32_t kos_smp_online_count(void);
+uint32_t kos_smp_this_cpu_id(void);
+void kos_smp_dump(void);
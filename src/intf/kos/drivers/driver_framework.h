@@ -4,6 +4,8 @@
 #include "hal/hal_interface_clean.h"
 #include "kos/types.h"
 #include "kos/config.h"
+#include "kos/sync/spinlock.h"
+#include "kos/sync/rcu.h"
 
 // =============================================================================
 // KOS - Driver Framework (HAL-based)
@@ -73,7 +75,7 @@ typedef struct kos_driver_ops {
     hal_result_t (*write)(kos_device_t* device, const void* buffer, size_t size, size_t* bytes_written);
     hal_result_t (*ioctl)(kos_device_t* device, uint32_t request, void* arg);
     
-    // Interrupt handling
+    // Interrupt handling, HAL_SUCCESS if the device raised the interrupt
     hal_result_t (*interrupt_handler)(kos_device_t* device, uint32_t irq, void* context);
     
     // Power management
@@ -117,7 +119,7 @@ struct kos_device {
     kos_driver_state_t state;
     uint32_t reference_count;
     hal_bool_t is_open;
-    // hal_mutex_t lock;  // Simplified - no mutex for now
+    kos_spinlock_t lock;
     kos_device_t* next;
 };
 
@@ -169,9 +171,9 @@ struct kos_driver_manager {
     uint64_t active_devices;
     uint64_t failed_operations;
     
-    // Simplified - no mutex for now
-    // hal_mutex_t driver_lock;
-    // hal_mutex_t device_lock;
+    // Writer locks, lookups walk the lists under RCU
+    kos_spinlock_t driver_lock;
+    kos_spinlock_t device_lock;
 };
 
 // =============================================================================
@@ -202,6 +204,8 @@ hal_result_t kos_device_close(kos_device_t* device);
 hal_result_t kos_device_read(kos_device_t* device, void* buffer, size_t size, size_t* bytes_read);
 hal_result_t kos_device_write(kos_device_t* device, const void* buffer, size_t size, size_t* bytes_written);
 hal_result_t kos_device_ioctl(kos_device_t* device, uint32_t request, void* arg);
+hal_result_t kos_device_request_irq(kos_device_t* device);
+hal_result_t kos_device_free_irq(kos_device_t* device);
 
 // Utility functions
 kos_driver_t* kos_driver_find_by_name(const char* name);
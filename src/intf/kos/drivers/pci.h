@@ -0,0 +1,87 @@
+#pragma once
+
+#include <stdint.h>
+#include <stdbool.h>
+#include "../types.h"
+
+// =============================================================================
+// KOS - PCI Configuration Space Interface
+// =============================================================================
+
+// Configuration mechanism #1 ports
+#define KOS_PCI_CONFIG_ADDRESS      0xCF8
+#define KOS_PCI_CONFIG_DATA         0xCFC
+
+// Header registers
+#define KOS_PCI_VENDOR_ID           0x00
+#define KOS_PCI_DEVICE_ID           0x02
+#define KOS_PCI_COMMAND             0x04
+#define KOS_PCI_STATUS              0x06
+#define KOS_PCI_REVISION            0x08
+#define KOS_PCI_PROG_IF             0x09
+#define KOS_PCI_SUBCLASS            0x0A
+#define KOS_PCI_CLASS               0x0B
+#define KOS_PCI_HEADER_TYPE         0x0E
+#define KOS_PCI_BAR0                0x10
+#define KOS_PCI_CAPABILITY_LIST     0x34
+#define KOS_PCI_INTERRUPT_LINE      0x3C
+#define KOS_PCI_INTERRUPT_PIN       0x3D
+
+// Command register
+#define KOS_PCI_COMMAND_IO          (1U << 0)
+#define KOS_PCI_COMMAND_MEMORY      (1U << 1)
+#define KOS_PCI_COMMAND_MASTER      (1U << 2)
+#define KOS_PCI_COMMAND_INTX_OFF    (1U << 10)
+
+// Status register
+#define KOS_PCI_STATUS_CAP_LIST     (1U << 4)
+
+// BAR decoding
+#define KOS_PCI_BAR_IO              0x01
+#define KOS_PCI_BAR_TYPE_MASK       0x06
+#define KOS_PCI_BAR_TYPE_64         0x04
+
+// Capability IDs
+#define KOS_PCI_CAP_ID_MSI          0x05
+#define KOS_PCI_CAP_ID_MSIX         0x11
+
+#define KOS_PCI_MAX_DEVICES         64
+#define KOS_PCI_BAR_COUNT           6
+
+// One PCI function found during enumeration
+typedef struct {
+    uint8_t bus;
+    uint8_t slot;
+    uint8_t function;
+    uint16_t vendor_id;
+    uint16_t device_id;
+    uint8_t class_code;
+    uint8_t subclass;
+    uint8_t prog_if;
+    uint8_t header_type;
+    uint8_t irq_line;           // Legacy INTx routing from firmware
+    uint8_t irq_pin;
+    uint8_t msi_cap;            // Config offset of the MSI capability, 0 if none
+    uint8_t msix_cap;           // Config offset of the MSI-X capability, 0 if none
+} kos_pci_device_t;
+
+// Configuration space access
+uint8_t kos_pci_read8(const kos_pci_device_t* dev, uint8_t offset);
+uint16_t kos_pci_read16(const kos_pci_device_t* dev, uint8_t offset);
+uint32_t kos_pci_read32(const kos_pci_device_t* dev, uint8_t offset);
+void kos_pci_write16(const kos_pci_device_t* dev, uint8_t offset, uint16_t value);
+void kos_pci_write32(const kos_pci_device_t* dev, uint8_t offset, uint32_t value);
+
+// Enumeration
+kos_result_t kos_pci_init(void);
+uint32_t kos_pci_get_device_count(void);
+kos_pci_device_t* kos_pci_get_device(uint32_t index);
+kos_pci_device_t* kos_pci_find_device(uint16_t vendor_id, uint16_t device_id);
+kos_pci_device_t* kos_pci_find_class(uint8_t class_code, uint8_t subclass);
+
+// Device helpers
+uint8_t kos_pci_find_capability(const kos_pci_device_t* dev, uint8_t cap_id);
+uint64_t kos_pci_get_bar(const kos_pci_device_t* dev, uint32_t bar);
+void kos_pci_enable_bus_master(const kos_pci_device_t* dev);
+void kos_pci_set_intx(const kos_pci_device_t* dev, bool enable);
+void kos_pci_dump_devices(void);
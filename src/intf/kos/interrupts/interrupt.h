@@ -5,6 +5,8 @@
 #include <stdbool.h>
 #include "../types.h"
 #include "exception.h"
+#include "../utils/histogram.h"
+#include "../time/timer.h"
 
 // =============================================================================
 // KOS - Interrupt Management Interface
@@ -27,6 +29,18 @@ typedef enum {
     KOS_INTERRUPT_PRIORITY_NMI = 4
 } kos_interrupt_priority_t;
 
+#define KOS_INTERRUPT_PRIORITY_COUNT 5
+
+// A handler runs with everything at or below its priority held off. LAPIC
+// sources are held off through CR8: priority p owns vector class
+// KOS_INTERRUPT_TPR_BASE + p. Legacy PIC lines ignore the TPR, so they are
+// held off by masking at the controller.
+#define KOS_INTERRUPT_TPR_BASE       3
+
+static inline uint8_t kos_interrupt_priority_to_tpr(kos_interrupt_priority_t priority) {
+    return (uint8_t)(KOS_INTERRUPT_TPR_BASE + priority);
+}
+
 // Interrupt states
 typedef enum {
     KOS_INTERRUPT_DISABLED = 0,
@@ -57,8 +71,38 @@ typedef enum {
     KOS_IRQ_COUNT = 16
 } kos_irq_t;
 
+// Dynamic lines for MSI/MSI-X are numbered after the legacy ones. Line
+// KOS_IRQ_COUNT + n uses vector KOS_IRQ_DYNAMIC_VECTOR_BASE + n, so the
+// vector class, and with it the TPR priority, follows from the line.
+#define KOS_IRQ_DYNAMIC_VECTOR_BASE  0x30
+#define KOS_IRQ_DYNAMIC_COUNT        80      // Vector classes 3-7, one per priority
+#define KOS_IRQ_VECTORS_PER_CLASS    16
+#define KOS_IRQ_LINES                (KOS_IRQ_COUNT + KOS_IRQ_DYNAMIC_COUNT)
+
+// Handler return value, lets shared lines tell which device raised the IRQ
+typedef enum {
+    KOS_IRQ_NONE = 0,
+    KOS_IRQ_HANDLED = 1
+} kos_irq_return_t;
+
 // Interrupt handler function type
-typedef void (*kos_interrupt_handler_t)(uint32_t irq, void* context);
+typedef kos_irq_return_t (*kos_interrupt_handler_t)(uint32_t irq, void* context);
+
+// Handler flags
+#define KOS_IRQF_SHARED           0x01    // Line may be shared with other handlers
+
+// Handler pool shared by all lines
+#define KOS_IRQ_MAX_ACTIONS       32
+
+// One handler on an IRQ line
+typedef struct kos_irq_action {
+    kos_interrupt_handler_t handler;
+    void* context;
+    uint32_t flags;
+    uint64_t handled;
+    struct kos_irq_action* next;
+    char name[32];
+} kos_irq_action_t;
 
 // Interrupt context structure
 typedef struct {
@@ -73,20 +117,60 @@ typedef struct {
     bool is_nested;
 } kos_interrupt_context_t;
 
-// Interrupt descriptor
+// Storm mitigation: a line whose averaged rate exceeds its budget is masked
+// and its handlers are polled from a timer instead. The line is retried after
+// a backoff that doubles while it keeps storming.
+#define KOS_IRQ_STORM_DEFAULT_RATE   20000                 // Interrupts per second per line
+#define KOS_IRQ_STORM_WINDOW_NS      10000000ULL           // Rate sample window
+#define KOS_IRQ_STORM_EWMA_SHIFT     2                     // New samples weigh 1/4
+#define KOS_IRQ_STORM_POLL_NS        1000000ULL            // Handler poll period while masked
+#define KOS_IRQ_STORM_BACKOFF_MIN_NS 10000000ULL
+#define KOS_IRQ_STORM_BACKOFF_MAX_NS 1000000000ULL
+#define KOS_IRQ_STORM_CALM_NS        1000000000ULL         // Quiet time that resets the backoff
+
+// Interrupt controller operations for the legacy lines
+typedef struct {
+    const char* name;
+    void (*mask)(uint32_t irq);
+    void (*unmask)(uint32_t irq);
+    void (*eoi)(uint32_t irq);
+    void (*mask_lines)(uint32_t lines);   // Hold off a set of lines on top of per-line masks
+} kos_irq_chip_t;
+
+// Interrupt descriptor, one handler chain per line
 typedef struct {
     uint32_t irq;
     uint32_t vector;
-    kos_interrupt_handler_t handler;
-    void* device_context;
+    const kos_irq_chip_t* chip; // Masks and acknowledges the line
+    kos_irq_action_t* actions;
+    uint32_t action_count;
+    uint32_t flags;             // KOS_IRQF_* shared by every action on the line
     kos_interrupt_priority_t priority;
     bool enabled;
     uint32_t count;
+    uint32_t unhandled;         // No handler claimed the interrupt
     uint64_t last_time;
     uint64_t total_time;
     uint64_t max_time;
     uint64_t min_time;
-    char name[32];
+    
+    // Tail behaviour, in ns
+    uint64_t expected_cycles;   // TSC deadline announced by the timer source, the PIT for IRQ 0
+    kos_histogram_t latency;    // Deadline to dispatch
+    kos_histogram_t duration;   // Handler chain run time
+    
+    // Storm mitigation
+    uint32_t rate_limit;        // Interrupts per second before throttling, 0 = never
+    uint32_t rate;              // EWMA of the interrupt rate, per second
+    uint64_t window_start;      // kos_clock_cycles() at the start of the sample window
+    uint32_t window_count;
+    bool throttled;             // Masked, handlers run from poll_timer
+    uint32_t storms;
+    uint32_t polls;
+    uint64_t backoff_ns;
+    uint64_t unthrottle_ns;     // Monotonic time the line is retried
+    uint64_t calm_since_ns;     // Monotonic time the line was last unmasked
+    kos_timer_t poll_timer;
 } kos_interrupt_descriptor_t;
 
 // Interrupt management configuration
@@ -97,20 +181,31 @@ typedef struct {
     bool enable_debug;
     uint32_t max_nesting_level;
     uint32_t interrupt_stack_size;
+    uint32_t storm_rate_limit;  // Per-line budget in interrupts per second, 0 = default
 } kos_interrupt_config_t;
 
+// Per-priority nesting statistics
+typedef struct {
+    uint64_t entries;
+    uint64_t preemptions;       // Entered on top of a lower-priority handler
+    uint32_t max_depth;
+    uint64_t max_stack_bytes;   // Stack used below the outermost interrupt frame
+} kos_interrupt_priority_stats_t;
+
 // Interrupt statistics
 typedef struct {
     uint32_t total_interrupts;
-    uint32_t interrupt_counts[KOS_IRQ_COUNT];
+    uint32_t interrupt_counts[KOS_IRQ_LINES];
     uint32_t nested_interrupts;
     uint32_t masked_interrupts;
     uint32_t failed_interrupts;
     uint64_t total_time;
     uint64_t max_interrupt_time;
     uint64_t min_interrupt_time;
-    uint32_t last_interrupt_time;
+    uint64_t last_interrupt_time;   // Monotonic ns when the last handler chain finished
     kos_irq_t last_irq;
+    uint32_t storms;            // Times any line was throttled
+    kos_interrupt_priority_stats_t priority[KOS_INTERRUPT_PRIORITY_COUNT];
 } kos_interrupt_stats_t;
 
 // Interrupt stack management
@@ -119,18 +214,25 @@ typedef struct {
     void* stack_top;
     size_t stack_size;
     void* current_sp;
-    uint32_t nesting_level;
-    bool in_interrupt;
 } kos_interrupt_stack_t;
 
 // Interrupt management functions
 kos_result_t kos_interrupt_init(const kos_interrupt_config_t* config);
+kos_result_t kos_interrupt_request(kos_irq_t irq, kos_interrupt_handler_t handler, void* context, uint32_t flags, const char* name);
+kos_result_t kos_interrupt_free(kos_irq_t irq, void* context);
 kos_result_t kos_interrupt_register_handler(kos_irq_t irq, kos_interrupt_handler_t handler, void* context, const char* name);
 kos_result_t kos_interrupt_unregister_handler(kos_irq_t irq);
 kos_result_t kos_interrupt_enable(kos_irq_t irq);
 kos_result_t kos_interrupt_disable(kos_irq_t irq);
 kos_result_t kos_interrupt_mask(kos_irq_t irq);
 kos_result_t kos_interrupt_unmask(kos_irq_t irq);
+kos_result_t kos_interrupt_set_chip(const kos_irq_chip_t* chip);
+
+// Dynamic line functions
+kos_result_t kos_interrupt_alloc_dynamic(kos_interrupt_priority_t priority, uint32_t count, const kos_irq_chip_t* chip, kos_irq_t* first_irq);
+void kos_interrupt_free_dynamic(kos_irq_t first_irq, uint32_t count);
+bool kos_interrupt_is_dynamic(kos_irq_t irq);
+uint32_t kos_interrupt_vector_to_irq(uint32_t vector);
 
 // Interrupt control functions
 kos_interrupt_state_t kos_interrupt_get_state(void);
@@ -152,17 +254,24 @@ kos_interrupt_priority_t kos_interrupt_get_priority(kos_irq_t irq);
 kos_result_t kos_interrupt_set_priority(kos_irq_t irq, kos_interrupt_priority_t priority);
 kos_result_t kos_interrupt_set_global_priority(kos_interrupt_priority_t priority);
 
+// Interrupt storm functions
+kos_result_t kos_interrupt_set_rate_limit(kos_irq_t irq, uint32_t per_second);
+uint32_t kos_interrupt_get_rate(kos_irq_t irq);
+bool kos_interrupt_is_throttled(kos_irq_t irq);
+uint32_t kos_interrupt_throttled_count(void);
+
 // Interrupt handler functions
 void kos_interrupt_handle(uint32_t irq);
 void kos_interrupt_handle_nested(uint32_t irq);
 kos_result_t kos_interrupt_dispatch(uint32_t irq);
-kos_interrupt_handler_t kos_interrupt_get_handler(kos_irq_t irq);
 
 // Interrupt statistics functions
-const kos_interrupt_stats_t* kos_interrupt_get_stats(void);
+void kos_interrupt_get_stats(kos_interrupt_stats_t* stats);
 void kos_interrupt_reset_stats(void);
 kos_result_t kos_interrupt_dump_stats(void);
 kos_result_t kos_interrupt_get_irq_stats(kos_irq_t irq, uint32_t* count, uint64_t* total_time);
+kos_result_t kos_interrupt_get_latency(kos_irq_t irq, kos_histogram_summary_t* latency, kos_histogram_summary_t* duration);
+void kos_interrupt_dump_latency(void);
 
 // Interrupt debugging functions
 void kos_interrupt_dump_context(const kos_interrupt_context_t* context);
@@ -190,6 +299,7 @@ kos_irq_t kos_interrupt_get_irq_from_vector(uint32_t vector);
 uint64_t kos_interrupt_get_timestamp(void);
 kos_result_t kos_interrupt_start_timing(kos_irq_t irq);
 kos_result_t kos_interrupt_end_timing(kos_irq_t irq);
+void kos_interrupt_set_expected(kos_irq_t irq, uint64_t deadline_cycles);
 uint64_t kos_interrupt_get_last_time(kos_irq_t irq);
 
 // Interrupt configuration functions
@@ -198,7 +308,7 @@ kos_interrupt_config_t kos_interrupt_get_config(void);
 kos_result_t kos_interrupt_validate_config(const kos_interrupt_config_t* config);
 
 // Interrupt macros for convenience
-#define KOS_INTERRUPT_HANDLER(name) static void name(uint32_t irq, void* context)
+#define KOS_INTERRUPT_HANDLER(name) static kos_irq_return_t name(uint32_t irq, void* context)
 #define KOS_INTERRUPT_REGISTER(irq, handler, context) kos_interrupt_register_handler(irq, handler, context, #handler)
 #define KOS_INTERRUPT_UNREGISTER(irq) kos_interrupt_unregister_handler(irq)
 #define KOS_INTERRUPT_ENABLE(irq) kos_interrupt_enable(irq)
@@ -221,7 +331,7 @@ kos_result_t kos_interrupt_validate_config(const kos_interrupt_config_t* config)
 #define KOS_INTERRUPT_GET_PRIORITY(irq) kos_interrupt_get_priority(irq)
 
 // Interrupt statistics macros
-#define KOS_INTERRUPT_GET_STATS() kos_interrupt_get_stats()
+#define KOS_INTERRUPT_GET_STATS(stats) kos_interrupt_get_stats(stats)
 #define KOS_INTERRUPT_RESET_STATS() kos_interrupt_reset_stats()
 #define KOS_INTERRUPT_DUMP_STATS() kos_interrupt_dump_stats()
 
@@ -0,0 +1,59 @@
+#pragma once
+
+#include <stdint.h>
+#include <stdbool.h>
+#include "../types.h"
+#include "interrupt.h"
+#include "../drivers/pci.h"
+
+// =============================================================================
+// KOS - MSI/MSI-X Interface
+// =============================================================================
+
+// Message-signalled interrupts are memory writes to the local APIC of the
+// target CPU, so each vector gets its own dynamic line instead of sharing an
+// INTx pin, and each MSI-X queue can be steered to a different CPU.
+
+// MSI capability layout
+#define KOS_MSI_CONTROL             0x02
+#define KOS_MSI_ADDRESS_LOW         0x04
+#define KOS_MSI_ADDRESS_HIGH        0x08
+#define KOS_MSI_DATA_32             0x08
+#define KOS_MSI_DATA_64             0x0C
+#define KOS_MSI_MASK_32             0x0C
+#define KOS_MSI_MASK_64             0x10
+
+#define KOS_MSI_CONTROL_ENABLE      (1U << 0)
+#define KOS_MSI_CONTROL_MMC_SHIFT   1           // log2 of vectors the device can use
+#define KOS_MSI_CONTROL_MME_SHIFT   4           // log2 of vectors enabled
+#define KOS_MSI_CONTROL_MME_MASK    (7U << 4)
+#define KOS_MSI_CONTROL_64BIT       (1U << 7)
+#define KOS_MSI_CONTROL_MASKABLE    (1U << 8)
+
+// MSI-X capability layout
+#define KOS_MSIX_CONTROL            0x02
+#define KOS_MSIX_TABLE              0x04
+#define KOS_MSIX_CONTROL_SIZE_MASK  0x7FFU       // Table size minus one
+#define KOS_MSIX_CONTROL_MASKALL    (1U << 14)
+#define KOS_MSIX_CONTROL_ENABLE     (1U << 15)
+#define KOS_MSIX_BIR_MASK           0x7U
+
+// MSI-X table entry
+#define KOS_MSIX_ENTRY_SIZE         16
+#define KOS_MSIX_ENTRY_ADDR_LOW     0x0
+#define KOS_MSIX_ENTRY_ADDR_HIGH    0x4
+#define KOS_MSIX_ENTRY_DATA         0x8
+#define KOS_MSIX_ENTRY_CONTROL      0xC
+#define KOS_MSIX_ENTRY_MASKED       (1U << 0)
+
+#define KOS_MSI_MAX_VECTORS         KOS_IRQ_VECTORS_PER_CLASS
+
+// MSI functions
+bool kos_msi_is_supported(void);
+kos_result_t kos_msi_enable(kos_pci_device_t* dev, uint32_t count, kos_interrupt_priority_t priority,
+                            uint32_t cpu, kos_irq_t* first_irq);
+kos_result_t kos_msix_enable(kos_pci_device_t* dev, uint32_t count, kos_interrupt_priority_t priority,
+                             const uint32_t* cpus, kos_irq_t* irqs);
+void kos_msi_disable(kos_pci_device_t* dev);
+kos_result_t kos_msi_set_affinity(kos_irq_t irq, uint32_t cpu);
+void kos_msi_dump(void);
@@ -0,0 +1,109 @@
+#pragma once
+
+#include <stdint.h>
+#include <stdbool.h>
+#include "../types.h"
+
+// =============================================================================
+// KOS - Deferred Work Interface
+// =============================================================================
+
+// Interrupt handlers (top halves) only acknowledge the device and queue work.
+// Softirqs and tasklets (bottom halves) run on IRQ exit with interrupts
+// enabled, bounded by a time budget, on the CPU that raised them. Jobs that
+// may take long go to the worker, which runs from the boot CPU's idle loop.
+
+// Bottom-half budget per IRQ exit, the rest is left to the worker
+#define KOS_SOFTIRQ_MAX_RESTART   8
+#define KOS_SOFTIRQ_BUDGET_NS     2000000ULL
+
+// Softirq vectors, lower numbers run first
+typedef enum {
+    KOS_SOFTIRQ_HI_TASKLET = 0,
+    KOS_SOFTIRQ_TIMER,
+    KOS_SOFTIRQ_TASKLET,
+    KOS_SOFTIRQ_COUNT
+} kos_softirq_t;
+
+typedef void (*kos_softirq_action_t)(void);
+typedef void (*kos_deferred_fn_t)(void* data);
+
+// Tasklet: runs once per schedule, never concurrently with itself
+typedef struct kos_tasklet {
+    struct kos_tasklet* next;
+    volatile bool scheduled;
+    volatile bool running;          // Held by the CPU running it
+    kos_deferred_fn_t func;
+    void* data;
+} kos_tasklet_t;
+
+#define KOS_TASKLET_INIT(fn, arg) { .next = NULL, .scheduled = false, .running = false, .func = (fn), .data = (arg) }
+
+// Work item for the worker context, may sleep or log
+typedef struct kos_work {
+    struct kos_work* next;
+    volatile bool pending;
+    kos_deferred_fn_t func;
+    void* data;
+} kos_work_t;
+
+#define KOS_WORK_INIT(fn, arg) { .next = NULL, .pending = false, .func = (fn), .data = (arg) }
+
+// Per-vector softirq statistics
+typedef struct {
+    uint64_t raised;
+    uint64_t runs;
+    uint64_t total_ns;
+    uint64_t max_ns;
+} kos_softirq_vector_stats_t;
+
+// Deferred work statistics, times in ns
+typedef struct {
+    // Top halves (interrupts off)
+    uint64_t hardirq_count;
+    uint64_t hardirq_ns;
+    uint64_t hardirq_max_ns;
+
+    // Bottom halves (interrupts on)
+    kos_softirq_vector_stats_t vectors[KOS_SOFTIRQ_COUNT];
+    uint64_t softirq_passes;
+    uint64_t softirq_ns;
+    uint64_t softirq_max_pass_ns;
+    uint64_t softirq_deferred;      // Passes cut short by the budget
+    uint64_t tasklet_runs;
+
+    // Worker context
+    uint64_t work_queued;
+    uint64_t work_runs;
+    uint64_t worker_ns;
+    uint64_t worker_max_ns;
+} kos_softirq_stats_t;
+
+// Softirq functions
+kos_result_t kos_softirq_init(void);
+kos_result_t kos_softirq_open(kos_softirq_t nr, kos_softirq_action_t action);
+void kos_softirq_raise(kos_softirq_t nr);
+bool kos_softirq_pending(void);
+void kos_softirq_run(void);
+
+// Interrupt context tracking, called by the low-level IRQ dispatcher
+void kos_irq_enter(void);
+void kos_irq_exit(void);
+bool kos_in_interrupt(void);
+bool kos_in_softirq(void);
+
+// Tasklet functions
+void kos_tasklet_init(kos_tasklet_t* tasklet, kos_deferred_fn_t func, void* data);
+bool kos_tasklet_schedule(kos_tasklet_t* tasklet);
+bool kos_tasklet_hi_schedule(kos_tasklet_t* tasklet);
+
+// Worker functions
+void kos_work_init(kos_work_t* work, kos_deferred_fn_t func, void* data);
+bool kos_work_queue(kos_work_t* work);
+bool kos_worker_pending(void);
+void kos_worker_run(void);
+
+// Statistics functions
+void kos_softirq_get_stats(kos_softirq_stats_t* stats);
+void kos_softirq_reset_stats(void);
+void kos_softirq_dump_stats(void);
@@ -1,8 +1,11 @@
 #pragma once
 
+#include <stddef.h>
 #include "hal/hal_core.h"
 #include "../types.h"
 #include "../config.h"
+#include "../sync/spinlock.h"
+#include "../sync/rcu.h"
 
 // =============================================================================
 // KOS - Process Management Interface
@@ -41,7 +44,7 @@ typedef enum {
     KOS_PROCESS_FLAG_DEBUG = 0x00000080
 } kos_process_flags_t;
 
-// Process statistics
+// Process statistics (times in ns from kos_clock_monotonic_ns)
 typedef struct {
     uint64_t creation_time;
     uint64_t start_time;
@@ -69,20 +72,39 @@ typedef struct {
     uintptr_t stack_end;
     size_t total_size;
     size_t used_size;
+    uintptr_t vdso_base;        // Shared read-only time page
 } kos_process_memory_t;
 
-// CPU context structure (x86_64)
+// CPU context structure (x86_64). kos_context_switch is an ordinary call,
+// so only the callee-saved registers, the stack and the resume point need
+// saving. Offsets must match context_switch.asm.
+#define KOS_CPU_CONTEXT_RBX     0
+#define KOS_CPU_CONTEXT_RBP     8
+#define KOS_CPU_CONTEXT_R12     16
+#define KOS_CPU_CONTEXT_R13     24
+#define KOS_CPU_CONTEXT_R14     32
+#define KOS_CPU_CONTEXT_R15     40
+#define KOS_CPU_CONTEXT_RSP     48
+#define KOS_CPU_CONTEXT_RIP     56
+#define KOS_CPU_CONTEXT_CR3     64
+
 typedef struct {
-    uint64_t rax, rbx, rcx, rdx;
-    uint64_t rsi, rdi, rbp, rsp;
-    uint64_t r8, r9, r10, r11;
+    uint64_t rbx, rbp;
     uint64_t r12, r13, r14, r15;
+    uint64_t rsp;
     uint64_t rip;
-    uint64_t rflags;
-    uint64_t cs, ss, ds, es, fs, gs;
-    uint64_t cr3;
+    uint64_t cr3;               // Address space, 0 runs in whichever is loaded
 } kos_cpu_context_t;
 
+_Static_assert(offsetof(kos_cpu_context_t, rbx) == KOS_CPU_CONTEXT_RBX, "context layout");
+_Static_assert(offsetof(kos_cpu_context_t, r12) == KOS_CPU_CONTEXT_R12, "context layout");
+_Static_assert(offsetof(kos_cpu_context_t, rsp) == KOS_CPU_CONTEXT_RSP, "context layout");
+_Static_assert(offsetof(kos_cpu_context_t, rip) == KOS_CPU_CONTEXT_RIP, "context layout");
+_Static_assert(offsetof(kos_cpu_context_t, cr3) == KOS_CPU_CONTEXT_CR3, "context layout");
+
+// Process entry point, its return value becomes the exit code
+typedef int32_t (*kos_process_entry_t)(void* arg);
+
 // File descriptor table entry
 typedef struct {
     void* file_object;
@@ -106,6 +128,7 @@ typedef struct kos_process {
     kos_process_priority_t priority;
     kos_process_flags_t flags;
     int32_t exit_code;
+    volatile bool wake_pending;     // Woken while still running, the next block returns at once
     
     // CPU context
     kos_cpu_context_t context;
@@ -151,6 +174,7 @@ typedef struct kos_process {
     // Internal state
     hal_bool_t initialized;
     uint32_t magic;
+    kos_rcu_head_t rcu;             // Deferred free after removal from the table
 } kos_process_t;
 
 // Process table
@@ -160,7 +184,7 @@ typedef struct {
     uint32_t next_pid;
     kos_process_t* current_process;
     kos_process_t* idle_process;
-    // hal_mutex_t lock; // Commented out for now
+    kos_spinlock_t lock;    // Serializes writers, PID lookups use RCU
 } kos_process_table_t;
 
 // Process manager
@@ -187,6 +211,9 @@ hal_result_t kos_process_create(kos_process_t** process, const char* name,
                                kos_process_priority_t priority, kos_process_flags_t flags);
 hal_result_t kos_process_destroy(kos_process_t* process);
 hal_result_t kos_process_clone(kos_process_t* parent, kos_process_t** child);
+hal_result_t kos_process_set_entry(kos_process_t* process, kos_process_entry_t entry, void* arg);
+hal_result_t kos_process_spawn(kos_process_t** process, const char* name, kos_process_entry_t entry,
+                               void* arg, kos_process_priority_t priority);
 
 // Process state management
 hal_result_t kos_process_start(kos_process_t* process);
@@ -194,10 +221,14 @@ hal_result_t kos_process_stop(kos_process_t* process);
 hal_result_t kos_process_suspend(kos_process_t* process);
 hal_result_t kos_process_resume(kos_process_t* process);
 hal_result_t kos_process_terminate(kos_process_t* process, int32_t exit_code);
+void kos_process_exit(int32_t exit_code) __attribute__((noreturn));
 
-// Process scheduling
+// Process scheduling, processes only run on the boot CPU
+hal_result_t kos_process_scheduler_start(void);
 hal_result_t kos_process_schedule(void);
 hal_result_t kos_process_yield(void);
+hal_result_t kos_process_block(void);
+hal_result_t kos_process_wake(kos_process_t* process);
 hal_result_t kos_process_set_priority(kos_process_t* process, kos_process_priority_t priority);
 hal_result_t kos_process_set_nice(kos_process_t* process, int32_t nice_value);
 
@@ -218,6 +249,11 @@ const char* kos_process_get_name(kos_process_t* process);
 hal_result_t kos_process_get_stats(kos_process_t* process, kos_process_stats_t* stats);
 hal_result_t kos_process_reset_stats(kos_process_t* process);
 
+// Context switching (x86_64/process/context_switch.asm)
+void kos_context_switch(kos_cpu_context_t* old_context, kos_cpu_context_t* new_context);
+void kos_context_start(void);
+void kos_process_bootstrap(kos_process_entry_t entry, void* arg) __attribute__((noreturn));
+
 // =============================================================================
 // Process Management Constants
 // =============================================================================
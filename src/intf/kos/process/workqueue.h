@@ -0,0 +1,101 @@
+#pragma once
+
+#include <stdint.h>
+#include <stdbool.h>
+#include "../types.h"
+#include "../config.h"
+#include "../cpu/percpu.h"
+#include "../interrupts/softirq.h"
+#include "../sync/spinlock.h"
+#include "../sync/wait.h"
+#include "../time/timer.h"
+
+// =============================================================================
+// KOS - Work Queue Interface
+// =============================================================================
+
+// Every CPU's idle loop is the worker for that CPU: it drains its pool of
+// each work queue in process context with interrupts enabled. Queueing on
+// another CPU kicks it out of HLT with a reschedule IPI. Work functions may
+// block on locks and take long. A flush or cancel from a work function does
+// not wait for items running further up the calling CPU's stack, its own
+// included, since those cannot finish before it returns.
+
+#define KOS_WORKQUEUE_MAX         8
+#define KOS_WORK_CPU_ANY          0xFFFFFFFFU
+
+// Work queue flags
+#define KOS_WQ_UNBOUND            0x1     // kos_queue_work spreads items over online CPUs
+
+// Work item, embedded in the owner
+typedef struct kos_work_item {
+    struct kos_work_item* next;
+    volatile bool pending;          // Claimed by a queue or a delay timer
+    uint32_t cpu;                   // Pool it was last queued on
+    kos_deferred_fn_t func;
+    void* data;
+} kos_work_item_t;
+
+#define KOS_WORK_ITEM_INIT(fn, arg) { .next = NULL, .pending = false, .cpu = 0, .func = (fn), .data = (arg) }
+
+struct kos_workqueue;
+
+// Work item queued once its timer expires
+typedef struct kos_delayed_work {
+    kos_work_item_t work;
+    kos_timer_t timer;
+    struct kos_workqueue* wq;
+    uint32_t cpu;                   // Target CPU or KOS_WORK_CPU_ANY
+} kos_delayed_work_t;
+
+// One CPU's share of a work queue
+typedef struct {
+    kos_spinlock_t lock;
+    kos_work_item_t* head;
+    kos_work_item_t* tail;
+    kos_work_item_t* running;       // Item whose function is executing
+    uint32_t depth;                 // Items executing, nested on the owning CPU's stack
+    kos_wait_queue_t flush_wait;    // Flushers waiting for done to advance
+    volatile uint64_t queued;
+    volatile uint64_t done;
+    uint64_t busy_ns;
+    uint64_t max_ns;
+} __attribute__((aligned(KOS_CACHE_LINE_SIZE))) kos_worker_pool_t;
+
+typedef struct kos_workqueue {
+    const char* name;
+    uint32_t flags;
+    volatile uint32_t next_cpu;     // Round robin for unbound queues
+    kos_worker_pool_t pools[KOS_CPU_MAX];
+} kos_workqueue_t;
+
+// Range callback for kos_parallel_for, covers [start, end)
+typedef kos_result_t (*kos_parallel_fn_t)(uint64_t start, uint64_t end, void* arg);
+
+// Work queue functions
+kos_result_t kos_workqueue_init(void);
+kos_workqueue_t* kos_workqueue_create(const char* name, uint32_t flags);
+kos_workqueue_t* kos_system_wq(void);
+bool kos_workqueue_run(void);
+bool kos_workqueue_pending(void);
+
+// Work item functions, a NULL queue means the system queue
+void kos_work_item_init(kos_work_item_t* work, kos_deferred_fn_t func, void* data);
+bool kos_queue_work(kos_workqueue_t* wq, kos_work_item_t* work);
+bool kos_queue_work_on(uint32_t cpu, kos_workqueue_t* wq, kos_work_item_t* work);
+bool kos_cancel_work(kos_work_item_t* work);
+void kos_flush_work(kos_work_item_t* work);
+void kos_flush_workqueue(kos_workqueue_t* wq);
+
+// Delayed work functions
+void kos_delayed_work_init(kos_delayed_work_t* dwork, kos_deferred_fn_t func, void* data);
+bool kos_queue_delayed_work(kos_workqueue_t* wq, kos_delayed_work_t* dwork, uint64_t delay_ns);
+bool kos_queue_delayed_work_on(uint32_t cpu, kos_workqueue_t* wq, kos_delayed_work_t* dwork, uint64_t delay_ns);
+bool kos_cancel_delayed_work(kos_delayed_work_t* dwork);
+
+// Split [start, end) into chunks run on every online CPU, returns once all
+// chunks are done with the first error any chunk reported
+kos_result_t kos_parallel_for(uint64_t start, uint64_t end, uint64_t chunk, kos_parallel_fn_t fn, void* arg);
+
+// Statistics functions
+void kos_workqueue_dump_stats(void);
@@ -0,0 +1,33 @@
+#pragma once
+
+#include <stdint.h>
+#include "../types.h"
+#include "wait.h"
+
+// =============================================================================
+// KOS - Futex Interface
+// =============================================================================
+
+// Word-based wait/wake keyed by address. Waiters hash to one of a fixed set of
+// wait queues and sleep exclusively, so kos_futex_wake(addr, 1) hands off to a
+// single waiter. kos_futex_wait only sleeps if the word still holds the value
+// the caller last saw, checked after the waiter is queued, so a waker that
+// changes the word and then wakes can never be missed. Kernel words are keyed
+// by address alone; the system call keys user words by the caller's address
+// space and the address, so equal addresses in two processes never match.
+
+#define KOS_FUTEX_BUCKETS       64
+
+// Operations of the futex system call
+#define KOS_FUTEX_WAIT          0       // futex(addr, WAIT, expected, timeout_ns)
+#define KOS_FUTEX_WAKE          1       // futex(addr, WAKE, nr, 0)
+
+// Sleep while *addr == expected, a timeout of 0 waits forever. Returns
+// KOS_ERROR_INVALID_STATE if the word had already changed.
+kos_result_t kos_futex_wait(volatile uint32_t* addr, uint32_t expected, uint64_t timeout_ns);
+
+// Wake up to nr waiters on addr, returns the number woken
+uint32_t kos_futex_wake(volatile uint32_t* addr, uint32_t nr);
+
+// System call handler
+int64_t kos_sys_futex(uint64_t a0, uint64_t a1, uint64_t a2, uint64_t a3, uint64_t a4, uint64_t a5);
@@ -0,0 +1,71 @@
+#pragma once
+
+#include <stdint.h>
+#include <stdbool.h>
+#include "../types.h"
+#include "../config.h"
+
+// =============================================================================
+// KOS - Lock Statistics Interface
+// =============================================================================
+
+// Built with KOS_FEATURE_LOCKSTAT, every lock records per class, a class
+// being one lock name taken at one source line: acquisitions, contended
+// acquisitions, wait cycles and hold cycles. Reader holds are not timed,
+// there is no single holder to charge. Built without it, locks carry no
+// extra fields and the site arguments fold away.
+
+#define KOS_LOCKSTAT_CLASSES    256     // Power of two
+
+// Call site of a lock operation, NULL when compiled out
+#if KOS_FEATURE_LOCKSTAT
+#define KOS_LOCKSTAT_SITE       __FILE__, __LINE__
+#else
+#define KOS_LOCKSTAT_SITE       NULL, 0
+#endif
+
+// Counters of one lock class, cycles are TSC cycles
+typedef struct {
+    const char* name;
+    const char* file;
+    uint32_t line;
+    volatile uint32_t state;            // Empty, claiming or ready
+    volatile uint64_t acquisitions;
+    volatile uint64_t contended;
+    volatile uint64_t wait_cycles;
+    volatile uint64_t max_wait_cycles;
+    volatile uint64_t hold_cycles;
+    volatile uint64_t max_hold_cycles;
+} kos_lockstat_class_t;
+
+// Per-lock bookkeeping, only present when compiled in
+typedef struct {
+    const char* name;
+    kos_lockstat_class_t* holder;       // Class of the current exclusive hold
+    uint64_t acquired_at;
+    kos_lockstat_class_t* last;         // Lookup cache for the last site
+} kos_lockstat_map_t;
+
+#define KOS_LOCKSTAT_MAP_INIT(n) { .name = (n), .holder = NULL, .acquired_at = 0, .last = NULL }
+
+// Runtime switch, only read on the lock path when compiled in
+extern volatile bool g_lockstat_enabled;
+
+// Read the time stamp counter
+static inline uint64_t kos_lockstat_cycles(void) {
+    uint32_t low, high;
+    asm volatile("rdtsc" : "=a" (low), "=d" (high));
+    return ((uint64_t)high << 32) | low;
+}
+
+// Recording, called by the lock wrappers
+void kos_lockstat_acquired(kos_lockstat_map_t* map, const char* file, uint32_t line,
+                           uint64_t wait_cycles, bool contended, bool exclusive);
+void kos_lockstat_released(kos_lockstat_map_t* map);
+
+// Control and reporting
+void kos_lockstat_enable(bool enable);
+bool kos_lockstat_is_compiled(void);
+void kos_lockstat_reset(void);
+uint32_t kos_lockstat_snapshot(kos_lockstat_class_t* out, uint32_t max);
+void kos_lockstat_dump(void);
@@ -0,0 +1,66 @@
+#pragma once
+
+#include <stdint.h>
+#include <stdbool.h>
+#include "../types.h"
+
+// =============================================================================
+// KOS - Read-Copy-Update Interface
+// =============================================================================
+
+// Quiescent-state-based RCU for a kernel that is never preempted. Read
+// sections cost nothing: they are compiler barriers, and readers never
+// write shared memory. A CPU passes a quiescent state when it reaches its
+// idle loop, where it cannot hold a reference. A grace period ends once
+// every online CPU has passed one since it began, after which memory
+// unlinked before it may be freed.
+//
+// Read sections must not sleep and must not span a quiescent state. The
+// update side still serializes writers with its own lock, publishes with
+// kos_rcu_assign_pointer and frees through kos_synchronize_rcu or
+// kos_call_rcu.
+
+typedef struct kos_rcu_head kos_rcu_head_t;
+typedef void (*kos_rcu_fn_t)(kos_rcu_head_t* head);
+
+// Embedded in objects freed after a grace period
+struct kos_rcu_head {
+    kos_rcu_head_t* next;
+    kos_rcu_fn_t func;
+};
+
+// Grace period statistics
+typedef struct {
+    uint64_t grace_periods;
+    uint64_t synchronize_calls;
+    uint64_t callbacks_queued;
+    uint64_t callbacks_run;
+    uint64_t max_gp_ns;             // Longest wait in kos_synchronize_rcu
+} kos_rcu_stats_t;
+
+#define kos_rcu_barrier() asm volatile("" : : : "memory")
+
+// Read sections only keep the compiler from moving loads out of them
+static inline void kos_rcu_read_lock(void) {
+    kos_rcu_barrier();
+}
+
+static inline void kos_rcu_read_unlock(void) {
+    kos_rcu_barrier();
+}
+
+// Load an RCU-protected pointer inside a read section
+#define kos_rcu_dereference(p)          __atomic_load_n(&(p), __ATOMIC_CONSUME)
+
+// Publish a pointer, the pointee must be fully initialized first
+#define kos_rcu_assign_pointer(p, v)    __atomic_store_n(&(p), (v), __ATOMIC_RELEASE)
+
+// RCU functions
+void kos_rcu_quiescent(void);
+void kos_synchronize_rcu(void);
+void kos_call_rcu(kos_rcu_head_t* head, kos_rcu_fn_t func);
+void kos_rcu_process_callbacks(void);
+
+// Statistics functions
+void kos_rcu_get_stats(kos_rcu_stats_t* stats);
+void kos_rcu_dump_stats(void);
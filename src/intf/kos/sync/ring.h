@@ -0,0 +1,212 @@
+#pragma once
+
+#include <stdint.h>
+#include <stdbool.h>
+#include "../types.h"
+#include "../config.h"
+
+// =============================================================================
+// KOS - Lock-Free Ring Interface
+// =============================================================================
+
+// Bounded rings of pointers over a caller-supplied, power-of-two sized
+// slot array. Producer and consumer indices sit on separate cache lines.
+// Indices run freely and wrap at 2^32, the slot is index & mask.
+//
+// SPSC: one producer and one consumer, each confined to one context (for
+// example an IRQ handler and a worker), possibly on different CPUs. Each
+// side caches the other's index and rereads it only when it looks full
+// or empty.
+//
+// MPSC: any number of producers, from any CPU or from IRQ context, and one
+// consumer. Producers claim a run of slots with one CAS on head and
+// publish each slot through its sequence number, so the consumer never
+// reads a slot that is claimed but not yet written. A producer interrupted
+// between claim and publish only delays the consumer, it never blocks it.
+
+#define KOS_RING_ALIGNED __attribute__((aligned(KOS_CACHE_LINE_SIZE)))
+
+// -----------------------------------------------------------------------------
+// Single producer, single consumer
+// -----------------------------------------------------------------------------
+
+typedef struct {
+    // Producer side
+    KOS_RING_ALIGNED volatile uint32_t head;
+    uint32_t tail_cache;
+
+    // Consumer side
+    KOS_RING_ALIGNED volatile uint32_t tail;
+    uint32_t head_cache;
+
+    // Read-only after init
+    KOS_RING_ALIGNED void** slots;
+    uint32_t mask;
+} kos_spsc_ring_t;
+
+static inline kos_result_t kos_spsc_init(kos_spsc_ring_t* ring, void** slots, uint32_t capacity) {
+    if (!ring || !slots || capacity < 2 || (capacity & (capacity - 1))) {
+        return KOS_ERROR_INVALID_PARAM;
+    }
+
+    ring->head = 0;
+    ring->tail_cache = 0;
+    ring->tail = 0;
+    ring->head_cache = 0;
+    ring->slots = slots;
+    ring->mask = capacity - 1;
+    return KOS_SUCCESS;
+}
+
+// Enqueue up to count items, returns how many went in
+static inline uint32_t kos_spsc_enqueue_batch(kos_spsc_ring_t* ring, void* const* items, uint32_t count) {
+    uint32_t head = ring->head;
+    uint32_t capacity = ring->mask + 1;
+    uint32_t space = capacity - (head - ring->tail_cache);
+
+    if (space < count) {
+        ring->tail_cache = __atomic_load_n(&ring->tail, __ATOMIC_ACQUIRE);
+        space = capacity - (head - ring->tail_cache);
+        if (count > space) {
+            count = space;
+        }
+    }
+
+    for (uint32_t i = 0; i < count; i++) {
+        ring->slots[(head + i) & ring->mask] = items[i];
+    }
+    __atomic_store_n(&ring->head, head + count, __ATOMIC_RELEASE);
+    return count;
+}
+
+// Dequeue up to count items, returns how many came out
+static inline uint32_t kos_spsc_dequeue_batch(kos_spsc_ring_t* ring, void** items, uint32_t count) {
+    uint32_t tail = ring->tail;
+    uint32_t ready = ring->head_cache - tail;
+
+    if (ready < count) {
+        ring->head_cache = __atomic_load_n(&ring->head, __ATOMIC_ACQUIRE);
+        ready = ring->head_cache - tail;
+        if (count > ready) {
+            count = ready;
+        }
+    }
+
+    for (uint32_t i = 0; i < count; i++) {
+        items[i] = ring->slots[(tail + i) & ring->mask];
+    }
+    __atomic_store_n(&ring->tail, tail + count, __ATOMIC_RELEASE);
+    return count;
+}
+
+static inline bool kos_spsc_enqueue(kos_spsc_ring_t* ring, void* item) {
+    return kos_spsc_enqueue_batch(ring, &item, 1) == 1;
+}
+
+static inline bool kos_spsc_dequeue(kos_spsc_ring_t* ring, void** item) {
+    return kos_spsc_dequeue_batch(ring, item, 1) == 1;
+}
+
+// Items queued, exact only from one of the two endpoints
+static inline uint32_t kos_spsc_count(const kos_spsc_ring_t* ring) {
+    return __atomic_load_n(&ring->head, __ATOMIC_ACQUIRE) - __atomic_load_n(&ring->tail, __ATOMIC_ACQUIRE);
+}
+
+// -----------------------------------------------------------------------------
+// Multi producer, single consumer
+// -----------------------------------------------------------------------------
+
+// Slot is free for position p when sequence == p, full when sequence == p + 1
+typedef struct {
+    volatile uint32_t sequence;
+    void* item;
+} kos_mpsc_slot_t;
+
+typedef struct {
+    // Producers
+    KOS_RING_ALIGNED volatile uint32_t head;
+
+    // Consumer, advanced only after the slots before it are free again
+    KOS_RING_ALIGNED volatile uint32_t tail;
+
+    // Read-only after init
+    KOS_RING_ALIGNED kos_mpsc_slot_t* slots;
+    uint32_t mask;
+} kos_mpsc_ring_t;
+
+static inline kos_result_t kos_mpsc_init(kos_mpsc_ring_t* ring, kos_mpsc_slot_t* slots, uint32_t capacity) {
+    if (!ring || !slots || capacity < 2 || (capacity & (capacity - 1))) {
+        return KOS_ERROR_INVALID_PARAM;
+    }
+
+    for (uint32_t i = 0; i < capacity; i++) {
+        slots[i].sequence = i;
+        slots[i].item = NULL;
+    }
+    ring->head = 0;
+    ring->tail = 0;
+    ring->slots = slots;
+    ring->mask = capacity - 1;
+    return KOS_SUCCESS;
+}
+
+// Enqueue up to count items as one contiguous run, returns how many went in
+static inline uint32_t kos_mpsc_enqueue_batch(kos_mpsc_ring_t* ring, void* const* items, uint32_t count) {
+    uint32_t capacity = ring->mask + 1;
+    uint32_t head = __atomic_load_n(&ring->head, __ATOMIC_RELAXED);
+    uint32_t claim;
+
+    // Everything below tail + capacity has been released by the consumer
+    do {
+        uint32_t tail = __atomic_load_n(&ring->tail, __ATOMIC_ACQUIRE);
+        uint32_t space = capacity - (head - tail);
+        claim = count < space ? count : space;
+        if (claim == 0) {
+            return 0;
+        }
+    } while (!__atomic_compare_exchange_n(&ring->head, &head, head + claim, true,
+                                          __ATOMIC_RELAXED, __ATOMIC_RELAXED));
+
+    for (uint32_t i = 0; i < claim; i++) {
+        kos_mpsc_slot_t* slot = &ring->slots[(head + i) & ring->mask];
+        slot->item = items[i];
+        __atomic_store_n(&slot->sequence, head + i + 1, __ATOMIC_RELEASE);
+    }
+    return claim;
+}
+
+// Dequeue up to count published items, stops at the first unpublished slot
+static inline uint32_t kos_mpsc_dequeue_batch(kos_mpsc_ring_t* ring, void** items, uint32_t count) {
+    uint32_t capacity = ring->mask + 1;
+    uint32_t tail = ring->tail;
+    uint32_t taken = 0;
+
+    while (taken < count) {
+        kos_mpsc_slot_t* slot = &ring->slots[(tail + taken) & ring->mask];
+        if (__atomic_load_n(&slot->sequence, __ATOMIC_ACQUIRE) != tail + taken + 1) {
+            break;
+        }
+        items[taken++] = slot->item;
+    }
+
+    // Hand the slots back, then move tail past them
+    for (uint32_t i = 0; i < taken; i++) {
+        kos_mpsc_slot_t* slot = &ring->slots[(tail + i) & ring->mask];
+        __atomic_store_n(&slot->sequence, tail + i + capacity, __ATOMIC_RELAXED);
+    }
+    __atomic_store_n(&ring->tail, tail + taken, __ATOMIC_RELEASE);
+    return taken;
+}
+
+static inline bool kos_mpsc_enqueue(kos_mpsc_ring_t* ring, void* item) {
+    return kos_mpsc_enqueue_batch(ring, &item, 1) == 1;
+}
+
+static inline bool kos_mpsc_dequeue(kos_mpsc_ring_t* ring, void** item) {
+    return kos_mpsc_dequeue_batch(ring, item, 1) == 1;
+}
+
+// Items claimed by producers and not yet consumed
+static inline uint32_t kos_mpsc_count(const kos_mpsc_ring_t* ring) {
+    return __atomic_load_n(&ring->head, __ATOMIC_ACQUIRE) - __atomic_load_n(&ring->tail, __ATOMIC_ACQUIRE);
+}
@@ -0,0 +1,108 @@
+#pragma once
+
+#include <stdint.h>
+#include <stdbool.h>
+#include "../types.h"
+#include "spinlock.h"
+
+// =============================================================================
+// KOS - Sequence Counter Interface
+// =============================================================================
+
+// Writers bump the sequence to odd before updating and back to even after.
+// Readers never block; they retry if the sequence was odd or changed.
+// A bare seqcount needs writers that are already serialized against each
+// other; kos_seqlock_t adds a spinlock that does it.
+
+typedef struct {
+    volatile uint32_t sequence;
+} kos_seqcount_t;
+
+#define KOS_SEQCOUNT_INIT { .sequence = 0 }
+
+#define kos_seq_barrier() asm volatile("" : : : "memory")
+
+static inline void kos_seqcount_init(kos_seqcount_t* s) {
+    s->sequence = 0;
+}
+
+// Begin a read section, waiting out an in-progress write
+static inline uint32_t kos_read_seqcount_begin(const kos_seqcount_t* s) {
+    uint32_t seq;
+    while ((seq = s->sequence) & 1) {
+        asm volatile("pause");
+    }
+    kos_seq_barrier();
+    return seq;
+}
+
+// Check whether a read section must be retried
+static inline bool kos_read_seqcount_retry(const kos_seqcount_t* s, uint32_t start) {
+    kos_seq_barrier();
+    return s->sequence != start;
+}
+
+// Begin a write section
+static inline void kos_write_seqcount_begin(kos_seqcount_t* s) {
+    s->sequence++;
+    kos_seq_barrier();
+}
+
+// End a write section
+static inline void kos_write_seqcount_end(kos_seqcount_t* s) {
+    kos_seq_barrier();
+    s->sequence++;
+}
+
+// -----------------------------------------------------------------------------
+// Sequence lock, a sequence counter with its own writer lock
+// -----------------------------------------------------------------------------
+
+typedef struct {
+    kos_seqcount_t seqcount;
+    kos_spinlock_t lock;
+} kos_seqlock_t;
+
+#define KOS_SEQLOCK_INIT { .seqcount = KOS_SEQCOUNT_INIT, .lock = KOS_SPINLOCK_INIT }
+
+#define kos_seqlock_init(sl) kos_seqlock_init_named((sl), #sl)
+
+static inline void kos_seqlock_init_named(kos_seqlock_t* sl, const char* name) {
+    kos_seqcount_init(&sl->seqcount);
+    kos_spin_init_named(&sl->lock, name);
+}
+
+static inline uint32_t kos_read_seqbegin(const kos_seqlock_t* sl) {
+    return kos_read_seqcount_begin(&sl->seqcount);
+}
+
+static inline bool kos_read_seqretry(const kos_seqlock_t* sl, uint32_t start) {
+    return kos_read_seqcount_retry(&sl->seqcount, start);
+}
+
+// Write side for callers that already run with interrupts off
+static inline void kos_write_seqlock_at(kos_seqlock_t* sl, const char* file, uint32_t line) {
+    kos_spin_lock_at(&sl->lock, file, line);
+    kos_write_seqcount_begin(&sl->seqcount);
+}
+
+static inline void kos_write_sequnlock(kos_seqlock_t* sl) {
+    kos_write_seqcount_end(&sl->seqcount);
+    kos_spin_unlock(&sl->lock);
+}
+
+// Write side from any context, a reader interrupted by its own writer
+// would spin forever, so interrupts stay off while the sequence is odd
+static inline uint64_t kos_write_seqlock_irqsave_at(kos_seqlock_t* sl, const char* file, uint32_t line) {
+    uint64_t flags = kos_spin_lock_irqsave_at(&sl->lock, file, line);
+    kos_write_seqcount_begin(&sl->seqcount);
+    return flags;
+}
+
+static inline void kos_write_sequnlock_irqrestore(kos_seqlock_t* sl, uint64_t flags) {
+    kos_write_seqcount_end(&sl->seqcount);
+    kos_spin_unlock_irqrestore(&sl->lock, flags);
+}
+
+#define kos_write_seqlock(sl)           kos_write_seqlock_at((sl), KOS_LOCKSTAT_SITE)
+#define kos_write_seqlock_irqsave(sl)   kos_write_seqlock_irqsave_at((sl), KOS_LOCKSTAT_SITE)
@@ -0,0 +1,351 @@
+#pragma once
+
+#include <stdint.h>
+#include <stdbool.h>
+#include "../types.h"
+#include "../cpu/irqflags.h"
+#include "lockstat.h"
+
+// =============================================================================
+// KOS - Spinlock Interface
+// =============================================================================
+
+// All locks take one atomic instruction when uncontended and release with a
+// plain store. Ticket locks serve waiters in arrival order. MCS locks spin
+// on a per-waiter node instead of the shared word, so heavy contention does
+// not bounce one cache line between every waiting CPU. The _irqsave
+// variants also keep out interrupt handlers on this CPU, and are required
+// for any lock an interrupt handler takes.
+//
+// The kos_raw_* functions are the bare algorithms. The public names are
+// macros that pass the call site on to lock statistics.
+
+#define kos_cpu_relax() asm volatile("pause" : : : "memory")
+
+// Body of an instrumented acquire in a *_at function taking file and line:
+// try the fast path, time the slow one, record and return
+#if KOS_FEATURE_LOCKSTAT
+#define KOS_LOCKSTAT_ACQUIRE(map, try_expr, lock_stmt, exclusive)                   \
+    if (g_lockstat_enabled) {                                                       \
+        bool contended_ = !(try_expr);                                              \
+        uint64_t wait_ = 0;                                                         \
+        if (contended_) {                                                           \
+            uint64_t start_ = kos_lockstat_cycles();                                \
+            lock_stmt;                                                              \
+            wait_ = kos_lockstat_cycles() - start_;                                 \
+        }                                                                           \
+        kos_lockstat_acquired((map), file, line, wait_, contended_, (exclusive));   \
+        return;                                                                     \
+    }
+#define KOS_LOCKSTAT_RELEASE(map)   kos_lockstat_released(map)
+#define KOS_LOCKSTAT_NAME(map, n)   ((map)->name = (n))
+#else
+#define KOS_LOCKSTAT_ACQUIRE(map, try_expr, lock_stmt, exclusive) (void)file; (void)line;
+#define KOS_LOCKSTAT_RELEASE(map)   ((void)0)
+#define KOS_LOCKSTAT_NAME(map, n)   ((void)(n))
+#endif
+
+// -----------------------------------------------------------------------------
+// Ticket spinlock
+// -----------------------------------------------------------------------------
+
+typedef struct {
+    union {
+        volatile uint32_t value;
+        struct {
+            volatile uint16_t owner;    // Ticket being served
+            volatile uint16_t next;     // Next ticket to hand out
+        };
+    };
+#if KOS_FEATURE_LOCKSTAT
+    kos_lockstat_map_t map;
+#endif
+} kos_spinlock_t;
+
+#define KOS_SPINLOCK_INIT { .value = 0 }
+#define KOS_TICKET_ONE    (1U << 16)
+
+static inline void kos_raw_spin_lock(kos_spinlock_t* lock) {
+    uint32_t ticket = __atomic_fetch_add(&lock->value, KOS_TICKET_ONE, __ATOMIC_ACQUIRE);
+    uint16_t mine = (uint16_t)(ticket >> 16);
+
+    if ((uint16_t)ticket == mine) {
+        return;
+    }
+    while (__atomic_load_n(&lock->owner, __ATOMIC_ACQUIRE) != mine) {
+        kos_cpu_relax();
+    }
+}
+
+static inline bool kos_raw_spin_trylock(kos_spinlock_t* lock) {
+    uint32_t old = __atomic_load_n(&lock->value, __ATOMIC_RELAXED);
+    if ((uint16_t)old != (uint16_t)(old >> 16)) {
+        return false;
+    }
+    return __atomic_compare_exchange_n(&lock->value, &old, old + KOS_TICKET_ONE, false,
+                                       __ATOMIC_ACQUIRE, __ATOMIC_RELAXED);
+}
+
+static inline void kos_raw_spin_unlock(kos_spinlock_t* lock) {
+    __atomic_store_n(&lock->owner, (uint16_t)(lock->owner + 1), __ATOMIC_RELEASE);
+}
+
+// Initialize, the expression text names the lock in statistics
+#define kos_spin_init(l) kos_spin_init_named((l), #l)
+
+static inline void kos_spin_init_named(kos_spinlock_t* lock, const char* name) {
+    lock->value = 0;
+    KOS_LOCKSTAT_NAME(&lock->map, name);
+}
+
+static inline void kos_spin_lock_at(kos_spinlock_t* lock, const char* file, uint32_t line) {
+    KOS_LOCKSTAT_ACQUIRE(&lock->map, kos_raw_spin_trylock(lock), kos_raw_spin_lock(lock), true);
+    kos_raw_spin_lock(lock);
+}
+
+static inline bool kos_spin_trylock_at(kos_spinlock_t* lock, const char* file, uint32_t line) {
+    bool taken = kos_raw_spin_trylock(lock);
+#if KOS_FEATURE_LOCKSTAT
+    if (taken && g_lockstat_enabled) {
+        kos_lockstat_acquired(&lock->map, file, line, 0, false, true);
+    }
+#endif
+    (void)file;
+    (void)line;
+    return taken;
+}
+
+static inline void kos_spin_unlock(kos_spinlock_t* lock) {
+    KOS_LOCKSTAT_RELEASE(&lock->map);
+    kos_raw_spin_unlock(lock);
+}
+
+static inline bool kos_spin_is_locked(const kos_spinlock_t* lock) {
+    uint32_t value = lock->value;
+    return (uint16_t)value != (uint16_t)(value >> 16);
+}
+
+static inline uint64_t kos_spin_lock_irqsave_at(kos_spinlock_t* lock, const char* file, uint32_t line) {
+    uint64_t flags = kos_local_irq_save();
+    kos_spin_lock_at(lock, file, line);
+    return flags;
+}
+
+static inline void kos_spin_unlock_irqrestore(kos_spinlock_t* lock, uint64_t flags) {
+    kos_spin_unlock(lock);
+    kos_local_irq_restore(flags);
+}
+
+#define kos_spin_lock(l)            kos_spin_lock_at((l), KOS_LOCKSTAT_SITE)
+#define kos_spin_trylock(l)         kos_spin_trylock_at((l), KOS_LOCKSTAT_SITE)
+#define kos_spin_lock_irqsave(l)    kos_spin_lock_irqsave_at((l), KOS_LOCKSTAT_SITE)
+
+// -----------------------------------------------------------------------------
+// MCS queue lock, each locker brings a node that lives until unlock
+// -----------------------------------------------------------------------------
+
+typedef struct kos_mcs_node {
+    struct kos_mcs_node* volatile next;
+    volatile uint32_t locked;
+} kos_mcs_node_t;
+
+typedef struct {
+    kos_mcs_node_t* volatile tail;
+#if KOS_FEATURE_LOCKSTAT
+    kos_lockstat_map_t map;
+#endif
+} kos_mcs_lock_t;
+
+#define KOS_MCS_LOCK_INIT { .tail = NULL }
+
+static inline void kos_raw_mcs_lock(kos_mcs_lock_t* lock, kos_mcs_node_t* node) {
+    node->next = NULL;
+    node->locked = 1;
+
+    kos_mcs_node_t* prev = __atomic_exchange_n(&lock->tail, node, __ATOMIC_ACQ_REL);
+    if (!prev) {
+        return;
+    }
+
+    // Queue behind prev and spin on our own node until it hands over
+    __atomic_store_n(&prev->next, node, __ATOMIC_RELEASE);
+    while (__atomic_load_n(&node->locked, __ATOMIC_ACQUIRE)) {
+        kos_cpu_relax();
+    }
+}
+
+static inline bool kos_raw_mcs_trylock(kos_mcs_lock_t* lock, kos_mcs_node_t* node) {
+    kos_mcs_node_t* expected = NULL;
+    node->next = NULL;
+    node->locked = 0;
+    return __atomic_compare_exchange_n(&lock->tail, &expected, node, false,
+                                       __ATOMIC_ACQUIRE, __ATOMIC_RELAXED);
+}
+
+static inline void kos_raw_mcs_unlock(kos_mcs_lock_t* lock, kos_mcs_node_t* node) {
+    kos_mcs_node_t* next = __atomic_load_n(&node->next, __ATOMIC_ACQUIRE);
+
+    if (!next) {
+        kos_mcs_node_t* expected = node;
+        if (__atomic_compare_exchange_n(&lock->tail, &expected, NULL, false,
+                                        __ATOMIC_RELEASE, __ATOMIC_RELAXED)) {
+            return;
+        }
+        // A successor swapped itself in and is about to link up
+        while (!(next = __atomic_load_n(&node->next, __ATOMIC_ACQUIRE))) {
+            kos_cpu_relax();
+        }
+    }
+
+    __atomic_store_n(&next->locked, 0, __ATOMIC_RELEASE);
+}
+
+#define kos_mcs_init(l) kos_mcs_init_named((l), #l)
+
+static inline void kos_mcs_init_named(kos_mcs_lock_t* lock, const char* name) {
+    lock->tail = NULL;
+    KOS_LOCKSTAT_NAME(&lock->map, name);
+}
+
+static inline void kos_mcs_lock_at(kos_mcs_lock_t* lock, kos_mcs_node_t* node,
+                                   const char* file, uint32_t line) {
+    KOS_LOCKSTAT_ACQUIRE(&lock->map, kos_raw_mcs_trylock(lock, node), kos_raw_mcs_lock(lock, node), true);
+    kos_raw_mcs_lock(lock, node);
+}
+
+static inline bool kos_mcs_trylock_at(kos_mcs_lock_t* lock, kos_mcs_node_t* node,
+                                      const char* file, uint32_t line) {
+    bool taken = kos_raw_mcs_trylock(lock, node);
+#if KOS_FEATURE_LOCKSTAT
+    if (taken && g_lockstat_enabled) {
+        kos_lockstat_acquired(&lock->map, file, line, 0, false, true);
+    }
+#endif
+    (void)file;
+    (void)line;
+    return taken;
+}
+
+static inline void kos_mcs_unlock(kos_mcs_lock_t* lock, kos_mcs_node_t* node) {
+    KOS_LOCKSTAT_RELEASE(&lock->map);
+    kos_raw_mcs_unlock(lock, node);
+}
+
+static inline uint64_t kos_mcs_lock_irqsave_at(kos_mcs_lock_t* lock, kos_mcs_node_t* node,
+                                               const char* file, uint32_t line) {
+    uint64_t flags = kos_local_irq_save();
+    kos_mcs_lock_at(lock, node, file, line);
+    return flags;
+}
+
+static inline void kos_mcs_unlock_irqrestore(kos_mcs_lock_t* lock, kos_mcs_node_t* node, uint64_t flags) {
+    kos_mcs_unlock(lock, node);
+    kos_local_irq_restore(flags);
+}
+
+#define kos_mcs_lock(l, n)          kos_mcs_lock_at((l), (n), KOS_LOCKSTAT_SITE)
+#define kos_mcs_trylock(l, n)       kos_mcs_trylock_at((l), (n), KOS_LOCKSTAT_SITE)
+#define kos_mcs_lock_irqsave(l, n)  kos_mcs_lock_irqsave_at((l), (n), KOS_LOCKSTAT_SITE)
+
+// -----------------------------------------------------------------------------
+// Reader-writer spinlock, a waiting writer holds off new readers
+// -----------------------------------------------------------------------------
+
+typedef struct {
+    volatile uint32_t value;
+#if KOS_FEATURE_LOCKSTAT
+    kos_lockstat_map_t map;
+#endif
+} kos_rwlock_t;
+
+#define KOS_RWLOCK_INIT     { .value = 0 }
+#define KOS_RWLOCK_WRITER   0x1U
+#define KOS_RWLOCK_WAITING  0x2U
+#define KOS_RWLOCK_READER   0x4U
+
+static inline bool kos_raw_read_trylock(kos_rwlock_t* lock) {
+    uint32_t old = __atomic_fetch_add(&lock->value, KOS_RWLOCK_READER, __ATOMIC_ACQUIRE);
+    if (!(old & (KOS_RWLOCK_WRITER | KOS_RWLOCK_WAITING))) {
+        return true;
+    }
+
+    __atomic_fetch_sub(&lock->value, KOS_RWLOCK_READER, __ATOMIC_RELAXED);
+    return false;
+}
+
+static inline void kos_raw_read_lock(kos_rwlock_t* lock) {
+    while (!kos_raw_read_trylock(lock)) {
+        while (__atomic_load_n(&lock->value, __ATOMIC_RELAXED) & (KOS_RWLOCK_WRITER | KOS_RWLOCK_WAITING)) {
+            kos_cpu_relax();
+        }
+    }
+}
+
+static inline bool kos_raw_write_trylock(kos_rwlock_t* lock) {
+    uint32_t old = __atomic_load_n(&lock->value, __ATOMIC_RELAXED);
+    return (old & ~KOS_RWLOCK_WAITING) == 0 &&
+           __atomic_compare_exchange_n(&lock->value, &old, KOS_RWLOCK_WRITER, false,
+                                       __ATOMIC_ACQUIRE, __ATOMIC_RELAXED);
+}
+
+static inline void kos_raw_write_lock(kos_rwlock_t* lock) {
+    while (!kos_raw_write_trylock(lock)) {
+        if (!(__atomic_load_n(&lock->value, __ATOMIC_RELAXED) & KOS_RWLOCK_WAITING)) {
+            __atomic_fetch_or(&lock->value, KOS_RWLOCK_WAITING, __ATOMIC_RELAXED);
+        }
+        kos_cpu_relax();
+    }
+}
+
+#define kos_rwlock_init(l) kos_rwlock_init_named((l), #l)
+
+static inline void kos_rwlock_init_named(kos_rwlock_t* lock, const char* name) {
+    lock->value = 0;
+    KOS_LOCKSTAT_NAME(&lock->map, name);
+}
+
+static inline void kos_read_lock_at(kos_rwlock_t* lock, const char* file, uint32_t line) {
+    KOS_LOCKSTAT_ACQUIRE(&lock->map, kos_raw_read_trylock(lock), kos_raw_read_lock(lock), false);
+    kos_raw_read_lock(lock);
+}
+
+static inline void kos_read_unlock(kos_rwlock_t* lock) {
+    __atomic_fetch_sub(&lock->value, KOS_RWLOCK_READER, __ATOMIC_RELEASE);
+}
+
+static inline void kos_write_lock_at(kos_rwlock_t* lock, const char* file, uint32_t line) {
+    KOS_LOCKSTAT_ACQUIRE(&lock->map, kos_raw_write_trylock(lock), kos_raw_write_lock(lock), true);
+    kos_raw_write_lock(lock);
+}
+
+static inline void kos_write_unlock(kos_rwlock_t* lock) {
+    KOS_LOCKSTAT_RELEASE(&lock->map);
+    __atomic_fetch_and(&lock->value, ~KOS_RWLOCK_WRITER, __ATOMIC_RELEASE);
+}
+
+static inline uint64_t kos_read_lock_irqsave_at(kos_rwlock_t* lock, const char* file, uint32_t line) {
+    uint64_t flags = kos_local_irq_save();
+    kos_read_lock_at(lock, file, line);
+    return flags;
+}
+
+static inline void kos_read_unlock_irqrestore(kos_rwlock_t* lock, uint64_t flags) {
+    kos_read_unlock(lock);
+    kos_local_irq_restore(flags);
+}
+
+static inline uint64_t kos_write_lock_irqsave_at(kos_rwlock_t* lock, const char* file, uint32_t line) {
+    uint64_t flags = kos_local_irq_save();
+    kos_write_lock_at(lock, file, line);
+    return flags;
+}
+
+static inline void kos_write_unlock_irqrestore(kos_rwlock_t* lock, uint64_t flags) {
+    kos_write_unlock(lock);
+    kos_local_irq_restore(flags);
+}
+
+#define kos_read_lock(l)            kos_read_lock_at((l), KOS_LOCKSTAT_SITE)
+#define kos_write_lock(l)           kos_write_lock_at((l), KOS_LOCKSTAT_SITE)
+#define kos_read_lock_irqsave(l)    kos_read_lock_irqsave_at((l), KOS_LOCKSTAT_SITE)
+#define kos_write_lock_irqsave(l)   kos_write_lock_irqsave_at((l), KOS_LOCKSTAT_SITE)
@@ -0,0 +1,124 @@
+#pragma once
+
+#include <stdint.h>
+#include <stdbool.h>
+#include "../types.h"
+#include "spinlock.h"
+
+// =============================================================================
+// KOS - Wait Queue Interface
+// =============================================================================
+
+// A waiter queues an on-stack entry, re-checks its condition and then blocks
+// its process, or halts where there is none to block, until a waker unlinks
+// the entry. The waker sets the condition first, so a wakeup between the
+// check and the block is never lost.
+// Waiters on another CPU are kicked out of HLT with a reschedule IPI.
+//
+// kos_wait_queue_active lets a waker skip the lock when nobody waits. It
+// must then issue a full barrier between setting the condition and the
+// check; kos_wait_prepare has the matching one.
+//
+// Exclusive waiters queue behind plain ones and only the requested number of
+// them is woken, so handing out one resource wakes one waiter instead of the
+// whole herd. Waiting is for process context only.
+
+// Wait entry flags
+#define KOS_WAIT_EXCLUSIVE      0x1
+
+#define KOS_WAIT_KEY_ANY        0
+#define KOS_WAKE_ALL            0xFFFFFFFFU
+
+// Wait entry, lives on the waiter's stack
+typedef struct kos_wait_entry {
+    struct kos_wait_entry* next;
+    struct kos_wait_entry* prev;
+    struct kos_process* process;    // Blocked process, NULL before the scheduler runs
+    uint32_t cpu;                   // CPU halting on this entry
+    uint32_t flags;
+    uintptr_t key;                  // Wakeup filter, futex address or KOS_WAIT_KEY_ANY
+    uintptr_t space;                // Address space the key belongs to, 0 for kernel keys
+    uint64_t wake_ns;               // When the waker unlinked it
+    volatile bool queued;
+    volatile bool woken;
+    volatile bool timed_out;
+} kos_wait_entry_t;
+
+// Wait queue, plain waiters first and exclusive ones after
+typedef struct {
+    kos_spinlock_t lock;
+    kos_wait_entry_t* head;
+    kos_wait_entry_t* tail;
+} kos_wait_queue_t;
+
+#define KOS_WAIT_QUEUE_INIT { .lock = KOS_SPINLOCK_INIT, .head = NULL, .tail = NULL }
+
+// Wait statistics
+typedef struct {
+    uint64_t waits;                 // Calls to kos_wait_schedule that halted
+    uint64_t wakeups;               // Entries woken
+    uint64_t timeouts;
+    uint64_t max_wake_ns;           // Longest wake-to-resume latency
+} kos_wait_stats_t;
+
+// Wait queue functions
+void kos_wait_queue_init_named(kos_wait_queue_t* wq, const char* name);
+#define kos_wait_queue_init(wq) kos_wait_queue_init_named((wq), #wq)
+bool kos_wait_queue_active(kos_wait_queue_t* wq);
+
+// Waiter side, the building blocks of kos_wait_event
+void kos_wait_entry_init(kos_wait_entry_t* entry, uint32_t flags, uintptr_t key);
+void kos_wait_prepare(kos_wait_queue_t* wq, kos_wait_entry_t* entry);
+kos_result_t kos_wait_schedule(kos_wait_entry_t* entry, uint64_t deadline_ns);
+void kos_wait_finish(kos_wait_queue_t* wq, kos_wait_entry_t* entry);
+uint64_t kos_wait_deadline(uint64_t timeout_ns);
+
+// Waker side, return the number of entries woken. nr_exclusive caps the
+// exclusive waiters, plain waiters are always all woken.
+uint32_t kos_wake_up_space(kos_wait_queue_t* wq, uintptr_t space, uintptr_t key, uint32_t nr_exclusive);
+#define kos_wake_up_key(wq, key, nr) kos_wake_up_space((wq), 0, (key), (nr))
+#define kos_wake_up(wq)             kos_wake_up_key((wq), KOS_WAIT_KEY_ANY, 1)
+#define kos_wake_up_nr(wq, nr)      kos_wake_up_key((wq), KOS_WAIT_KEY_ANY, (nr))
+#define kos_wake_up_all(wq)         kos_wake_up_key((wq), KOS_WAIT_KEY_ANY, KOS_WAKE_ALL)
+
+// Statistics functions
+void kos_wait_get_stats(kos_wait_stats_t* stats);
+void kos_wait_dump_stats(void);
+
+// Sleep on wq until cond holds and store KOS_SUCCESS or KOS_ERROR_TIMEOUT
+// in *(result_out). A deadline of 0 waits forever.
+#define __kos_wait_event(wq, cond, flags, deadline_ns, result_out) \
+    do { \
+        kos_wait_entry_t __wait; \
+        kos_result_t __result = KOS_SUCCESS; \
+        uint64_t __deadline = (deadline_ns); \
+        kos_wait_entry_init(&__wait, (flags), KOS_WAIT_KEY_ANY); \
+        for (;;) { \
+            kos_wait_prepare((wq), &__wait); \
+            if (cond) { \
+                __result = KOS_SUCCESS; \
+                break; \
+            } \
+            if (__result == KOS_ERROR_TIMEOUT) { \
+                break; \
+            } \
+            __result = kos_wait_schedule(&__wait, __deadline); \
+        } \
+        kos_wait_finish((wq), &__wait); \
+        *(result_out) = __result; \
+    } while (0)
+
+#define kos_wait_event(wq, cond) \
+    do { \
+        kos_result_t __ignored; \
+        __kos_wait_event((wq), (cond), 0, 0, &__ignored); \
+    } while (0)
+#define kos_wait_event_exclusive(wq, cond) \
+    do { \
+        kos_result_t __ignored; \
+        __kos_wait_event((wq), (cond), KOS_WAIT_EXCLUSIVE, 0, &__ignored); \
+    } while (0)
+#define kos_wait_event_timeout(wq, cond, timeout_ns, result_out) \
+    __kos_wait_event((wq), (cond), 0, kos_wait_deadline(timeout_ns), (result_out))
+#define kos_wait_event_exclusive_timeout(wq, cond, timeout_ns, result_out) \
+    __kos_wait_event((wq), (cond), KOS_WAIT_EXCLUSIVE, kos_wait_deadline(timeout_ns), (result_out))
@@ -0,0 +1,62 @@
+#pragma once
+
+#include <stdint.h>
+#include <stdbool.h>
+#include "../types.h"
+
+// =============================================================================
+// KOS - Batched System Call Interface
+// =============================================================================
+
+// A batch is an array of device operations run in one kernel entry. Each
+// op gets its own result: bytes transferred, 0 for ioctl, or a negative
+// kos_result_t. An op flagged LINK gates the next one: if it fails, the
+// rest of its chain is cancelled and the batch carries on after the chain.
+
+#define KOS_SYSCALL_BATCH_MAX       64
+
+// A cancelled op reports this result
+#define KOS_SYSCALL_BATCH_CANCELLED KOS_ERROR_INVALID_STATE
+
+// Operation codes
+typedef enum {
+    KOS_BATCH_OP_NOP = 0,
+    KOS_BATCH_OP_READ = 1,
+    KOS_BATCH_OP_WRITE = 2,
+    KOS_BATCH_OP_IOCTL = 3
+} kos_batch_opcode_t;
+
+// Operation flags
+#define KOS_BATCH_F_LINK            0x01    // Next op runs only if this one succeeds
+
+// Operation descriptor, 40 bytes, filled by the caller
+typedef struct {
+    uint16_t opcode;
+    uint16_t flags;
+    uint32_t device_id;
+    uint32_t request;           // ioctl request
+    uint32_t reserved;
+    uint64_t buffer;            // read/write buffer or ioctl argument
+    uint64_t size;
+    int64_t result;             // Written by the kernel
+} kos_batch_op_t;
+
+_Static_assert(sizeof(kos_batch_op_t) == 40, "batch op layout is ABI");
+
+// Batch statistics
+typedef struct {
+    uint64_t batches;
+    uint64_t ops;
+    uint64_t failed;
+    uint64_t cancelled;
+} kos_syscall_batch_stats_t;
+
+// Batch functions, submit takes kernel ops and trusts their buffers
+int64_t kos_syscall_batch_submit(kos_batch_op_t* ops, uint32_t count);
+void kos_syscall_batch_get_stats(kos_syscall_batch_stats_t* stats);
+
+// System call handlers, installed in the dispatch table
+int64_t kos_sys_device_read(uint64_t a0, uint64_t a1, uint64_t a2, uint64_t a3, uint64_t a4, uint64_t a5);
+int64_t kos_sys_device_write(uint64_t a0, uint64_t a1, uint64_t a2, uint64_t a3, uint64_t a4, uint64_t a5);
+int64_t kos_sys_device_ioctl(uint64_t a0, uint64_t a1, uint64_t a2, uint64_t a3, uint64_t a4, uint64_t a5);
+int64_t kos_sys_batch(uint64_t a0, uint64_t a1, uint64_t a2, uint64_t a3, uint64_t a4, uint64_t a5);
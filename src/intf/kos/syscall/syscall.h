@@ -0,0 +1,80 @@
+#pragma once
+
+#include <stdint.h>
+#include <stdbool.h>
+#include "../types.h"
+
+// =============================================================================
+// KOS - System Call Interface
+// =============================================================================
+
+// SysV convention: number in RAX, arguments in RDI, RSI, RDX, R10, R8, R9,
+// result in RAX. Negative results are kos_result_t error codes. SYSCALL is
+// the fast path, int 0x80 takes the same registers for compatibility.
+
+#define KOS_SYSCALL_MAX         64
+#define KOS_SYSCALL_ARGS        6
+
+// End of the lower canonical half, user pointers live below it
+#define KOS_USER_SPACE_END      0x0000800000000000ULL
+
+// Check that [addr, addr + size) lies in the user half and addr is aligned
+// to align, a power of two. Handlers call it before touching a user pointer.
+static inline bool kos_user_access_ok(uint64_t addr, uint64_t size, uint64_t align) {
+    if (addr & (align - 1)) {
+        return false;
+    }
+    return size <= KOS_USER_SPACE_END && addr <= KOS_USER_SPACE_END - size;
+}
+
+// Built-in system calls
+typedef enum {
+    KOS_SYS_NOP = 0,            // Returns 0, measures the entry/exit cost
+    KOS_SYS_GETPID = 1,
+    KOS_SYS_CLOCK_NS = 2,       // Monotonic time in ns
+    KOS_SYS_SLEEP_NS = 3,
+    KOS_SYS_YIELD = 4,
+    KOS_SYS_VDSO_BASE = 5,      // Address of the shared time page
+    KOS_SYS_DEVICE_READ = 6,
+    KOS_SYS_DEVICE_WRITE = 7,
+    KOS_SYS_DEVICE_IOCTL = 8,
+    KOS_SYS_BATCH = 9,          // Array of device ops, see batch.h
+    KOS_SYS_FUTEX = 10,         // Word wait/wake, see futex.h
+    KOS_SYS_EXIT = 11,          // Ends the calling process, does not return
+    KOS_SYS_BUILTIN_COUNT
+} kos_syscall_nr_t;
+
+// Register frame built by both entry paths, lowest address first
+typedef struct {
+    uint64_t number;                    // RAX
+    uint64_t args[KOS_SYSCALL_ARGS];    // RDI, RSI, RDX, R10, R8, R9
+    uint64_t rip;                       // Return address (RCX on SYSCALL)
+    uint64_t rflags;                    // R11 on SYSCALL
+    uint64_t rsp;                       // Caller stack
+} kos_syscall_frame_t;
+
+typedef int64_t (*kos_syscall_fn_t)(uint64_t a0, uint64_t a1, uint64_t a2,
+                                    uint64_t a3, uint64_t a4, uint64_t a5);
+
+// Per-syscall counters
+typedef struct {
+    uint64_t calls[KOS_SYSCALL_MAX];
+    uint64_t cycles[KOS_SYSCALL_MAX];
+    uint64_t invalid;
+    uint64_t total;
+} kos_syscall_stats_t;
+
+// System call functions
+kos_result_t kos_syscall_register(uint32_t nr, kos_syscall_fn_t handler, const char* name);
+int64_t kos_syscall_dispatch(kos_syscall_frame_t* frame);
+const char* kos_syscall_get_name(uint32_t nr);
+void kos_syscall_bad_return(kos_syscall_frame_t* frame);
+
+// Drop to ring 3 at rip with stack rsp and RDI = arg, interrupts off.
+// The calling process's kernel stack is reused for its later kernel entries.
+__attribute__((noreturn)) void kos_syscall_enter_user(uint64_t rip, uint64_t rsp, uint64_t arg);
+
+// Statistics functions
+void kos_syscall_get_stats(kos_syscall_stats_t* stats);
+void kos_syscall_reset_stats(void);
+void kos_syscall_dump_stats(void);
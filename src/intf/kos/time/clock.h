@@ -0,0 +1,45 @@
+#pragma once
+
+#include <stdint.h>
+#include <stdbool.h>
+#include "../types.h"
+#include "clocksource.h"
+
+// =============================================================================
+// KOS - Monotonic Clock Interface
+// =============================================================================
+
+// Clock state snapshot
+typedef struct {
+    const char* source_name;
+    uint64_t frequency;
+    uint32_t mult;
+    uint32_t shift;
+    uint64_t cycle_last;
+    uint64_t base_ns;
+    uint64_t updates;
+    uint64_t ticks;
+    uint64_t wall_base_ns;
+} kos_clock_info_t;
+
+// Clock management functions
+kos_result_t kos_clock_init(void);
+kos_result_t kos_clock_select(kos_clocksource_t* cs);
+void kos_clock_update(void);
+kos_result_t kos_clock_get_info(kos_clock_info_t* info);
+
+// Nanoseconds since kos_clock_init, never goes backwards
+uint64_t kos_clock_monotonic_ns(void);
+
+// Nanoseconds since 1970-01-01 UTC, seeded from the RTC
+uint64_t kos_clock_realtime_ns(void);
+void kos_clock_set_realtime(uint64_t unix_ns);
+
+// Raw TSC cycles for cheap interval measurement
+uint64_t kos_clock_cycles(void);
+
+// Convert a kos_clock_cycles() delta to nanoseconds
+uint64_t kos_clock_cycles_to_ns(uint64_t cycles);
+
+// Convert nanoseconds to kos_clock_cycles() units
+uint64_t kos_clock_ns_to_cycles(uint64_t ns);
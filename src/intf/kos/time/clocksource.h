@@ -0,0 +1,69 @@
+#pragma once
+
+#include <stdint.h>
+#include <stddef.h>
+#include <stdbool.h>
+#include "../types.h"
+
+// =============================================================================
+// KOS - Clocksource Interface
+// =============================================================================
+
+// Clocksource flags
+#define KOS_CLOCKSOURCE_FLAG_CONTINUOUS   0x01  // Keeps counting in idle/C-states
+#define KOS_CLOCKSOURCE_FLAG_INVARIANT    0x02  // Rate independent of P-states
+#define KOS_CLOCKSOURCE_FLAG_PER_CPU      0x04  // Counter is local to each CPU
+#define KOS_CLOCKSOURCE_FLAG_UNSTABLE     0x08  // Not suitable as system clock
+
+// Clocksource ratings (higher is better)
+#define KOS_CLOCKSOURCE_RATING_POOR       50
+#define KOS_CLOCKSOURCE_RATING_FAIR       100
+#define KOS_CLOCKSOURCE_RATING_GOOD       250
+#define KOS_CLOCKSOURCE_RATING_BEST       300
+
+// Maximum seconds a single cycles->ns delta may cover without overflow
+#define KOS_CLOCKSOURCE_MAX_DELTA_SEC     600
+
+#define KOS_NSEC_PER_SEC                  1000000000ULL
+#define KOS_NSEC_PER_MSEC                 1000000ULL
+#define KOS_NSEC_PER_USEC                 1000ULL
+
+struct kos_clocksource;
+
+// Counter read function
+typedef uint64_t (*kos_clocksource_read_t)(struct kos_clocksource* cs);
+
+// Clocksource descriptor
+typedef struct kos_clocksource {
+    const char* name;
+    kos_clocksource_read_t read;
+    uint64_t mask;            // Valid counter bits
+    uint64_t frequency;       // Counter frequency in Hz
+    uint32_t mult;            // ns = (cycles * mult) >> shift
+    uint32_t shift;
+    uint32_t rating;
+    uint32_t flags;
+    void* private_data;
+    struct kos_clocksource* next;
+} kos_clocksource_t;
+
+// Clocksource management functions
+kos_result_t kos_clocksource_register(kos_clocksource_t* cs);
+kos_result_t kos_clocksource_unregister(kos_clocksource_t* cs);
+kos_clocksource_t* kos_clocksource_get_best(void);
+kos_clocksource_t* kos_clocksource_find(const char* name);
+void kos_clocksource_dump(void);
+
+// Conversion helpers
+void kos_clocks_calc_mult_shift(uint32_t* mult, uint32_t* shift, uint64_t from, uint64_t to, uint32_t max_sec);
+uint64_t kos_clocksource_cycles_to_ns(const kos_clocksource_t* cs, uint64_t cycles);
+
+// Fast conversion for deltas shorter than KOS_CLOCKSOURCE_MAX_DELTA_SEC
+static inline uint64_t kos_clocksource_cyc2ns(const kos_clocksource_t* cs, uint64_t cycles) {
+    return (cycles * cs->mult) >> cs->shift;
+}
+
+// Read the counter of a clocksource
+static inline uint64_t kos_clocksource_read(kos_clocksource_t* cs) {
+    return cs->read(cs) & cs->mask;
+}
@@ -0,0 +1,23 @@
+#pragma once
+
+#include <stdint.h>
+#include <stdbool.h>
+#include "../types.h"
+
+// =============================================================================
+// KOS - CMOS Real-Time Clock Interface
+// =============================================================================
+
+// Calendar time as kept by the CMOS RTC, assumed to be UTC
+typedef struct {
+    uint32_t year;
+    uint32_t month;
+    uint32_t day;
+    uint32_t hour;
+    uint32_t minute;
+    uint32_t second;
+} kos_rtc_time_t;
+
+// RTC functions
+kos_result_t kos_rtc_read(kos_rtc_time_t* time);
+uint64_t kos_rtc_to_unix_ns(const kos_rtc_time_t* time);
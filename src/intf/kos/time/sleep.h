@@ -0,0 +1,38 @@
+#pragma once
+
+#include <stdint.h>
+#include <stdbool.h>
+#include "../types.h"
+
+// =============================================================================
+// KOS - Sleep Interface
+// =============================================================================
+
+// Waits shorter than the spin threshold never touch the timer wheel. Longer
+// waits block on a timer until the threshold remains, then spin to the
+// deadline, so wakeups are both cheap for the CPU and precise.
+
+// Bounds for the calibrated spin threshold
+#define KOS_SLEEP_MIN_SPIN_NS     2000ULL
+#define KOS_SLEEP_MAX_SPIN_NS     5000000ULL
+
+// Sleep statistics
+typedef struct {
+    uint64_t calls;
+    uint64_t spins;           // Calls that only spun
+    uint64_t blocks;          // Calls that blocked the calling process
+    uint64_t halts;           // Calls that halted the CPU, no process to block
+    uint64_t spin_ns;         // Total time spent spinning
+    uint64_t max_overshoot_ns;
+    uint64_t spin_threshold_ns;
+} kos_sleep_stats_t;
+
+// Sleep functions
+kos_result_t kos_sleep_init(void);
+kos_result_t kos_sleep_ns(uint64_t ns);
+kos_result_t kos_sleep_until(uint64_t deadline_ns);
+
+// Sleep statistics functions
+uint64_t kos_sleep_get_spin_threshold(void);
+void kos_sleep_get_stats(kos_sleep_stats_t* stats);
+void kos_sleep_dump_stats(void);
@@ -0,0 +1,84 @@
+#pragma once
+
+#include <stdint.h>
+#include <stdbool.h>
+#include "../types.h"
+#include "../sync/spinlock.h"
+
+// =============================================================================
+// KOS - Kernel Timer Interface
+// =============================================================================
+
+// Wheel resolution, one PIT tick
+#define KOS_TIMER_TICK_NS         1000000ULL
+
+// Wheel geometry: 256 slots at level 0, 64 slots at each upper level
+#define KOS_TIMER_ROOT_BITS       8
+#define KOS_TIMER_LEVEL_BITS      6
+#define KOS_TIMER_ROOT_SIZE       (1 << KOS_TIMER_ROOT_BITS)
+#define KOS_TIMER_LEVEL_SIZE      (1 << KOS_TIMER_LEVEL_BITS)
+#define KOS_TIMER_LEVELS          4
+
+struct kos_timer_base;
+
+// Timer callback, runs in deferred context with interrupts enabled
+typedef void (*kos_timer_callback_t)(void* context);
+
+// Kernel timer (embedded in the owner, no allocation)
+typedef struct kos_timer {
+    struct kos_timer* next;
+    struct kos_timer** pprev;   // Link pointing at us, NULL when not pending
+    uint64_t expires;           // Expiry tick
+    kos_timer_callback_t callback;
+    void* context;
+    struct kos_timer_base* base;
+} kos_timer_t;
+
+// Timer statistics
+typedef struct {
+    uint64_t added;
+    uint64_t cancelled;
+    uint64_t expired;
+    uint64_t cascaded;
+    uint64_t runs;
+    uint32_t pending;
+    uint32_t max_batch;
+} kos_timer_stats_t;
+
+// Timing wheel, shared by all CPUs under its lock
+typedef struct kos_timer_base {
+    kos_spinlock_t lock;        // Taken with interrupts off, never held across callbacks
+    kos_timer_t* root[KOS_TIMER_ROOT_SIZE];
+    kos_timer_t* levels[KOS_TIMER_LEVELS][KOS_TIMER_LEVEL_SIZE];
+    uint64_t clk;               // Next tick to process
+    kos_timer_t* volatile running;  // Callback in progress, for kos_timer_cancel_sync
+    volatile bool work_pending;
+    bool initialized;
+    kos_timer_stats_t stats;
+} kos_timer_base_t;
+
+// Timer management functions
+void kos_timer_init(kos_timer_t* timer, kos_timer_callback_t callback, void* context);
+kos_result_t kos_timer_add(kos_timer_t* timer, uint64_t expires_ns);
+kos_result_t kos_timer_add_relative(kos_timer_t* timer, uint64_t delay_ns);
+bool kos_timer_mod(kos_timer_t* timer, uint64_t expires_ns);
+bool kos_timer_cancel(kos_timer_t* timer);
+bool kos_timer_cancel_sync(kos_timer_t* timer);
+
+static inline bool kos_timer_pending(const kos_timer_t* timer) {
+    return timer->pprev != NULL;
+}
+
+// Wheel processing for the system wheel
+void kos_timer_tick(void);
+bool kos_timer_work_pending(void);
+void kos_timer_run(void);
+
+// Explicit wheel functions
+void kos_timer_base_init(kos_timer_base_t* base, uint64_t now_ns);
+kos_result_t kos_timer_base_add(kos_timer_base_t* base, kos_timer_t* timer, uint64_t expires_ns);
+uint32_t kos_timer_base_run(kos_timer_base_t* base, uint64_t now_ns);
+
+// Timer statistics functions
+void kos_timer_get_stats(kos_timer_stats_t* stats);
+void kos_timer_dump_stats(void);
@@ -0,0 +1,118 @@
+#pragma once
+
+#include <stdint.h>
+#include <stdbool.h>
+#include "../types.h"
+#include "../config.h"
+#include "../syscall/syscall.h"
+
+// =============================================================================
+// KOS - Shared Time Page Interface
+// =============================================================================
+
+// One page holding the clock's conversion parameters, republished on each
+// tick. The inline readers below compute time with a TSC read and a
+// multiply, without entering the kernel, and touch nothing but the page.
+// Processes share the kernel address space for now and find the page
+// through KOS_SYS_VDSO_BASE; a read-only user mapping comes with user
+// address spaces.
+
+#define KOS_VDSO_VERSION          1
+
+// How readers get the current cycle count
+typedef enum {
+    KOS_VDSO_MODE_NONE = 0,       // Clock not running yet
+    KOS_VDSO_MODE_TSC = 1,        // rdtsc, the clock runs on the TSC
+    KOS_VDSO_MODE_SYSCALL = 2     // Counter not readable from user mode
+} kos_vdso_mode_t;
+
+// Page layout, readers retry while sequence is odd or changes
+typedef struct {
+    volatile uint32_t sequence;
+    uint32_t version;
+    uint32_t mode;
+    uint32_t shift;
+    uint64_t mult;
+    uint64_t mask;
+    uint64_t cycle_last;
+    uint64_t base_ns;             // Monotonic ns at cycle_last
+    uint64_t base_frac;           // Sub-nanosecond remainder, scaled by 2^shift
+    uint64_t wall_base_ns;        // Realtime minus monotonic, ns since 1970
+    uint64_t ticks;               // Clock updates, one per timer tick
+    uint64_t tick_ns;             // Monotonic ns at the last tick
+} __attribute__((aligned(KOS_PAGE_SIZE))) kos_vdso_time_t;
+
+_Static_assert(sizeof(kos_vdso_time_t) == KOS_PAGE_SIZE, "time page must be one page");
+
+#define kos_vdso_barrier() asm volatile("" : : : "memory")
+
+// Fallback for clocksources user mode cannot read. Ring 3 only, kernel code
+// calls kos_clock_monotonic_ns instead.
+static inline uint64_t kos_vdso_syscall_clock_ns(void) {
+    uint64_t ret = KOS_SYS_CLOCK_NS;
+    asm volatile("syscall" : "+a" (ret) : : "rcx", "r11", "memory");
+    return ret;
+}
+
+// Monotonic nanoseconds since boot
+static inline uint64_t kos_vdso_monotonic_ns(const kos_vdso_time_t* page) {
+    uint32_t seq;
+    uint64_t ns;
+    do {
+        while ((seq = page->sequence) & 1) {
+            asm volatile("pause");
+        }
+        kos_vdso_barrier();
+
+        if (page->mode != KOS_VDSO_MODE_TSC) {
+            return kos_vdso_syscall_clock_ns();
+        }
+
+        uint32_t low, high;
+        asm volatile("rdtsc" : "=a" (low), "=d" (high));
+        uint64_t now = ((uint64_t)high << 32) | low;
+        uint64_t delta = (now - page->cycle_last) & page->mask;
+        ns = page->base_ns + ((page->base_frac + delta * page->mult) >> page->shift);
+
+        kos_vdso_barrier();
+    } while (page->sequence != seq);
+
+    return ns;
+}
+
+// Wall-clock nanoseconds since 1970-01-01 UTC
+static inline uint64_t kos_vdso_realtime_ns(const kos_vdso_time_t* page) {
+    uint32_t seq;
+    uint64_t wall_base;
+    uint64_t ns;
+    do {
+        while ((seq = page->sequence) & 1) {
+            asm volatile("pause");
+        }
+        kos_vdso_barrier();
+        wall_base = page->wall_base_ns;
+        ns = kos_vdso_monotonic_ns(page);
+        kos_vdso_barrier();
+    } while (page->sequence != seq);
+
+    return wall_base + ns;
+}
+
+// Tick-granular monotonic time, two loads and no counter read
+static inline uint64_t kos_vdso_coarse_ns(const kos_vdso_time_t* page) {
+    uint32_t seq;
+    uint64_t ns;
+    do {
+        while ((seq = page->sequence) & 1) {
+            asm volatile("pause");
+        }
+        kos_vdso_barrier();
+        ns = page->tick_ns;
+        kos_vdso_barrier();
+    } while (page->sequence != seq);
+
+    return ns;
+}
+
+// Time page of this boot
+const kos_vdso_time_t* kos_vdso_get_page(void);
@@ -0,0 +1,65 @@
+#pragma once
+
+#include <stdint.h>
+#include <stdbool.h>
+#include "../types.h"
+
+// =============================================================================
+// KOS - Log-Linear Histogram Interface
+// =============================================================================
+
+// Values below 2^SUB_BITS get one bucket each. Above that, every power of
+// two is split into 2^SUB_BITS linear buckets, so the relative error stays
+// under 1/2^SUB_BITS at any magnitude. Recording is a clz, two shifts and
+// an increment.
+
+#define KOS_HISTOGRAM_SUB_BITS    3
+#define KOS_HISTOGRAM_SUB_COUNT   (1U << KOS_HISTOGRAM_SUB_BITS)
+#define KOS_HISTOGRAM_MAX_BITS    32      // Larger values land in the last bucket
+#define KOS_HISTOGRAM_BUCKETS     ((KOS_HISTOGRAM_MAX_BITS - KOS_HISTOGRAM_SUB_BITS + 1) * KOS_HISTOGRAM_SUB_COUNT)
+#define KOS_HISTOGRAM_MAX_VALUE   ((1ULL << KOS_HISTOGRAM_MAX_BITS) - 1)
+
+typedef struct {
+    uint32_t buckets[KOS_HISTOGRAM_BUCKETS];
+    uint64_t count;
+    uint64_t max;
+} kos_histogram_t;
+
+// Percentile summary, values in recorded units
+typedef struct {
+    uint64_t count;
+    uint64_t p50;
+    uint64_t p99;
+    uint64_t p999;
+    uint64_t max;
+} kos_histogram_summary_t;
+
+// Bucket index of a value
+static inline uint32_t kos_histogram_index(uint64_t value) {
+    if (value > KOS_HISTOGRAM_MAX_VALUE) {
+        value = KOS_HISTOGRAM_MAX_VALUE;
+    }
+    if (value < KOS_HISTOGRAM_SUB_COUNT) {
+        return (uint32_t)value;
+    }
+
+    uint32_t msb = 63 - (uint32_t)__builtin_clzll(value);
+    uint32_t shift = msb - KOS_HISTOGRAM_SUB_BITS;
+    return ((shift + 1) << KOS_HISTOGRAM_SUB_BITS) +
+           (uint32_t)((value >> shift) & (KOS_HISTOGRAM_SUB_COUNT - 1));
+}
+
+// Record one value
+static inline void kos_histogram_record(kos_histogram_t* h, uint64_t value) {
+    h->buckets[kos_histogram_index(value)]++;
+    h->count++;
+    if (value > h->max) {
+        h->max = value;
+    }
+}
+
+// Histogram functions
+void kos_histogram_reset(kos_histogram_t* h);
+uint64_t kos_histogram_bucket_high(uint32_t index);
+uint64_t kos_histogram_percentile(const kos_histogram_t* h, uint32_t per_mille);
+void kos_histogram_summarize(const kos_histogram_t* h, kos_histogram_summary_t* summary);
@@ -2,6 +2,7 @@
 
 #include <stdint.h>
 #include <stddef.h>
+#include "kos/cpu/counter.h"
 
 // Performance metrics structure
 typedef struct {
@@ -20,23 +21,30 @@ typedef struct {
     
     // System metrics
     uint32_t uptime_seconds;
-    uint32_t interrupts_count;
-    uint32_t context_switches;
+    uint64_t interrupts_count;
+    uint32_t interrupt_rate;        // Sum of the per-line averaged rates, per second
+    uint32_t throttled_lines;       // IRQ lines masked for storming
+    uint64_t context_switches;
     
     // I/O metrics
-    uint32_t disk_reads;
-    uint32_t disk_writes;
-    uint32_t network_packets;
+    uint64_t disk_reads;
+    uint64_t disk_writes;
+    uint64_t network_packets;
     
-    // Performance counters
+    // Performance counters (ns from kos_clock_monotonic_ns)
     uint64_t boot_time;
     uint64_t last_update_time;
 } perf_metrics_t;
 
+// I/O event counters, drivers bump them with kos_counter_inc(disk_reads) etc.
+KOS_COUNTER_DECLARE(disk_reads);
+KOS_COUNTER_DECLARE(disk_writes);
+KOS_COUNTER_DECLARE(network_packets);
+
 // Performance monitoring functions
 void perf_init(void);
 void perf_update(void);
-perf_metrics_t* perf_get_metrics(void);
+void perf_get_metrics(perf_metrics_t* metrics);   // Consistent copy, never blocks writers
 void perf_print_stats(void);
 void perf_reset_counters(void);
 
@@ -56,7 +64,7 @@ void perf_log_timing(const char* name, uint64_t cycles);
 // Performance thresholds
 #define PERF_CPU_HIGH_USAGE    80
 #define PERF_MEM_HIGH_USAGE    85
-#define PERF_INTERRUPT_THRESHOLD 1000
+#define PERF_INTERRUPT_THRESHOLD 1000   // Per-line storm budgets live in the interrupt layer
 
 // Performance alerts
 typedef enum {
@@ -68,4 +76,5 @@ typedef enum {
 } perf_alert_t;
 
 perf_alert_t perf_check_alerts(void);
+perf_alert_t perf_check_metrics(const perf_metrics_t* metrics);
 const char* perf_alert_string(perf_alert_t alert);
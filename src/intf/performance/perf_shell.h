@@ -9,6 +9,15 @@ void perf_cmd_reset(void);
 void perf_cmd_monitor(void);
 void perf_cmd_alerts(void);
 void perf_cmd_benchmark(void);
+void perf_cmd_irq(void);
+void perf_cmd_syscall(void);
+void perf_cmd_batch(void);
+void perf_cmd_ipi(void);
+void perf_cmd_lockstat(void);
+void perf_cmd_ring(void);
+void perf_cmd_counters(void);
+void perf_cmd_parallel(void);
+void perf_cmd_switch(void);
 
 // Shell integration
 void perf_register_shell_commands(void);
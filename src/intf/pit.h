@@ -1,9 +1,10 @@
 #pragma once
 #include "interrupts/isr.h"
+#include "kos/interrupts/interrupt.h"
 
 // Timer management functions
 void timer_phase(int hz);
-void timer_handler(struct registers *r);
+kos_irq_return_t timer_handler(uint32_t irq, void* context);
 void timer_install();
 void timer_wait(int ticks);
 void timer_callback(void);